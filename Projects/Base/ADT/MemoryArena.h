@@ -0,0 +1,219 @@
+/*=============================================================================
+   Copyright (c) 2012, Ludo Sapiens Inc. and contributors.
+   See accompanying file LICENSE.txt for details.
+=============================================================================*/
+#ifndef BASE_MEMORYARENA_H
+#define BASE_MEMORYARENA_H
+
+#include <Base/StdDefs.h>
+#include <Base/ADT/Vector.h>
+#include <Base/Dbg/Defs.h>
+
+#include <cstdlib>
+
+NAMESPACE_BEGIN
+
+/*==============================================================================
+   CLASS MemoryArena
+==============================================================================*/
+
+//! A linear allocator handing out memory from large blocks.
+//! Allocated objects are never freed individually, and never move; everything
+//! is released at once with reset(), which keeps the memory for later use.
+//! Only objects which do not need their destructor to be called should be
+//! stored in an arena.
+class MemoryArena
+{
+public:
+
+   /*----- classes -----*/
+
+   //! The source of the blocks (defaults to malloc/free).
+   class Allocator
+   {
+   public:
+      virtual ~Allocator() {}
+      virtual void* allocate( size_t size ) = 0;
+      virtual void  deallocate( void* ptr ) = 0;
+   };
+
+   /*----- methods -----*/
+
+   inline MemoryArena( size_t blockSize = 4096, Allocator* allocator = nullptr );
+   inline ~MemoryArena();
+
+   inline void  reset();
+   inline void  clear();
+
+   // Memory allocation without call to constructor.
+   inline void*  alloc( size_t size, size_t alignment = sizeof(double) );
+   template< typename T > inline T*  alloc() { return (T*)alloc( sizeof(T), alignof(T) ); }
+
+   // Copies the specified object into the arena.
+   template< typename T > inline T*  store( const T& obj ) { return new( alloc<T>() ) T( obj ); }
+
+   inline void  allocator( Allocator* a );
+   inline Allocator*  allocator() const { return _allocator; }
+
+   inline size_t  used() const;
+   inline size_t  capacity() const;
+   inline size_t  numBlocks() const { return _blocks.size(); }
+
+private:
+
+   /*----- types and enumerations -----*/
+
+   struct Block
+   {
+      char*   _data;
+      size_t  _size;
+   };
+
+   /*----- methods -----*/
+
+   inline void  allocateBlock( size_t size );
+   inline void  releaseBlocks();
+
+   MemoryArena( const MemoryArena& );
+   void operator=( const MemoryArena& );
+
+   /*----- data members -----*/
+
+   Vector<Block>  _blocks;
+   size_t         _cur;        //!< The index of the block being filled.
+   size_t         _offset;     //!< The first free byte in the current block.
+   size_t         _used;       //!< The bytes used in the blocks before the current one.
+   size_t         _blockSize;
+   Allocator*     _allocator;
+};
+
+//------------------------------------------------------------------------------
+//!
+inline
+MemoryArena::MemoryArena( size_t blockSize, Allocator* allocator ):
+   _cur( 0 ), _offset( 0 ), _used( 0 ), _blockSize( blockSize ), _allocator( allocator )
+{
+}
+
+//------------------------------------------------------------------------------
+//!
+inline
+MemoryArena::~MemoryArena()
+{
+   releaseBlocks();
+}
+
+//------------------------------------------------------------------------------
+//! Makes all of the memory available again. When the previous use spilled
+//! into more than one block, they are replaced by a single block holding
+//! them all, so that the same usage doesn't allocate anymore.
+inline void
+MemoryArena::reset()
+{
+   if( _blocks.size() > 1 )
+   {
+      size_t size = capacity();
+      releaseBlocks();
+      allocateBlock( size );
+   }
+   _cur    = 0;
+   _offset = 0;
+   _used   = 0;
+}
+
+//------------------------------------------------------------------------------
+//! Releases all of the memory.
+inline void
+MemoryArena::clear()
+{
+   releaseBlocks();
+   _cur    = 0;
+   _offset = 0;
+   _used   = 0;
+}
+
+//------------------------------------------------------------------------------
+//!
+inline void*
+MemoryArena::alloc( size_t size, size_t alignment )
+{
+   while( _cur < _blocks.size() )
+   {
+      const Block& b = _blocks[_cur];
+      size_t start   = (size_t(b._data) + _offset + alignment - 1) & ~(alignment - 1);
+      start         -= size_t(b._data);
+      if( start + size <= b._size )
+      {
+         _offset = start + size;
+         return b._data + start;
+      }
+      // Move on to the next block (left over from before a reset).
+      _used  += _offset;
+      _offset = 0;
+      ++_cur;
+   }
+
+   allocateBlock( size + alignment > _blockSize ? size + alignment : _blockSize );
+   return alloc( size, alignment );
+}
+
+//------------------------------------------------------------------------------
+//! Sets the allocator for the blocks; the arena must be cleared first.
+inline void
+MemoryArena::allocator( Allocator* a )
+{
+   CHECK( _blocks.empty() );
+   _allocator = a;
+}
+
+//------------------------------------------------------------------------------
+//! Returns the number of bytes handed out since the last reset (including
+//! alignment padding).
+inline size_t
+MemoryArena::used() const
+{
+   return _used + _offset;
+}
+
+//------------------------------------------------------------------------------
+//!
+inline size_t
+MemoryArena::capacity() const
+{
+   size_t size = 0;
+   for( size_t i = 0; i < _blocks.size(); ++i )
+   {
+      size += _blocks[i]._size;
+   }
+   return size;
+}
+
+//------------------------------------------------------------------------------
+//!
+inline void
+MemoryArena::allocateBlock( size_t size )
+{
+   Block b;
+   b._data = (char*)( _allocator ? _allocator->allocate( size ) : malloc( size ) );
+   b._size = size;
+   _blocks.pushBack( b );
+}
+
+//------------------------------------------------------------------------------
+//!
+inline void
+MemoryArena::releaseBlocks()
+{
+   for( size_t i = 0; i < _blocks.size(); ++i )
+   {
+      if( _allocator )
+         _allocator->deallocate( _blocks[i]._data );
+      else
+         free( _blocks[i]._data );
+   }
+   _blocks.clear();
+}
+
+NAMESPACE_END
+
+#endif
@@ -9,6 +9,20 @@
 #include <Base/IO/NullDevice.h>
 #include <Base/Util/EndianSwapper.h>
 
+#if !defined(BASE_BINARY_STREAM_SSE2)
+#  if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define BASE_BINARY_STREAM_SSE2  1  // Set to 0 to swap bulk arrays one element at a time.
+#  else
+#    define BASE_BINARY_STREAM_SSE2  0
+#  endif
+#endif
+
+#include <cstring>
+
+#if BASE_BINARY_STREAM_SSE2
+#include <emmintrin.h>
+#endif
+
 
 // Set to 1 if you want the prefixed string size to be store in the
 // stream's specified endianness (as opposed the always little endian if 0).
@@ -24,6 +38,92 @@ inline void nothing( void* )
 {
 }
 
+// Size of the chunks swapped on the side when writing a non-native array.
+const size_t _swapChunkSize = 4096;
+
+#if BASE_BINARY_STREAM_SSE2
+//------------------------------------------------------------------------------
+//! Swaps the bytes of every 16b word of v.
+inline __m128i swapBytes16( __m128i v )
+{
+   return _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+}
+#endif
+
+//------------------------------------------------------------------------------
+//!
+void swapArray16( void* data, size_t n )
+{
+   uint8_t* cur = (uint8_t*)data;
+#if BASE_BINARY_STREAM_SSE2
+   for( ; n >= 8; n -= 8, cur += 16 )
+   {
+      __m128i v = _mm_loadu_si128( (const __m128i*)cur );
+      _mm_storeu_si128( (__m128i*)cur, swapBytes16( v ) );
+   }
+#endif
+   for( ; n != 0; --n, cur += 2 )
+   {
+      EndianSwapper::byteSwap16( cur );
+   }
+}
+
+//------------------------------------------------------------------------------
+//!
+void swapArray32( void* data, size_t n )
+{
+   uint8_t* cur = (uint8_t*)data;
+#if BASE_BINARY_STREAM_SSE2
+   // Swap the 16b halves of every word, then the bytes of every half.
+   for( ; n >= 4; n -= 4, cur += 16 )
+   {
+      __m128i v = _mm_loadu_si128( (const __m128i*)cur );
+      v = _mm_shufflelo_epi16( v, _MM_SHUFFLE(2,3,0,1) );
+      v = _mm_shufflehi_epi16( v, _MM_SHUFFLE(2,3,0,1) );
+      _mm_storeu_si128( (__m128i*)cur, swapBytes16( v ) );
+   }
+#endif
+   for( ; n != 0; --n, cur += 4 )
+   {
+      EndianSwapper::byteSwap32( cur );
+   }
+}
+
+//------------------------------------------------------------------------------
+//!
+void swapArray64( void* data, size_t n )
+{
+   uint8_t* cur = (uint8_t*)data;
+#if BASE_BINARY_STREAM_SSE2
+   // Reverse the 16b quarters of every word, then the bytes of every quarter.
+   for( ; n >= 2; n -= 2, cur += 16 )
+   {
+      __m128i v = _mm_loadu_si128( (const __m128i*)cur );
+      v = _mm_shufflelo_epi16( v, _MM_SHUFFLE(0,1,2,3) );
+      v = _mm_shufflehi_epi16( v, _MM_SHUFFLE(0,1,2,3) );
+      _mm_storeu_si128( (__m128i*)cur, swapBytes16( v ) );
+   }
+#endif
+   for( ; n != 0; --n, cur += 8 )
+   {
+      EndianSwapper::byteSwap64( cur );
+   }
+}
+
+//------------------------------------------------------------------------------
+//!
+void swapArray( void* data, size_t n, size_t size )
+{
+   switch( size )
+   {
+      case 1 :                            break;
+      case 2 : swapArray16( data, n );    break;
+      case 4 : swapArray32( data, n );    break;
+      case 8 : swapArray64( data, n );    break;
+      default: CHECK( false );            break;
+   }
+}
+
 UNNAMESPACE_END
 
 
@@ -67,7 +167,7 @@ NAMESPACE_END
 //------------------------------------------------------------------------------
 //!
 BinaryStream::BinaryStream( IODevice* device, Endian e ):
-   _device( device )
+   _device( device ), _swap( false )
 {
    endian( e );
 }
@@ -96,6 +196,11 @@ void
 BinaryStream::endian( Endian e )
 {
    _endian = e;
+#if (CPU_ENDIANNESS == CPU_ENDIAN_LITTLE)
+   _swap   = (e == ENDIAN_BIG);
+#else
+   _swap   = (e == ENDIAN_LITTLE);
+#endif
    switch( _endian )
    {
       case ENDIAN_NATIVE:
@@ -134,6 +239,49 @@ BinaryStream::endian( Endian e )
    }
 }
 
+//------------------------------------------------------------------------------
+//! Reads n elements of the specified size (1, 2, 4, or 8 bytes), and swaps
+//! them in place if the stream's endianness isn't the native one.
+//! Returns the number of complete elements read.
+size_t
+BinaryStream::readArray( void* data, size_t n, size_t size )
+{
+   size_t read = _device->read( (char*)data, n*size ) / size;
+   if( _swap )  swapArray( data, read, size );
+   return read;
+}
+
+//------------------------------------------------------------------------------
+//! Writes n elements of the specified size (1, 2, 4, or 8 bytes).
+//! When they need swapping, the copy is done in chunks so that the source
+//! array is left untouched.
+//! Returns the number of complete elements written.
+size_t
+BinaryStream::writeArray( const void* data, size_t n, size_t size )
+{
+   if( !_swap || size == 1 )
+   {
+      return _device->write( (const char*)data, n*size ) / size;
+   }
+
+   char chunk[_swapChunkSize];
+   const size_t perChunk = _swapChunkSize / size;
+   const char*  src      = (const char*)data;
+   size_t       written  = 0;
+   while( written < n )
+   {
+      size_t m     = (n - written < perChunk) ? n - written : perChunk;
+      size_t bytes = m*size;
+      memcpy( chunk, src, bytes );
+      swapArray( chunk, m, size );
+      size_t w = _device->write( chunk, bytes ) / size;
+      written += w;
+      if( w != m )  break;
+      src += bytes;
+   }
+   return written;
+}
+
 //------------------------------------------------------------------------------
 //!
 BinaryStream&
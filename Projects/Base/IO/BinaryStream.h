@@ -13,6 +13,34 @@
 
 NAMESPACE_BEGIN
 
+template< typename T > class Vec2;
+template< typename T > class Vec3;
+template< typename T > class Vec4;
+template< typename T > class Quat;
+template< typename T > class Mat2;
+template< typename T > class Mat3;
+template< typename T > class Mat4;
+
+/*==============================================================================
+  STRUCT BinaryElement
+==============================================================================*/
+
+//! Describes how an element of a bulk read or write is laid out: a packed
+//! array of COUNT scalars, each of which gets swapped on its own.
+template< typename T > struct BinaryElement
+{
+   typedef T  Scalar;
+   enum { COUNT = 1 };
+};
+
+template< typename T > struct BinaryElement< Vec2<T> > { typedef T Scalar; enum { COUNT =  2 }; };
+template< typename T > struct BinaryElement< Vec3<T> > { typedef T Scalar; enum { COUNT =  3 }; };
+template< typename T > struct BinaryElement< Vec4<T> > { typedef T Scalar; enum { COUNT =  4 }; };
+template< typename T > struct BinaryElement< Quat<T> > { typedef T Scalar; enum { COUNT =  4 }; };
+template< typename T > struct BinaryElement< Mat2<T> > { typedef T Scalar; enum { COUNT =  4 }; };
+template< typename T > struct BinaryElement< Mat3<T> > { typedef T Scalar; enum { COUNT =  9 }; };
+template< typename T > struct BinaryElement< Mat4<T> > { typedef T Scalar; enum { COUNT = 16 }; };
+
 /*==============================================================================
   CLASS BinaryStream
 ==============================================================================*/
@@ -46,6 +74,13 @@ public:
 
    BASE_DLL_API bool  flush();
 
+   // Bulk routines, reading or writing n elements (PODs or CGMath types) with
+   // a single device call. They return the number of complete elements.
+   template< typename T > inline size_t  read( T* data, size_t n );
+   template< typename T > inline size_t  write( const T* data, size_t n );
+   BASE_DLL_API size_t  readArray( void* data, size_t n, size_t size );
+   BASE_DLL_API size_t  writeArray( const void* data, size_t n, size_t size );
+
    // Input routines.
    inline size_t  read( char* data, size_t n ) { return _device->read(data, n); }
    BASE_DLL_API BinaryStream&  operator>>(   String&  str );
@@ -106,6 +141,7 @@ protected:
    /*----- members -----*/
    RCP<IODevice>  _device;
    Endian         _endian;
+   bool           _swap;        //!< Whether the endianness differs from the native one.
    EndianFunc     _swapRead16;
    EndianFunc     _swapRead32;
    EndianFunc     _swapRead64;
@@ -116,6 +152,26 @@ protected:
 private:
 };
 
+//------------------------------------------------------------------------------
+//!
+template< typename T > inline size_t
+BinaryStream::read( T* data, size_t n )
+{
+   typedef typename BinaryElement<T>::Scalar  Scalar;
+   const size_t count = BinaryElement<T>::COUNT;
+   return readArray( data, n*count, sizeof(Scalar) ) / count;
+}
+
+//------------------------------------------------------------------------------
+//!
+template< typename T > inline size_t
+BinaryStream::write( const T* data, size_t n )
+{
+   typedef typename BinaryElement<T>::Scalar  Scalar;
+   const size_t count = BinaryElement<T>::COUNT;
+   return writeArray( data, n*count, sizeof(Scalar) ) / count;
+}
+
 #define GEN_IN_OPER_1( type ) \
    inline BinaryStream& \
    BinaryStream::operator>>( type& val ) \
@@ -636,6 +636,21 @@ bool  remove( const Path& path )
 #endif
 }
 
+//------------------------------------------------------------------------------
+//! Deletes an empty directory.
+//! Returns false on failure.
+bool  removeDirectory( const Path& path )
+{
+#if BASE_IO_USE_STAT
+   return rmdir( path.cstr() ) == 0;
+#elif BASE_IO_USE_WIN32
+   return RemoveDirectoryA( path.cstr() ) == TRUE;
+#else
+#error RMDIR missing implementation.
+   return false;
+#endif
+}
+
 } //namespace FS
 
 NAMESPACE_END
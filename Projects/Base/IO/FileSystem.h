@@ -213,6 +213,7 @@ namespace FS
    //BASE_DLL_API bool createFile( const Path& path, Mode mode );
    //BASE_DLL_API bool createDirectory( const Path& path );
    BASE_DLL_API bool remove( const Path& path );
+   BASE_DLL_API bool removeDirectory( const Path& path );
    //BASE_DLL_API bool delete( const Directory& dir, bool recursive = false );
    //BASE_DLL_API bool move( const Entry& src, const Path& dst );
    //BASE_DLL_API bool move( const Path& src, const Path& dst );
@@ -195,7 +195,8 @@ UNNAMESPACE_END
 MMapDevice::MMapDevice( const FS::Entry& entry, Mode mode ):
    IODevice( mode ),
    _file( NULL ),
-   _data( NULL )
+   _data( NULL ),
+   _pos( NULL )
 {
    open( entry, mode ); // Call this to skip to the end.
 }
@@ -373,6 +374,13 @@ MMapDevice::doPos() const
 size_t
 MMapDevice::doRead( char* data, size_t n )
 {
+   // Never read past the end of the mapping.
+   size_t left = _data ? size() - doPos() : 0;
+   if( n > left )
+   {
+      n = left;
+      addState( STATE_EOF );
+   }
    memcpy( data, _pos, n );
    _pos += n;
    return n;
@@ -383,6 +391,8 @@ MMapDevice::doRead( char* data, size_t n )
 size_t
 MMapDevice::doPeek( char* data, size_t n )
 {
+   size_t left = _data ? size() - doPos() : 0;
+   if( n > left )  n = left;
    memcpy( data, _pos, n );
    return n;
 }
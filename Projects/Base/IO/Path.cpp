@@ -4,6 +4,8 @@
 =============================================================================*/
 #include <Base/IO/Path.h>
 
+#include <cstdlib>
+#include <cstring>
 #include <map>
 
 #ifdef __GNUC__
@@ -79,6 +81,25 @@ Path::getCurrentDirectory()
    return String(tmp);
 }
 
+//------------------------------------------------------------------------------
+//! Returns the directory for temporary files (from TMPDIR, TMP or TEMP, else
+//! /tmp), without a trailing slash.
+String
+Path::getTempDirectory()
+{
+   const char* env = getenv( "TMPDIR" );
+   if( env == nullptr || *env == '\0' )  env = getenv( "TMP" );
+   if( env == nullptr || *env == '\0' )  env = getenv( "TEMP" );
+   if( env == nullptr || *env == '\0' )  env = "/tmp";
+   char tmp[1024];
+   strncpy( tmp, env, sizeof(tmp)-1 );
+   tmp[sizeof(tmp)-1] = '\0';
+   bs2fs( tmp, sizeof(tmp) );
+   size_t len = strlen( tmp );
+   while( len > 1 && tmp[len-1] == '/' )  tmp[--len] = '\0';
+   return String( tmp );
+}
+
 //------------------------------------------------------------------------------
 //! Converts backward slashes to forward slashes.
 void
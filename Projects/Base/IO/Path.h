@@ -27,6 +27,7 @@ public:
    BASE_DLL_API static void setToken( const String& token, const String& p );
    BASE_DLL_API static String getPath( const String& token );
    BASE_DLL_API static String getCurrentDirectory();
+   BASE_DLL_API static String getTempDirectory();
 
    BASE_DLL_API static void bs2fs( char* tmp, size_t s = (size_t)-1 );
    BASE_DLL_API static void fs2bs( char* tmp, size_t s = (size_t)-1 );
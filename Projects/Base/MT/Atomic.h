@@ -90,6 +90,12 @@ inline bool atomicCAS( volatile int32_t& var, int32_t oldV, int32_t newV );
 inline bool atomicCAS( volatile void*& ptr, void* oldV, void* newV );
 
 
+//------------------------------------------------------------------------------
+//! Issues a full memory barrier (both compiler and hardware), guaranteeing that
+//! no load nor store gets reordered across the call.
+inline void atomicBarrier();
+
+
 /*==============================================================================
   CLASS AtomicInt32
 ==============================================================================*/
@@ -239,6 +245,11 @@ inline bool  atomicCAS( volatile void*& var, void* oldV, void* newV )
    return __sync_bool_compare_and_swap( &var, oldV, newV );
 }
 
+inline void  atomicBarrier()
+{
+   __sync_synchronize();
+}
+
 #endif //BASE_ATOMIC == BASE_ATOMIC_GCC_BUILTINS
 
 
@@ -330,6 +341,13 @@ inline bool  atomicCAS( void* volatile& ptr, void* oldV, void* newV )
 #endif
 }
 
+inline void  atomicBarrier()
+{
+   // Interlocked operations act as full barriers on all Windows platforms.
+   volatile long dummy = 0;
+   _InterlockedExchange( &dummy, 0 );
+}
+
 #endif //BASE_ATOMIC == BASE_ATOMIC_WIN_INTRINSICS
 
 
@@ -403,6 +421,11 @@ inline bool  atomicCAS( void* volatile& var, void* oldV, void* newV )
    return OSAtomicCompareAndSwapPtr( oldV, newV, &var );
 }
 
+inline void  atomicBarrier()
+{
+   OSMemoryBarrier();
+}
+
 #endif //BASE_ATOMIC == BASE_ATOMIC_OSX_ATOMICS
 
 
@@ -13,6 +13,9 @@ UNNAMESPACE_BEGIN
 
 //DBG_STREAM( os_mt, "MT" );
 
+// Zero-initialized before any static StorageSlot gets constructed.
+volatile int32_t  _numStorageSlots = 0;
+
 UNNAMESPACE_END
 
 
@@ -35,6 +38,19 @@ BaseTask::~BaseTask()
 }
 
 
+/*==============================================================================
+   CLASS StorageSlotBase
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//!
+StorageSlotBase::StorageSlotBase():
+   _index( atomicInc( _numStorageSlots ) - 1 )
+{
+   CHECK( _index < MAX_SLOTS );
+}
+
+
 /*==============================================================================
    CLASS Task
 ==============================================================================*/
@@ -44,7 +60,8 @@ BaseTask::~BaseTask()
 Task::Task():
    _parent( NULL ),
    _workerTask( NULL ),
-   _count( 0 )
+   _count( 0 ),
+   _autoDelete( true )
 {
 }
 
@@ -122,6 +139,14 @@ Task::storage() const
    return _workerTask->storage();
 }
 
+//------------------------------------------------------------------------------
+//!
+void*&
+Task::storage( uint slotIndex )
+{
+   return _workerTask->_slots[slotIndex];
+}
+
 //------------------------------------------------------------------------------
 //!
 void
@@ -150,7 +175,16 @@ Task::decCount()
 #if BASE_PROFILE_TASKS
       ++(queue()._nTasksDeleted);
 #endif
-      delete this;
+      if( _autoDelete )
+      {
+         delete this;
+      }
+      else
+      {
+         // Make the task ready to be posted again.
+         _parent     = NULL;
+         _workerTask = NULL;
+      }
    }
 }
 
@@ -19,6 +19,62 @@ NAMESPACE_BEGIN
 class TaskQueue;
 class WorkerTask;
 
+/*==============================================================================
+  CLASS StorageSlotBase
+==============================================================================*/
+
+//! The untyped part of a StorageSlot.
+class StorageSlotBase
+{
+public:
+
+   /*----- types -----*/
+
+   enum
+   {
+      MAX_SLOTS = 16  //!< The maximum number of slots which can be reserved.
+   };
+
+   /*----- methods -----*/
+
+   inline uint  index() const { return _index; }
+
+protected:
+
+   /*----- methods -----*/
+
+   BASE_DLL_API StorageSlotBase();
+
+   /*----- data members -----*/
+
+   uint  _index;  //!< The index of the slot in every worker task.
+
+private:
+}; //class StorageSlotBase
+
+
+/*==============================================================================
+  CLASS StorageSlot
+==============================================================================*/
+
+//! A typed entry in the storage of every worker task.
+//! A subsystem reserves a slot once (typically as a static variable), and then
+//! accesses its per-worker value directly, without the String lookup that
+//! Task::StorageType requires.
+//! T needs to fit in a pointer (typically a pointer type), and starts as 0.
+template< typename T >
+class StorageSlot:
+   public StorageSlotBase
+{
+public:
+
+   /*----- methods -----*/
+
+   StorageSlot() {}
+
+private:
+}; //class StorageSlot
+
 /*==============================================================================
    CLASS BaseTask
 ==============================================================================*/
@@ -60,6 +116,10 @@ public:
 
    BASE_DLL_API TaskQueue&  queue();
 
+   // Tasks which are not auto-deleted can be posted again once completed.
+   inline bool  autoDelete() const   { return _autoDelete; }
+   inline void  autoDelete( bool v ) { _autoDelete = v; }
+
 protected:
 
    friend class TaskQueue;
@@ -74,6 +134,10 @@ protected:
    BASE_DLL_API const StorageType&  storage() const;
    inline void*&  storage( const String& key ) { return storage()[key]; }
 
+   template< typename T >
+   inline T&  storage( const StorageSlot<T>& slot ) { return (T&)storage( slot.index() ); }
+   BASE_DLL_API void*&  storage( uint slotIndex );
+
    void incCount();
    void decCount();
 
@@ -82,6 +146,7 @@ protected:
    Task*        _parent;      //!< The task which spawned this task.
    WorkerTask*  _workerTask;  //!< The worker task associated with the task.
    AtomicInt32  _count;       //!< The number of outstanding child tasks that were spawned.
+   bool         _autoDelete;  //!< Whether or not the task deletes itself when completed.
 
 private:
 }; //class Task
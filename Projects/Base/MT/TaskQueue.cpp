@@ -20,6 +20,45 @@ DBG_STREAM( os_mtp, "MTP" );
 
 UNNAMESPACE_END
 
+
+/*==============================================================================
+  CLASS RangeTask
+==============================================================================*/
+
+//! A persistent task processing chunks of a TaskQueue::parallelFor() call.
+class RangeTask:
+   public Task
+{
+public:
+
+   /*----- methods -----*/
+
+   RangeTask( TaskQueue::RangeJob* job ): _job( job )
+   {
+      autoDelete( false );
+   }
+
+   virtual void execute()
+   {
+      TaskQueue::RangeJob& job = *_job;
+      WorkerTask&       worker = *_workerTask;
+      while( true )
+      {
+         uint b = uint(job._next += job._chunk) - job._chunk;
+         if( b >= job._end )  return;
+         uint e = job._end - b > job._chunk ? b + job._chunk : job._end;
+         job._func( job._data, b, e, worker );
+      }
+   }
+
+protected:
+
+   /*----- data members -----*/
+
+   TaskQueue::RangeJob*  _job;  //!< The job shared by all of the range tasks.
+};
+
+
 //------------------------------------------------------------------------------
 //!
 uint
@@ -36,15 +75,44 @@ TaskQueue::defaultNumberOfThreads()
    return n;
 }
 
+//------------------------------------------------------------------------------
+//! Returns the scheduling used when SCHEDULING_DEFAULT is requested.
+//! Can be overridden with the BASE_TASK_SCHEDULING environment variable
+//! (either "locked" or "stealing").
+TaskQueue::Scheduling
+TaskQueue::defaultScheduling()
+{
+   Scheduling s = SCHEDULING_LOCKED;
+   const char* env = getenv("BASE_TASK_SCHEDULING");
+   if( env )
+   {
+      if( strcmp( env, "stealing" ) == 0 )
+      {
+         s = SCHEDULING_WORK_STEALING;
+      }
+      else
+      if( strcmp( env, "locked" ) == 0 )
+      {
+         s = SCHEDULING_LOCKED;
+      }
+      fprintf( stderr, "\nTaskQueue: Overriding scheduling to '%s'.\n", s == SCHEDULING_WORK_STEALING ? "stealing" : "locked" );
+   }
+   return s;
+}
+
 //------------------------------------------------------------------------------
 //!
-TaskQueue::TaskQueue( uint nThreads ):
-   _nWaitFor( 0 )
+TaskQueue::TaskQueue( uint nThreads, Scheduling scheduling ):
+   _scheduling( scheduling ),
+   _nWaitFor( 0 ),
+   _nInjected( 0 ),
+   _nIdle( 0 )
 {
-   DBG_BLOCK( os_mt, "TaskQueue::TaskQueue(" << nThreads << ")" );
+   DBG_BLOCK( os_mt, "TaskQueue::TaskQueue(" << nThreads << ", " << scheduling << ")" );
    PROFILE_TASK_OPERATION( _nTasksSubmitted = 0 );
    PROFILE_TASK_OPERATION( _nTasksDeleted   = 0 );
    if( nThreads == 0 )  nThreads = defaultNumberOfThreads();
+   if( _scheduling == SCHEDULING_DEFAULT )  _scheduling = defaultScheduling();
    createThreads( nThreads );
 }
 
@@ -134,10 +202,11 @@ TaskQueue::createThreads( uint n )
    LockGuard  lock( _wTasksLock );
    for( uint i = 0; i < n; ++i )
    {
-      WorkerTask* task = new WorkerTask( this );
+      WorkerTask* task = new WorkerTask( this, i );
       Thread* thread = new Thread( task, false );
       _wTasks.pushBack( task );
       _threads.pushBack( thread );
+      _rangeTasks.pushBack( new RangeTask( &_rangeJob ) );
    }
 }
 
@@ -158,6 +227,8 @@ TaskQueue::deleteThreads()
       _wTasks.popBack();
 
       delete thread;
+      delete _rangeTasks.back();
+      _rangeTasks.popBack();
    }
 }
 
@@ -171,6 +242,19 @@ TaskQueue::post( Task* task )
    ++_nTasks;
    PROFILE_TASK_OPERATION( ++_nTasksSubmitted );
 
+   if( workStealing() )
+   {
+      // We don't know which thread we are called from, so we can't use the
+      // owner end of any lock-free deque.
+      {
+         LockGuard lock( _injectedLock );
+         _injected.pushBack( task );
+      }
+      ++_nInjected;
+      awakeIdle();
+      return;
+   }
+
    WorkerTask* queue = findBestQueue();
    queue->pushBack( task );
 }
@@ -185,9 +269,50 @@ TaskQueue::post( Task* task, WorkerTask* wt )
    ++_nTasks;
    PROFILE_TASK_OPERATION( ++_nTasksSubmitted );
 
+   if( workStealing() )
+   {
+      wt->pushStealing( task );
+      return;
+   }
+
    wt->pushFront( task );
 }
 
+//------------------------------------------------------------------------------
+//! Calls func( data, b, e, worker ) on chunks [b, e) covering [begin, end).
+//! See the templated version for details.
+void
+TaskQueue::parallelFor( uint begin, uint end, uint grainSize, RangeFunc func, void* data )
+{
+   DBG_BLOCK( os_mt, "TaskQueue::parallelFor(" << begin << ", " << end << ", " << grainSize << ")" );
+   if( begin >= end )  return;
+
+   // Only one parallelFor() can run at a time, since the range tasks are shared.
+   LockGuard lock( _rangeLock );
+
+   // Aim for a few chunks per worker (for load balancing), but never go
+   // below the grain size.
+   uint n        = end - begin;
+   uint nThreads = uint(_rangeTasks.size());
+   uint chunk    = n / (nThreads * 4);
+   if( chunk < grainSize )  chunk = grainSize;
+   if( chunk < 1 )          chunk = 1;
+   uint nChunks  = (n - 1) / chunk + 1;
+
+   _rangeJob._next  = int32_t(begin);
+   _rangeJob._end   = end;
+   _rangeJob._chunk = chunk;
+   _rangeJob._func  = func;
+   _rangeJob._data  = data;
+
+   uint nTasks = nChunks < nThreads ? nChunks : nThreads;
+   for( uint i = 0; i < nTasks; ++i )
+   {
+      post( _rangeTasks[i] );
+   }
+   waitForAll();
+}
+
 //------------------------------------------------------------------------------
 //! Waits for all outstanding job queues to be empty.
 void
@@ -284,18 +409,63 @@ TaskQueue::awakeAll()
 }
 
 
+//------------------------------------------------------------------------------
+//! Retrieves the oldest task posted from outside of the worker threads.
+Task*
+TaskQueue::popInjected()
+{
+   // Avoid the lock when there is obviously nothing to retrieve.
+   if( _nInjected <= 0 )  return NULL;
+
+   LockGuard lock( _injectedLock );
+   if( _injected.empty() )  return NULL;
+
+   Task* task = _injected.front();
+   _injected.popFront();
+   --_nInjected;
+   return task;
+}
+
+//------------------------------------------------------------------------------
+//! Wakes a single idle worker task, if any.
+void
+TaskQueue::awakeIdle()
+{
+   // The newly queued task must be visible before checking for idle workers
+   // (they set their flag before checking the queues one last time).
+   atomicBarrier();
+   if( _nIdle <= 0 )  return;
+
+   // Assumes _wTasks cannot change.
+   for( WorkerTaskContainer::Iterator cur = _wTasks.begin();
+        cur != _wTasks.end();
+        ++cur )
+   {
+      WorkerTask* t = *cur;
+      if( t->_sleeping.CAS( 1, 0 ) )
+      {
+         --_nIdle;
+         t->awake();
+         return;
+      }
+   }
+}
+
+
 /*==============================================================================
   CLASS WorkerTask
 ==============================================================================*/
 
 //------------------------------------------------------------------------------
 //!
-WorkerTask::WorkerTask( TaskQueue* queue ):
+WorkerTask::WorkerTask( TaskQueue* queue, uint id ):
    _queue( queue ),
+   _id( id ),
    _tasksSema( 0 ),
+   _sleeping( 0 ),
    _needsToStop( false )
 {
-   DBG_BLOCK( os_mt, "WorkerTask::WorkerTask( " << (void*)queue << " ) " << (void*)this );
+   DBG_BLOCK( os_mt, "WorkerTask::WorkerTask( " << (void*)queue << ", " << id << " ) " << (void*)this );
    //StdErr << "WorkerTask::WorkerTask( " << (void*)queue << " ) " << (void*)this << nl;
 
    PROFILE_TASK_OPERATION( _timeWaiting = 0.0 );
@@ -303,6 +473,11 @@ WorkerTask::WorkerTask( TaskQueue* queue ):
    PROFILE_TASK_OPERATION( _timeLocking = 0.0 );
    PROFILE_TASK_OPERATION( _timeOthers  = 0.0 );
    PROFILE_TASK_OPERATION( _nTasksSubmitted = 0 );
+
+   for( uint i = 0; i < StorageSlotBase::MAX_SLOTS; ++i )
+   {
+      _slots[i] = NULL;
+   }
 }
 
 //------------------------------------------------------------------------------
@@ -394,6 +569,81 @@ WorkerTask::findTaskToOffload()
    return NULL;
 }
 
+//------------------------------------------------------------------------------
+//! Retrieves a task to execute in work stealing mode: first from our own deque,
+//! then from the injected tasks, and finally by stealing from another worker.
+Task*
+WorkerTask::findStealingTask()
+{
+   Task* task = _stealTasks.pop();
+   if( task )  return task;
+
+   TaskQueue& q = queue();
+   task = q.popInjected();
+   if( task )
+   {
+      PROFILE_TASK_OPERATION( ++_nTasksSubmitted );
+      return task;
+   }
+
+   // Start with our neighbor, so that thieves are spread among victims.
+   uint n = uint(q._wTasks.size());
+   for( uint i = 1; i < n; ++i )
+   {
+      WorkerTask* wt = q._wTasks[(_id + i) % n];
+      task = wt->_stealTasks.steal();
+      if( task )  return task;
+   }
+
+   return NULL;
+}
+
+//------------------------------------------------------------------------------
+//! Returns true if any task is waiting to be executed (work stealing mode only).
+bool
+WorkerTask::hasStealingTasks()
+{
+   TaskQueue& q = queue();
+   if( q._nInjected > 0 )  return true;
+   // Assumes tm._wTasks cannot change.
+   for( TaskQueue::WorkerTaskContainer::Iterator it = q._wTasks.begin();
+        it != q._wTasks.end();
+        ++it )
+   {
+      if( !(*it)->_stealTasks.empty() )  return true;
+   }
+   return false;
+}
+
+//------------------------------------------------------------------------------
+//! Puts the worker task to sleep until more work is available (work stealing
+//! mode only).
+//! Returns true if the wait condition (specified as either a parent task
+//! waiting for its children, or a condition) is met, false otherwise.
+bool
+WorkerTask::idle( Task* parentTask, const Condition* cond )
+{
+   TaskQueue& q = queue();
+
+   // Advertise ourselves as idle before checking one last time, so that any
+   // task posted from now on will wake us.
+   _sleeping = 1;
+   ++(q._nIdle);
+
+   bool done = _needsToStop || (parentTask && parentTask->_count == 1) || (cond && (*cond)());
+   if( !done && !hasStealingTasks() )
+   {
+      PROFILE_TASK_OPERATION( _timeOthers += _timer.restart() );
+      _tasksSema.wait();
+      PROFILE_TASK_OPERATION( _timeWaiting += _timer.restart() );
+   }
+
+   // Unless someone woke us already, unregister ourselves.
+   if( _sleeping.CAS( 1, 0 ) )  --(q._nIdle);
+
+   return done;
+}
+
 //------------------------------------------------------------------------------
 //!
 void
@@ -404,6 +654,26 @@ WorkerTask::waitForAll( Task* parentTask )
    // Do we have task to wait for?
    if( parentTask && parentTask->_count == 1 ) return;
 
+   if( queue().workStealing() )
+   {
+      while( !_needsToStop )
+      {
+         Task* task = findStealingTask();
+         if( task )
+         {
+            execute( task );
+         }
+         else
+         {
+            idle( parentTask, NULL );
+         }
+
+         // Check if we are done waiting for all our children.
+         if( parentTask && parentTask->_count == 1 )  return; // End a recursive call.
+      }
+      return;
+   }
+
    do
    {
       PROFILE_TASK_OPERATION( _timeOthers += _timer.restart() );
@@ -460,6 +730,28 @@ WorkerTask::waitFor( const Condition& cond )
       return;
    }
 
+   if( queue().workStealing() )
+   {
+      while( !_needsToStop )
+      {
+         Task* task = findStealingTask();
+         if( task )
+         {
+            execute( task );
+         }
+         else
+         if( idle( NULL, &cond ) )
+         {
+            break;
+         }
+
+         // Check if we are done waiting for the condition.
+         if( cond() )  break;
+      }
+      --(queue()._nWaitFor);
+      return;
+   }
+
    do
    {
       PROFILE_TASK_OPERATION( _timeOthers += _timer.restart() );
@@ -15,6 +15,7 @@
 #include <Base/MT/Semaphore.h>
 #include <Base/MT/Task.h>
 #include <Base/MT/ValueTrigger.h>
+#include <Base/MT/WorkStealingDeque.h>
 #include <Base/Msg/Delegate.h>
 #include <Base/Msg/DelegateList.h>
 
@@ -38,6 +39,7 @@
 
 NAMESPACE_BEGIN
 
+class RangeTask;
 class Thread;
 class TaskQueue;
 
@@ -56,7 +58,7 @@ public:
 
    /*----- methods -----*/
 
-   WorkerTask( TaskQueue* queue );
+   WorkerTask( TaskQueue* queue, uint id );
 
    ~WorkerTask();
 
@@ -65,6 +67,11 @@ public:
    inline       StorageType&  storage()       { return _storage; }
    inline const StorageType&  storage() const { return _storage; }
 
+   template< typename T >
+   inline       T&  storage( const StorageSlot<T>& slot )       { return (T&)_slots[slot.index()]; }
+   template< typename T >
+   inline const T&  storage( const StorageSlot<T>& slot ) const { return (const T&)_slots[slot.index()]; }
+
    void  waitForAll( Task* parentTask );
    void  waitFor( const Condition& cond );
    void  execute();
@@ -74,15 +81,20 @@ public:
 protected:
 
    /*----- data types -----*/
-   typedef DEQueue< Task* >  TaskContainer;
+   typedef DEQueue< Task* >            TaskContainer;
+   typedef WorkStealingDeque< Task* >  StealingContainer;
 
    /*----- members -----*/
 
-   TaskQueue*     _queue;      //!< The queue which owns the worker task.
-   TaskContainer  _tasks;      //!< The tasks waiting to be executed.
-   Lock           _tasksLock;  //!< A lock to access _tasks in a thread-safe manner.
-   Semaphore      _tasksSema;  //!< A semaphore to put the worker task to sleep if the queue is empty.
-   StorageType    _storage;    //!< User data, similar to thread-local storage.
+   TaskQueue*         _queue;         //!< The queue which owns the worker task.
+   uint               _id;            //!< The index of the worker task inside the queue.
+   TaskContainer      _tasks;         //!< The tasks waiting to be executed.
+   Lock               _tasksLock;     //!< A lock to access _tasks in a thread-safe manner.
+   Semaphore          _tasksSema;     //!< A semaphore to put the worker task to sleep if the queue is empty.
+   StealingContainer  _stealTasks;    //!< The lock-free tasks (used instead of _tasks when work stealing).
+   AtomicInt32        _sleeping;      //!< Set to 1 while idling in work stealing mode (cleared by whoever wakes us).
+   StorageType        _storage;       //!< User data, similar to thread-local storage.
+   void*              _slots[StorageSlotBase::MAX_SLOTS]; //!< User data indexed by StorageSlot.
 
 #if BASE_PROFILE_TASKS
    Timer        _timer;       //!< A timer used to collect the times below;
@@ -119,6 +131,12 @@ private:
 
    inline void  awake() { _tasksSema.post(); }
 
+   // Work stealing routines.
+   inline void  pushStealing( Task* task );
+   Task*  findStealingTask();
+   bool   hasStealingTasks();
+   bool   idle( Task* parentTask, const Condition* cond );
+
 }; //class WorkerTask
 
 
@@ -129,15 +147,36 @@ class TaskQueue
 {
 public:
 
+   /*----- types -----*/
+
+   //! The strategy used to distribute tasks among the worker threads.
+   //! SCHEDULING_LOCKED keeps one locked DEQueue per worker, and posting
+   //! looks for the least busy worker.
+   //! SCHEDULING_WORK_STEALING uses lock-free Chase-Lev deques; spawned tasks
+   //! stay on their worker's deque, and idle workers steal from the others.
+   enum Scheduling
+   {
+      SCHEDULING_DEFAULT,
+      SCHEDULING_LOCKED,
+      SCHEDULING_WORK_STEALING
+   };
+
+   //! The routine called by parallelFor() on every chunk [begin, end).
+   typedef void (*RangeFunc)( void* data, uint begin, uint end, WorkerTask& worker );
+
    /*----- static methods -----*/
 
-   static BASE_DLL_API uint  defaultNumberOfThreads();
+   static BASE_DLL_API uint        defaultNumberOfThreads();
+   static BASE_DLL_API Scheduling  defaultScheduling();
 
    /*----- methods -----*/
 
-   BASE_DLL_API TaskQueue( uint nThreads = 0 );
+   BASE_DLL_API TaskQueue( uint nThreads = 0, Scheduling scheduling = SCHEDULING_DEFAULT );
    BASE_DLL_API ~TaskQueue();
 
+   inline Scheduling  scheduling() const { return _scheduling; }
+   inline bool        workStealing() const { return _scheduling == SCHEDULING_WORK_STEALING; }
+
    BASE_DLL_API void    print( TextStream& os = StdErr );
 
    BASE_DLL_API void    term( bool now = false );
@@ -147,10 +186,16 @@ public:
    BASE_DLL_API uint    numTasks();
    BASE_DLL_API void    setStorage( uint threadID, const String& key, void* data );
    BASE_DLL_API void*&  getStorage( uint threadID, const String& key );
+   template< typename T >
+   inline T&  storage( uint threadID, const StorageSlot<T>& slot ) { return _wTasks[threadID]->storage( slot ); }
 
    BASE_DLL_API void    post( Task* task );
    BASE_DLL_API void    waitForAll();
 
+   template< typename F >
+   inline void  parallelFor( uint begin, uint end, uint grainSize, F& functor );
+   BASE_DLL_API void  parallelFor( uint begin, uint end, uint grainSize, RangeFunc func, void* data );
+
 protected:
 
    /*----- methods -----*/
@@ -163,9 +208,21 @@ protected:
    /*----- data types -----*/
    typedef Vector< Thread* >      ThreadContainer;
    typedef Vector< WorkerTask* >  WorkerTaskContainer;
+   typedef Vector< RangeTask* >   RangeTaskContainer;
+
+   //! The state shared by all of the RangeTasks of a parallelFor() call.
+   struct RangeJob
+   {
+      AtomicInt32  _next;   //!< The beginning of the next chunk to process.
+      uint         _end;    //!< The end of the range.
+      uint         _chunk;  //!< The number of iterations in a chunk.
+      RangeFunc    _func;   //!< The routine to call on every chunk.
+      void*        _data;   //!< The user data passed to _func.
+   };
 
    /*----- data members -----*/
 
+   Scheduling           _scheduling;   //!< The scheduling strategy.
    ThreadContainer      _threads;      //!< The lists of threads.
    WorkerTaskContainer  _wTasks;       //!< The working task queue.
    Lock                 _wTasksLock;   //!< A lock to guarantee single-thread access on the jobs queue.
@@ -173,6 +230,17 @@ protected:
    ValueTrigger         _nThreads;     //!< The total number of active threads.
    AtomicInt32          _nWaitFor;     //!< The total number of outstanding waitFor() calls.
 
+   // Work stealing.
+   DEQueue< Task* >     _injected;     //!< Tasks posted from outside of the worker threads.
+   Lock                 _injectedLock; //!< A lock to access _injected in a thread-safe manner.
+   AtomicInt32          _nInjected;    //!< The number of tasks in _injected (read without locking).
+   AtomicInt32          _nIdle;        //!< The number of worker tasks idling (work stealing mode only).
+
+   // Parallel for.
+   RangeTaskContainer   _rangeTasks;   //!< Persistent tasks (one per thread) used by parallelFor().
+   RangeJob             _rangeJob;     //!< The current parallelFor() job.
+   Lock                 _rangeLock;    //!< A lock serializing parallelFor() calls.
+
 #if BASE_PROFILE_TASKS
    AtomicInt32          _nTasksSubmitted; //!< The total number of submitted tasks.
    AtomicInt32          _nTasksDeleted;   //!< The total number of deleted tasks.
@@ -194,8 +262,34 @@ private:
    void  awakeAll();
    void  awakeAllWaitFor() { if( _nWaitFor > 0 )  awakeAll(); }
 
+   // Work stealing routines.
+   Task*  popInjected();
+   void   awakeIdle();
+
+   friend class RangeTask;
+   template< typename F >
+   static void  rangeCall( void* data, uint begin, uint end, WorkerTask& worker )
+   {
+      (*(F*)data)( begin, end, worker );
+   }
+
 }; //class TaskQueue
 
+//------------------------------------------------------------------------------
+//! Calls functor( begin, end, worker ) on consecutive chunks of the range
+//! [begin, end), spread over all of the worker threads, and returns once the
+//! whole range got processed.
+//! The chunks contain at least grainSize iterations, but grow with the size of
+//! the range to only have a few chunks per worker thread.  Workers grab chunks
+//! dynamically, which balances uneven workloads.
+//! No memory gets allocated, since persistent tasks are used.
+//! Like waitForAll(), this must not be called from inside of a task.
+template< typename F > inline void
+TaskQueue::parallelFor( uint begin, uint end, uint grainSize, F& functor )
+{
+   parallelFor( begin, end, grainSize, &TaskQueue::rangeCall<F>, &functor );
+}
+
 //------------------------------------------------------------------------------
 //!
 inline TaskQueue&
@@ -284,6 +378,17 @@ WorkerTask::pushFront( Task* task )
    _tasksSema.post();
 }
 
+//------------------------------------------------------------------------------
+//! Pushes a task on the owner end of the lock-free deque.
+//! Must only be called from the thread running this worker task.
+inline void
+WorkerTask::pushStealing( Task* task )
+{
+   PROFILE_TASK_OPERATION( ++_nTasksSubmitted );
+   _stealTasks.push( task );
+   queue().awakeIdle();
+}
+
 NAMESPACE_END
 
 #endif //BASE_TASK_QUEUE_H
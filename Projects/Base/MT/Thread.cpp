@@ -87,6 +87,8 @@ private:
       thread->_task->execute();
       if( autofree )
       {
+         // The task can complete before the Thread constructor even returns.
+         thread->waitForImp();
          delete thread;
       }
       return 0;
@@ -197,6 +199,8 @@ private:
       thread->_task->execute();
       if( autofree )
       {
+         // The task can complete before the Thread constructor even returns.
+         thread->waitForImp();
          delete thread;
       }
       return 0;
@@ -242,6 +246,7 @@ Thread::yield()
 //------------------------------------------------------------------------------
 //!
 Thread::Thread( BaseTask* task, bool autofree ):
+   _imp( NULL ),
    _task( task ),
    _autofree( autofree )
 {
@@ -256,6 +261,18 @@ Thread::~Thread()
    delete _imp;
 }
 
+//------------------------------------------------------------------------------
+//! Waits until the constructor has assigned _imp (only needed by auto-freed
+//! threads, which delete themselves from their own thread).
+void
+Thread::waitForImp()
+{
+   while( *(ThreadImp* volatile*)&_imp == NULL )
+   {
+      ThreadImp::yield();
+   }
+}
+
 //------------------------------------------------------------------------------
 //!
 void
@@ -47,6 +47,8 @@ private:
 
    /*----- methods -----*/
 
+   void waitForImp();
+
    //! Disallow copying for this class and its children.
    Thread( const Thread& );
    Thread& operator=( const Thread& );
@@ -0,0 +1,194 @@
+/*=============================================================================
+   Copyright (c) 2012, Ludo Sapiens Inc. and contributors.
+   See accompanying file LICENSE.txt for details.
+=============================================================================*/
+#ifndef BASE_WORK_STEALING_DEQUE_H
+#define BASE_WORK_STEALING_DEQUE_H
+
+#include <Base/StdDefs.h>
+
+#include <Base/ADT/Vector.h>
+#include <Base/Dbg/Defs.h>
+#include <Base/MT/Atomic.h>
+
+NAMESPACE_BEGIN
+
+/*==============================================================================
+  CLASS WorkStealingDeque
+==============================================================================*/
+
+//! A lock-free double-ended queue implementing the Chase-Lev algorithm.
+//! A single owner thread pushes and pops elements at the bottom (LIFO), while
+//! any number of thief threads can concurrently steal from the top (FIFO).
+//! Ref:
+//!   D. Chase, Y. Lev, "Dynamic Circular Work-Stealing Deque", SPAA 2005.
+//!   N.M. Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP 2013.
+//! T needs to be a POD type (typically a pointer), since elements are copied
+//! around without any construction nor destruction, and NULL-like values are
+//! returned (T(0)) when the queue is empty or a steal attempt failed.
+//! Indices are 32b, and are compared through their difference, so they can
+//! safely wrap around.
+//! Arrays replaced when growing are kept alive until the deque is destroyed,
+//! since a thief could still be reading from them.
+template< typename T >
+class WorkStealingDeque
+{
+public:
+
+   /*----- methods -----*/
+
+   WorkStealingDeque( uint capacity = 64 );
+   ~WorkStealingDeque();
+
+   // Owner-only routines.
+   void  push( const T& v );
+   T     pop();
+
+   // Thief routine (can be called by anyone).
+   T     steal();
+
+   inline bool  empty() const { return size() <= 0; }
+   inline int   size() const  { return int(_bottom - int32_t(_top)); }
+
+protected:
+
+   /*----- classes -----*/
+
+   struct Array
+   {
+      Array( uint logSize ): _mask( (1<<logSize) - 1 ), _data( new T[1<<logSize] ) { }
+      ~Array() { delete [] _data; }
+
+      inline int32_t  size() const { return _mask + 1; }
+
+      inline T     get( int32_t i ) const    { return _data[i & _mask]; }
+      inline void  put( int32_t i, const T& v ) { _data[i & _mask] = v; }
+
+      int32_t  _mask;
+      T*       _data;
+   };
+
+   /*----- methods -----*/
+
+   Array*  grow( Array* a, int32_t b, int32_t t );
+
+   //! Disallow copying.
+   WorkStealingDeque( const WorkStealingDeque& );
+   WorkStealingDeque& operator=( const WorkStealingDeque& );
+
+   /*----- data members -----*/
+
+   AtomicInt32         _top;       //!< The steal end (incremented by thieves and owner).
+   volatile int32_t    _bottom;    //!< The owner end (only written by the owner).
+   Array* volatile     _array;     //!< The current circular array.
+   Vector<Array*>      _retired;   //!< Previous arrays, kept until destruction.
+};
+
+//------------------------------------------------------------------------------
+//!
+template< typename T >
+WorkStealingDeque<T>::WorkStealingDeque( uint capacity ):
+   _top( 0 ),
+   _bottom( 0 )
+{
+   uint logSize = 1;
+   while( (1u << logSize) < capacity )  ++logSize;
+   _array = new Array( logSize );
+}
+
+//------------------------------------------------------------------------------
+//!
+template< typename T >
+WorkStealingDeque<T>::~WorkStealingDeque()
+{
+   delete _array;
+   for( uint i = 0; i < _retired.size(); ++i )
+   {
+      delete _retired[i];
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Pushes an element at the bottom of the queue (owner only).
+template< typename T > void
+WorkStealingDeque<T>::push( const T& v )
+{
+   int32_t b = _bottom;
+   int32_t t = _top;
+   Array*  a = _array;
+   if( b - t > a->size() - 1 )  a = grow( a, b, t );
+   a->put( b, v );
+   // Publish the element before the new bottom.
+   atomicBarrier();
+   _bottom = b + 1;
+}
+
+//------------------------------------------------------------------------------
+//! Pops the element at the bottom of the queue (owner only).
+//! Returns T(0) if the queue is empty (or the last element got stolen).
+template< typename T > T
+WorkStealingDeque<T>::pop()
+{
+   int32_t b = _bottom - 1;
+   Array*  a = _array;
+   _bottom   = b;
+   // The store to bottom must be visible before reading top.
+   atomicBarrier();
+   int32_t t = _top;
+   if( b - t < 0 )
+   {
+      // Empty queue.
+      _bottom = b + 1;
+      return T(0);
+   }
+
+   T v = a->get( b );
+   if( b == t )
+   {
+      // Last element: race against thieves.
+      if( !_top.CAS( t, t + 1 ) )  v = T(0);
+      _bottom = b + 1;
+   }
+   return v;
+}
+
+//------------------------------------------------------------------------------
+//! Steals the element at the top of the queue.
+//! Returns T(0) if the queue is empty or if another thread won the race.
+template< typename T > T
+WorkStealingDeque<T>::steal()
+{
+   int32_t t = _top;
+   // Read top before bottom.
+   atomicBarrier();
+   int32_t b = _bottom;
+   if( b - t <= 0 )  return T(0);
+
+   Array* a = _array;
+   T v = a->get( t );
+   if( !_top.CAS( t, t + 1 ) )  return T(0);
+   return v;
+}
+
+//------------------------------------------------------------------------------
+//! Doubles the size of the circular array (owner only).
+template< typename T > typename WorkStealingDeque<T>::Array*
+WorkStealingDeque<T>::grow( Array* a, int32_t b, int32_t t )
+{
+   uint logSize = 1;
+   while( (1 << logSize) < a->size() )  ++logSize;
+   Array* na = new Array( logSize + 1 );
+   for( int32_t i = t; i != b; ++i )
+   {
+      na->put( i, a->get(i) );
+   }
+   _retired.pushBack( a );
+   // Copies need to be visible before the new array.
+   atomicBarrier();
+   _array = na;
+   return na;
+}
+
+NAMESPACE_END
+
+#endif //BASE_WORK_STEALING_DEQUE_H
@@ -12,6 +12,7 @@
 #include <Base/ADT/Heap.h>
 #include <Base/ADT/Map.h>
 #include <Base/ADT/MapWithDefault.h>
+#include <Base/ADT/MemoryArena.h>
 #include <Base/ADT/Pair.h>
 #include <Base/ADT/Queue.h>
 #include <Base/ADT/RCVector.h>
@@ -708,6 +709,67 @@ void adt_map_default( Test::Result& res )
    TEST_ADD( res, map.size() == 1 );
 }
 
+class CountingAllocator:
+   public MemoryArena::Allocator
+{
+public:
+   CountingAllocator(): _allocs(0), _frees(0) {}
+   virtual void* allocate( size_t size ) { ++_allocs; return malloc( size ); }
+   virtual void  deallocate( void* ptr ) { ++_frees; free( ptr ); }
+   uint  _allocs;
+   uint  _frees;
+};
+
+void adt_memory_arena( Test::Result& res )
+{
+   CountingAllocator counter;
+   {
+      MemoryArena arena( 256, &counter );
+      TEST_ADD( res, arena.numBlocks() == 0 );
+      TEST_ADD( res, arena.used() == 0 );
+
+      // Alignment and stable pointers.
+      char*   c = arena.store( 'a' );
+      double* d = arena.store( 1.5 );
+      TEST_ADD( res, (size_t(d) & (alignof(double)-1)) == 0 );
+      Vector<uint*> ptrs;
+      for( uint i = 0; i < 100; ++i ) ptrs.pushBack( arena.store( i ) );
+      bool ok = *c == 'a' && *d == 1.5;
+      for( uint i = 0; i < 100; ++i ) ok &= *ptrs[i] == i;
+      TEST_ADD( res, ok );
+      TEST_ADD( res, arena.numBlocks() > 1 );
+      TEST_ADD( res, counter._allocs == arena.numBlocks() );
+
+      // Larger than a block.
+      void* big = arena.alloc( 1000 );
+      TEST_ADD( res, big != nullptr );
+      memset( big, 0, 1000 );
+
+      // The blocks get merged, after which the same usage doesn't allocate.
+      size_t used = arena.used();
+      arena.reset();
+      TEST_ADD( res, arena.used() == 0 );
+      TEST_ADD( res, arena.numBlocks() == 1 );
+      TEST_ADD( res, arena.capacity() >= used );
+      uint allocs = counter._allocs;
+      for( uint frame = 0; frame < 10; ++frame )
+      {
+         arena.store( 'a' );
+         arena.store( 1.5 );
+         for( uint i = 0; i < 100; ++i ) arena.store( i );
+         arena.alloc( 1000 );
+         arena.reset();
+      }
+      TEST_ADD( res, counter._allocs == allocs );
+
+      arena.clear();
+      TEST_ADD( res, arena.numBlocks() == 0 );
+      TEST_ADD( res, counter._frees == counter._allocs );
+      arena.store( 1 );
+   }
+   TEST_ADD( res, counter._frees == counter._allocs );
+}
+
 void adt_pair( Test::Result& res )
 {
    Pair<uint, String> pair( 1, "one" );
@@ -1486,6 +1548,7 @@ void  init_adt()
    col->add( new Test::Function("heap",        "Tests the Heap data structure",        adt_heap        ) );
    col->add( new Test::Function("map",         "Tests the Map data structure",         adt_map         ) );
    col->add( new Test::Function("map_default", "Tests the Map data structure",         adt_map_default ) );
+   col->add( new Test::Function("memory_arena","Tests the MemoryArena allocator",      adt_memory_arena) );
    col->add( new Test::Function("pair",        "Tests the Pair data structure",        adt_pair        ) );
    col->add( new Test::Function("queue",       "Tests the Queue data structure",       adt_queue       ) );
    col->add( new Test::Function("rcvector",    "Tests the RCVector data structure",    adt_rcvector    ) );
@@ -22,6 +22,9 @@
 #include <Base/ADT/String.h>
 #include <Base/Dbg/DebugStream.h>
 #include <Base/Util/Platform.h>
+#include <Base/Util/Timer.h>
+
+#include <cstring>
 
 USING_NAMESPACE
 
@@ -130,6 +133,115 @@ void io_binary_stream_endian( Test::Result& res )
 
 }
 
+//------------------------------------------------------------------------------
+//! Checks that the bulk routines produce the same bytes as the scalar ones,
+//! and read them back, for n elements of type T in the specified endianness.
+template< typename T >
+bool io_bulk_round_trip( uint n, BinaryStream::Endian endian )
+{
+   Vector<T> src( n );
+   for( uint i = 0; i < n; ++i )
+   {
+      src[i] = T(0x0102030405060708ull * (i+1));
+   }
+
+   // Devices clear their string when created, so they all come first.
+   String scalarStr, bulkStr;
+   BinaryStream scalarOS( new StringDevice( scalarStr, IODevice::MODE_WRITE ), endian );
+   BinaryStream bulkOS( new StringDevice( bulkStr, IODevice::MODE_WRITE ), endian );
+   BinaryStream bulkIS( new StringDevice( bulkStr, IODevice::MODE_READ ), endian );
+
+   for( uint i = 0; i < n; ++i )
+   {
+      scalarOS << src[i];
+   }
+   if( bulkOS.write( src.data(), n ) != n || bulkStr != scalarStr )  return false;
+
+   Vector<T> dst( n );
+   if( bulkIS.read( dst.data(), n ) != n )  return false;
+   return n == 0 || memcmp( src.data(), dst.data(), n*sizeof(T) ) == 0;
+}
+
+void io_binary_stream_bulk( Test::Result& res )
+{
+   // Odd counts exercise the tails of the swapping loops, and the large
+   // ones the chunking of the swapped writes.
+   const uint counts[] = { 0, 1, 3, 37, 3001 };
+   const BinaryStream::Endian endians[] = {
+      BinaryStream::ENDIAN_NATIVE, BinaryStream::ENDIAN_LITTLE, BinaryStream::ENDIAN_BIG
+   };
+   for( uint e = 0; e < 3; ++e )
+   {
+      for( uint c = 0; c < 5; ++c )
+      {
+         TEST_ADD( res, io_bulk_round_trip<uint8_t> ( counts[c], endians[e] ) );
+         TEST_ADD( res, io_bulk_round_trip<uint16_t>( counts[c], endians[e] ) );
+         TEST_ADD( res, io_bulk_round_trip<uint32_t>( counts[c], endians[e] ) );
+         TEST_ADD( res, io_bulk_round_trip<uint64_t>( counts[c], endians[e] ) );
+         TEST_ADD( res, io_bulk_round_trip<float>   ( counts[c], endians[e] ) );
+         TEST_ADD( res, io_bulk_round_trip<double>  ( counts[c], endians[e] ) );
+      }
+   }
+
+   // Short reads only count complete elements.
+   String str;
+   BinaryStream is( new StringDevice( str, IODevice::MODE_READ ), BinaryStream::ENDIAN_BIG );
+   str = "\x01\x02\x03\x04\x05\x06";
+   uint32_t v[2];
+   TEST_ADD( res, is.read( v, 2 ) == 1 );
+   TEST_ADD( res, v[0] == 0x01020304 );
+}
+
+void io_binary_stream_perf( Test::Result& )
+{
+   const uint n = 1 << 22;
+   Vector<float> src( n ), dst( n );
+   for( uint i = 0; i < n; ++i )
+   {
+      src[i] = float(i);
+   }
+   const double mb = double(n*sizeof(float)) / (1024.0*1024.0);
+   const char* names[] = { "native", "swapped" };
+#if (CPU_ENDIANNESS == CPU_ENDIAN_BIG)
+   const BinaryStream::Endian endians[] = { BinaryStream::ENDIAN_BIG, BinaryStream::ENDIAN_LITTLE };
+#else
+   const BinaryStream::Endian endians[] = { BinaryStream::ENDIAN_LITTLE, BinaryStream::ENDIAN_BIG };
+#endif
+
+   for( uint e = 0; e < 2; ++e )
+   {
+      String str;
+      RCP<StringDevice> odev = new StringDevice( str, IODevice::MODE_WRITE );
+      RCP<StringDevice> idev = new StringDevice( str, IODevice::MODE_READ );
+      BinaryStream os( odev.ptr(), endians[e] );
+      BinaryStream is( idev.ptr(), endians[e] );
+      str.reserve( n*sizeof(float) );
+
+      Timer timer;
+      for( uint i = 0; i < n; ++i )
+      {
+         os << src[i];
+      }
+      double tScalarOut = timer.restart();
+      for( uint i = 0; i < n; ++i )
+      {
+         is >> dst[i];
+      }
+      double tScalarIn = timer.restart();
+
+      odev->reset();
+      timer.restart();
+      os.write( src.data(), n );
+      double tBulkOut = timer.restart();
+      idev->seek( 0 );
+      is.read( dst.data(), n );
+      double tBulkIn = timer.restart();
+
+      StdErr << names[e] << ": scalar write " << mb/tScalarOut << " MB/s, read " << mb/tScalarIn << " MB/s"
+             << "; bulk write " << mb/tBulkOut << " MB/s, read " << mb/tBulkIn << " MB/s" << nl;
+   }
+}
+
 void io_file_input( Test::Result& res )
 {
    RCP<FileDevice>  fd;
@@ -790,6 +902,7 @@ void init_io()
    RCP<Test::Collection> col = new Test::Collection( "io", "Collection for Base/IO" );
    col->add( new Test::Function("binary_stream"         , "Tests binary stream"                                  , io_binary_stream         ) );
    col->add( new Test::Function("binary_stream_endian"  , "Tests binary stream endianness"                       , io_binary_stream_endian  ) );
+   col->add( new Test::Function("binary_stream_bulk"    , "Tests binary stream bulk reads and writes"            , io_binary_stream_bulk    ) );
    col->add( new Test::Function("file_input"            , "Tests FileDevice input capability"                    , io_file_input            ) );
    col->add( new Test::Function("file_input_gz"         , "Tests GZippedFileDevice input capability"             , io_file_input_gz         ) );
    col->add( new Test::Function("file_output"           , "Tests FileDevice output capability"                   , io_file_output           ) );
@@ -809,4 +922,5 @@ void init_io()
    Test::special().add( new Test::Function("indent"     , "Prints out indentation variations"    , io_indent     ) );
    Test::special().add( new Test::Function("text_stream", "Prints out data using a TextStream"   , io_text_stream) );
    Test::special().add( new Test::Function("io_sync"    , "Tries to get a FileDevice out-of-sync", io_sync       ) );
+   Test::special().add( new Test::Function("binary_perf", "Times scalar and bulk binary streaming", io_binary_stream_perf) );
 }
@@ -10,6 +10,7 @@
 #include <Base/MT/TaskQueue.h>
 #include <Base/MT/Thread.h>
 #include <Base/MT/ValueTrigger.h>
+#include <Base/MT/WorkStealingDeque.h>
 
 #include <Base/Util/Platform.h>
 #include <Base/Util/Timer.h>
@@ -25,6 +26,9 @@ int32_t        gValue;
 AtomicInt32    gAI32;
 AtomicInt32*   gAI32p  = NULL;
 
+StorageSlot<intptr_t>  gSlot;
+StorageSlot<void*>     gSlot2;
+
 // Inserts a 4b value 'v' into the specified 'dst' variable.
 inline void  atomicInsert4( int32_t& dst, const int32_t v )
 {
@@ -355,6 +359,68 @@ public:
    uint  _id;
 };
 
+class StealerTask:
+   public BaseTask
+{
+public:
+   StealerTask( WorkStealingDeque<intptr_t>* deque, AtomicInt32* taken, AtomicInt32* done ):
+      _deque( deque ), _taken( taken ), _done( done ) { }
+   virtual void execute()
+   {
+      while( *_done == 0 || !_deque->empty() )
+      {
+         intptr_t v = _deque->steal();
+         if( v != 0 )  ++_taken[v-1];
+      }
+   }
+   WorkStealingDeque<intptr_t>*  _deque;
+   AtomicInt32*                  _taken;
+   AtomicInt32*                  _done;
+};
+
+class TinyTask:
+   public Task
+{
+public:
+   virtual void execute()
+   {
+      int32_t a = 0;
+      int32_t b = 1;
+      for( int32_t i = 0; i < 256; ++i )
+      {
+         b = b + a;
+         a = b - a;
+      }
+      gAI32 += (b & 1);
+   }
+};
+
+class CountRange
+{
+public:
+   CountRange( AtomicInt32* counts ): _counts( counts ), _nChunks( 0 ) { }
+   void operator()( uint begin, uint end, WorkerTask& /*worker*/ )
+   {
+      ++_nChunks;
+      for( uint i = begin; i < end; ++i )  ++_counts[i];
+   }
+   AtomicInt32*  _counts;
+   AtomicInt32   _nChunks;
+};
+
+class TinyRange
+{
+public:
+   void operator()( uint begin, uint end, WorkerTask& /*worker*/ )
+   {
+      for( uint i = begin; i < end; ++i )
+      {
+         TinyTask t;
+         t.execute();
+      }
+   }
+};
+
 void mt_atomic32( Test::Result& res )
 {
    gValue = 0;
@@ -434,6 +500,217 @@ void mt_fib( Test::Result& res )
    //StdErr << "res=" << serial << "," << parallel << nl;
 }
 
+void mt_stealing_deque( Test::Result& res )
+{
+   // Owner-only behavior (LIFO).
+   WorkStealingDeque<intptr_t> deque( 2 );
+   TEST_ADD( res, deque.empty() );
+   TEST_ADD( res, deque.pop() == 0 );
+   TEST_ADD( res, deque.steal() == 0 );
+   for( intptr_t i = 1; i <= 100; ++i )
+   {
+      deque.push( i );
+   }
+   TEST_ADD( res, deque.size() == 100 );
+   TEST_ADD( res, deque.pop() == 100 );
+   TEST_ADD( res, deque.steal() == 1 ); // Thieves get the oldest.
+   TEST_ADD( res, deque.pop() == 99 );
+   TEST_ADD( res, deque.size() == 97 );
+   while( deque.pop() != 0 ) { }
+   TEST_ADD( res, deque.empty() );
+
+   // Concurrent thieves: every element must be retrieved exactly once.
+   const int32_t n = 1 << 16;
+   Vector<AtomicInt32> taken( n );
+   for( int32_t i = 0; i < n; ++i )  taken[i] = 0;
+   AtomicInt32 done( 0 );
+   Vector<Thread*> thieves;
+   for( uint i = 0; i < 3; ++i )
+   {
+      thieves.pushBack( new Thread( new StealerTask( &deque, taken.data(), &done ) ) );
+   }
+   for( int32_t i = 1; i <= n; ++i )
+   {
+      deque.push( i );
+      if( (i & 3) == 0 )
+      {
+         intptr_t v = deque.pop();
+         if( v != 0 )  ++taken[v-1];
+      }
+   }
+   done = 1;
+   for( uint i = 0; i < thieves.size(); ++i )
+   {
+      thieves[i]->wait();
+      delete thieves[i];
+   }
+   uint nBad = 0;
+   for( int32_t i = 0; i < n; ++i )
+   {
+      if( taken[i] != 1 )  ++nBad;
+   }
+   TEST_ADD( res, nBad == 0 );
+   TEST_ADD( res, deque.empty() );
+}
+
+void mt_stealing( Test::Result& res )
+{
+   TaskQueue queue( 2, TaskQueue::SCHEDULING_WORK_STEALING );
+   TEST_ADD( res, queue.workStealing() );
+
+   // Recursive spawning.
+   uint n = 20;
+   uint serial = SerialFib( n );
+   uint parallel;
+   queue.post( new Fib( n, parallel ) );
+   queue.waitForAll();
+   TEST_ADD( res, serial == parallel );
+
+   // Multi-level spawning.
+   const uint s = 5;
+   AtomicInt32  values[s];
+   for( uint i = 0; i < s; ++i )  values[i] = 0;
+   gAI32p = values;
+   for( uint i = 0; i < s; ++i )
+   {
+      queue.post( new SpawnL0( i ) );
+   }
+   queue.waitForAll();
+   for( uint i = 0; i < s; ++i )
+   {
+      int total = (int(i*i*i) << 16) + (int(i*i) << 8) + (int(i) << 4) + 1;
+      TEST_ADD( res, gAI32p[i] == total );
+   }
+
+   // Many flat posts.
+   for( uint i = 0; i < 64; ++i )
+   {
+      for( uint t = 0; t < 32; ++t )
+      {
+         queue.post( new SimpleTask() );
+      }
+      queue.waitForAll();
+      TEST_ADD( res, queue.numTasks() == 0 );
+   }
+}
+
+class SlotTask:
+   public Task
+{
+public:
+   SlotTask( AtomicInt32* nBad ): _nBad( nBad ) { }
+   virtual void execute()
+   {
+      // The slot and the String key were set to the same value.
+      intptr_t v = storage( gSlot );
+      if( v < 1 || v != (intptr_t)storage( "key" ) || storage( gSlot2 ) != NULL )  ++(*_nBad);
+   }
+   AtomicInt32*  _nBad;
+};
+
+class SlotRange
+{
+public:
+   SlotRange(): _nBad( 0 ) { }
+   void operator()( uint begin, uint end, WorkerTask& worker )
+   {
+      for( uint i = begin; i < end; ++i )
+      {
+         intptr_t v = worker.storage( gSlot );
+         if( v < 1 || v != (intptr_t)worker.storage()["key"] )  ++_nBad;
+      }
+   }
+   AtomicInt32  _nBad;
+};
+
+class LookupRange
+{
+public:
+   LookupRange( bool slot, uint n ): _slot( slot ), _n( n ), _sum( 0 ) { }
+   void operator()( uint /*begin*/, uint /*end*/, WorkerTask& worker )
+   {
+      intptr_t sum = 0;
+      if( _slot )
+      {
+         for( uint i = 0; i < _n; ++i )  sum += worker.storage( gSlot );
+      }
+      else
+      {
+         for( uint i = 0; i < _n; ++i )  sum += (intptr_t)worker.storage()["brain.vm"];
+      }
+      _sum = sum;
+   }
+   bool      _slot;
+   uint      _n;
+   intptr_t  _sum;
+};
+
+void mt_parallel_for( Test::Result& res )
+{
+   const TaskQueue::Scheduling schedulings[] = { TaskQueue::SCHEDULING_LOCKED, TaskQueue::SCHEDULING_WORK_STEALING };
+   const uint n = 10000;
+   Vector<AtomicInt32> counts( n );
+   for( uint s = 0; s < 2; ++s )
+   {
+      TaskQueue queue( 3, schedulings[s] );
+      const uint grains[] = { 0, 1, 7, 100, 20000 };
+      for( uint g = 0; g < 5; ++g )
+      {
+         for( uint i = 0; i < n; ++i )  counts[i] = 0;
+         CountRange range( counts.data() );
+         queue.parallelFor( 10, n, grains[g], range );
+         TEST_ADD( res, queue.numTasks() == 0 );
+         uint nBad = 0;
+         for( uint i = 0; i < n; ++i )
+         {
+            if( counts[i] != (i < 10 ? 0 : 1) )  ++nBad;
+         }
+         TEST_ADD( res, nBad == 0 );
+         TEST_ADD( res, range._nChunks >= 1 );
+         if( grains[g] >= n )  TEST_ADD( res, range._nChunks == 1 );
+      }
+
+      // Empty ranges do nothing.
+      CountRange range( counts.data() );
+      queue.parallelFor( 5, 5, 1, range );
+      TEST_ADD( res, range._nChunks == 0 );
+
+      // Range tasks are reused across calls.
+      for( uint i = 0; i < 100; ++i )
+      {
+         queue.parallelFor( 0, 64, 1, range );
+      }
+      TEST_ADD( res, queue.numTasks() == 0 );
+   }
+}
+
+void mt_storage_slot( Test::Result& res )
+{
+   TEST_ADD( res, gSlot.index() != gSlot2.index() );
+   TEST_ADD( res, gSlot.index() < StorageSlotBase::MAX_SLOTS );
+   TEST_ADD( res, gSlot2.index() < StorageSlotBase::MAX_SLOTS );
+
+   TaskQueue queue( 3 );
+   for( uint i = 0; i < queue.numAllocatedThreads(); ++i )
+   {
+      TEST_ADD( res, queue.storage( i, gSlot ) == 0 );
+      queue.storage( i, gSlot ) = i + 1;
+      queue.setStorage( i, "key", (void*)intptr_t(i + 1) );
+   }
+
+   AtomicInt32 nBad( 0 );
+   for( uint i = 0; i < 100; ++i )
+   {
+      queue.post( new SlotTask( &nBad ) );
+   }
+   queue.waitForAll();
+   TEST_ADD( res, nBad == 0 );
+
+   SlotRange range;
+   queue.parallelFor( 0, 1000, 1, range );
+   TEST_ADD( res, range._nBad == 0 );
+}
+
 void mt_simple( Test::Result& res )
 {
    Semaphore  sem1( 0 );
@@ -563,6 +840,105 @@ void mt_worker_threads( Test::Result& res )
    //TEST_ADD( res, nThreads == queue.numThreads() ); // Should be identical.
 }
 
+void mt_scheduling_timed( Test::Result& res )
+{
+   // Compares the locked and work stealing schedulings with an increasing
+   // number of threads, for both flat posting (e.g. World::runBrains) and
+   // recursive spawning.
+   const TaskQueue::Scheduling schedulings[] = { TaskQueue::SCHEDULING_LOCKED, TaskQueue::SCHEDULING_WORK_STEALING };
+   const char* names[] = { "locked  ", "stealing" };
+   const uint nFlat = 1 << 14;
+   const uint nFib  = 24;
+   const uint serial = SerialFib( nFib );
+   StdErr << nl;
+   StdErr << "Hardware threads: " << Thread::numHardwareThreads() << nl;
+   for( uint nThreads = 1; nThreads <= 16; nThreads *= 2 )
+   {
+      for( uint s = 0; s < 2; ++s )
+      {
+         TaskQueue queue( nThreads, schedulings[s] );
+         Timer timer;
+         gAI32 = 0;
+         for( uint f = 0; f < 8; ++f )
+         {
+            for( uint i = 0; i < nFlat; ++i )
+            {
+               queue.post( new TinyTask() );
+            }
+            queue.waitForAll();
+         }
+         double tFlat = timer.restart();
+         uint parallel;
+         queue.post( new Fib( nFib, parallel ) );
+         queue.waitForAll();
+         double tFib = timer.elapsed();
+         TEST_ADD( res, parallel == serial );
+         StdErr << nThreads << " threads " << names[s]
+                << ": flat=" << tFlat << " s"
+                << " fib=" << tFib << " s" << nl;
+      }
+   }
+}
+
+void mt_parallel_for_timed( Test::Result& /*res*/ )
+{
+   // Compares posting one task per element (as done per entity in the World)
+   // with a single parallelFor() call.
+   const uint n      = 10000;
+   const uint frames = 32;
+   StdErr << nl;
+   for( uint nThreads = 1; nThreads <= 8; nThreads *= 2 )
+   {
+      TaskQueue queue( nThreads );
+      Timer timer;
+      for( uint f = 0; f < frames; ++f )
+      {
+         for( uint i = 0; i < n; ++i )
+         {
+            queue.post( new TinyTask() );
+         }
+         queue.waitForAll();
+      }
+      double tTasks = timer.restart();
+      TinyRange range;
+      for( uint f = 0; f < frames; ++f )
+      {
+         queue.parallelFor( 0, n, 16, range );
+      }
+      double tRange = timer.elapsed();
+      StdErr << nThreads << " threads, " << n << " elements:"
+             << " tasks=" << tTasks/frames*1000.0 << " ms/frame"
+             << " parallelFor=" << tRange/frames*1000.0 << " ms/frame" << nl;
+   }
+}
+
+void mt_storage_timed( Test::Result& res )
+{
+   // Compares the String-keyed storage lookup with a StorageSlot access.
+   const uint n = 1000000;
+   TaskQueue queue( 1 );
+   queue.setStorage( 0, "brain.vm", (void*)intptr_t(1) );
+   queue.storage( 0, gSlot ) = 1;
+   // Add a few more keys, as a real application would.
+   queue.setStorage( 0, "a.key", NULL );
+   queue.setStorage( 0, "some.other.key", NULL );
+   queue.setStorage( 0, "zzz", NULL );
+
+   Timer timer;
+   LookupRange mapRange( false, n );
+   queue.parallelFor( 0, 1, 1, mapRange );
+   double tMap = timer.restart();
+   LookupRange slotRange( true, n );
+   queue.parallelFor( 0, 1, 1, slotRange );
+   double tSlot = timer.elapsed();
+   TEST_ADD( res, mapRange._sum == intptr_t(n) );
+   TEST_ADD( res, slotRange._sum == intptr_t(n) );
+
+   StdErr << nl << n << " lookups:"
+          << " String key=" << tMap/n*1e9 << " ns/lookup"
+          << " StorageSlot=" << tSlot/n*1e9 << " ns/lookup" << nl;
+}
+
 void mt_info( Test::Result& /*res*/ )
 {
    StdErr << nl;
@@ -577,6 +953,10 @@ void init_mt()
    col->add( new Test::Function("mt_auto_free"    , "Tests auto-freeing of task once completed", mt_auto_free     ) );
    col->add( new Test::Function("mt_simple"       , "Tests simple multi-threading situation"   , mt_simple        ) );
    col->add( new Test::Function("mt_spawn"        , "Tests spawning tasks"                     , mt_spawn         ) );
+   col->add( new Test::Function("mt_stealing_deque", "Tests the WorkStealingDeque class"        , mt_stealing_deque) );
+   col->add( new Test::Function("mt_stealing"     , "Tests the work stealing scheduling"       , mt_stealing      ) );
+   col->add( new Test::Function("mt_parallel_for" , "Tests TaskQueue::parallelFor()"           , mt_parallel_for  ) );
+   col->add( new Test::Function("mt_storage_slot" , "Tests the StorageSlot class"              , mt_storage_slot  ) );
    col->add( new Test::Function("mt_valuetrigger" , "Tests the ValueTrigger class"             , mt_valuetrigger  ) );
    col->add( new Test::Function("mt_valuetrigger2", "Tests the ValueTrigger class"             , mt_valuetrigger2 ) );
    col->add( new Test::Function("mt_waitfor"      ,  "Tests the waitFor() method"              , mt_waitfor       ) );
@@ -585,6 +965,9 @@ void init_mt()
    col->add( new Test::Function("mt_fib"           , "Tests simple fibonacci example"                              , mt_fib            ) );
    col->add( new Test::Function("mt_worker_threads", "Runs multiple worker threads"                                , mt_worker_threads ) );
    col->add( new Test::Function("mt_atomic32_timed", "Runs mt_atomic32 and gives the time it took"                 , mt_atomic32_timed ) );
+   col->add( new Test::Function("mt_scheduling_timed", "Compares locked and work stealing schedulings"             , mt_scheduling_timed ) );
+   col->add( new Test::Function("mt_parallel_for_timed", "Compares per-element tasks with parallelFor()"           , mt_parallel_for_timed ) );
+   col->add( new Test::Function("mt_storage_timed" , "Compares String keys with StorageSlot accesses"              , mt_storage_timed ) );
    col->add( new Test::Function("mt_info"          , "Reports some info about the number of hardware threads, etc.", mt_info           ) );
    Test::special().add( col.ptr() );
 }
@@ -4,6 +4,7 @@
 =============================================================================*/
 #include <CGMath/BIH.h>
 #include <CGMath/CGMath.h>
+#include <CGMath/FloatN.h>
 
 #include <Base/Dbg/DebugStream.h>
 #include <Base/Util/Timer.h>
@@ -119,6 +120,20 @@ private:
    float            _tmax;
 };
 
+/*==============================================================================
+   CLASS PacketStackNode
+==============================================================================*/
+//! A node left to visit by a packet, with the ray intervals of all of its rays.
+template< typename V >
+struct PacketStackNode
+{
+   const BIH::Node* _node;
+   V                _tmin;
+   V                _tmax;
+   uint             _stacked; //!< The rays which stacked the node (skipped if their interval is empty).
+   uint             _direct;  //!< The rays which would have visited the node right away.
+};
+
 UNNAMESPACE_END
 
 
@@ -217,7 +232,7 @@ BIH::create(
    {
       maxDepth = (int)CGM::log2( float(centers.size()) ) * 2 + 1;
    }
-   _maxDepth = CGM::min( maxDepth, (uint)100 );
+   _maxDepth = CGM::min( maxDepth, (uint)MAX_DEPTH );
 
    // 2. Init ids.
    if( ids == 0 )
@@ -406,7 +421,7 @@ BIH::trace( const Rayf& ray, Hit& hit, IntersectFunc intersect, void* data ) con
 
 
    // Traverse tree.
-   Vector<TraversalStackNode> stack( _maxDepth );
+   TraversalStackNode stack[MAX_DEPTH];
    uint stackID = 0;
    const Node* node = &_nodes[0];
 
@@ -497,6 +512,172 @@ BIH::trace( const Rayf& ray, Hit& hit, IntersectFunc intersect, void* data ) con
    }
 }
 
+//------------------------------------------------------------------------------
+//! Traces a packet of 4 rays, and returns a mask where bit i is set if
+//! rays[i] hit an element (hits[i] is then updated).
+//! The results are the same as tracing the rays one by one.
+uint
+BIH::trace4( const Rayf rays[4], Hit hits[4], IntersectFunc intersect, void* data ) const
+{
+   return tracePacket< FloatN<4> >( rays, hits, intersect, data );
+}
+
+//------------------------------------------------------------------------------
+//! Traces a packet of 8 rays (see trace4()).
+uint
+BIH::trace8( const Rayf rays[8], Hit hits[8], IntersectFunc intersect, void* data ) const
+{
+   return tracePacket< FloatN<8> >( rays, hits, intersect, data );
+}
+
+//------------------------------------------------------------------------------
+//! Traverses the tree with all of the rays at once.
+//! Every node keeps the mask of the rays which would visit it when traced on
+//! their own, and only those rays get tested in the leaves, which yields the
+//! same results as trace().
+//! Rays whose directions do not all have the same signs are traced one by one,
+//! since they do not share the traversal order.
+template< typename V >
+uint
+BIH::tracePacket( const Rayf* rays, Hit* hits, IntersectFunc intersect, void* data ) const
+{
+   const uint N = V::SIZE;
+   if( _nodes.empty() )
+   {
+      return 0;
+   }
+
+   // Compute traversal order (shared by all of the rays).
+   Vec3f invDir[N];
+   for( uint i = 0; i < N; ++i )
+   {
+      invDir[i] = rays[i].direction().getInversed();
+   }
+   uint order[3];
+   order[0] = invDir[0](0) >= 0.0f ? 0 : 1;
+   order[1] = invDir[0](1) >= 0.0f ? 0 : 1;
+   order[2] = invDir[0](2) >= 0.0f ? 0 : 1;
+   for( uint i = 1; i < N; ++i )
+   {
+      if( (invDir[i](0) >= 0.0f ? 0u : 1u) != order[0] ||
+          (invDir[i](1) >= 0.0f ? 0u : 1u) != order[1] ||
+          (invDir[i](2) >= 0.0f ? 0u : 1u) != order[2] )
+      {
+         uint impacts = 0;
+         for( uint r = 0; r < N; ++r )
+         {
+            if( trace( rays[r], hits[r], intersect, data ) )  impacts |= 1 << r;
+         }
+         return impacts;
+      }
+   }
+
+   // Transpose the rays.
+   V org[3];
+   V inv[3];
+   float tmp[N];
+   for( uint axis = 0; axis < 3; ++axis )
+   {
+      for( uint i = 0; i < N; ++i )  tmp[i] = rays[i].origin()(axis);
+      org[axis] = V::loadUnaligned( tmp );
+      for( uint i = 0; i < N; ++i )  tmp[i] = invDir[i](axis);
+      inv[axis] = V::loadUnaligned( tmp );
+   }
+   for( uint i = 0; i < N; ++i )  tmp[i] = hits[i]._t;
+
+   V    tmin    = V::set( 0.0f );
+   V    tmax    = V::loadUnaligned( tmp );
+   V    hitT    = tmax;
+   uint mask    = (1 << N) - 1;
+   uint impacts = 0;
+
+   // Traverse tree.
+   PacketStackNode<V> stack[MAX_DEPTH];
+   uint stackID = 0;
+   const Node* node = &_nodes[0];
+
+   while( 1 )
+   {
+      if( node->isInteriorNode() )
+      {
+         uint axis = node->axis();
+         V tplane0 = ( V::set( node->_plane[order[axis]] ) - org[axis] ) * inv[axis];
+         V tplane1 = ( V::set( node->_plane[1-order[axis]] ) - org[axis] ) * inv[axis];
+
+         // Clip node.
+         if( node->isClipNode() )
+         {
+            node = &_nodes[node->index()];
+            tmin = V::max( tmin, tplane0 );
+            tmax = V::min( tmax, tplane1 );
+            continue;
+         }
+
+         uint traverse0 = mask & V::less( tmin, tplane0 ).bits();
+         uint traverse1 = mask & V::less( tplane1, tmax ).bits();
+
+         if( traverse0 )
+         {
+            if( traverse1 )
+            {
+               PacketStackNode<V>& e = stack[stackID++];
+               e._node    = &_nodes[node->index() + 1-order[axis]];
+               e._tmin    = V::max( tmin, tplane1 );
+               e._tmax    = tmax;
+               e._stacked = traverse0 & traverse1;
+               e._direct  = traverse1 & ~traverse0;
+            }
+            node = &_nodes[node->index() + order[axis]];
+            tmax = V::min( tmax, tplane0 );
+            mask = traverse0;
+            continue;
+         }
+         if( traverse1 )
+         {
+            node = &_nodes[node->index() + 1-order[axis]];
+            tmin = V::max( tmin, tplane1 );
+            mask = traverse1;
+            continue;
+         }
+      }
+      else
+      {
+         // We are in a leaf node.
+         // Intersects all primitives in it.
+         for( uint r = 0; r < N; ++r )
+         {
+            if( (mask & (1 << r)) == 0 )  continue;
+            uint numElems = node->_numElements;
+            uint id       = node->index();
+            for( uint i = 0; i < numElems; ++i, ++id )
+            {
+               if( intersect( rays[r], _ids[id], hits[r]._t, data ) )
+               {
+                  impacts    |= 1 << r;
+                  hits[r]._id = _ids[id];
+               }
+            }
+         }
+         for( uint r = 0; r < N; ++r )  tmp[r] = hits[r]._t;
+         hitT = V::loadUnaligned( tmp );
+      }
+
+      // Unstack.
+      do
+      {
+         if( stackID == 0 )
+         {
+            return impacts;
+         }
+         const PacketStackNode<V>& e = stack[--stackID];
+         node = e._node;
+         tmin = e._tmin;
+         tmax = V::min( e._tmax, hitT );
+         mask = ( e._stacked & ~V::greater( tmin, tmax ).bits() ) | e._direct;
+      } while( mask == 0 );
+   }
+}
+
 //------------------------------------------------------------------------------
 //!
 inline void
@@ -16,6 +16,12 @@ NAMESPACE_BEGIN
 /*==============================================================================
    CLASS BIH
 ==============================================================================*/
+//! A bounding interval hierarchy, used to trace rays against many elements.
+//! Rays can be traced one at a time, or in packets of 4 or 8 rays which visit
+//! the tree together (see trace4() and trace8()); packets are faster when the
+//! rays are coherent (e.g. neighbouring pixels, or rays from the same point),
+//! and use SSE/AVX when available.
+//! Traversals never allocate memory, since their stack lives on the call stack.
 class BIH
 {
 
@@ -107,6 +113,11 @@ public:
    
    /*----- types and enumerations ----*/
 
+   enum
+   {
+      MAX_DEPTH = 100  //!< The maximum depth of the tree (bounds the traversal stack).
+   };
+
    typedef bool (*IntersectFunc)( const Rayf&, uint, float&, void* );
    typedef bool (*InsideFunc)( const AABBoxf&, uint, void* );
 
@@ -133,6 +144,8 @@ public:
    
    // Queries.
    CGMATH_DLL_API bool trace( const Rayf&, Hit& hit, IntersectFunc, void* data ) const;
+   CGMATH_DLL_API uint trace4( const Rayf rays[4], Hit hits[4], IntersectFunc, void* data ) const;
+   CGMATH_DLL_API uint trace8( const Rayf rays[8], Hit hits[8], IntersectFunc, void* data ) const;
    CGMATH_DLL_API bool findElementsInside( const AABBoxf& box, Vector<uint>& dst ) const;
    CGMATH_DLL_API bool findElementsInside( const AABBoxf& box, Vector<uint>& dst, InsideFunc, void* data ) const;
    
@@ -142,6 +155,11 @@ public:
    
 private: 
 
+   /*----- methods -----*/
+
+   template< typename V >
+   uint tracePacket( const Rayf* rays, Hit* hits, IntersectFunc, void* data ) const;
+
    /*----- data members -----*/
 
    uint          _maxDepth;
@@ -0,0 +1,527 @@
+/*=============================================================================
+   Copyright (c) 2012, Ludo Sapiens Inc. and contributors.
+   See accompanying file LICENSE.txt for details.
+=============================================================================*/
+#include <CGMath/BVH.h>
+#include <CGMath/CGMath.h>
+
+/*==============================================================================
+   UNNAME NAMESPACE
+==============================================================================*/
+
+UNNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//!
+inline AABBoxf merge( const AABBoxf& a, const AABBoxf& b )
+{
+   AABBoxf box = a;
+   box |= b;
+   return box;
+}
+
+//------------------------------------------------------------------------------
+//!
+inline bool sameBox( const AABBoxf& a, const AABBoxf& b )
+{
+   return a.slabX() == b.slabX() && a.slabY() == b.slabY() && a.slabZ() == b.slabZ();
+}
+
+//------------------------------------------------------------------------------
+//! Clips [0,tmax] of the ray against the box, and returns its entry in tmin.
+//! NaNs (a null direction component on a slab boundary) never cull the box.
+inline bool intersect(
+   const AABBoxf& box,
+   const Vec3f&   org,
+   const Vec3f&   invDir,
+   float          tmax,
+   float&         tmin
+)
+{
+   float tnear = 0.0f;
+   float tfar  = tmax;
+   for( uint a = 0; a < 3; ++a )
+   {
+      float t0 = ( box.min(a) - org(a) ) * invDir(a);
+      float t1 = ( box.max(a) - org(a) ) * invDir(a);
+      if( t0 > t1 )
+      {
+         float tmp = t0;
+         t0 = t1;
+         t1 = tmp;
+      }
+      if( t0 > tnear ) tnear = t0;
+      if( t1 < tfar  ) tfar  = t1;
+   }
+   tmin = tnear;
+   return tnear <= tfar;
+}
+
+/*==============================================================================
+   CLASS RayStack
+==============================================================================*/
+//! The nodes left to visit by a ray, along with their entry distance.
+//! Balanced trees fit in the fixed part, so most rays never allocate.
+class RayStack
+{
+public:
+
+   /*----- methods -----*/
+
+   RayStack(): _size( 0 ) {}
+
+   inline bool empty() const { return _size == 0; }
+
+   inline void push( uint node, float tmin )
+   {
+      if( _size < LOCAL_SIZE )
+      {
+         _local[_size]._node = node;
+         _local[_size]._tmin = tmin;
+      }
+      else
+      {
+         Entry e;
+         e._node = node;
+         e._tmin = tmin;
+         _extra.pushBack( e );
+      }
+      ++_size;
+   }
+
+   inline void pop( uint& node, float& tmin )
+   {
+      --_size;
+      if( _size < LOCAL_SIZE )
+      {
+         node = _local[_size]._node;
+         tmin = _local[_size]._tmin;
+      }
+      else
+      {
+         node = _extra.back()._node;
+         tmin = _extra.back()._tmin;
+         _extra.popBack();
+      }
+   }
+
+private:
+
+   /*----- types -----*/
+
+   enum { LOCAL_SIZE = 64 };
+
+   struct Entry
+   {
+      uint   _node;
+      float  _tmin;
+   };
+
+   /*----- data members -----*/
+
+   Entry          _local[LOCAL_SIZE];
+   Vector<Entry>  _extra;
+   uint           _size;
+};
+
+UNNAMESPACE_END
+
+
+NAMESPACE_BEGIN
+
+/*==============================================================================
+   CLASS BVH
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//!
+BVH::BVH():
+   _root( INVALID ), _free( INVALID ), _numLeaves( 0 )
+{
+}
+
+//------------------------------------------------------------------------------
+//!
+BVH::~BVH()
+{
+}
+
+//------------------------------------------------------------------------------
+//!
+uint
+BVH::add( const AABBoxf& box, void* data )
+{
+   uint leaf = allocNode();
+   Node& n   = _nodes[leaf];
+   n._box    = box;
+   n._data   = data;
+   insertLeaf( leaf );
+   ++_numLeaves;
+   return leaf;
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+BVH::remove( uint leaf )
+{
+   CHECK( leaf < _nodes.size() && _nodes[leaf].isLeaf() );
+   removeLeaf( leaf );
+   freeNode( leaf );
+   --_numLeaves;
+}
+
+//------------------------------------------------------------------------------
+//! Changes the box of a leaf, and refits its ancestors.
+void
+BVH::update( uint leaf, const AABBoxf& box )
+{
+   CHECK( leaf < _nodes.size() && _nodes[leaf].isLeaf() );
+   _nodes[leaf]._box = box;
+   refit( _nodes[leaf]._parent );
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+BVH::clear()
+{
+   _nodes.clear();
+   _root      = INVALID;
+   _free      = INVALID;
+   _numLeaves = 0;
+}
+
+//------------------------------------------------------------------------------
+//!
+uint
+BVH::height() const
+{
+   return _root == INVALID ? 0 : height( _root );
+}
+
+//------------------------------------------------------------------------------
+//! Finds the leaves overlapping the frustum. Subtrees which are entirely
+//! inside are collected without testing their nodes.
+void
+BVH::find( const Frustumf& frustum, Vector<void*>& result ) const
+{
+   if( _root == INVALID ) return;
+
+   Vector<uint> stack;
+   stack.pushBack( _root );
+   while( !stack.empty() )
+   {
+      uint cur = stack.back();
+      stack.popBack();
+
+      const Node& n = _nodes[cur];
+      int inter     = frustum.intersect( n._box );
+      if( inter == Frustumf::OUTSIDE ) continue;
+      if( inter == Frustumf::INSIDE || n.isLeaf() )
+      {
+         collect( cur, result );
+         continue;
+      }
+      stack.pushBack( n._children[1] );
+      stack.pushBack( n._children[0] );
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Finds the leaves overlapping the box.
+void
+BVH::find( const AABBoxf& box, Vector<void*>& result ) const
+{
+   if( _root == INVALID ) return;
+
+   Vector<uint> stack;
+   stack.pushBack( _root );
+   while( !stack.empty() )
+   {
+      uint cur = stack.back();
+      stack.popBack();
+
+      const Node& n = _nodes[cur];
+      if( !n._box.isOverlapping( box ) ) continue;
+      if( n.isLeaf() )
+      {
+         result.pushBack( n._data );
+         continue;
+      }
+      stack.pushBack( n._children[1] );
+      stack.pushBack( n._children[0] );
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Finds the closest element along the ray, visiting the leaves front to back.
+//! The callback shrinks t with every closer hit, which prunes the nodes
+//! farther than it.
+bool
+BVH::trace( const Rayf& ray, float& t, IntersectFunc func, void* data ) const
+{
+   if( _root == INVALID ) return false;
+
+   const Vec3f& org = ray.origin();
+   const Vec3f  inv = Vec3f(1.0f) / ray.direction();
+
+   float tmin;
+   if( !intersect( _nodes[_root]._box, org, inv, t, tmin ) ) return false;
+
+   bool hit = false;
+   RayStack stack;
+   stack.push( _root, tmin );
+   while( !stack.empty() )
+   {
+      uint cur;
+      stack.pop( cur, tmin );
+      if( tmin > t ) continue; // Behind a hit found since it was stacked.
+
+      const Node& n = _nodes[cur];
+      if( n.isLeaf() )
+      {
+         hit |= func( ray, n._data, t, data );
+         continue;
+      }
+
+      float t0, t1;
+      uint c0 = n._children[0];
+      uint c1 = n._children[1];
+      bool h0 = intersect( _nodes[c0]._box, org, inv, t, t0 );
+      bool h1 = intersect( _nodes[c1]._box, org, inv, t, t1 );
+      if( h0 && h1 )
+      {
+         // Visit the closest child first.
+         if( t1 < t0 )
+         {
+            stack.push( c0, t0 );
+            stack.push( c1, t1 );
+         }
+         else
+         {
+            stack.push( c1, t1 );
+            stack.push( c0, t0 );
+         }
+      }
+      else if( h0 )
+      {
+         stack.push( c0, t0 );
+      }
+      else if( h1 )
+      {
+         stack.push( c1, t1 );
+      }
+   }
+   return hit;
+}
+
+//------------------------------------------------------------------------------
+//! Returns as soon as the callback reports a hit within [0,t].
+bool
+BVH::traceAny( const Rayf& ray, float t, IntersectFunc func, void* data ) const
+{
+   if( _root == INVALID ) return false;
+
+   const Vec3f& org = ray.origin();
+   const Vec3f  inv = Vec3f(1.0f) / ray.direction();
+
+   float tmin;
+   if( !intersect( _nodes[_root]._box, org, inv, t, tmin ) ) return false;
+
+   RayStack stack;
+   stack.push( _root, tmin );
+   while( !stack.empty() )
+   {
+      uint cur;
+      stack.pop( cur, tmin );
+
+      const Node& n = _nodes[cur];
+      if( n.isLeaf() )
+      {
+         float lt = t;
+         if( func( ray, n._data, lt, data ) ) return true;
+         continue;
+      }
+      for( uint c = 0; c < 2; ++c )
+      {
+         uint child = n._children[c];
+         if( intersect( _nodes[child]._box, org, inv, t, tmin ) ) stack.push( child, tmin );
+      }
+   }
+   return false;
+}
+
+//------------------------------------------------------------------------------
+//!
+uint
+BVH::allocNode()
+{
+   uint id;
+   if( _free != INVALID )
+   {
+      id    = _free;
+      _free = _nodes[id]._parent;
+   }
+   else
+   {
+      id = uint(_nodes.size());
+      _nodes.pushBack( Node() );
+   }
+   Node& n        = _nodes[id];
+   n._parent      = INVALID;
+   n._children[0] = INVALID;
+   n._children[1] = INVALID;
+   n._data        = nullptr;
+   return id;
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+BVH::freeNode( uint id )
+{
+   _nodes[id]._parent = _free;
+   _free = id;
+}
+
+//------------------------------------------------------------------------------
+//! Inserts the leaf as the sibling of the node whose surface grows the least,
+//! counting the growth of the ancestors on the way down.
+void
+BVH::insertLeaf( uint leaf )
+{
+   if( _root == INVALID )
+   {
+      _root = leaf;
+      _nodes[leaf]._parent = INVALID;
+      return;
+   }
+
+   const AABBoxf box = _nodes[leaf]._box;
+   uint cur = _root;
+   while( !_nodes[cur].isLeaf() )
+   {
+      const Node& n    = _nodes[cur];
+      float area       = n._box.surface();
+      float mergedArea = merge( n._box, box ).surface();
+      // Cost of making a new parent for this node and the leaf.
+      float cost       = 2.0f * mergedArea;
+      // Cost pushed down to the children.
+      float inherited  = 2.0f * ( mergedArea - area );
+
+      float childCost[2];
+      for( uint c = 0; c < 2; ++c )
+      {
+         const Node& child = _nodes[n._children[c]];
+         float grown       = merge( child._box, box ).surface();
+         childCost[c]      = inherited + ( child.isLeaf() ? grown : grown - child._box.surface() );
+      }
+
+      if( cost < childCost[0] && cost < childCost[1] ) break;
+      cur = childCost[0] <= childCost[1] ? n._children[0] : n._children[1];
+   }
+
+   // Make a new parent for the sibling and the leaf.
+   uint sibling   = cur;
+   uint oldParent = _nodes[sibling]._parent;
+   uint parent    = allocNode();
+   Node& p        = _nodes[parent];
+   p._parent      = oldParent;
+   p._box         = merge( _nodes[sibling]._box, box );
+   p._children[0] = sibling;
+   p._children[1] = leaf;
+   _nodes[sibling]._parent = parent;
+   _nodes[leaf]._parent    = parent;
+
+   if( oldParent == INVALID )
+   {
+      _root = parent;
+   }
+   else
+   {
+      Node& op = _nodes[oldParent];
+      op._children[ op._children[0] == sibling ? 0 : 1 ] = parent;
+      refit( oldParent );
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Unlinks the leaf; its sibling takes the place of their parent.
+void
+BVH::removeLeaf( uint leaf )
+{
+   if( leaf == _root )
+   {
+      _root = INVALID;
+      return;
+   }
+
+   uint parent      = _nodes[leaf]._parent;
+   const Node& p    = _nodes[parent];
+   uint grandParent = p._parent;
+   uint sibling     = p._children[ p._children[0] == leaf ? 1 : 0 ];
+
+   _nodes[sibling]._parent = grandParent;
+   if( grandParent == INVALID )
+   {
+      _root = sibling;
+   }
+   else
+   {
+      Node& gp = _nodes[grandParent];
+      gp._children[ gp._children[0] == parent ? 0 : 1 ] = sibling;
+      refit( grandParent );
+   }
+   freeNode( parent );
+   _nodes[leaf]._parent = INVALID;
+}
+
+//------------------------------------------------------------------------------
+//! Recomputes the boxes from the node up to the root, stopping as soon as a
+//! box does not change.
+void
+BVH::refit( uint node )
+{
+   while( node != INVALID )
+   {
+      Node& n     = _nodes[node];
+      AABBoxf box = merge( _nodes[n._children[0]]._box, _nodes[n._children[1]]._box );
+      if( sameBox( box, n._box ) ) break;
+      n._box = box;
+      node   = n._parent;
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Appends the data of every leaf of the subtree, from left to right.
+void
+BVH::collect( uint node, Vector<void*>& result ) const
+{
+   Vector<uint> stack;
+   stack.pushBack( node );
+   while( !stack.empty() )
+   {
+      const Node& n = _nodes[stack.back()];
+      stack.popBack();
+      if( n.isLeaf() )
+      {
+         result.pushBack( n._data );
+         continue;
+      }
+      stack.pushBack( n._children[1] );
+      stack.pushBack( n._children[0] );
+   }
+}
+
+//------------------------------------------------------------------------------
+//!
+uint
+BVH::height( uint node ) const
+{
+   const Node& n = _nodes[node];
+   if( n.isLeaf() ) return 1;
+   return 1 + CGM::max( height( n._children[0] ), height( n._children[1] ) );
+}
+
+NAMESPACE_END
@@ -0,0 +1,105 @@
+/*=============================================================================
+   Copyright (c) 2012, Ludo Sapiens Inc. and contributors.
+   See accompanying file LICENSE.txt for details.
+=============================================================================*/
+#ifndef CGMATH_BVH_H
+#define CGMATH_BVH_H
+
+#include <CGMath/StdDefs.h>
+#include <CGMath/AABBox.h>
+#include <CGMath/Frustum.h>
+#include <CGMath/Ray.h>
+
+#include <Base/ADT/Vector.h>
+
+NAMESPACE_BEGIN
+
+/*==============================================================================
+   CLASS BVH
+==============================================================================*/
+//! A dynamic bounding volume hierarchy over boxes which can move.
+//! Every element is a leaf holding its box and a user pointer. New leaves are
+//! inserted next to the subtree they enlarge the least, and a leaf whose box
+//! changes only refits its ancestors, so moving a few elements is cheap.
+//! Leaf IDs stay valid until the leaf is removed.
+//! Rays visit the leaves front to back, so that the boxes behind the closest
+//! hit found so far are skipped.
+class BVH
+{
+public:
+
+   /*----- types and enumerations ----*/
+
+   enum
+   {
+      INVALID = 0xFFFFFFFF
+   };
+
+   //! Intersects the ray with the element of a leaf; on a hit closer than t,
+   //! updates t and returns true.
+   typedef bool (*IntersectFunc)( const Rayf&, void* leafData, float& t, void* data );
+
+   /*----- methods -----*/
+
+   CGMATH_DLL_API BVH();
+   CGMATH_DLL_API ~BVH();
+
+   // Operations.
+   CGMATH_DLL_API uint  add( const AABBoxf& box, void* data );
+   CGMATH_DLL_API void  remove( uint leaf );
+   CGMATH_DLL_API void  update( uint leaf, const AABBoxf& box );
+   CGMATH_DLL_API void  clear();
+
+   // Attributes.
+   inline uint            numLeaves() const       { return _numLeaves; }
+   inline const AABBoxf&  box( uint leaf ) const  { return _nodes[leaf]._box; }
+   inline void*           data( uint leaf ) const { return _nodes[leaf]._data; }
+   inline AABBoxf         region() const          { return _root == INVALID ? AABBoxf::empty() : _nodes[_root]._box; }
+   CGMATH_DLL_API uint    height() const;
+
+   // Queries (the data of the leaves found are appended to the vector).
+   CGMATH_DLL_API void  find( const Frustumf&, Vector<void*>& ) const;
+   CGMATH_DLL_API void  find( const AABBoxf&, Vector<void*>& ) const;
+
+   // Ray queries over [0,t] (the ray direction needn't be normalized).
+   CGMATH_DLL_API bool  trace( const Rayf&, float& t, IntersectFunc, void* data ) const;
+   CGMATH_DLL_API bool  traceAny( const Rayf&, float t, IntersectFunc, void* data ) const;
+
+private:
+
+   /*----- classes -----*/
+
+   struct Node
+   {
+      inline bool isLeaf() const { return _children[0] == INVALID; }
+
+      AABBoxf  _box;
+      uint     _parent;      //!< The parent node, or the next free node.
+      uint     _children[2];
+      void*    _data;
+   };
+
+   /*----- methods -----*/
+
+   uint  allocNode();
+   void  freeNode( uint );
+   void  insertLeaf( uint );
+   void  removeLeaf( uint );
+   void  refit( uint node );
+   void  collect( uint node, Vector<void*>& ) const;
+   uint  height( uint node ) const;
+
+   BVH( const BVH& );
+   void operator=( const BVH& );
+
+   /*----- data members -----*/
+
+   Vector<Node>  _nodes;
+   uint          _root;
+   uint          _free;
+   uint          _numLeaves;
+};
+
+NAMESPACE_END
+
+#endif //CGMATH_BVH_H
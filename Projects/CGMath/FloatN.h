@@ -0,0 +1,309 @@
+/*=============================================================================
+   Copyright (c) 2012, Ludo Sapiens Inc. and contributors.
+   See accompanying file LICENSE.txt for details.
+=============================================================================*/
+#ifndef CGMATH_FLOATN_H
+#define CGMATH_FLOATN_H
+
+#include <CGMath/StdDefs.h>
+
+#include <CGMath/CGMath.h>
+
+#if !defined(CGMATH_SSE)
+#  if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#    define CGMATH_SSE  1  // Set to 0 to process FloatN<4> with plain loops.
+#  else
+#    define CGMATH_SSE  0
+#  endif
+#endif
+
+#if !defined(CGMATH_AVX)
+#  if defined(__AVX__)
+#    define CGMATH_AVX  1  // Set to 0 to process FloatN<8> with plain loops.
+#  else
+#    define CGMATH_AVX  0
+#  endif
+#endif
+
+#if CGMATH_SSE
+#include <xmmintrin.h>
+#endif
+#if CGMATH_AVX
+#include <immintrin.h>
+#endif
+
+NAMESPACE_BEGIN
+
+/*==============================================================================
+  CLASS FloatN
+==============================================================================*/
+//! N floats processed in lock step (one per ray, particle, instance...).
+//! The generic version is plain loops (which compilers can vectorize), and is
+//! specialized below with SSE and AVX intrinsics; all of them compute the same
+//! values as the scalar code.
+//! load() and store() require addresses aligned on N floats, while
+//! loadUnaligned() does not.
+//! min() and max() return the same values as CGM::min() and CGM::max(), even
+//! with NaNs.
+template< uint N >
+class FloatN
+{
+public:
+
+   /*----- types -----*/
+
+   enum { SIZE = N };
+
+   class Mask
+   {
+   public:
+      Mask() {}
+      Mask( uint m ): _m( m ) {}
+      inline Mask  operator&( const Mask& b ) const { return _m & b._m; }
+      inline Mask  operator|( const Mask& b ) const { return _m | b._m; }
+      inline Mask  andNot( const Mask& b ) const    { return _m & ~b._m; } //!< this & !b
+      inline bool  any() const                      { return _m != 0; }
+      inline uint  bits() const                     { return _m; } //!< Bit i is set for lane i.
+   private:
+      uint _m;
+   };
+
+   /*----- methods -----*/
+
+   static inline FloatN set( float v )
+   {
+      FloatN r;
+      for( uint i = 0; i < N; ++i )  r._v[i] = v;
+      return r;
+   }
+   static inline FloatN load( const float* v )
+   {
+      FloatN r;
+      for( uint i = 0; i < N; ++i )  r._v[i] = v[i];
+      return r;
+   }
+   static inline FloatN loadUnaligned( const float* v )
+   {
+      return load( v );
+   }
+   inline void store( float* dst ) const
+   {
+      for( uint i = 0; i < N; ++i )  dst[i] = _v[i];
+   }
+
+   inline FloatN operator+( const FloatN& b ) const
+   {
+      FloatN r;
+      for( uint i = 0; i < N; ++i )  r._v[i] = _v[i] + b._v[i];
+      return r;
+   }
+   inline FloatN operator-( const FloatN& b ) const
+   {
+      FloatN r;
+      for( uint i = 0; i < N; ++i )  r._v[i] = _v[i] - b._v[i];
+      return r;
+   }
+   inline FloatN operator*( const FloatN& b ) const
+   {
+      FloatN r;
+      for( uint i = 0; i < N; ++i )  r._v[i] = _v[i] * b._v[i];
+      return r;
+   }
+   inline FloatN operator/( const FloatN& b ) const
+   {
+      FloatN r;
+      for( uint i = 0; i < N; ++i )  r._v[i] = _v[i] / b._v[i];
+      return r;
+   }
+
+   static inline FloatN sqrt( const FloatN& a )
+   {
+      FloatN r;
+      for( uint i = 0; i < N; ++i )  r._v[i] = CGM::sqrt( a._v[i] );
+      return r;
+   }
+   static inline FloatN min( const FloatN& a, const FloatN& b )
+   {
+      FloatN r;
+      for( uint i = 0; i < N; ++i )  r._v[i] = CGM::min( a._v[i], b._v[i] );
+      return r;
+   }
+   static inline FloatN max( const FloatN& a, const FloatN& b )
+   {
+      FloatN r;
+      for( uint i = 0; i < N; ++i )  r._v[i] = CGM::max( a._v[i], b._v[i] );
+      return r;
+   }
+
+   static inline Mask less( const FloatN& a, const FloatN& b )
+   {
+      uint m = 0;
+      for( uint i = 0; i < N; ++i )  m |= uint(a._v[i] < b._v[i]) << i;
+      return m;
+   }
+   static inline Mask lessEqual( const FloatN& a, const FloatN& b )
+   {
+      uint m = 0;
+      for( uint i = 0; i < N; ++i )  m |= uint(a._v[i] <= b._v[i]) << i;
+      return m;
+   }
+   static inline Mask greater( const FloatN& a, const FloatN& b )
+   {
+      uint m = 0;
+      for( uint i = 0; i < N; ++i )  m |= uint(a._v[i] > b._v[i]) << i;
+      return m;
+   }
+
+   //! Returns a where the mask is set, and b elsewhere.
+   static inline FloatN select( const Mask& m, const FloatN& a, const FloatN& b )
+   {
+      FloatN r;
+      for( uint i = 0; i < N; ++i )  r._v[i] = (m.bits() & (1 << i)) ? a._v[i] : b._v[i];
+      return r;
+   }
+
+private:
+
+   /*----- data members -----*/
+
+   float _v[N];
+};
+
+#if CGMATH_SSE
+//------------------------------------------------------------------------------
+//!
+template<>
+class FloatN<4>
+{
+public:
+
+   /*----- types -----*/
+
+   enum { SIZE = 4 };
+
+   class Mask
+   {
+   public:
+      Mask() {}
+      Mask( __m128 m ): _m( m ) {}
+      inline Mask  operator&( const Mask& b ) const { return _mm_and_ps( _m, b._m ); }
+      inline Mask  operator|( const Mask& b ) const { return _mm_or_ps( _m, b._m ); }
+      inline Mask  andNot( const Mask& b ) const    { return _mm_andnot_ps( b._m, _m ); }
+      inline bool  any() const                      { return _mm_movemask_ps( _m ) != 0; }
+      inline uint  bits() const                     { return _mm_movemask_ps( _m ); }
+      inline __m128  mask() const                   { return _m; }
+   private:
+      __m128 _m;
+   };
+
+   /*----- methods -----*/
+
+   FloatN() {}
+   FloatN( __m128 v ): _v( v ) {}
+
+   static inline FloatN set( float v )                  { return _mm_set1_ps( v ); }
+   static inline FloatN load( const float* v )          { return _mm_load_ps( v ); }
+   static inline FloatN loadUnaligned( const float* v ) { return _mm_loadu_ps( v ); }
+   inline void store( float* dst ) const                { _mm_store_ps( dst, _v ); }
+
+   inline FloatN operator+( const FloatN& b ) const { return _mm_add_ps( _v, b._v ); }
+   inline FloatN operator-( const FloatN& b ) const { return _mm_sub_ps( _v, b._v ); }
+   inline FloatN operator*( const FloatN& b ) const { return _mm_mul_ps( _v, b._v ); }
+   inline FloatN operator/( const FloatN& b ) const { return _mm_div_ps( _v, b._v ); }
+
+   static inline FloatN sqrt( const FloatN& a ) { return _mm_sqrt_ps( a._v ); }
+   // The operands are swapped to match CGM::min() and CGM::max().
+   static inline FloatN min( const FloatN& a, const FloatN& b ) { return _mm_min_ps( b._v, a._v ); }
+   static inline FloatN max( const FloatN& a, const FloatN& b ) { return _mm_max_ps( b._v, a._v ); }
+
+   static inline Mask less( const FloatN& a, const FloatN& b )      { return _mm_cmplt_ps( a._v, b._v ); }
+   static inline Mask lessEqual( const FloatN& a, const FloatN& b ) { return _mm_cmple_ps( a._v, b._v ); }
+   static inline Mask greater( const FloatN& a, const FloatN& b )   { return _mm_cmpgt_ps( a._v, b._v ); }
+
+   static inline FloatN select( const Mask& m, const FloatN& a, const FloatN& b )
+   {
+      return _mm_or_ps( _mm_and_ps( m.mask(), a._v ), _mm_andnot_ps( m.mask(), b._v ) );
+   }
+
+private:
+
+   /*----- data members -----*/
+
+   __m128 _v;
+};
+#endif
+
+#if CGMATH_AVX
+//------------------------------------------------------------------------------
+//!
+template<>
+class FloatN<8>
+{
+public:
+
+   /*----- types -----*/
+
+   enum { SIZE = 8 };
+
+   class Mask
+   {
+   public:
+      Mask() {}
+      Mask( __m256 m ): _m( m ) {}
+      inline Mask  operator&( const Mask& b ) const { return _mm256_and_ps( _m, b._m ); }
+      inline Mask  operator|( const Mask& b ) const { return _mm256_or_ps( _m, b._m ); }
+      inline Mask  andNot( const Mask& b ) const    { return _mm256_andnot_ps( b._m, _m ); }
+      inline bool  any() const                      { return _mm256_movemask_ps( _m ) != 0; }
+      inline uint  bits() const                     { return _mm256_movemask_ps( _m ); }
+      inline __m256  mask() const                   { return _m; }
+   private:
+      __m256 _m;
+   };
+
+   /*----- methods -----*/
+
+   FloatN() {}
+   FloatN( __m256 v ): _v( v ) {}
+
+   static inline FloatN set( float v )                  { return _mm256_set1_ps( v ); }
+   static inline FloatN load( const float* v )          { return _mm256_load_ps( v ); }
+   static inline FloatN loadUnaligned( const float* v ) { return _mm256_loadu_ps( v ); }
+   inline void store( float* dst ) const                { _mm256_store_ps( dst, _v ); }
+
+   inline FloatN operator+( const FloatN& b ) const { return _mm256_add_ps( _v, b._v ); }
+   inline FloatN operator-( const FloatN& b ) const { return _mm256_sub_ps( _v, b._v ); }
+   inline FloatN operator*( const FloatN& b ) const { return _mm256_mul_ps( _v, b._v ); }
+   inline FloatN operator/( const FloatN& b ) const { return _mm256_div_ps( _v, b._v ); }
+
+   static inline FloatN sqrt( const FloatN& a ) { return _mm256_sqrt_ps( a._v ); }
+   // The operands are swapped to match CGM::min() and CGM::max().
+   static inline FloatN min( const FloatN& a, const FloatN& b ) { return _mm256_min_ps( b._v, a._v ); }
+   static inline FloatN max( const FloatN& a, const FloatN& b ) { return _mm256_max_ps( b._v, a._v ); }
+
+   static inline Mask less( const FloatN& a, const FloatN& b )      { return _mm256_cmp_ps( a._v, b._v, _CMP_LT_OQ ); }
+   static inline Mask lessEqual( const FloatN& a, const FloatN& b ) { return _mm256_cmp_ps( a._v, b._v, _CMP_LE_OQ ); }
+   static inline Mask greater( const FloatN& a, const FloatN& b )   { return _mm256_cmp_ps( a._v, b._v, _CMP_GT_OQ ); }
+
+   static inline FloatN select( const Mask& m, const FloatN& a, const FloatN& b )
+   {
+      return _mm256_blendv_ps( b._v, a._v, m.mask() );
+   }
+
+private:
+
+   /*----- data members -----*/
+
+   __m256 _v;
+};
+#endif
+
+//! The widest version available.
+#if CGMATH_AVX
+typedef FloatN<8>  Floats;
+#else
+typedef FloatN<4>  Floats;
+#endif
+
+NAMESPACE_END
+
+#endif //CGMATH_FLOATN_H
@@ -9,6 +9,7 @@
 
 #include <CGMath/AABBox.h>
 #include <CGMath/CGMath.h>
+#include <CGMath/Mat4.h>
 #include <CGMath/Plane.h>
 
 NAMESPACE_BEGIN
@@ -45,6 +46,7 @@ public:
    // Constructors/destructor.
    Frustum() {}
    Frustum( const Plane<T> planes[6] );
+   Frustum( const Mat4<T>& viewProj );
    Frustum( const Ref<T>&, T front, T back, T fovx, T fovy );
    Frustum( const Ref<T>&, T front, T back, T fovx, T fovy, T shearX, T shearY );
 
@@ -85,6 +87,24 @@ Frustum<T>::Frustum( const Plane<T> planes[6] )
       _planes[5] = planes[5];
 }
 
+//------------------------------------------------------------------------------
+//! Extracts the planes of the clipping volume of a projection*view matrix
+//! (-w <= x,y,z <= w in clip space).
+template< typename T > inline
+Frustum<T>::Frustum( const Mat4<T>& m )
+{
+   Vec4<T> r0 = m.row(0);
+   Vec4<T> r1 = m.row(1);
+   Vec4<T> r2 = m.row(2);
+   Vec4<T> r3 = m.row(3);
+   Vec4<T> p[6] = { -(r3+r0), -(r3-r0), -(r3+r1), -(r3-r1), -(r3+r2), -(r3-r2) };
+   for( uint i = 0; i < 6; ++i )
+   {
+      _planes[i] = Plane<T>( p[i].x, p[i].y, p[i].z, p[i].w );
+      _planes[i].normalize();
+   }
+}
+
 //------------------------------------------------------------------------------
 //! Defines a frustum along the referential's +Z axis.
 template< typename T > inline
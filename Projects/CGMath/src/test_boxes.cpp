@@ -7,9 +7,13 @@
 #include <CGMath/AABBox.h>
 #include <CGMath/AARect.h>
 #include <CGMath/BIH.h>
+#include <CGMath/BVH.h>
 #include <CGMath/Frustum.h>
+#include <CGMath/Random.h>
 #include <CGMath/Range.h>
 
+#include <algorithm>
+
 USING_NAMESPACE
 
 //DBG_STREAM( os_test, "Test" );
@@ -313,6 +317,201 @@ void cgmath_Range( Test::Result& res )
 }
 
 
+//------------------------------------------------------------------------------
+//!
+void cgmath_frustum_matrix( Test::Result& res )
+{
+   Frustumf frustum( Mat4f::ortho( -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, 3.0f ) );
+   AABBoxf  box;
+
+   box.set( Vec3f(0.0f, 0.0f, -2.0f) );
+   TEST_ADD( res, frustum.intersect(box) == Frustumf::INSIDE );
+   box.set( Vec3f(0.0f, 0.0f, 2.0f) );
+   TEST_ADD( res, frustum.intersect(box) == Frustumf::OUTSIDE );
+   box.set( Vec3f(0.0f, 0.0f, -3.5f) );
+   TEST_ADD( res, frustum.intersect(box) == Frustumf::OUTSIDE );
+   box.set( Vec3f(1.5f, 0.0f, -2.0f) );
+   TEST_ADD( res, frustum.intersect(box) == Frustumf::OUTSIDE );
+   box.grow( 1.0f );
+   TEST_ADD( res, frustum.intersect(box) == Frustumf::INTERSECT );
+}
+
+//------------------------------------------------------------------------------
+//!
+AABBoxf randomBox( RNG_WELL& rng, float range )
+{
+   Vec3f c( (float)rng.getDouble(), (float)rng.getDouble(), (float)rng.getDouble() );
+   Vec3f s( (float)rng.getDouble(), (float)rng.getDouble(), (float)rng.getDouble() );
+   c = c*(2.0f*range) - range;
+   s = s*0.5f + 0.01f;
+   return AABBoxf( c-s, c+s );
+}
+
+//------------------------------------------------------------------------------
+//!
+bool sameData( Vector<void*>& a, Vector<void*>& b )
+{
+   if( a.size() != b.size() ) return false;
+   std::sort( a.begin(), a.end() );
+   std::sort( b.begin(), b.end() );
+   return std::equal( a.begin(), a.end(), b.begin() );
+}
+
+//------------------------------------------------------------------------------
+//! Returns the entry distance of the ray into the box, if it is before t.
+bool rayBox( const AABBoxf& box, const Rayf& ray, float& t )
+{
+   float tnear = 0.0f;
+   float tfar  = t;
+   for( uint a = 0; a < 3; ++a )
+   {
+      float t0 = ( box.min(a) - ray.origin()(a) ) / ray.direction()(a);
+      float t1 = ( box.max(a) - ray.origin()(a) ) / ray.direction()(a);
+      tnear = CGM::max( tnear, CGM::min( t0, t1 ) );
+      tfar  = CGM::min( tfar,  CGM::max( t0, t1 ) );
+   }
+   if( tnear > tfar || tnear >= t ) return false;
+   t = tnear;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//!
+struct BoxHit
+{
+   const Vector<AABBoxf>*  _boxes;
+   void*                   _leaf;
+};
+
+//------------------------------------------------------------------------------
+//!
+bool traceBox( const Rayf& ray, void* leaf, float& t, void* data )
+{
+   BoxHit* hit = (BoxHit*)data;
+   if( !rayBox( (*hit->_boxes)[size_t(leaf)-1], ray, t ) ) return false;
+   hit->_leaf = leaf;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//! Compares the BVH queries with a brute force search, while boxes are added,
+//! moved and removed.
+void cgmath_BVH( Test::Result& res )
+{
+   const uint num = 500;
+   RNG_WELL rng;
+   BVH      bvh;
+
+   Vector<AABBoxf> boxes( num );
+   Vector<uint>    leaves( num, uint(BVH::INVALID) );
+   for( uint i = 0; i < num; ++i )
+   {
+      boxes[i]  = randomBox( rng, 20.0f );
+      leaves[i] = bvh.add( boxes[i], (void*)size_t(i+1) );
+   }
+   TEST_ADD( res, bvh.numLeaves() == num );
+   TEST_ADD( res, bvh.height() < 40 );
+
+   Frustumf frustum(
+      Reff( Quatf::axisCir( Vec3f(0.0f, 1.0f, 0.0f), 0.125f ), Vec3f(0.0f, 0.0f, 20.0f) ),
+      1.0f, 30.0f,
+      CGM::degToRad( 30.0f ), CGM::degToRad( 20.0f )
+   );
+   AABBoxf region( Vec3f(-5.0f, -20.0f, -5.0f), Vec3f(10.0f, 20.0f, 5.0f) );
+
+   Vector<void*> found;
+   Vector<void*> expected;
+   for( uint step = 0; step < 4; ++step )
+   {
+      // Frustum query.
+      found.clear();
+      expected.clear();
+      bvh.find( frustum, found );
+      for( uint i = 0; i < num; ++i )
+      {
+         if( leaves[i] != BVH::INVALID && frustum.intersect( boxes[i] ) != Frustumf::OUTSIDE )
+         {
+            expected.pushBack( (void*)size_t(i+1) );
+         }
+      }
+      TEST_ADD( res, !expected.empty() && expected.size() < bvh.numLeaves() );
+      TEST_ADD( res, sameData( found, expected ) );
+
+      // Box query.
+      found.clear();
+      expected.clear();
+      bvh.find( region, found );
+      for( uint i = 0; i < num; ++i )
+      {
+         if( leaves[i] != BVH::INVALID && boxes[i].isOverlapping( region ) )
+         {
+            expected.pushBack( (void*)size_t(i+1) );
+         }
+      }
+      TEST_ADD( res, sameData( found, expected ) );
+
+      // Ray queries.
+      uint numHits = 0;
+      for( uint r = 0; r < 200; ++r )
+      {
+         Vec3f org = randomBox( rng, 30.0f ).center();
+         Vec3f dst = randomBox( rng, 10.0f ).center();
+         Rayf ray( org, dst - org );
+
+         BoxHit hit = { &boxes, nullptr };
+         float t    = CGConstf::infinity();
+         bool found = bvh.trace( ray, t, traceBox, &hit );
+
+         void* closest = nullptr;
+         float ct      = CGConstf::infinity();
+         for( uint i = 0; i < num; ++i )
+         {
+            if( leaves[i] != BVH::INVALID && rayBox( boxes[i], ray, ct ) ) closest = (void*)size_t(i+1);
+         }
+         TEST_ADD( res, found == (closest != nullptr) );
+         TEST_ADD( res, hit._leaf == closest && t == ct );
+         TEST_ADD( res, bvh.traceAny( ray, 1.0f, traceBox, &hit ) == (ct <= 1.0f) );
+         numHits += found ? 1 : 0;
+      }
+      TEST_ADD( res, numHits > 0 && numHits < 200 );
+
+      // Move some, remove some and add back others.
+      for( uint i = step; i < num; i += 7 )
+      {
+         boxes[i] = randomBox( rng, 20.0f );
+         if( leaves[i] != BVH::INVALID ) bvh.update( leaves[i], boxes[i] );
+      }
+      for( uint i = step; i < num; i += 5 )
+      {
+         if( leaves[i] != BVH::INVALID )
+         {
+            bvh.remove( leaves[i] );
+            leaves[i] = BVH::INVALID;
+         }
+         else
+         {
+            leaves[i] = bvh.add( boxes[i], (void*)size_t(i+1) );
+         }
+      }
+      uint n = 0;
+      for( uint i = 0; i < num; ++i ) n += leaves[i] != BVH::INVALID ? 1 : 0;
+      TEST_ADD( res, bvh.numLeaves() == n );
+   }
+
+   // The root encloses every box.
+   AABBoxf all = AABBoxf::empty();
+   for( uint i = 0; i < num; ++i )
+   {
+      if( leaves[i] != BVH::INVALID ) all |= boxes[i];
+   }
+   TEST_ADD( res, bvh.region().isInside( all ) && all.isInside( bvh.region() ) );
+
+   bvh.clear();
+   found.clear();
+   bvh.find( frustum, found );
+   TEST_ADD( res, bvh.numLeaves() == 0 && found.empty() );
+}
+
 //------------------------------------------------------------------------------
 //!
 void  init_boxes()
@@ -320,7 +519,9 @@ void  init_boxes()
    Test::Collection& std = Test::standard();
    std.add( new Test::Function( "aabbox",  "Tests axis-aligned bounding boxes", cgmath_AABBox  ) );
    std.add( new Test::Function( "aarect",  "Tests 2D rectangles",               cgmath_AARect  ) );
+   std.add( new Test::Function( "bvh",     "Tests BVH class",                   cgmath_BVH     ) );
    std.add( new Test::Function( "frustum", "Tests frustum class",               cgmath_frustum ) );
+   std.add( new Test::Function( "frustum_matrix", "Tests frustum extraction from a matrix", cgmath_frustum_matrix ) );
    std.add( new Test::Function( "range",   "Tests 1D ranges",                   cgmath_Range   ) );
 
    Test::Collection& spc = Test::special();
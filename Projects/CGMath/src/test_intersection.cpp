@@ -4,6 +4,7 @@
 =============================================================================*/
 #include <Base/Dbg/UnitTest.h>
 
+#include <CGMath/BIH.h>
 #include <CGMath/Dist.h>
 #include <CGMath/Geom.h>
 #include <CGMath/Random.h>
@@ -11,6 +12,7 @@
 #include <CGMath/RayCaster.h>
 
 #include <Base/Util/Bits.h>
+#include <Base/Util/Timer.h>
 
 USING_NAMESPACE
 
@@ -486,6 +488,145 @@ void cgmath_ray_caster_random( Test::Result& res )
 }
 
 
+//------------------------------------------------------------------------------
+//! A field of random spheres, used to test the BIH.
+struct SphereField
+{
+   SphereField( uint n )
+   {
+      RNG_WELL rng;
+      Vector<AABBoxf>  boxes( n );
+      Vector<AABBoxf*> boxPtrs( n );
+      _spheres.resize( n );
+      for( uint i = 0; i < n; ++i )
+      {
+         Vec3f c( (float)rng.getDouble(), (float)rng.getDouble(), (float)rng.getDouble() );
+         c = c*20.0f - 10.0f;
+         _spheres[i] = Vec4f( c, 0.1f + 0.2f*(float)rng.getDouble() );
+         boxes[i]    = AABBoxf( c );
+         boxes[i].grow( _spheres[i].w );
+         boxPtrs[i]  = &boxes[i];
+         _centers.pushBack( c );
+      }
+      _bih.create( boxPtrs, _centers, NULL, 2 );
+   }
+
+   static bool intersect( const Rayf& ray, uint id, float& t, void* data )
+   {
+      const Vec4f& s = ((SphereField*)data)->_spheres[id];
+      Vec3f oc = ray.origin() - Vec3f( s.x, s.y, s.z );
+      float a  = ray.direction().sqrLength();
+      float b  = oc.dot( ray.direction() );
+      float c  = oc.sqrLength() - s.w*s.w;
+      float d  = b*b - a*c;
+      if( d < 0.0f )  return false;
+      float ti = ( -b - CGM::sqrt( d ) ) / a;
+      if( ti < 0.0f || ti >= t )  return false;
+      t = ti;
+      return true;
+   }
+
+   //! Creates the rays of a w x h image seen from the specified position.
+   void  camera( const Vec3f& pos, uint w, uint h, Vector<Rayf>& rays ) const
+   {
+      rays.clear();
+      for( uint y = 0; y < h; ++y )
+      {
+         for( uint x = 0; x < w; ++x )
+         {
+            Vec3f dir( (x + 0.5f)/w - 0.5f, (y + 0.5f)/h - 0.5f, 1.0f );
+            rays.pushBack( Rayf( pos, dir - pos*(1.0f/30.0f) ) );
+         }
+      }
+   }
+
+   Vector<Vec4f>  _spheres;
+   Vector<Vec3f>  _centers;
+   BIH            _bih;
+};
+
+//------------------------------------------------------------------------------
+//! Traces the rays in packets of N (N being 1, 4 or 8).
+uint traceRays( const SphereField& field, const Vector<Rayf>& rays, Vector<BIH::Hit>& hits, uint n )
+{
+   hits.clear();
+   hits.resize( rays.size() );
+   uint impacts = 0;
+   void* data   = (void*)&field;
+   for( uint i = 0; i + n <= rays.size(); i += n )
+   {
+      uint mask;
+      switch( n )
+      {
+         case 4:  mask = field._bih.trace4( &rays[i], &hits[i], SphereField::intersect, data ); break;
+         case 8:  mask = field._bih.trace8( &rays[i], &hits[i], SphereField::intersect, data ); break;
+         default: mask = field._bih.trace( rays[i], hits[i], SphereField::intersect, data ) ? 1 : 0;
+      }
+      for( ; mask != 0; mask >>= 1 )  impacts += mask & 1;
+   }
+   return impacts;
+}
+
+//------------------------------------------------------------------------------
+//!
+void cgmath_bih( Test::Result& res )
+{
+   SphereField field( 2048 );
+
+   // Coherent rays (a camera), and incoherent ones (random directions).
+   Vector<Rayf> rays[2];
+   field.camera( Vec3f( 0.0f, 0.0f, -30.0f ), 64, 64, rays[0] );
+   RNG_WELL rng;
+   for( uint i = 0; i < 4096; ++i )
+   {
+      Vec3f dir( (float)rng.getDouble(), (float)rng.getDouble(), (float)rng.getDouble() );
+      rays[1].pushBack( Rayf( Vec3f( 0.0f ), dir - 0.5f ) );
+   }
+
+   for( uint r = 0; r < 2; ++r )
+   {
+      Vector<BIH::Hit> hits1, hits4, hits8;
+      uint n1 = traceRays( field, rays[r], hits1, 1 );
+      uint n4 = traceRays( field, rays[r], hits4, 4 );
+      uint n8 = traceRays( field, rays[r], hits8, 8 );
+      TEST_ADD( res, n1 > 0 && n1 < rays[r].size() );
+      TEST_ADD( res, n4 == n1 );
+      TEST_ADD( res, n8 == n1 );
+      uint same = 0;
+      for( uint i = 0; i < hits1.size(); ++i )
+      {
+         if( hits4[i]._t == hits1[i]._t && hits4[i]._id == hits1[i]._id &&
+             hits8[i]._t == hits1[i]._t && hits8[i]._id == hits1[i]._id )
+         {
+            ++same;
+         }
+      }
+      TEST_ADD( res, same == hits1.size() );
+   }
+}
+
+//------------------------------------------------------------------------------
+//!
+void cgmath_bih_perf( Test::Result& )
+{
+   printf("\n");
+   SphereField field( 16384 );
+   Vector<Rayf> rays;
+   field.camera( Vec3f( 0.0f, 0.0f, -30.0f ), 256, 256, rays );
+
+   Vector<BIH::Hit> hits;
+   const uint sizes[3] = { 1, 4, 8 };
+   for( uint s = 0; s < 3; ++s )
+   {
+      Timer timer;
+      uint n = 0;
+      for( uint i = 0; i < 4; ++i )  n = traceRays( field, rays, hits, sizes[s] );
+      double elapsed = timer.elapsed();
+      printf( "%u-ray packets: %u hits, %.4g rays/s\n", sizes[s], n, 4.0*rays.size()/elapsed );
+   }
+}
+
+
 //------------------------------------------------------------------------------
 //!
 void  init_intersection()
@@ -495,4 +636,8 @@ void  init_intersection()
    std.add( new Test::Function( "tri_pt_closest",    "Tests closest point to a triangle", cgmath_tri_pt_closest    ) );
    std.add( new Test::Function( "ray_caster",        "Tests ray casting",                 cgmath_ray_caster        ) );
    std.add( new Test::Function( "ray_caster_random", "Tests ray casting precision",       cgmath_ray_caster_random ) );
+   std.add( new Test::Function( "bih",               "Tests BIH ray packets",             cgmath_bih               ) );
+
+   Test::Collection& spc = Test::special();
+   spc.add( new Test::Function( "bih_perf", "Measures BIH rays per second", cgmath_bih_perf ) );
 }
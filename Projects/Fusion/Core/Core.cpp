@@ -10,6 +10,7 @@
 #include <Fusion/Drawable/Text.h>
 #include <Fusion/Drawable/TQuad.h>
 #include <Fusion/Resource/Bitmap.h>
+#include <Fusion/Resource/DiskCache.h>
 #include <Fusion/Resource/ImageGenerator.h>
 #include <Fusion/Resource/GlyphManager.h>
 #include <Fusion/Resource/ResManager.h>
@@ -108,6 +109,7 @@ String _sndAPI(""); // "", "OpenAL"
 
 // ResManager-related preferences.
 uint  _numResourceThreads = 0;
+uint  _diskCacheSize      = 256; // In MB; 0 disables the on-disk cache of procedural resources.
 
 // HID-related variables.
 Delegate1List<const Event&>  _onHID;
@@ -164,6 +166,7 @@ coreConfigVM( VMState* vm )
       VM::get( vm, -1, "gfxVSync", _gfxVSync );
       if( VM::get( vm, -1, "size", v2i ) )  Core::size( v2i );
       VM::get( vm, -1, "numResourceThreads", _numResourceThreads );
+      VM::get( vm, -1, "diskCacheSize", _diskCacheSize );
    }
    return 0;
 }
@@ -1520,6 +1523,12 @@ Core::exec()
    singleton().readConfig( singleton()._config );
    singleton().setRoots();
    ResManager::numThreads( _numResourceThreads );
+   if( _diskCacheSize > 0 )
+   {
+      Path dir = cacheRoot();
+      dir /= "procedural";
+      DiskCache::procedural( new DiskCache( dir, size_t(_diskCacheSize) << 20 ) );
+   }
 
    DBG_MSG( os_core, "Starting main loop" );
    singleton().performExec();
@@ -2319,6 +2328,9 @@ void Core::performRender()
 {
    PROFILE_EVENT( EventProfiler::RENDER_BEGIN );
 
+   // Recycle the per-frame constants of the previous frame (already displayed).
+   _gfx->beginFrame();
+
    {
       LockGuard guard( _renderBeginLock );
       ::executeDelegates( _renderBegin );
@@ -0,0 +1,517 @@
+/*=============================================================================
+   Copyright (c) 2012, Ludo Sapiens Inc. and contributors.
+   See accompanying file LICENSE.txt for details.
+=============================================================================*/
+#include <Fusion/Resource/DiskCache.h>
+
+#include <Base/ADT/Vector.h>
+#include <Base/Dbg/DebugStream.h>
+#include <Base/IO/BinaryStream.h>
+#include <Base/IO/FileDevice.h>
+#include <Base/IO/FileSystem.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+USING_NAMESPACE
+
+/*==============================================================================
+  UNNAMED NAMESPACE
+==============================================================================*/
+UNNAMESPACE_BEGIN
+
+DBG_STREAM( os_dc, "DiskCache" );
+
+const uint32_t  _indexMagic   = 0x78644350; // "PCdx"
+const uint32_t  _indexVersion = 1;
+
+// Bumped whenever the format of the generated blobs changes.
+const uint32_t  _keyVersion   = 2;
+
+//------------------------------------------------------------------------------
+//!
+struct StampedKey
+{
+   uint32_t      _stamp;
+   SHA1::Digest  _key;
+};
+
+//------------------------------------------------------------------------------
+//!
+inline bool stampSort( const StampedKey& a, const StampedKey& b )
+{
+   return a._stamp < b._stamp;
+}
+
+//------------------------------------------------------------------------------
+//! Parses a blob file name back into its digest.
+bool  parseKey( const String& name, SHA1::Digest& key )
+{
+   if( name.size() != 40 )  return false;
+   uint32_t* h = key;
+   return sscanf( name.cstr(), "%08x%08x%08x%08x%08x", h, h+1, h+2, h+3, h+4 ) == 5;
+}
+
+//------------------------------------------------------------------------------
+//!
+template< typename T > inline void  appendValue( String& dst, const T& v )
+{
+   dst.append( (const char*)&v, sizeof(T) );
+}
+
+//------------------------------------------------------------------------------
+//!
+template< typename T > inline bool  readValue( const String& src, size_t& pos, T& v )
+{
+   if( pos + sizeof(T) > src.size() )  return false;
+   memcpy( &v, src.cstr() + pos, sizeof(T) );
+   pos += sizeof(T);
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//! Builds the header of a blob, which stamps the files it was generated from:
+//! their count, then for each of them its name (length and characters), its
+//! size, and its modification time (0 for both when it doesn't exist).
+void  writeStamps( const Vector<String>& files, String& dst )
+{
+   appendValue( dst, uint32_t(files.size()) );
+   for( uint i = 0; i < files.size(); ++i )
+   {
+      const String& name = files[i];
+      FS::Entry entry( name );
+      bool exists = entry.exists();
+      appendValue( dst, uint32_t(name.size()) );
+      dst.append( name.cstr(), name.size() );
+      appendValue( dst, uint64_t(exists ? entry.size() : 0) );
+      appendValue( dst, uint64_t(exists ? time_t(entry.lastModified()) : 0) );
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Checks the header of a blob against the files it names, and returns the
+//! position of the data which follows it (0 when stale or malformed).
+size_t  checkStamps( const String& blob )
+{
+   size_t   pos = 0;
+   uint32_t count;
+   if( !readValue( blob, pos, count ) )  return 0;
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      uint32_t len;
+      if( !readValue( blob, pos, len ) || pos + len > blob.size() )  return 0;
+      String name = blob.sub( pos, len );
+      pos += len;
+
+      uint64_t size, mtime;
+      if( !readValue( blob, pos, size ) || !readValue( blob, pos, mtime ) )  return 0;
+
+      FS::Entry entry( name );
+      bool exists = entry.exists();
+      if( size  != uint64_t(exists ? entry.size() : 0) )  return 0;
+      if( mtime != uint64_t(exists ? time_t(entry.lastModified()) : 0) )  return 0;
+   }
+   return pos;
+}
+
+UNNAMESPACE_END
+
+
+/*==============================================================================
+  CLASS DiskCache
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//!
+DiskCache*  DiskCache::_procedural = nullptr;
+
+//------------------------------------------------------------------------------
+//!
+DiskCache*
+DiskCache::procedural()
+{
+   return _procedural;
+}
+
+//------------------------------------------------------------------------------
+//! Sets the cache used for the procedural resources, which takes ownership of it.
+void
+DiskCache::procedural( DiskCache* cache )
+{
+   if( cache == _procedural )  return;
+   delete _procedural;
+   _procedural = cache;
+}
+
+//------------------------------------------------------------------------------
+//! The key covers the source script (its path, size, and modification time)
+//! along with the digest of the parameters, so that editing either one misses.
+//! The other files the resource turns out to depend on are given to put().
+void
+DiskCache::key(
+   const char*         kind,
+   const String&       sourcePath,
+   const SHA1::Digest& params,
+   SHA1::Digest&       dst
+)
+{
+   SHA1 sha;
+   sha.begin();
+
+   sha.put( _keyVersion );
+   sha.put( kind );
+   sha.put( sourcePath.cstr(), sourcePath.size() );
+
+   FS::Entry entry( sourcePath );
+   if( entry.exists() )
+   {
+      sha.put( (uint64_t)entry.size() );
+      sha.put( (uint64_t)time_t(entry.lastModified()) );
+   }
+
+   const uint32_t* h = params;
+   for( uint i = 0; i < 5; ++i )
+   {
+      sha.put( h[i] );
+   }
+
+   dst = sha.end();
+}
+
+//------------------------------------------------------------------------------
+//!
+DiskCache::DiskCache( const Path& dir, size_t capacity ):
+   _dir( dir ),
+   _capacity( capacity ),
+   _bytes( 0 ),
+   _clock( 0 ),
+   _dirty( false ),
+   _hits( 0 ),
+   _misses( 0 ),
+   _evictions( 0 )
+{
+   _dir.toDir();
+   FS::createDirectories( _dir );
+   if( !loadIndex() )  rebuildIndex();
+   LockGuard lock( _lock );
+   evictLocked();
+}
+
+//------------------------------------------------------------------------------
+//!
+DiskCache::~DiskCache()
+{
+   flush();
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+DiskCache::capacity( size_t bytes )
+{
+   LockGuard lock( _lock );
+   _capacity = bytes;
+   evictLocked();
+}
+
+//------------------------------------------------------------------------------
+//! Reads the blob stored under the specified key into dst.
+//! Returns false if there is none (or if it could not be read).
+bool
+DiskCache::get( const SHA1::Digest& key, String& dst )
+{
+   LockGuard lock( _lock );
+
+   EntryContainer::Iterator it = _entries.find( key );
+   if( it == _entries.end() )
+   {
+      ++_misses;
+      return false;
+   }
+
+   size_t bytes = size_t(it->second._bytes);
+   RCP<FileDevice> fd = new FileDevice( blobPath( key ), IODevice::MODE_READ );
+   dst.resize( bytes );
+   if( !fd->isOpen() || (bytes && fd->read( &dst[0], bytes ) != bytes) )
+   {
+      // Deleted or truncated behind our back.
+      DBG_MSG( os_dc, "Dropping unreadable blob " << key.str() );
+      dst.clear();
+      removeLocked( it );
+      ++_misses;
+      return false;
+   }
+   fd->close();
+
+   size_t start = checkStamps( dst );
+   if( start == 0 )
+   {
+      // One of the files it was generated from changed.
+      DBG_MSG( os_dc, "Dropping stale blob " << key.str() );
+      dst.clear();
+      removeLocked( it );
+      saveIndex();
+      ++_misses;
+      return false;
+   }
+   dst.erase( 0, start );
+
+   it->second._stamp = ++_clock;
+   _dirty = true;
+   ++_hits;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//! Stores a blob under the specified key, replacing any previous one, along
+//! with the current size and modification time of the specified files; get()
+//! drops the blob once any of them changes.
+//! The blob is written to a temporary file first, so that a partially written
+//! file never gets picked up.
+bool
+DiskCache::put( const SHA1::Digest& key, const String& src, const Vector<String>& files )
+{
+   String header;
+   writeStamps( files, header );
+   size_t bytes = header.size() + src.size();
+
+   LockGuard lock( _lock );
+
+   if( _capacity != 0 && bytes > _capacity )  return false;
+
+   Path path = blobPath( key );
+   Path tmp  = path + ".tmp";
+   {
+      RCP<FileDevice> fd = new FileDevice( tmp, IODevice::MODE_WRITE|IODevice::MODE_NEWFILE );
+      bool ok = fd->isOpen() &&
+                fd->write( header.cstr(), header.size() ) == header.size() &&
+                fd->write( src.cstr(), src.size() ) == src.size() &&
+                fd->flush();
+      fd->close();
+      if( !ok )
+      {
+         StdErr << "DiskCache - Could not write " << tmp.string() << nl;
+         FS::remove( tmp );
+         return false;
+      }
+   }
+
+   EntryContainer::Iterator it = _entries.find( key );
+   if( it != _entries.end() )
+   {
+      _bytes -= size_t(it->second._bytes);
+      _entries.erase( it );
+   }
+   FS::remove( path ); // Required by rename() on Windows.
+   if( rename( tmp.cstr(), path.cstr() ) != 0 )
+   {
+      FS::remove( tmp );
+      return false;
+   }
+
+   Entry& e = _entries[key];
+   e._bytes = bytes;
+   e._stamp = ++_clock;
+   _bytes  += bytes;
+
+   evictLocked();
+
+   // Keep the index current so that a crash doesn't lose the blobs.
+   saveIndex();
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//!
+bool
+DiskCache::has( const SHA1::Digest& key ) const
+{
+   LockGuard lock( _lock );
+   return _entries.has( key );
+}
+
+//------------------------------------------------------------------------------
+//!
+bool
+DiskCache::remove( const SHA1::Digest& key )
+{
+   LockGuard lock( _lock );
+   EntryContainer::Iterator it = _entries.find( key );
+   if( it == _entries.end() )  return false;
+   removeLocked( it );
+   saveIndex();
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+DiskCache::clear()
+{
+   LockGuard lock( _lock );
+   while( !_entries.empty() )
+   {
+      removeLocked( _entries.begin() );
+   }
+   saveIndex();
+}
+
+//------------------------------------------------------------------------------
+//! Writes the last uses back to the index.
+bool
+DiskCache::flush()
+{
+   LockGuard lock( _lock );
+   return _dirty ? saveIndex() : true;
+}
+
+//------------------------------------------------------------------------------
+//!
+DiskCache::Stats
+DiskCache::stats() const
+{
+   LockGuard lock( _lock );
+   Stats s;
+   s._bytes     = _bytes;
+   s._entries   = _entries.size();
+   s._hits      = _hits;
+   s._misses    = _misses;
+   s._evictions = _evictions;
+   return s;
+}
+
+//------------------------------------------------------------------------------
+//!
+Path
+DiskCache::blobPath( const SHA1::Digest& key ) const
+{
+   Path path = _dir;
+   path /= key.str();
+   return path;
+}
+
+//------------------------------------------------------------------------------
+//!
+Path
+DiskCache::indexPath() const
+{
+   Path path = _dir;
+   path /= "index";
+   return path;
+}
+
+//------------------------------------------------------------------------------
+//! Index layout: magic, version, clock, count, then for every blob its digest
+//! (5 words), its size (64 bits), and its last use (32 bits).
+bool
+DiskCache::loadIndex()
+{
+   RCP<FileDevice> fd = new FileDevice( indexPath(), IODevice::MODE_READ );
+   if( !fd->isOpen() )  return false;
+
+   BinaryStream is( fd.ptr() );
+   uint32_t magic, version, count;
+   is >> magic >> version >> _clock >> count;
+   if( !is.ok() || magic != _indexMagic || version != _indexVersion )  return false;
+
+   _entries.clear();
+   _bytes = 0;
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      uint32_t h[5];
+      Entry e;
+      is >> h[0] >> h[1] >> h[2] >> h[3] >> h[4] >> e._bytes >> e._stamp;
+      if( !is.ok() )
+      {
+         _entries.clear();
+         _bytes = 0;
+         return false;
+      }
+      _entries[SHA1::Digest( h )] = e;
+      _bytes += size_t(e._bytes);
+   }
+   _dirty = false;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//! Recovers the blobs present in the directory when the index is missing.
+void
+DiskCache::rebuildIndex()
+{
+   DBG_MSG( os_dc, "Rebuilding index in " << _dir.string() );
+   _entries.clear();
+   _bytes = 0;
+   _clock = 0;
+   for( FS::DirIterator it( _dir ); it(); ++it )
+   {
+      SHA1::Digest key;
+      if( !parseKey( *it, key ) )  continue;
+      Path path = _dir;
+      path /= *it;
+      FS::Entry entry( path );
+      if( entry.type() != FS::TYPE_FILE )  continue;
+      Entry& e = _entries[key];
+      e._bytes = entry.size();
+      e._stamp = 0;
+      _bytes  += entry.size();
+   }
+   saveIndex();
+}
+
+//------------------------------------------------------------------------------
+//!
+bool
+DiskCache::saveIndex()
+{
+   RCP<FileDevice> fd = new FileDevice( indexPath(), IODevice::MODE_WRITE|IODevice::MODE_NEWFILE );
+   if( !fd->isOpen() )  return false;
+
+   BinaryStream os( fd.ptr() );
+   os << _indexMagic << _indexVersion << _clock << (uint32_t)_entries.size();
+   for( EntryContainer::ConstIterator it = _entries.begin(); it != _entries.end(); ++it )
+   {
+      const uint32_t* h = it->first;
+      os << h[0] << h[1] << h[2] << h[3] << h[4] << it->second._bytes << it->second._stamp;
+   }
+   _dirty = !os.ok();
+   return !_dirty;
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+DiskCache::removeLocked( EntryContainer::Iterator it )
+{
+   FS::remove( blobPath( it->first ) );
+   _bytes -= size_t(it->second._bytes);
+   _entries.erase( it );
+   _dirty = true;
+}
+
+//------------------------------------------------------------------------------
+//! Deletes the least recently used blobs until the cache fits its capacity.
+void
+DiskCache::evictLocked()
+{
+   if( _capacity == 0 || _bytes <= _capacity )  return;
+
+   Vector<StampedKey> order;
+   order.reserve( _entries.size() );
+   for( EntryContainer::ConstIterator it = _entries.begin(); it != _entries.end(); ++it )
+   {
+      StampedKey sk;
+      sk._stamp = it->second._stamp;
+      sk._key   = it->first;
+      order.pushBack( sk );
+   }
+   std::sort( order.begin(), order.end(), stampSort );
+
+   for( size_t i = 0; i < order.size() && _bytes > _capacity; ++i )
+   {
+      DBG_MSG( os_dc, "Evicting " << order[i]._key.str() );
+      removeLocked( _entries.find( order[i]._key ) );
+      ++_evictions;
+   }
+}
@@ -0,0 +1,129 @@
+/*=============================================================================
+   Copyright (c) 2012, Ludo Sapiens Inc. and contributors.
+   See accompanying file LICENSE.txt for details.
+=============================================================================*/
+#ifndef FUSION_DISK_CACHE_H
+#define FUSION_DISK_CACHE_H
+
+#include <Fusion/StdDefs.h>
+
+#include <Base/ADT/Map.h>
+#include <Base/ADT/String.h>
+#include <Base/ADT/Vector.h>
+#include <Base/IO/Path.h>
+#include <Base/MT/Lock.h>
+#include <Base/Util/SHA.h>
+
+NAMESPACE_BEGIN
+
+/*==============================================================================
+  CLASS DiskCache
+==============================================================================*/
+//! A content-addressed cache of blobs on disk, used to avoid regenerating
+//! procedural resources from one run to the next.
+//! Every blob is stored in its own file, named after its digest, and a small
+//! index keeps the size and the last use of each of them. When the cache grows
+//! past its capacity, the least recently used blobs are deleted.
+//! A blob also remembers the files it was generated from (besides the ones the
+//! key covers), and is dropped when any of them changed.
+class DiskCache
+{
+public:
+
+   /*----- types -----*/
+
+   struct Stats
+   {
+      Stats(): _bytes(0), _entries(0), _hits(0), _misses(0), _evictions(0) {}
+
+      size_t  _bytes;
+      size_t  _entries;
+      uint    _hits;
+      uint    _misses;
+      uint    _evictions;
+   };
+
+   /*----- static methods -----*/
+
+   // The cache used by the procedural resources (null when disabled).
+   static FUSION_DLL_API DiskCache*  procedural();
+   static FUSION_DLL_API void        procedural( DiskCache* cache );
+
+   // Builds the key of a generated resource from everything it depends on.
+   static FUSION_DLL_API void  key(
+      const char*         kind,
+      const String&       sourcePath,
+      const SHA1::Digest& params,
+      SHA1::Digest&       dst
+   );
+
+   /*----- methods -----*/
+
+   FUSION_DLL_API DiskCache( const Path& dir, size_t capacity = 0 );
+   FUSION_DLL_API ~DiskCache();
+
+   inline const Path&  directory() const { return _dir; }
+
+   // Total size of the blobs in bytes (0 means no limit).
+   inline size_t  capacity() const { return _capacity; }
+   FUSION_DLL_API void  capacity( size_t bytes );
+
+   FUSION_DLL_API bool  get( const SHA1::Digest& key, String& dst );
+   FUSION_DLL_API bool  put( const SHA1::Digest& key, const String& src, const Vector<String>& files = Vector<String>() );
+   FUSION_DLL_API bool  has( const SHA1::Digest& key ) const;
+   FUSION_DLL_API bool  remove( const SHA1::Digest& key );
+   FUSION_DLL_API void  clear();
+
+   FUSION_DLL_API bool  flush();
+
+   FUSION_DLL_API Stats  stats() const;
+
+protected:
+
+   /*----- types -----*/
+
+   struct Entry
+   {
+      uint64_t  _bytes;
+      uint32_t  _stamp;  //!< Clock value at the last use.
+   };
+
+   typedef Map< SHA1::Digest, Entry >  EntryContainer;
+
+   /*----- methods -----*/
+
+   Path  blobPath( const SHA1::Digest& key ) const;
+   Path  indexPath() const;
+
+   bool  loadIndex();
+   void  rebuildIndex();
+   bool  saveIndex();
+   void  removeLocked( EntryContainer::Iterator it );
+   void  evictLocked();
+
+   /*----- static data members -----*/
+
+   static DiskCache*  _procedural;
+
+   /*----- data members -----*/
+
+   mutable Lock    _lock;
+   Path            _dir;
+   EntryContainer  _entries;
+   size_t          _capacity;
+   size_t          _bytes;
+   uint32_t        _clock;
+   bool            _dirty;
+   uint            _hits;
+   uint            _misses;
+   uint            _evictions;
+
+private:
+
+   DiskCache( const DiskCache& );
+   void operator=( const DiskCache& );
+}; //class DiskCache
+
+NAMESPACE_END
+
+#endif //FUSION_DISK_CACHE_H
@@ -5,11 +5,15 @@
 #include <Fusion/Resource/ImageGenerator.h>
 
 #include <Fusion/Resource/BitmapManipulator.h>
+#include <Fusion/Resource/DiskCache.h>
+#include <Fusion/Resource/ResManager.h>
 #include <Fusion/VM/VM.h>
 #include <Fusion/VM/VMRegistry.h>
 
 #include <Base/ADT/StringMap.h>
 #include <Base/Dbg/Defs.h>
+#include <Base/IO/BinaryStream.h>
+#include <Base/IO/StringDevice.h>
 #include <Base/Util/Timer.h>
 
 USING_NAMESPACE
@@ -225,6 +229,31 @@ void initVM( VMState* vm, uint /*mask*/ )
    VM::registerFunctions( vm, "_G", funcs );
 }
 
+//------------------------------------------------------------------------------
+//! Serializes a generated bitmap for the disk cache.
+void  writeBitmap( const Bitmap& bmp, String& dst )
+{
+   BinaryStream os( new StringDevice( dst, IODevice::MODE_WRITE ) );
+   os << (uint32_t)bmp.width() << (uint32_t)bmp.height();
+   os << (uint8_t)bmp.pixelType() << (uint8_t)bmp.numChannels();
+   os.write( (const char*)bmp.pixels(), bmp.size() );
+}
+
+//------------------------------------------------------------------------------
+//!
+RCP<Bitmap>  readBitmap( String& src, const Vec2i& size, Bitmap::PixelType type, int chan )
+{
+   BinaryStream is( new StringDevice( src, IODevice::MODE_READ ) );
+   uint32_t w, h;
+   uint8_t  t, c;
+   is >> w >> h >> t >> c;
+   if( !is.ok() || int(w) != size.x || int(h) != size.y || t != type || c != chan )  return nullptr;
+
+   RCP<Bitmap> bmp = new Bitmap( size, type, chan );
+   if( is.read( (char*)bmp->pixels(), bmp->size() ) != bmp->size() )  return nullptr;
+   return bmp;
+}
+
 UNNAMESPACE_END
 
 /*==============================================================================
@@ -274,6 +303,32 @@ ImageGenerator::~ImageGenerator()
 void
 ImageGenerator::execute()
 {
+   // Reuse the image generated by a previous run, if any.
+   DiskCache*   cache = DiskCache::procedural();
+   SHA1::Digest key;
+   if( cache )
+   {
+      SHA1 sha;
+      sha.begin();
+      sha.put( (uint32_t)_size.x );
+      sha.put( (uint32_t)_size.y );
+      sha.put( (uint8_t)_type );
+      sha.put( (uint8_t)_chan );
+      if( _args.isValid() )  ResManager::getDigestPart( *_args, sha );
+      DiskCache::key( "image", _path, sha.end(), key );
+
+      String blob;
+      if( cache->get( key, blob ) )
+      {
+         RCP<Bitmap> bmp = readBitmap( blob, _size, _type, _chan );
+         if( bmp.isValid() )
+         {
+            _result->bitmap( bmp.ptr() );
+            return;
+         }
+      }
+   }
+
    // Prepare to build image.
    VMState* vm = VM::open( VM_CAT_IMAGE | VM_CAT_MATH, true );
 
@@ -312,4 +367,11 @@ ImageGenerator::execute()
    }
 
    _result->bitmap( context._bitmap.ptr() );
+
+   if( cache )
+   {
+      String blob;
+      writeBitmap( *(context._bitmap), blob );
+      cache->put( key, blob );
+   }
 }
@@ -21,10 +21,19 @@ ResCacheBase::CacheContainer  ResCacheBase::_caches;
 //!
 Lock  ResCacheBase::_cachesLock;
 
+//------------------------------------------------------------------------------
+//!
+size_t  ResCacheBase::_globalBudget = 0;
+
+//------------------------------------------------------------------------------
+//!
+AtomicInt32  ResCacheBase::_clock( 0 );
+
 //------------------------------------------------------------------------------
 //!
 ResCacheBase::ResCacheBase( const String& name ):
-   _name( name )
+   _name( name ),
+   _budget( 0 )
 {
    LockGuard lock( _cachesLock );
    _caches.pushBack( this );
@@ -50,6 +59,7 @@ ResCacheBase::cleanAll( double t )
    {
       (*cur)->clean( t );
    }
+   enforceGlobalBudget();
 }
 
 //------------------------------------------------------------------------------
@@ -65,3 +75,95 @@ ResCacheBase::clearAll()
       (*cur)->clear();
    }
 }
+
+//------------------------------------------------------------------------------
+//!
+ResCacheBase::Stats
+ResCacheBase::statsAll()
+{
+   LockGuard lock( _cachesLock );
+   Stats s;
+   for( CacheContainer::Iterator cur = _caches.begin();
+        cur != _caches.end();
+        ++cur )
+   {
+      s += (*cur)->stats();
+   }
+   return s;
+}
+
+//------------------------------------------------------------------------------
+//!
+size_t
+ResCacheBase::globalBudget()
+{
+   return _globalBudget;
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+ResCacheBase::globalBudget( size_t b )
+{
+   LockGuard lock( _cachesLock );
+   _globalBudget = b;
+}
+
+//------------------------------------------------------------------------------
+//! Returns a new value of the clock ordering the uses of all of the caches.
+int32_t
+ResCacheBase::stamp()
+{
+   return ++_clock;
+}
+
+//------------------------------------------------------------------------------
+//!
+ResCacheBase*
+ResCacheBase::find( const String& name )
+{
+   LockGuard lock( _cachesLock );
+   for( CacheContainer::Iterator cur = _caches.begin();
+        cur != _caches.end();
+        ++cur )
+   {
+      if( (*cur)->name() == name )  return *cur;
+   }
+   return nullptr;
+}
+
+//------------------------------------------------------------------------------
+//! Evicts the least recently used resources across all of the caches until
+//! they fit in the global budget. Must be called with _cachesLock held.
+void
+ResCacheBase::enforceGlobalBudget()
+{
+   if( _globalBudget == 0 )  return;
+
+   size_t bytes = 0;
+   for( CacheContainer::Iterator cur = _caches.begin(); cur != _caches.end(); ++cur )
+   {
+      bytes += (*cur)->stats()._bytes;
+   }
+
+   while( bytes > _globalBudget )
+   {
+      // Find the cache holding the oldest unused resource.
+      ResCacheBase* oldest = nullptr;
+      int32_t oldestStamp  = 0;
+      for( CacheContainer::Iterator cur = _caches.begin(); cur != _caches.end(); ++cur )
+      {
+         int32_t s;
+         if( (*cur)->oldestUnused( s ) && (!oldest || olderThan( s, oldestStamp )) )
+         {
+            oldest      = *cur;
+            oldestStamp = s;
+         }
+      }
+      if( !oldest )  break;
+
+      size_t freed = oldest->evictOldest();
+      if( freed == 0 )  break;
+      bytes -= freed;
+   }
+}
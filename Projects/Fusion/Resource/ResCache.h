@@ -12,9 +12,11 @@
 
 #include <CGMath/CGConst.h>
 
+#include <Base/MT/Atomic.h>
 #include <Base/MT/Lock.h>
 #include <Base/ADT/Map.h>
 #include <Base/ADT/String.h>
+#include <Base/ADT/Vector.h>
 #include <Base/Util/RCP.h>
 
 NAMESPACE_BEGIN
@@ -26,6 +28,32 @@ class ResCacheBase
 {
 public:
 
+   /*----- types -----*/
+
+   //! Usage counters of a cache (or of all of them).
+   struct Stats
+   {
+      Stats(): _bytes(0), _entries(0), _hits(0), _misses(0), _evictions(0) {}
+
+      float  hitRate() const { return (_hits + _misses) ? float(_hits) / float(_hits + _misses) : 0.0f; }
+
+      Stats& operator+=( const Stats& s )
+      {
+         _bytes     += s._bytes;
+         _entries   += s._entries;
+         _hits      += s._hits;
+         _misses    += s._misses;
+         _evictions += s._evictions;
+         return *this;
+      }
+
+      size_t  _bytes;      //!< Bytes held by the resident resources (those loaded so far).
+      size_t  _entries;
+      uint    _hits;
+      uint    _misses;
+      uint    _evictions;
+   };
+
    /*----- methods -----*/
 
    FUSION_DLL_API ResCacheBase( const String& name );
@@ -33,11 +61,22 @@ public:
 
    inline const String&  name() const { return _name; }
 
+   // Memory budget in bytes (0 means no limit).
+   inline size_t  budget() const     { return _budget; }
+   inline void    budget( size_t b ) { _budget = b; }
+
    FUSION_DLL_API virtual void  clean( double t ) = 0;
    FUSION_DLL_API virtual void  clear()           = 0;
+   FUSION_DLL_API virtual Stats  stats() const    = 0;
 
    static FUSION_DLL_API void  cleanAll( double curTime );
    static FUSION_DLL_API void  clearAll();
+   static FUSION_DLL_API Stats  statsAll();
+   static FUSION_DLL_API ResCacheBase*  find( const String& name );
+
+   // Budget shared by all of the caches (0 means no limit).
+   static FUSION_DLL_API size_t  globalBudget();
+   static FUSION_DLL_API void    globalBudget( size_t b );
 
 protected:
 
@@ -45,14 +84,28 @@ protected:
 
    typedef Vector< ResCacheBase* >  CacheContainer;
 
+   /*----- methods -----*/
+
+   // Global eviction support.
+   virtual bool    oldestUnused( int32_t& stamp ) const = 0;
+   virtual size_t  evictOldest() = 0;
+
+   static FUSION_DLL_API int32_t  stamp();
+   static inline bool     olderThan( int32_t a, int32_t b ) { return int32_t(a - b) < 0; }
+
+   static void  enforceGlobalBudget();
+
    /*----- static data members -----*/
 
    static CacheContainer  _caches;
    static Lock            _cachesLock;
+   static size_t          _globalBudget;
+   static AtomicInt32     _clock;        //!< Orders the uses across all of the caches.
 
    /*----- data members -----*/
 
    String  _name;
+   size_t  _budget;
 
 private:
 }; //class ResCacheBase
@@ -61,20 +114,34 @@ private:
 /*==============================================================================
   CLASS ResCache
 ==============================================================================*/
+
+//! Keeps resources by key, and evicts the ones nobody refers to anymore.
+//! Entries are kept in a list from most to least recently used. An unused
+//! entry is evicted once it has stayed unused for the eviction delay, or
+//! sooner, least recently used first, when the cache is over its budget.
+//! Entries still referred to outside of the cache are never evicted.
 template< typename T, typename K = String >
 class ResCache:
    public ResCacheBase
 {
 public:
 
+   /*----- types -----*/
+
+   //! Returns the number of bytes held by a resource's data.
+   typedef size_t (*SizeFunc)( const T& );
+
    /*----- methods -----*/
 
-   ResCache( const String& name, double evictionDelay = 0.5 );
+   ResCache( const String& name, double evictionDelay = 0.5, SizeFunc sizeFunc = nullptr );
    virtual ~ResCache() {}
 
    inline double  evictionDelay() const     { return _evictionDelay; }
    inline void    evictionDelay( double d ) { _evictionDelay = d; }
 
+   inline SizeFunc  sizeFunc() const         { return _sizeFunc; }
+   inline void      sizeFunc( SizeFunc f )   { _sizeFunc = f; }
+
    inline Resource<T>* get( const K& key );
    inline const K& get( const Resource<T>* res ) const;
    inline const K& get( const T* res ) const;
@@ -84,33 +151,45 @@ public:
 
    void  clean( double t );
    void  clear();
+   Stats  stats() const;
 
 protected:
 
    /*----- type and classes -----*/
 
+   struct Entry;
+
+   typedef Map< K, Entry >                ForwardMap;
+   typedef Map< const Resource<T>*, K >  BackwardMap;
+
    struct Entry
    {
       Entry() {}
-      Entry( Resource<T>* res ): _res( res ), _timestamp( CGConstd::infinity() ) {}
+      Entry( Resource<T>* res ):
+         _res( res ), _prev( nullptr ), _next( nullptr ),
+         _bytes( 0 ), _sized( false ), _time( CGConstd::infinity() ), _stamp( 0 ) {}
 
       Resource<T>*  resource() const { return _res.ptr(); }
       bool  isResourceUnique() const { return _res.isUnique(); }
       bool  isDataUnique() const     { return _res->data() && _res->data()->isUnique(); }
+      bool  isUnused() const         { return isResourceUnique() && isDataUnique(); }
 
-      void  markUsed()               { _timestamp = CGConstd::infinity(); }
-      void  markUnused( double t )   { _timestamp = t; }
-      bool  markedUnused()           { return _timestamp != CGConstd::infinity(); }
+      void  markUsed()               { _time = CGConstd::infinity(); }
+      void  markUnused( double t )   { _time = t; }
+      bool  markedUnused() const     { return _time != CGConstd::infinity(); }
 
       /*----- data members -----*/
 
-      RCP< Resource<T> >  _res;        //!< The resource's pointer to the data.
-      double              _timestamp;  //!< Timestamp.  +inf means it is in use, otherwise, it's the earliest unused timestamp.
+      RCP< Resource<T> >            _res;    //!< The resource's pointer to the data.
+      typename ForwardMap::Iterator _it;     //!< The entry's position in the forward map.
+      Entry*                        _prev;   //!< The next more recently used entry.
+      Entry*                        _next;   //!< The next less recently used entry.
+      size_t                        _bytes;
+      bool                          _sized;  //!< Whether _bytes was computed from the loaded data.
+      double                        _time;   //!< +inf while in use, otherwise the earliest time it was seen unused.
+      int32_t                       _stamp;  //!< The time of the last use, in ResCacheBase::stamp() units.
    };
 
-   typedef Map< K, Entry >                ForwardMap;
-   typedef Map< const Resource<T>*, K >  BackwardMap;
-
    /*----- methods -----*/
 
    // Disallow copying.
@@ -119,14 +198,31 @@ protected:
 
    void removeLocked( const typename ForwardMap::Iterator& fit );
 
-   inline bool  shouldEvict( const Entry& e, double t ) const { return (t - e._timestamp) >= _evictionDelay; }
+   inline bool  shouldEvict( const Entry& e, double t ) const { return (t - e._time) >= _evictionDelay; }
+
+   // Recency list.
+   inline void  link( Entry* e );
+   inline void  unlink( Entry* e );
+   inline void  touch( Entry* e ) { unlink( e ); link( e ); }
+
+   void    sizeLoaded();
+   size_t  evictLocked( Entry* e );
+   void    enforceBudget();
+
+   virtual bool    oldestUnused( int32_t& stamp ) const;
+   virtual size_t  evictOldest();
 
    /*----- data members -----*/
 
-   mutable Lock  _lock;
-   ForwardMap    _fmap;
-   BackwardMap   _bmap;
-   double        _evictionDelay;
+   mutable Lock     _lock;
+   ForwardMap       _fmap;
+   BackwardMap      _bmap;
+   double           _evictionDelay;
+   SizeFunc         _sizeFunc;
+   Entry*           _head;       //!< The most recently used entry.
+   Entry*           _tail;       //!< The least recently used entry.
+   Vector<Entry*>   _unsized;    //!< Entries whose data wasn't loaded yet when last checked.
+   mutable Stats    _stats;
 
 private:
    static K  _null;
@@ -140,9 +236,12 @@ template< typename T, typename K > K ResCache<T,K>::_null = K();
 //------------------------------------------------------------------------------
 //!
 template< typename T, typename K >
-ResCache<T,K>::ResCache( const String& name, double evictionDelay ):
+ResCache<T,K>::ResCache( const String& name, double evictionDelay, SizeFunc sizeFunc ):
    ResCacheBase( name ),
-   _evictionDelay( evictionDelay )
+   _evictionDelay( evictionDelay ),
+   _sizeFunc( sizeFunc ),
+   _head( nullptr ),
+   _tail( nullptr )
 {}
 
 ////------------------------------------------------------------------------------
@@ -160,9 +259,13 @@ ResCache<T,K>::get( const K& key )
    typename ForwardMap::Iterator result = _fmap.find( key );
    if( result != _fmap.end() )
    {
-      (*result).second.markUsed();
-      return (*result).second.resource();
+      Entry& e = (*result).second;
+      e.markUsed();
+      touch( &e );
+      ++_stats._hits;
+      return e.resource();
    }
+   ++_stats._misses;
    return NULL;
 }
 
@@ -199,9 +302,16 @@ template< typename T, typename K > Resource<T>*
 ResCache<T,K>::add( const K& key )
 {
    LockGuard lock( _lock );
+   typename ForwardMap::Iterator fit = _fmap.find( key );
+   if( fit != _fmap.end() )  removeLocked( fit );
+
    Resource<T>* res = new Resource<T>();
    res->state( Resource<T>::LOADING );
-   _fmap[ key ] = Entry( res );
+   fit = _fmap.insert( std::make_pair( key, Entry( res ) ) ).first;
+   Entry& e = (*fit).second;
+   e._it    = fit;
+   link( &e );
+   _unsized.pushBack( &e );
    _bmap[ res ] = key;
    return res;
 }
@@ -224,35 +334,54 @@ ResCache<T,K>::remove( const K& key )
 template< typename T, typename K > void
 ResCache<T,K>::removeLocked( const typename ForwardMap::Iterator& fit )
 {
-   typename BackwardMap::Iterator bit = _bmap.find( (*fit).second.resource() );
+   Entry* e = &(*fit).second;
+   unlink( e );
+   if( e->_sized )  _stats._bytes -= e->_bytes;
+   else             _unsized.removeSwap( e );
+   typename BackwardMap::Iterator bit = _bmap.find( e->resource() );
    _bmap.erase( bit );
    _fmap.erase( fit );
 }
 
 //------------------------------------------------------------------------------
-//!
+//! Walks from the least recently used entry, evicting the ones which stayed
+//! unused for the eviction delay, and stops at the first one which hasn't yet.
+//! Entries found in use count as used now, and move to the front.
 template< typename T, typename K > void
 ResCache<T,K>::clean( double t )
 {
    LockGuard lock( _lock );
 
-   typename ForwardMap::Iterator cur = _fmap.begin();
-   while( cur != _fmap.end() )
-   {
-      Entry& entry = (*cur).second;
+   sizeLoaded();
 
-      if( entry.isResourceUnique() && entry.isDataUnique() )
+   size_t n = _fmap.size();
+   Entry* e = _tail;
+   while( e && n-- > 0 )
+   {
+      Entry* prev = e->_prev;
+      if( !e->isUnused() )
+      {
+         e->markUsed();
+         touch( e );
+      }
+      else if( !e->markedUnused() )
       {
-         if( !entry.markedUnused() )  entry.markUnused(t);
-         if( shouldEvict(entry, t) )
-         {
-            StdErr << "Evicting '" << (*cur).first << nl;
-            removeLocked( cur++ );
-            continue; // Don't call ++cur below.
-         }
+         e->markUnused( t );
       }
-      ++cur;
+      else if( shouldEvict( *e, t ) )
+      {
+         StdErr << "Evicting '" << (*e->_it).first << nl;
+         evictLocked( e );
+      }
+      else
+      {
+         // The rest was used more recently.
+         break;
+      }
+      e = prev;
    }
+
+   enforceBudget();
 }
 
 //------------------------------------------------------------------------------
@@ -263,6 +392,128 @@ ResCache<T,K>::clear()
    LockGuard lock( _lock );
    _fmap.clear();
    _bmap.clear();
+   _unsized.clear();
+   _head         = nullptr;
+   _tail         = nullptr;
+   _stats._bytes = 0;
+}
+
+//------------------------------------------------------------------------------
+//!
+template< typename T, typename K > ResCacheBase::Stats
+ResCache<T,K>::stats() const
+{
+   LockGuard lock( _lock );
+   Stats s    = _stats;
+   s._entries = _fmap.size();
+   return s;
+}
+
+//------------------------------------------------------------------------------
+//! Inserts the entry as the most recently used one.
+template< typename T, typename K > void
+ResCache<T,K>::link( Entry* e )
+{
+   e->_prev  = nullptr;
+   e->_next  = _head;
+   e->_stamp = stamp();
+   if( _head )  _head->_prev = e;
+   else         _tail        = e;
+   _head = e;
+}
+
+//------------------------------------------------------------------------------
+//!
+template< typename T, typename K > void
+ResCache<T,K>::unlink( Entry* e )
+{
+   if( e->_prev )  e->_prev->_next = e->_next;
+   else            _head           = e->_next;
+   if( e->_next )  e->_next->_prev = e->_prev;
+   else            _tail           = e->_prev;
+   e->_prev = nullptr;
+   e->_next = nullptr;
+}
+
+//------------------------------------------------------------------------------
+//! Accounts for the size of the entries loaded since the last call.
+template< typename T, typename K > void
+ResCache<T,K>::sizeLoaded()
+{
+   for( size_t i = 0; i < _unsized.size(); )
+   {
+      Entry* e = _unsized[i];
+      const T* data = e->resource()->data();
+      if( data && e->resource()->isReady() )
+      {
+         e->_bytes      = _sizeFunc ? _sizeFunc( *data ) : 0;
+         e->_sized      = true;
+         _stats._bytes += e->_bytes;
+         _unsized[i]    = _unsized.back();
+         _unsized.popBack();
+      }
+      else
+      {
+         ++i;
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Removes the entry and returns the bytes it freed.
+template< typename T, typename K > size_t
+ResCache<T,K>::evictLocked( Entry* e )
+{
+   size_t bytes = e->_sized ? e->_bytes : 0;
+   ++_stats._evictions;
+   removeLocked( e->_it );
+   return bytes;
+}
+
+//------------------------------------------------------------------------------
+//! Evicts unused entries, least recently used first, until within budget.
+template< typename T, typename K > void
+ResCache<T,K>::enforceBudget()
+{
+   if( _budget == 0 )  return;
+
+   Entry* e = _tail;
+   while( e && _stats._bytes > _budget )
+   {
+      Entry* prev = e->_prev;
+      if( e->isUnused() )  evictLocked( e );
+      e = prev;
+   }
+}
+
+//------------------------------------------------------------------------------
+//!
+template< typename T, typename K > bool
+ResCache<T,K>::oldestUnused( int32_t& stamp ) const
+{
+   LockGuard lock( _lock );
+   for( const Entry* e = _tail; e; e = e->_prev )
+   {
+      if( e->_sized && e->_bytes && e->isUnused() )
+      {
+         stamp = e->_stamp;
+         return true;
+      }
+   }
+   return false;
+}
+
+//------------------------------------------------------------------------------
+//!
+template< typename T, typename K > size_t
+ResCache<T,K>::evictOldest()
+{
+   LockGuard lock( _lock );
+   for( Entry* e = _tail; e; e = e->_prev )
+   {
+      if( e->_sized && e->_bytes && e->isUnused() )  return evictLocked( e );
+   }
+   return 0;
 }
 
 NAMESPACE_END
@@ -5,6 +5,7 @@
 #include <Fusion/Resource/ResManager.h>
 
 #include <Fusion/Core/Animator.h>
+#include <Fusion/Resource/DiskCache.h>
 #include <Fusion/Resource/Font.h>
 #include <Fusion/Resource/Image.h>
 #include <Fusion/Resource/ImageGenerator.h>
@@ -65,6 +66,31 @@ ResCache< Gfx::Program  >*  _rc_prog    = NULL;
 ResCache< Snd::Sound    >*  _rc_snd     = NULL;
 
 
+//------------------------------------------------------------------------------
+//! Sizes of the cached resources, used for the caches' memory budgets.
+size_t imageBytes( const Image& img )
+{
+   return img.bitmap() ? img.bitmap()->size() : 0;
+}
+
+//------------------------------------------------------------------------------
+//! Estimates the memory used by a texture, counting its mipmaps and faces.
+size_t textureBytes( const Gfx::Texture& tex )
+{
+   size_t bytes = size_t(tex.width()) * CGM::max( tex.height(), 1u ) * CGM::max( tex.depth(), 1u );
+   bytes       *= Gfx::toBytes( tex.format() );
+   if( tex.type() == Gfx::TEX_TYPE_CUBEMAP )  bytes *= 6;
+   if( tex.isMipmapped() )                    bytes += bytes / 3;
+   return bytes;
+}
+
+//------------------------------------------------------------------------------
+//!
+size_t soundBytes( const Snd::Sound& snd )
+{
+   return snd.sizeInBytes();
+}
+
 //------------------------------------------------------------------------------
 //!
 struct KeyVariant
@@ -476,9 +502,9 @@ ResManager::initializeFusion()
 {
    //os_res.activate();
 
-   _rc_image     = new ResCache< Image, DigestKey >( "Image"          );
-   _rc_imageCube = new ResCache< Image, DigestKey >( "ImageCube"      );
-   _rc_texture   = new ResCache< Gfx::Texture     >( "Texture"        );
+   _rc_image     = new ResCache< Image, DigestKey >( "Image"         , 0.5, imageBytes   );
+   _rc_imageCube = new ResCache< Image, DigestKey >( "ImageCube"     , 0.5, imageBytes   );
+   _rc_texture   = new ResCache< Gfx::Texture     >( "Texture"       , 0.5, textureBytes );
    _rc_font      = new ResCache< Font             >( "Font"           );
    _rc_vs        = new ResCache< Gfx::Shader      >( "VertexShader"   );
    _rc_gs        = new ResCache< Gfx::Shader      >( "GeometryShader" );
@@ -486,7 +512,7 @@ ResManager::initializeFusion()
    //_rc_cs      = new ResCache< Gfx::Shader      >( "ComputeShader"  );
    _rc_ff        = new ResCache< Gfx::Shader      >( "FixedFunction"  );
    _rc_prog      = new ResCache< Gfx::Program     >( "Program"        );
-   _rc_snd       = new ResCache< Snd::Sound       >( "Sound"          );
+   _rc_snd       = new ResCache< Snd::Sound       >( "Sound"         , 0.5, soundBytes   );
 
    VMRegistry::add( initVM, VM_CAT_APP );
    _register( clearFusion );
@@ -514,6 +540,8 @@ ResManager::terminateFusion()
    delete _rc_ff       ; _rc_ff        = NULL;
    delete _rc_prog     ; _rc_prog      = NULL;
    delete _rc_snd      ; _rc_snd       = NULL;
+
+   DiskCache::procedural( NULL );
 }
 
 //------------------------------------------------------------------------------
@@ -412,11 +412,28 @@ VM::userData( VMState* vm, void* data )
    lua_rawset( vm, LUA_REGISTRYINDEX );
 }
 
+//------------------------------------------------------------------------------
+//! Appends the name of every file loaded in the vm from now on to files
+//! (NULL to stop), e.g. to know everything a generated resource depends on.
+void
+VM::recordFiles( VMState* vm, Vector<String>* files )
+{
+   lua_pushlightuserdata( vm, (int*)vm+3 );
+   lua_pushlightuserdata( vm, files );
+   lua_rawset( vm, LUA_REGISTRYINDEX );
+}
+
 //------------------------------------------------------------------------------
 //!
 int
 VM::loadFile( VMState* vm, const Path& fileName )
 {
+   lua_pushlightuserdata( vm, (int*)vm+3 );
+   lua_rawget( vm, LUA_REGISTRYINDEX );
+   Vector<String>* files = (Vector<String>*)lua_touserdata( vm, -1 );
+   lua_pop( vm, 1 );
+   if( files )  files->pushBack( fileName.string() );
+
    return luaL_loadfile( vm, fileName.cstr() );
 }
 
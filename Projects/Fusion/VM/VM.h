@@ -168,6 +168,7 @@ public:
    static FUSION_DLL_API void  close( VMState* );
    static FUSION_DLL_API void* userData( VMState* );
    static FUSION_DLL_API void  userData( VMState*, void* data );
+   static FUSION_DLL_API void  recordFiles( VMState*, Vector<String>* files );
    static FUSION_DLL_API int   loadFile( VMState*, const Path& fileName );
    static FUSION_DLL_API void  doFile( VMState*, const String& fileName, int nresults = 0 );
    static FUSION_DLL_API void  doFile( VMState*, const String& fileName, int nargs, int nresults );
@@ -8,7 +8,9 @@
 //#include <Base/Util/Validator.h>
 
 #include <Fusion/Resource/BitmapManipulator.h>
+#include <Fusion/Resource/DiskCache.h>
 #include <Fusion/Resource/RectPacker.h>
+#include <Fusion/Resource/ResCache.h>
 #include <Fusion/Resource/ResManager.h>
 
 #include <CGMath/Dist.h>
@@ -16,6 +18,7 @@
 #include <CGMath/Vec4.h>
 
 #include <Base/IO/FileDevice.h>
+#include <Base/IO/FileSystem.h>
 #include <Base/IO/TextStream.h>
 #include <CGMath/Vec2.h>
 
@@ -1346,6 +1349,203 @@ void fusion_transform01( Test::Result& res )
    TEST_ADD( res, asVec4f( *img, 3, 3 ) == Vec4f(2.0f, 1.0f, 3.0f, 4.0f) );
 }
 
+//------------------------------------------------------------------------------
+//! A resource of a known size.
+class Blob:
+   public RCObject
+{
+public:
+   Blob( size_t size ): _size( size ) {}
+   size_t  _size;
+};
+
+size_t blobBytes( const Blob& b ) { return b._size; }
+
+//------------------------------------------------------------------------------
+//!
+RCP< Resource<Blob> >  addBlob( ResCache<Blob>& cache, const String& key, size_t size )
+{
+   RCP< Resource<Blob> > res = cache.add( key );
+   res->data( new Blob( size ) );
+   return res;
+}
+
+//------------------------------------------------------------------------------
+//!
+void fusion_rescache( Test::Result& res )
+{
+   ResCache<Blob> cache( "Blobs", 0.5, blobBytes );
+   {
+      for( uint i = 0; i < 10; ++i ) addBlob( cache, String().format( "b%d", i ), 100 );
+   }
+   RCP<Blob> held = data( cache.get( "b0" ) );  // In use, and most recently used.
+   TEST_ADD( res, cache.get( "missing" ) == nullptr );
+
+   cache.clean( 0.0 );
+   ResCacheBase::Stats stats = cache.stats();
+   TEST_ADD( res, stats._entries == 10 );
+   TEST_ADD( res, stats._bytes == 1000 );
+   TEST_ADD( res, stats._hits == 1 && stats._misses == 1 );
+   TEST_ADD( res, stats.hitRate() == 0.5f );
+
+   // Over budget: the least recently used unused entries go first.
+   cache.budget( 550 );
+   cache.clean( 0.1 );
+   stats = cache.stats();
+   TEST_ADD( res, stats._bytes == 500 );
+   TEST_ADD( res, stats._evictions == 5 );
+   TEST_ADD( res, cache.get( "b0" ) != nullptr );
+   TEST_ADD( res, cache.get( "b1" ) == nullptr );
+   TEST_ADD( res, cache.get( "b5" ) == nullptr );
+   TEST_ADD( res, cache.get( "b6" ) != nullptr );
+
+   // Entries in use are never evicted, even over budget.
+   cache.budget( 1 );
+   cache.clean( 0.2 );
+   TEST_ADD( res, cache.stats()._entries == 1 );
+   TEST_ADD( res, cache.get( "b0" ) != nullptr );
+   cache.budget( 0 );
+
+   // Unused entries go after the eviction delay.
+   held = nullptr;
+   cache.clean( 1.0 );
+   TEST_ADD( res, cache.stats()._entries == 1 );
+   cache.clean( 1.6 );
+   TEST_ADD( res, cache.stats()._entries == 0 );
+   TEST_ADD( res, cache.stats()._bytes == 0 );
+
+   // Global budget, across caches.
+   ResCache<Blob> other( "OtherBlobs", 100.0, blobBytes );
+   cache.evictionDelay( 100.0 );
+   addBlob( cache, "a", 300 );
+   addBlob( other, "b", 300 );
+   addBlob( cache, "c", 300 );
+   ResCacheBase::globalBudget( 700 );
+   ResCacheBase::cleanAll( 2.0 );
+   ResCacheBase::globalBudget( 0 );
+   TEST_ADD( res, cache.get( "a" ) == nullptr );
+   TEST_ADD( res, other.get( "b" ) != nullptr );
+   TEST_ADD( res, cache.get( "c" ) != nullptr );
+   TEST_ADD( res, ResCacheBase::find( "OtherBlobs" ) == &other );
+}
+
+//------------------------------------------------------------------------------
+//!
+void writeFile( const Path& path, const char* str )
+{
+   RCP<FileDevice> fd = new FileDevice( path, IODevice::MODE_WRITE|IODevice::MODE_NEWFILE );
+   fd->write( str, strlen(str) );
+}
+
+//------------------------------------------------------------------------------
+//! A 40 bytes blob.
+String blobOf( char c )
+{
+   String s;
+   s.resize( 40 );
+   for( uint i = 0; i < 40; ++i )  s[i] = c;
+   return s;
+}
+
+//------------------------------------------------------------------------------
+//!
+void fusion_diskcache( Test::Result& res )
+{
+   Path dir( Path::getTempDirectory() );
+   dir /= "diskcache_test";
+   Path src = dir;
+   src /= "shape.geom";
+   FS::createDirectories( dir );
+   writeFile( src, "return 1" );
+
+   RCP<Table> params = new Table();
+   params->set( "radius", 1.0f );
+   SHA1::Digest pd, k1, k2, k3;
+   ResManager::getDigest( *params, pd );
+   DiskCache::key( "geometry", src.string(), pd, k1 );
+
+   // A parameter change gives a different key.
+   params->set( "radius", 2.0f );
+   ResManager::getDigest( *params, pd );
+   DiskCache::key( "geometry", src.string(), pd, k2 );
+   TEST_ADD( res, !(k1 == k2) );
+
+   String blob;
+   {
+      DiskCache cache( dir, 100 );
+      cache.clear();
+      TEST_ADD( res, cache.put( k1, blobOf( 'a' ) ) );
+      TEST_ADD( res, cache.get( k1, blob ) && blob == blobOf( 'a' ) );
+      TEST_ADD( res, !cache.get( k2, blob ) );
+      TEST_ADD( res, cache.put( k2, blobOf( 'b' ) ) );
+      // Every blob starts with the (empty) list of its other files.
+      TEST_ADD( res, cache.stats()._bytes == 88 );
+   }
+
+   // Blobs survive across runs.
+   {
+      DiskCache cache( dir, 100 );
+      TEST_ADD( res, cache.stats()._entries == 2 );
+      TEST_ADD( res, cache.get( k1, blob ) && blob == blobOf( 'a' ) );
+
+      // Over capacity: the least recently used blob goes.
+      params->set( "radius", 3.0f );
+      ResManager::getDigest( *params, pd );
+      DiskCache::key( "geometry", src.string(), pd, k3 );
+      TEST_ADD( res, cache.put( k3, blobOf( 'c' ) ) );
+      TEST_ADD( res, cache.stats()._evictions == 1 );
+      TEST_ADD( res, cache.has( k1 ) && !cache.has( k2 ) && cache.has( k3 ) );
+   }
+
+   // Editing the source gives a different key.
+   writeFile( src, "return 22" );
+   DiskCache::key( "geometry", src.string(), pd, k2 );
+   TEST_ADD( res, !(k2 == k3) );
+
+   // A lost index is rebuilt from the blobs.
+   Path index = dir;
+   index /= "index";
+   FS::remove( index );
+   {
+      DiskCache cache( dir, 100 );
+      TEST_ADD( res, cache.stats()._entries == 2 );
+      TEST_ADD( res, cache.get( k3, blob ) && blob == blobOf( 'c' ) );
+      cache.clear();
+      TEST_ADD( res, cache.stats()._bytes == 0 );
+   }
+
+   // Editing a file loaded by the source drops the blob.
+   Path dep = dir;
+   dep /= "part.geom";
+   writeFile( dep, "return 1" );
+   Vector<String> files;
+   files.pushBack( src.string() );
+   files.pushBack( dep.string() );
+   {
+      DiskCache cache( dir, 1000 );
+      TEST_ADD( res, cache.put( k1, blobOf( 'd' ), files ) );
+      TEST_ADD( res, cache.get( k1, blob ) && blob == blobOf( 'd' ) );
+      writeFile( dep, "return 333" );
+      TEST_ADD( res, !cache.get( k1, blob ) );
+      TEST_ADD( res, !cache.has( k1 ) );
+      TEST_ADD( res, cache.stats()._bytes == 0 );
+   }
+
+   // Leave nothing behind.
+   Vector<Path> left;
+   for( FS::DirIterator it( dir ); it(); ++it )
+   {
+      String name = *it;
+      if( name == "." || name == ".." )  continue;
+      Path path = dir;
+      path /= name;
+      left.pushBack( path );
+   }
+   for( uint i = 0; i < left.size(); ++i )  FS::remove( left[i] );
+   TEST_ADD( res, FS::removeDirectory( dir ) );
+   TEST_ADD( res, !FS::Entry( dir ).exists() );
+}
+
 #if 0
 //------------------------------------------------------------------------------
 //!
@@ -1401,6 +1601,8 @@ main( int argc, char* argv[] )
    Test::standard().add( new Test::Function( "transform01", "Tests BitmapManipulator::transform()", fusion_transform01 ) );
    Test::standard().add( new Test::Function( "expand"     , "Tests ResManager::expand()"          , fusion_expand      ) );
    Test::standard().add( new Test::Function( "bitmap"     , "Tests Bitmap routines"               , fusion_bitmap      ) );
+   Test::standard().add( new Test::Function( "rescache"   , "Tests ResCache eviction"             , fusion_rescache    ) );
+   Test::standard().add( new Test::Function( "diskcache"  , "Tests the on-disk DiskCache"         , fusion_diskcache   ) );
 
    Test::special().add( new Test::Function( "copy", "Tests BitmapManipulator::copy*() routines", fusion_copy ) );
    Test::special().add( new Test::Function( "crop", "Tests BitmapManipulator::crop()", fusion_crop ) );
@@ -3011,7 +3011,7 @@ D3DManager::render( const Pass& pass )
             StencilState stencilState = _cache->_stencilState;
 
             // Render node.
-            const RCP<RenderNode> rn = (RenderNode*)(*curCmd)._data.ptr(); // Sneaky const_cast at the same time.
+            const RCP<RenderNode> rn = (RenderNode*)(*curCmd)._data; // Sneaky const_cast at the same time.
             Manager::render( rn );
 
             // Restore various states.
@@ -3041,27 +3041,27 @@ D3DManager::render( const Pass& pass )
          } break;
          case Pass::PASS_CMD_SET_ALPHA_STATE:
          {
-            applyState( *(const AlphaState*)(*curCmd)._data.ptr(), _cache->_alphaState, _device );
+            applyState( *(const AlphaState*)(*curCmd)._data, _cache->_alphaState, _device );
          } break;
          case Pass::PASS_CMD_SET_COLOR_STATE:
          {
-            applyState( *(const ColorState*)(*curCmd)._data.ptr(), _cache->_colorState, _device );
+            applyState( *(const ColorState*)(*curCmd)._data, _cache->_colorState, _device );
          } break;
          case Pass::PASS_CMD_SET_CULL_STATE:
          {
-            applyState( *(const CullState*)(*curCmd)._data.ptr(), _cache->_cullState, _device );
+            applyState( *(const CullState*)(*curCmd)._data, _cache->_cullState, _device );
          } break;
          case Pass::PASS_CMD_SET_DEPTH_STATE:
          {
-            applyState( *(const DepthState*)(*curCmd)._data.ptr(), _cache->_depthState, _device );
+            applyState( *(const DepthState*)(*curCmd)._data, _cache->_depthState, _device );
          } break;
          case Pass::PASS_CMD_SET_OFFSET_STATE:
          {
-            applyState( *(const OffsetState*)(*curCmd)._data.ptr(), _cache->_offsetState, _device );
+            applyState( *(const OffsetState*)(*curCmd)._data, _cache->_offsetState, _device );
          } break;
          case Pass::PASS_CMD_SET_STENCIL_STATE:
          {
-            applyState( *(const StencilState*)(*curCmd)._data.ptr(), _cache->_stencilState, _device );
+            applyState( *(const StencilState*)(*curCmd)._data, _cache->_stencilState, _device );
          } break;
          case Pass::PASS_CMD_SET_WIREFRAME:
          {
@@ -3075,7 +3075,7 @@ D3DManager::render( const Pass& pass )
          } break;
          case Pass::PASS_CMD_SET_PROGRAM:
          {
-            curProg = (const Program*)(*curCmd)._data.ptr();
+            curProg = (const Program*)(*curCmd)._data;
          } break;
          case Pass::PASS_CMD_EXEC:
          {
@@ -3085,29 +3085,29 @@ D3DManager::render( const Pass& pass )
          {
             // Keep it for the exec clause.
             range   = 0;
-            curGeom = (const Geometry*)(*curCmd)._data.ptr();
+            curGeom = (const Geometry*)(*curCmd)._data;
          } break;
          case Pass::PASS_CMD_EXEC_GEOMETRY:
          {
             range   = 0;
-            curGeom = (const Geometry*)(*curCmd)._data.ptr();
+            curGeom = (const Geometry*)(*curCmd)._data;
             ok &= executeGeometry( curGeom, curProg, curConst, curSamp, curMatrices, curCamPosition, range );
          } break;
          case Pass::PASS_CMD_SET_RANGEGEOMETRY:
          {
             // Keep it for the exec clause.
             range   = (*curCmd)._uPtr;
-            curGeom = (const Geometry*)(*curCmd)._data.ptr();
+            curGeom = (const Geometry*)(*curCmd)._data;
          } break;
          case Pass::PASS_CMD_EXEC_RANGEGEOMETRY:
          {
             range   = (*curCmd)._uPtr;
-            curGeom = (const Geometry*)(*curCmd)._data.ptr();
+            curGeom = (const Geometry*)(*curCmd)._data;
             ok &= executeGeometry( curGeom, curProg, curConst, curSamp, curMatrices, curCamPosition, range );
          } break;
          case Pass::PASS_CMD_SET_CONSTANTS:
          {
-            curConst = (const ConstantList*)(*curCmd)._data.ptr();
+            curConst = (const ConstantList*)(*curCmd)._data;
          } break;
          case Pass::PASS_CMD_SET_CAMERA_POSITION:
          {
@@ -3115,7 +3115,7 @@ D3DManager::render( const Pass& pass )
          } break;
          case Pass::PASS_CMD_SET_SAMPLERS:
          {
-            curSamp = (const SamplerList*)(*curCmd)._data.ptr();
+            curSamp = (const SamplerList*)(*curCmd)._data;
          } break;
          case Pass::PASS_CMD_COPY_COLOR:
          {
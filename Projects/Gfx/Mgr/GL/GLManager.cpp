@@ -3790,6 +3790,9 @@ GLManager::executeGeometry(
       return false;
    }
 
+   // Only rebind what changed since the previous draw.
+   uint changed = bind( prog, constants, samp, geom );
+
    // Shader.
    const OpenGLProgram* oglProg = (const OpenGLProgram*)prog;
    oglProg->activate( _cache->_prog );
@@ -3832,7 +3835,7 @@ GLManager::executeGeometry(
    }
 
    // Constants.
-   if( constants )
+   if( constants && (changed & BIND_CONSTANTS) )
    {
       DBG_MSG( os_gl, constants->size() << " constants" );
       for( uint i = 0; i < constants->size(); ++i )
@@ -3870,81 +3873,84 @@ GLManager::executeGeometry(
    }
 
    // Textures.
-   uint curTexUnit = 0;
-   if( samp )
+   if( changed & BIND_SAMPLERS )
    {
-      for( uint i = 0; i < samp->size(); ++i )
+      uint curTexUnit = 0;
+      if( samp )
       {
-         const Sampler* s            = (*samp)[i].ptr();
-         int samplerID               = oglProg->getSampler( s->name() );
-         const OpenGLTexture* oglTex = (const OpenGLTexture*)s->texture().ptr();
-
-         if( samplerID == -1 )
+         for( uint i = 0; i < samp->size(); ++i )
          {
-            DBG_MSG( os_gl, "Sampler '" << s->name().cstr() << "' is not in the program... Skipped." );
-            continue;
-         }
+            const Sampler* s            = (*samp)[i].ptr();
+            int samplerID               = oglProg->getSampler( s->name() );
+            const OpenGLTexture* oglTex = (const OpenGLTexture*)s->texture().ptr();
+
+            if( samplerID == -1 )
+            {
+               DBG_MSG( os_gl, "Sampler '" << s->name().cstr() << "' is not in the program... Skipped." );
+               continue;
+            }
 
-         gl_activeTexture( GL_TEXTURE0 + curTexUnit );
-         gl_uniform1i( samplerID, curTexUnit );
-         glBindTexture( oglTex->_oglType, oglTex->_id );
+            gl_activeTexture( GL_TEXTURE0 + curTexUnit );
+            gl_uniform1i( samplerID, curTexUnit );
+            glBindTexture( oglTex->_oglType, oglTex->_id );
 
-         DBG_MSG( os_gl, "Using texture #" << oglTex->_id << " in unit #" << curTexUnit );
-         ++curTexUnit;
+            DBG_MSG( os_gl, "Using texture #" << oglTex->_id << " in unit #" << curTexUnit );
+            ++curTexUnit;
 
-         // Set texture parameters.
-         const TextureState& ts = s->state();
-         uint tsDiff            = ts.compare( oglTex->_texState );
-         if( oglTex->_texState != ts )
-         {
-            GLint maxA;
-            GLenum magF, minF;
-            toGLFilters( ts, magF, minF, maxA );
-            switch( tsDiff )
+            // Set texture parameters.
+            const TextureState& ts = s->state();
+            uint tsDiff            = ts.compare( oglTex->_texState );
+            if( oglTex->_texState != ts )
             {
-               case 1:
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_MAG_FILTER, magF );
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_MIN_FILTER, minF );
-                  break;
-               case 2:
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_S, toGL( ts.clampX() ) );
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_T, toGL( ts.clampY() ) );
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_R, toGL( ts.clampZ() ) );
-                  break;
-               case 3:
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_MAG_FILTER, magF );
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_MIN_FILTER, minF );
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_S, toGL( ts.clampX() ) );
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_T, toGL( ts.clampY() ) );
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_R, toGL( ts.clampZ() ) );
-                  break;
-               default:
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_MAG_FILTER, magF );
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_MIN_FILTER, minF );
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_MAX_ANISOTROPY, maxA );
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_S, toGL( ts.clampX() ) );
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_T, toGL( ts.clampY() ) );
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_R, toGL( ts.clampZ() ) );
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_BASE_LEVEL, ts.baseLevel() );
-                  glTexParameteri( oglTex->_oglType, GL_TEXTURE_MAX_LEVEL, ts.lastLevel() );
-                  glTexParameterf( oglTex->_oglType, GL_TEXTURE_LOD_BIAS, ts.LODBias() );
+               GLint maxA;
+               GLenum magF, minF;
+               toGLFilters( ts, magF, minF, maxA );
+               switch( tsDiff )
+               {
+                  case 1:
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_MAG_FILTER, magF );
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_MIN_FILTER, minF );
+                     break;
+                  case 2:
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_S, toGL( ts.clampX() ) );
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_T, toGL( ts.clampY() ) );
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_R, toGL( ts.clampZ() ) );
+                     break;
+                  case 3:
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_MAG_FILTER, magF );
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_MIN_FILTER, minF );
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_S, toGL( ts.clampX() ) );
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_T, toGL( ts.clampY() ) );
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_R, toGL( ts.clampZ() ) );
+                     break;
+                  default:
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_MAG_FILTER, magF );
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_MIN_FILTER, minF );
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_MAX_ANISOTROPY, maxA );
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_S, toGL( ts.clampX() ) );
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_T, toGL( ts.clampY() ) );
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_WRAP_R, toGL( ts.clampZ() ) );
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_BASE_LEVEL, ts.baseLevel() );
+                     glTexParameteri( oglTex->_oglType, GL_TEXTURE_MAX_LEVEL, ts.lastLevel() );
+                     glTexParameterf( oglTex->_oglType, GL_TEXTURE_LOD_BIAS, ts.LODBias() );
+               }
+               oglTex->_texState = ts;
             }
-            oglTex->_texState = ts;
          }
       }
+      // Deactive extraneous texture units.
+      for( uint i = curTexUnit; i < _curTexUnitsUsed; ++i )
+      {
+         gl_activeTexture( GL_TEXTURE0 + i );
+         glBindTexture( GL_TEXTURE_2D, 0 );
+      }
+      // Update current number of active texture units.
+      _curTexUnitsUsed = curTexUnit;
    }
-   // Deactive extraneous texture units.
-   for( uint i = curTexUnit; i < _curTexUnitsUsed; ++i )
-   {
-      gl_activeTexture( GL_TEXTURE0 + i );
-      glBindTexture( GL_TEXTURE_2D, 0 );
-   }
-   // Update current number of active texture units.
-   _curTexUnitsUsed = curTexUnit;
 
    // Geometry.
    const OpenGLGeometry* oglGeom = (const OpenGLGeometry*)geom;
-   oglGeom->activate();
+   if( changed & BIND_GEOMETRY ) oglGeom->activate();
 
    // Draw primitives.
    const OpenGLIndexBuffer* indexBuffer = (const OpenGLIndexBuffer*)(geom->indexBuffer().ptr());
@@ -4004,6 +4010,9 @@ GLManager::render( const Pass& pass )
    bool ok = true;
    bool wire = false;
 
+   ++_stats._passes;
+   _bound.invalidate();
+
    ok &= setFramebuffer( pass._framebuffer.ptr() );
 
    // Set viewport and scissor.
@@ -4091,8 +4100,9 @@ GLManager::render( const Pass& pass )
             const Cache savedCache = *_cache;
 
             // Render node.
-            const RCP<RenderNode> rn = (RenderNode*)(*curCmd)._data.ptr(); // Sneaky const_cast at the same time.
+            const RCP<RenderNode> rn = (RenderNode*)(*curCmd)._data; // Sneaky const_cast at the same time.
             Manager::render( rn );
+            _bound.invalidate();
 
             // Restore various states.
             // - Framebuffer.
@@ -4135,27 +4145,45 @@ GLManager::render( const Pass& pass )
          } break;
          case Pass::PASS_CMD_SET_ALPHA_STATE:
          {
-            applyState( *(const AlphaState*)(*curCmd)._data.ptr(), _cache->_alphaState );
+            if( bindState( 0, (*curCmd)._data ) )
+            {
+               applyState( *(const AlphaState*)(*curCmd)._data, _cache->_alphaState );
+            }
          } break;
          case Pass::PASS_CMD_SET_COLOR_STATE:
          {
-            applyState( *(const ColorState*)(*curCmd)._data.ptr(), _cache->_colorState );
+            if( bindState( 1, (*curCmd)._data ) )
+            {
+               applyState( *(const ColorState*)(*curCmd)._data, _cache->_colorState );
+            }
          } break;
          case Pass::PASS_CMD_SET_CULL_STATE:
          {
-            applyState( *(const CullState*)(*curCmd)._data.ptr(), _cache->_cullState );
+            if( bindState( 2, (*curCmd)._data ) )
+            {
+               applyState( *(const CullState*)(*curCmd)._data, _cache->_cullState );
+            }
          } break;
          case Pass::PASS_CMD_SET_DEPTH_STATE:
          {
-            applyState( *(const DepthState*)(*curCmd)._data.ptr(), _cache->_depthState );
+            if( bindState( 3, (*curCmd)._data ) )
+            {
+               applyState( *(const DepthState*)(*curCmd)._data, _cache->_depthState );
+            }
          } break;
          case Pass::PASS_CMD_SET_OFFSET_STATE:
          {
-            applyState( *(const OffsetState*)(*curCmd)._data.ptr(), _cache->_offsetState );
+            if( bindState( 4, (*curCmd)._data ) )
+            {
+               applyState( *(const OffsetState*)(*curCmd)._data, _cache->_offsetState );
+            }
          } break;
          case Pass::PASS_CMD_SET_STENCIL_STATE:
          {
-            applyState( *(const StencilState*)(*curCmd)._data.ptr(), _cache->_stencilState );
+            if( bindState( 5, (*curCmd)._data ) )
+            {
+               applyState( *(const StencilState*)(*curCmd)._data, _cache->_stencilState );
+            }
          } break;
          case Pass::PASS_CMD_SET_WIREFRAME:
          {
@@ -4169,7 +4197,7 @@ GLManager::render( const Pass& pass )
          } break;
          case Pass::PASS_CMD_SET_PROGRAM:
          {
-            curProg = (const Program*)(*curCmd)._data.ptr();
+            curProg = (const Program*)(*curCmd)._data;
          } break;
          case Pass::PASS_CMD_EXEC:
          {
@@ -4179,29 +4207,29 @@ GLManager::render( const Pass& pass )
          {
             //Keep it for the exec clause.
             range   = 0;
-            curGeom = (const Geometry*)(*curCmd)._data.ptr();
+            curGeom = (const Geometry*)(*curCmd)._data;
          } break;
          case Pass::PASS_CMD_EXEC_GEOMETRY:
          {
             range   = 0;
-            curGeom = (const Geometry*)(*curCmd)._data.ptr();
+            curGeom = (const Geometry*)(*curCmd)._data;
             ok &= executeGeometry( curGeom, curProg, curConst, curSamp, curMatrices, curCamPosition, range );
          } break;
          case Pass::PASS_CMD_SET_RANGEGEOMETRY:
          {
             //Keep it for the exec clause.
             range   = (*curCmd)._uPtr;
-            curGeom = (const Geometry*)(*curCmd)._data.ptr();
+            curGeom = (const Geometry*)(*curCmd)._data;
          } break;
          case Pass::PASS_CMD_EXEC_RANGEGEOMETRY:
          {
             range   = (*curCmd)._uPtr;
-            curGeom = (const Geometry*)(*curCmd)._data.ptr();
+            curGeom = (const Geometry*)(*curCmd)._data;
             ok &= executeGeometry( curGeom, curProg, curConst, curSamp, curMatrices, curCamPosition, range );
          } break;
          case Pass::PASS_CMD_SET_CONSTANTS:
          {
-            curConst = (const ConstantList*)(*curCmd)._data.ptr();
+            curConst = (const ConstantList*)(*curCmd)._data;
          } break;
          case Pass::PASS_CMD_SET_CAMERA_POSITION:
          {
@@ -4209,40 +4237,44 @@ GLManager::render( const Pass& pass )
          } break;
          case Pass::PASS_CMD_SET_SAMPLERS:
          {
-            curSamp = (const SamplerList*)(*curCmd)._data.ptr();
+            curSamp = (const SamplerList*)(*curCmd)._data;
          } break;
          case Pass::PASS_CMD_COPY_COLOR:
          {
-            const OpenGLTexture* dst = (const OpenGLTexture*)(*curCmd)._data.ptr();
+            const OpenGLTexture* dst = (const OpenGLTexture*)(*curCmd)._data;
             CHECK( dst->_oglType == GL_TEXTURE_2D );
             glFlush();
             glBindTexture( dst->_oglType, dst->_id );
             glCopyTexImage2D( dst->_oglType, 0, toGLInternalFormat(dst->format()), 0, 0, _curWidth, _curHeight, 0 );
             glBindTexture( dst->_oglType, 0 );
+            _bound._samplers = nullptr;
          } break;
          case Pass::PASS_CMD_COPY_DEPTH:
          {
-            const OpenGLTexture* dst = (const OpenGLTexture*)(*curCmd)._data.ptr();
+            const OpenGLTexture* dst = (const OpenGLTexture*)(*curCmd)._data;
             CHECK( dst->_oglType == GL_TEXTURE_2D );
             glBindTexture( dst->_oglType, dst->_id );
             glCopyTexImage2D( dst->_oglType, 0, toGLInternalFormat(dst->format()), 0, 0, _curWidth, _curHeight, 0 );
             glBindTexture( dst->_oglType, 0 );
+            _bound._samplers = nullptr;
          } break;
          case Pass::PASS_CMD_COPY_DEPTH_STENCIL:
          {
-            const OpenGLTexture* dst = (const OpenGLTexture*)(*curCmd)._data.ptr();
+            const OpenGLTexture* dst = (const OpenGLTexture*)(*curCmd)._data;
             CHECK( dst->_oglType == GL_TEXTURE_2D );
             glBindTexture( dst->_oglType, dst->_id );
             glCopyTexImage2D( dst->_oglType, 0, toGLInternalFormat(dst->format()), 0, 0, _curWidth, _curHeight, 0 );
             glBindTexture( dst->_oglType, 0 );
+            _bound._samplers = nullptr;
          } break;
          case Pass::PASS_CMD_COPY_STENCIL:
          {
-            const OpenGLTexture* dst = (const OpenGLTexture*)(*curCmd)._data.ptr();
+            const OpenGLTexture* dst = (const OpenGLTexture*)(*curCmd)._data;
             CHECK( dst->_oglType == GL_TEXTURE_2D );
             glBindTexture( dst->_oglType, dst->_id );
             glCopyTexImage2D( dst->_oglType, 0, toGLInternalFormat(dst->format()), 0, 0, _curWidth, _curHeight, 0 );
             glBindTexture( dst->_oglType, 0 );
+            _bound._samplers = nullptr;
          } break;
          case Pass::PASS_CMD_SET_SCISSOR:
          {
@@ -3434,7 +3434,7 @@ GLES2Manager::render( const Pass& pass )
             const Cache savedCache = *_cache;
 
             // Render node.
-            const RCP<RenderNode> rn = (RenderNode*)(*curCmd)._data.ptr(); // Sneaky const_cast at the same time.
+            const RCP<RenderNode> rn = (RenderNode*)(*curCmd)._data; // Sneaky const_cast at the same time.
             Manager::render( rn );
 
             // Restore various states.
@@ -3478,27 +3478,27 @@ GLES2Manager::render( const Pass& pass )
          } break;
          case Pass::PASS_CMD_SET_ALPHA_STATE:
          {
-            applyState( *(const AlphaState*)(*curCmd)._data.ptr(), _cache->_alphaState );
+            applyState( *(const AlphaState*)(*curCmd)._data, _cache->_alphaState );
          } break;
          case Pass::PASS_CMD_SET_COLOR_STATE:
          {
-            applyState( *(const ColorState*)(*curCmd)._data.ptr(), _cache->_colorState );
+            applyState( *(const ColorState*)(*curCmd)._data, _cache->_colorState );
          } break;
          case Pass::PASS_CMD_SET_CULL_STATE:
          {
-            applyState( *(const CullState*)(*curCmd)._data.ptr(), _cache->_cullState );
+            applyState( *(const CullState*)(*curCmd)._data, _cache->_cullState );
          } break;
          case Pass::PASS_CMD_SET_DEPTH_STATE:
          {
-            applyState( *(const DepthState*)(*curCmd)._data.ptr(), _cache->_depthState );
+            applyState( *(const DepthState*)(*curCmd)._data, _cache->_depthState );
          } break;
          case Pass::PASS_CMD_SET_OFFSET_STATE:
          {
-            applyState( *(const OffsetState*)(*curCmd)._data.ptr(), _cache->_offsetState );
+            applyState( *(const OffsetState*)(*curCmd)._data, _cache->_offsetState );
          } break;
          case Pass::PASS_CMD_SET_STENCIL_STATE:
          {
-            applyState( *(const StencilState*)(*curCmd)._data.ptr(), _cache->_stencilState );
+            applyState( *(const StencilState*)(*curCmd)._data, _cache->_stencilState );
          } break;
          case Pass::PASS_CMD_SET_WIREFRAME:
          {
@@ -3512,7 +3512,7 @@ GLES2Manager::render( const Pass& pass )
          } break;
          case Pass::PASS_CMD_SET_PROGRAM:
          {
-            curProg = (const Program*)(*curCmd)._data.ptr();
+            curProg = (const Program*)(*curCmd)._data;
          } break;
          case Pass::PASS_CMD_EXEC:
          {
@@ -3522,29 +3522,29 @@ GLES2Manager::render( const Pass& pass )
          {
             //Keep it for the exec clause.
             range   = 0;
-            curGeom = (const Geometry*)(*curCmd)._data.ptr();
+            curGeom = (const Geometry*)(*curCmd)._data;
          } break;
          case Pass::PASS_CMD_EXEC_GEOMETRY:
          {
             range   = 0;
-            curGeom = (const Geometry*)(*curCmd)._data.ptr();
+            curGeom = (const Geometry*)(*curCmd)._data;
             ok &= executeGeometry( curGeom, curProg, curConst, curSamp, curMatrices, curCamPosition, range );
          } break;
          case Pass::PASS_CMD_SET_RANGEGEOMETRY:
          {
             //Keep it for the exec clause.
             range   = (*curCmd)._uPtr;
-            curGeom = (const Geometry*)(*curCmd)._data.ptr();
+            curGeom = (const Geometry*)(*curCmd)._data;
          } break;
          case Pass::PASS_CMD_EXEC_RANGEGEOMETRY:
          {
             range   = (*curCmd)._uPtr;
-            curGeom = (const Geometry*)(*curCmd)._data.ptr();
+            curGeom = (const Geometry*)(*curCmd)._data;
             ok &= executeGeometry( curGeom, curProg, curConst, curSamp, curMatrices, curCamPosition, range );
          } break;
          case Pass::PASS_CMD_SET_CONSTANTS:
          {
-            curConst = (const ConstantList*)(*curCmd)._data.ptr();
+            curConst = (const ConstantList*)(*curCmd)._data;
          } break;
          case Pass::PASS_CMD_SET_CAMERA_POSITION:
          {
@@ -3552,11 +3552,11 @@ GLES2Manager::render( const Pass& pass )
          } break;
          case Pass::PASS_CMD_SET_SAMPLERS:
          {
-            curSamp = (const SamplerList*)(*curCmd)._data.ptr();
+            curSamp = (const SamplerList*)(*curCmd)._data;
          } break;
          case Pass::PASS_CMD_COPY_COLOR:
          {
-            const OpenGLTexture* dst = (const OpenGLTexture*)(*curCmd)._data.ptr();
+            const OpenGLTexture* dst = (const OpenGLTexture*)(*curCmd)._data;
             CHECK( dst->_oglType == GL_TEXTURE_2D );
             glFlush();
             glBindTexture( dst->_oglType, dst->_id );
@@ -3565,7 +3565,7 @@ GLES2Manager::render( const Pass& pass )
          } break;
          case Pass::PASS_CMD_COPY_DEPTH:
          {
-            const OpenGLTexture* dst = (const OpenGLTexture*)(*curCmd)._data.ptr();
+            const OpenGLTexture* dst = (const OpenGLTexture*)(*curCmd)._data;
             CHECK( dst->_oglType == GL_TEXTURE_2D );
             glBindTexture( dst->_oglType, dst->_id );
             glCopyTexImage2D( dst->_oglType, 0, toGLInternalFormat(dst->format()), 0, 0, _curWidth, _curHeight, 0 );
@@ -3573,7 +3573,7 @@ GLES2Manager::render( const Pass& pass )
          } break;
          case Pass::PASS_CMD_COPY_DEPTH_STENCIL:
          {
-            const OpenGLTexture* dst = (const OpenGLTexture*)(*curCmd)._data.ptr();
+            const OpenGLTexture* dst = (const OpenGLTexture*)(*curCmd)._data;
             CHECK( dst->_oglType == GL_TEXTURE_2D );
             glBindTexture( dst->_oglType, dst->_id );
             glCopyTexImage2D( dst->_oglType, 0, toGLInternalFormat(dst->format()), 0, 0, _curWidth, _curHeight, 0 );
@@ -3581,7 +3581,7 @@ GLES2Manager::render( const Pass& pass )
          } break;
          case Pass::PASS_CMD_COPY_STENCIL:
          {
-            const OpenGLTexture* dst = (const OpenGLTexture*)(*curCmd)._data.ptr();
+            const OpenGLTexture* dst = (const OpenGLTexture*)(*curCmd)._data;
             CHECK( dst->_oglType == GL_TEXTURE_2D );
             glBindTexture( dst->_oglType, dst->_id );
             glCopyTexImage2D( dst->_oglType, 0, toGLInternalFormat(dst->format()), 0, 0, _curWidth, _curHeight, 0 );
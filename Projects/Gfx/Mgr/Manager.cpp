@@ -26,7 +26,8 @@ UNNAMESPACE_END
 //------------------------------------------------------------------------------
 //!
 Manager::Manager( Context* context, const String& api ):
-   _context( context ), _api( api ), _width(0), _height(0), _curWidth(0), _curHeight(0), _doingRTT(false)
+   _context( context ), _api( api ), _width(0), _height(0), _curWidth(0), _curHeight(0), _doingRTT(false),
+   _constantRing( this )
 {
    DBG_BLOCK( os_mgr, "Manager::Manager" );
 }
@@ -39,6 +40,74 @@ Manager::~Manager
    DBG_BLOCK( os_mgr, "Manager::~Manager" );
 }
 
+//------------------------------------------------------------------------------
+//! Called before recording the passes of a new frame; everything handed out by
+//! the constant ring for the previous one gets recycled.
+void
+Manager::beginFrame()
+{
+   _constantRing.beginFrame();
+}
+
+//------------------------------------------------------------------------------
+//! Records a draw using the specified objects, and returns which ones need to
+//! be bound (a combination of the BIND_* flags). Constants and samplers are
+//! tied to the program, so a new program rebinds them as well.
+uint
+Manager::bind(
+   const Program*      prog,
+   const ConstantList* constants,
+   const SamplerList*  samplers,
+   const Geometry*     geom
+)
+{
+   uint changed = 0;
+   if( prog != _bound._prog )
+   {
+      _bound._prog = prog;
+      changed |= BIND_PROGRAM | BIND_CONSTANTS | BIND_SAMPLERS;
+   }
+   if( constants != _bound._constants )
+   {
+      _bound._constants = constants;
+      changed |= BIND_CONSTANTS;
+   }
+   if( samplers != _bound._samplers )
+   {
+      _bound._samplers = samplers;
+      changed |= BIND_SAMPLERS;
+   }
+   if( geom != _bound._geom )
+   {
+      _bound._geom = geom;
+      changed |= BIND_GEOMETRY;
+   }
+
+   ++_stats._draws;
+   if( changed & BIND_PROGRAM )   ++_stats._programBinds;   else ++_stats._redundantBinds;
+   if( changed & BIND_CONSTANTS ) ++_stats._constantBinds;  else ++_stats._redundantBinds;
+   if( changed & BIND_SAMPLERS )  ++_stats._samplerBinds;   else ++_stats._redundantBinds;
+   if( changed & BIND_GEOMETRY )  ++_stats._geometryBinds;  else ++_stats._redundantBinds;
+
+   return changed;
+}
+
+//------------------------------------------------------------------------------
+//! Records a render state command; returns false if the same state object is
+//! already current.
+bool
+Manager::bindState( uint slot, const RCObject* state )
+{
+   if( _bound._states[slot] == state )
+   {
+      ++_stats._redundantBinds;
+      return false;
+   }
+   _bound._states[slot] = state;
+   ++_stats._stateChanges;
+   return true;
+}
+
 //------------------------------------------------------------------------------
 //!
 void
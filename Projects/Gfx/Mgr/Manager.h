@@ -12,6 +12,7 @@
 #include <Gfx/Geom/Geometry.h>
 #include <Gfx/Pass/Pass.h>
 #include <Gfx/Pass/RenderNode.h>
+#include <Gfx/Prog/ConstantRing.h>
 #include <Gfx/Prog/Constants.h>
 #include <Gfx/Prog/Program.h>
 #include <Gfx/Tex/Texture.h>
@@ -45,6 +46,28 @@ class Manager:
 {
 public:
 
+   /*----- classes -----*/
+
+   //! Counters of the work done by render( const Pass& ).
+   struct Stats
+   {
+      Stats() { reset(); }
+      void reset()
+      {
+         _passes = _draws = _programBinds = _constantBinds = _samplerBinds = 0;
+         _geometryBinds = _stateChanges = _redundantBinds = 0;
+      }
+
+      uint  _passes;
+      uint  _draws;
+      uint  _programBinds;
+      uint  _constantBinds;
+      uint  _samplerBinds;
+      uint  _geometryBinds;
+      uint  _stateChanges;
+      uint  _redundantBinds;  //!< Binds and states skipped since already current.
+   };
+
    /*----- static methods -----*/
 
    static GFX_DLL_API RCP<Manager>  create( Context* context = NULL );
@@ -56,6 +79,14 @@ public:
    inline const String&  API() const { return _api; }
    inline Context*  context() const { return _context.ptr(); }
 
+   // Statistics.
+   inline const Stats&  stats() const { return _stats; }
+   inline void  resetStats()          { _stats.reset(); }
+
+   // Per-frame constants (see ConstantRing).
+   inline ConstantRing&  constantRing() { return _constantRing; }
+   GFX_DLL_API void  beginFrame();
+
    GFX_DLL_API virtual void  printInfo( TextStream& os ) const;
 
    GFX_DLL_API virtual void setSize( uint width, uint height );
@@ -306,6 +337,36 @@ public:
 
 protected:
 
+   /*----- types and enumerations ----*/
+
+   enum
+   {
+      BIND_PROGRAM   = 0x01,
+      BIND_CONSTANTS = 0x02,
+      BIND_SAMPLERS  = 0x04,
+      BIND_GEOMETRY  = 0x08
+   };
+
+   //! The objects bound by the last draw of the current pass.
+   struct Bindings
+   {
+      Bindings() { invalidate(); }
+      void invalidate()
+      {
+         _prog      = nullptr;
+         _constants = nullptr;
+         _samplers  = nullptr;
+         _geom      = nullptr;
+         for( uint i = 0; i < 6; ++i ) _states[i] = nullptr;
+      }
+
+      const Program*       _prog;
+      const ConstantList*  _constants;
+      const SamplerList*   _samplers;
+      const Geometry*      _geom;
+      const RCObject*      _states[6];  //!< Alpha, color, cull, depth, offset, stencil.
+   };
+
    /*----- data members -----*/
 
    RCP<Context>   _context;       //!< A pointer to the associated context.
@@ -316,9 +377,15 @@ protected:
    uint           _curHeight;
    bool           _doingRTT;      //!< A boolean indicating whether or not we are doing render-to-texture
    RCP<Geometry>  _oneToOneGeom;  //!< A simple quad, fully mapping a texture (reused in all filters)
+   Bindings       _bound;
+   Stats          _stats;
+   ConstantRing   _constantRing;  //!< Storage for the constants of the current frame.
 
    /*----- methods -----*/
 
+   GFX_DLL_API uint  bind( const Program*, const ConstantList*, const SamplerList*, const Geometry* );
+   GFX_DLL_API bool  bindState( uint slot, const RCObject* state );
+
    Manager( Context* context, const String& api );
 
    virtual ~Manager();
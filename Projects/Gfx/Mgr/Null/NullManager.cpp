@@ -49,7 +49,8 @@ namespace Gfx
 //------------------------------------------------------------------------------
 //!
 NullManager::NullManager( NullContext* context ):
-   Manager( context, "null" )
+   Manager( context, "null" ),
+   _draws( NULL )
 {
    DBG_BLOCK( os_nm, "Creating NullManager" );
 }
@@ -437,9 +438,83 @@ NullManager::generateMipmaps( const RCP<Texture>& /*texture*/ )
 //------------------------------------------------------------------------------
 //!
 bool
-NullManager::render( const Pass& /*pass*/ )
+NullManager::render( const Pass& pass )
 {
    DBG_BLOCK( os_nm, "NullManager::render()" );
+
+   // Replay the commands like a real manager would, only counting the binds.
+   ++_stats._passes;
+   _bound.invalidate();
+
+   const Geometry*     curGeom  = 0;
+   const Program*      curProg  = 0;
+   const SamplerList*  curSamp  = 0;
+   const ConstantList* curConst = 0;
+   const float*        curWorld = 0;
+
+   Pass::CommandContainer::ConstIterator curCmd = pass._commands.begin();
+   Pass::CommandContainer::ConstIterator endCmd = pass._commands.end();
+   for( ; curCmd != endCmd; ++curCmd )
+   {
+      switch( (*curCmd)._id )
+      {
+         case Pass::PASS_CMD_RENDER:
+         {
+            const RCP<RenderNode> rn = (RenderNode*)(*curCmd)._data;
+            Manager::render( rn );
+            _bound.invalidate();
+         } break;
+         case Pass::PASS_CMD_SET_ALPHA_STATE:
+         case Pass::PASS_CMD_SET_COLOR_STATE:
+         case Pass::PASS_CMD_SET_CULL_STATE:
+         case Pass::PASS_CMD_SET_DEPTH_STATE:
+         case Pass::PASS_CMD_SET_OFFSET_STATE:
+         case Pass::PASS_CMD_SET_STENCIL_STATE:
+            bindState( (*curCmd)._id - Pass::PASS_CMD_SET_ALPHA_STATE, (*curCmd)._data );
+            break;
+         case Pass::PASS_CMD_SET_PROGRAM:
+            curProg = (const Program*)(*curCmd)._data;
+            break;
+         case Pass::PASS_CMD_SET_CONSTANTS:
+            curConst = (const ConstantList*)(*curCmd)._data;
+            break;
+         case Pass::PASS_CMD_SET_SAMPLERS:
+            curSamp = (const SamplerList*)(*curCmd)._data;
+            break;
+         case Pass::PASS_CMD_SET_WORLD:
+            curWorld = (*curCmd)._fPtr;
+            break;
+         case Pass::PASS_CMD_SET_GEOMETRY:
+         case Pass::PASS_CMD_SET_RANGEGEOMETRY:
+            curGeom = (const Geometry*)(*curCmd)._data;
+            break;
+         case Pass::PASS_CMD_EXEC_GEOMETRY:
+         case Pass::PASS_CMD_EXEC_RANGEGEOMETRY:
+            curGeom = (const Geometry*)(*curCmd)._data;
+            // Fall through.
+         case Pass::PASS_CMD_EXEC:
+            if( curGeom && curProg )
+            {
+               bind( curProg, curConst, curSamp, curGeom );
+               if( _draws )
+               {
+                  Draw d = { curProg, curConst, curSamp, curWorld, curGeom };
+                  _draws->pushBack( d );
+               }
+            }
+            break;
+         case Pass::PASS_CMD_COPY_COLOR:
+         case Pass::PASS_CMD_COPY_DEPTH:
+         case Pass::PASS_CMD_COPY_DEPTH_STENCIL:
+         case Pass::PASS_CMD_COPY_STENCIL:
+            // Copies bind the destination texture.
+            _bound._samplers = nullptr;
+            break;
+         default:
+            break;
+      }
+   }
+
    return true;
 }
 
@@ -8,6 +8,8 @@
 #include <Gfx/StdDefs.h>
 #include <Gfx/Mgr/Manager.h>
 
+#include <Base/ADT/Vector.h>
+
 NAMESPACE_BEGIN
 
 namespace Gfx
@@ -23,6 +25,23 @@ class NullManager:
    public Manager
 {
 public:
+
+   /*----- classes -----*/
+
+   //! A draw replayed by render( const Pass& ), with the state it used.
+   struct Draw
+   {
+      const Program*       _program;
+      const ConstantList*  _constants;
+      const SamplerList*   _samplers;
+      const float*         _world;
+      const Geometry*      _geometry;
+   };
+
+   /*----- methods -----*/
+
+   // Records the draws replayed by render( const Pass& ) into a vector (NULL to stop).
+   inline void  recordDraws( Vector<Draw>* draws ) { _draws = draws; }
    /*----- methods -----*/
 
    GFX_DLL_API virtual void  display();
@@ -210,6 +229,7 @@ protected:
 
    /*----- data members -----*/
 
+   Vector<Draw>*  _draws;
 
    /*----- methods -----*/
 
@@ -6,6 +6,9 @@
 
 #include <Gfx/Pass/RenderNode.h>
 
+#include <Base/ADT/Map.h>
+
+#include <algorithm>
 
 USING_NAMESPACE
 
@@ -17,6 +20,61 @@ using namespace Gfx;
 
 UNNAMESPACE_BEGIN
 
+//------------------------------------------------------------------------------
+//! The commands (as indices) defining the state used by a draw; -1 when the
+//! state was never set.
+struct DrawState
+{
+   int  _prog;
+   int  _constants;
+   int  _samplers;
+   int  _world;
+   int  _geom;    //!< The command holding the geometry and its range.
+};
+
+//------------------------------------------------------------------------------
+//!
+struct Draw
+{
+   uint64_t   _key;
+   int        _cmd;
+   DrawState  _state;
+
+   bool operator<( const Draw& d ) const { return _key < d._key; }
+};
+
+//------------------------------------------------------------------------------
+//! Returns a small number for the object, in order of first use.
+inline uint64_t rank( Map<const void*, uint>& ranks, const void* ptr )
+{
+   auto it = ranks.find( ptr );
+   if( it != ranks.end() ) return it->second;
+   uint r = uint(ranks.size()) < 0xFFFF ? uint(ranks.size()) : 0xFFFF;
+   ranks[ptr] = r;
+   return r;
+}
+
+//------------------------------------------------------------------------------
+//! Returns the bits of a distance, which sort like the distance itself.
+inline uint64_t depthBits( float d )
+{
+   if( !(d > 0.0f) ) return 0;
+   union { float f; uint32_t u; } v;
+   v.f = d;
+   return v.u;
+}
+
+//------------------------------------------------------------------------------
+//! Appends the command setting a state if it differs from the current one.
+//! A state never set goes back to its default, a null object or the identity.
+template< typename C, typename Cmd > inline void
+emitState( C& dst, const C& src, int& cur, int cmd, const Cmd& def )
+{
+   if( cmd == cur ) return;
+   dst.pushBack( cmd >= 0 ? src[cmd] : def );
+   cur = cmd;
+}
+
 UNNAMESPACE_END
 
 /*==============================================================================
@@ -31,8 +89,10 @@ const float Pass::_identityMatrix[16] =
 };
 
 //------------------------------------------------------------------------------
-//!
-Pass::Pass()
+//! The allocator, if specified, provides the memory for the stored matrices,
+//! ranges, rects and positions.
+Pass::Pass( MemoryArena::Allocator* allocator ):
+   _arena( 4096, allocator )
 {
    clear();
 }
@@ -69,12 +129,12 @@ Pass::clear()
 
    _clearBuffers      = CLEAR_ALL;
    _fbGenerateMipmaps = false;
+   _sortMode          = SORT_NONE;
 
    _commands.clear();
-   _ranges.clear();
-   _rects.clear();
-   _matrices.clear();
-   _positions.clear();
+   _arena.reset();
+   _objects.clear();
+   for( uint i = 0; i <= PASS_CMD_SET_WORLD; ++i ) _lastObjects[i] = nullptr;
 }
 
 //------------------------------------------------------------------------------
@@ -84,7 +144,7 @@ Pass::render( const RCP<const RenderNode>& rn )
 {
    Command cmd;
    cmd._id = PASS_CMD_RENDER;
-   cmd._data = rn;
+   cmd._data = retain( cmd._id, rn.ptr() );
    _commands.pushBack(cmd);
 }
 
@@ -122,3 +182,167 @@ Pass::setClear( ClearType buffer )
 {
    _clearBuffers = buffer;
 }
+
+//------------------------------------------------------------------------------
+//! Reorders the draws recorded so far according to the sort mode.
+//! Only runs of program, constants, samplers, world matrix and geometry
+//! commands are reordered; any other command (render states, matrices,
+//! sub-renderings...) keeps its place. The state commands are re-emitted only
+//! when they change, and the state in effect after each run is preserved.
+void
+Pass::sortDraws()
+{
+   if( _sortMode == SORT_NONE ) return;
+
+   Map<const void*, uint> progRanks;
+   Map<const void*, uint> sampRanks;
+   Vector<Draw>           draws;
+   CommandContainer       sorted;
+   sorted.reserve( _commands.size() );
+
+   DrawState state = { -1, -1, -1, -1, -1 };
+   const float* view = _identityMatrix;
+   int      rankedProg = -2;
+   int      rankedSamp = -2;
+   uint64_t prog       = 0;
+   uint64_t samp       = 0;
+
+   // The commands restoring the defaults of the states.
+   Command defs[5];
+   defs[0]._id   = PASS_CMD_SET_PROGRAM;
+   defs[1]._id   = PASS_CMD_SET_CONSTANTS;
+   defs[2]._id   = PASS_CMD_SET_SAMPLERS;
+   defs[3]._id   = PASS_CMD_SET_WORLD;
+   defs[3]._fPtr = _identityMatrix;
+   defs[4]._id   = PASS_CMD_SET_GEOMETRY;
+
+   int n = int(_commands.size());
+   int i = 0;
+   while( i < n )
+   {
+      const Command& cmd = _commands[i];
+      if( !sortable( cmd._id ) )
+      {
+         if( cmd._id == PASS_CMD_SET_VIEW ) view = cmd._fPtr;
+         sorted.pushBack( cmd );
+         ++i;
+         continue;
+      }
+
+      // Collect the draws of the run.
+      DrawState start = state;
+      draws.clear();
+      for( ; i < n && sortable( _commands[i]._id ); ++i )
+      {
+         switch( _commands[i]._id )
+         {
+            case PASS_CMD_SET_PROGRAM:      state._prog      = i; continue;
+            case PASS_CMD_SET_CONSTANTS:    state._constants = i; continue;
+            case PASS_CMD_SET_SAMPLERS:     state._samplers  = i; continue;
+            case PASS_CMD_SET_WORLD:        state._world     = i; continue;
+            case PASS_CMD_SET_GEOMETRY:
+            case PASS_CMD_SET_RANGEGEOMETRY: state._geom     = i; continue;
+            case PASS_CMD_EXEC_GEOMETRY:
+            case PASS_CMD_EXEC_RANGEGEOMETRY: state._geom    = i; break;
+            default: break;
+         }
+
+         // Depth of the origin of the world matrix.
+         const float* w = state._world >= 0 ? _commands[state._world]._fPtr : _identityMatrix;
+         float z = -( view[2]*w[12] + view[6]*w[13] + view[10]*w[14] + view[14] );
+
+         // Only look up the ranks when the state commands change.
+         if( state._prog != rankedProg )
+         {
+            prog       = rank( progRanks, state._prog >= 0 ? _commands[state._prog]._data : nullptr );
+            rankedProg = state._prog;
+         }
+         if( state._samplers != rankedSamp )
+         {
+            samp       = rank( sampRanks, state._samplers >= 0 ? _commands[state._samplers]._data : nullptr );
+            rankedSamp = state._samplers;
+         }
+
+         Draw d;
+         d._cmd   = i;
+         d._state = state;
+         if( _sortMode == SORT_STATE )
+         {
+            d._key = (prog << 48) | (samp << 32) | depthBits( z );
+         }
+         else
+         {
+            d._key = ((~depthBits( z ) & 0xFFFFFFFF) << 32) | (prog << 16) | samp;
+         }
+         draws.pushBack( d );
+      }
+
+      std::stable_sort( draws.begin(), draws.end() );
+
+      // Emit the draws, with only the state changes.
+      DrawState cur = start;
+      for( auto d = draws.begin(); d != draws.end(); ++d )
+      {
+         emitState( sorted, _commands, cur._prog,      d->_state._prog,      defs[0] );
+         emitState( sorted, _commands, cur._constants, d->_state._constants, defs[1] );
+         emitState( sorted, _commands, cur._samplers,  d->_state._samplers,  defs[2] );
+         emitState( sorted, _commands, cur._world,     d->_state._world,     defs[3] );
+
+         int geom = d->_state._geom;
+         if( geom < 0 )
+         {
+            emitState( sorted, _commands, cur._geom, geom, defs[4] );
+            sorted.pushBack( _commands[d->_cmd] );
+         }
+         else if( geom == d->_cmd )
+         {
+            sorted.pushBack( _commands[d->_cmd] );
+         }
+         else
+         {
+            // Merge the geometry and a plain EXEC into one command.
+            Command c = _commands[geom];
+            c._id = ( c._id == PASS_CMD_SET_RANGEGEOMETRY ) ? PASS_CMD_EXEC_RANGEGEOMETRY : PASS_CMD_EXEC_GEOMETRY;
+            sorted.pushBack( c );
+         }
+         cur._geom = geom;
+      }
+
+      // Leave the state as the recorded commands did.
+      emitState( sorted, _commands, cur._prog,      state._prog,      defs[0] );
+      emitState( sorted, _commands, cur._constants, state._constants, defs[1] );
+      emitState( sorted, _commands, cur._samplers,  state._samplers,  defs[2] );
+      emitState( sorted, _commands, cur._world,     state._world,     defs[3] );
+      if( state._geom != cur._geom )
+      {
+         Command c = state._geom >= 0 ? _commands[state._geom] : defs[4];
+         if( c._id == PASS_CMD_EXEC_GEOMETRY )      c._id = PASS_CMD_SET_GEOMETRY;
+         if( c._id == PASS_CMD_EXEC_RANGEGEOMETRY ) c._id = PASS_CMD_SET_RANGEGEOMETRY;
+         sorted.pushBack( c );
+      }
+   }
+
+   _commands.swap( sorted );
+}
+
+//------------------------------------------------------------------------------
+//!
+bool
+Pass::sortable( CommandType cmd )
+{
+   switch( cmd )
+   {
+      case PASS_CMD_EXEC:
+      case PASS_CMD_SET_PROGRAM:
+      case PASS_CMD_SET_CONSTANTS:
+      case PASS_CMD_SET_SAMPLERS:
+      case PASS_CMD_SET_WORLD:
+      case PASS_CMD_SET_GEOMETRY:
+      case PASS_CMD_EXEC_GEOMETRY:
+      case PASS_CMD_SET_RANGEGEOMETRY:
+      case PASS_CMD_EXEC_RANGEGEOMETRY:
+         return true;
+      default:
+         return false;
+   }
+}
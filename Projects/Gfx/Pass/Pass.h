@@ -16,7 +16,7 @@
 #include <Gfx/Tex/Sampler.h>
 
 
-#include <Base/ADT/List.h>
+#include <Base/ADT/MemoryArena.h>
 #include <Base/Util/RCObject.h>
 #include <Base/Util/RCP.h>
 
@@ -36,6 +36,14 @@ enum ClearType
    CLEAR_ALL     = CLEAR_COLOR | CLEAR_DEPTH | CLEAR_STENCIL
 };
 
+//! Order in which sortDraws() puts the draws of a pass.
+enum SortMode
+{
+   SORT_NONE,           //!< Keep the recording order.
+   SORT_STATE,          //!< By program, then samplers, then depth (front to back).
+   SORT_BACK_TO_FRONT   //!< By depth (back to front), then program and samplers.
+};
+
 
 // Forward declarations.
 class RenderNode;
@@ -55,7 +63,7 @@ public:
 
    /*----- methods -----*/
 
-   GFX_DLL_API Pass();
+   GFX_DLL_API Pass( MemoryArena::Allocator* allocator = nullptr );
 
    GFX_DLL_API virtual ~Pass();
 
@@ -63,6 +71,11 @@ public:
 
    inline void  exec();
 
+   // Draw sorting.
+   inline void      sortMode( SortMode mode ) { _sortMode = mode; }
+   inline SortMode  sortMode() const          { return _sortMode; }
+   GFX_DLL_API void  sortDraws();
+
    // Sub-rendering.
    GFX_DLL_API void  render( const RCP<const RenderNode>& rn );
 
@@ -191,11 +204,15 @@ private:
 
    /*----- structures -----*/
 
+   //! Commands are plain data; the objects they refer to are kept alive by
+   //! the pass (see retain()).
    class Command
    {
    public:
-      CommandType          _id;
-      RCP<const RCObject>  _data;
+      Command(): _data( nullptr ), _fPtr( nullptr ) {}
+
+      CommandType      _id;
+      const RCObject*  _data;
       union {
          const float*  _fPtr;
          const uint*   _uPtr;
@@ -215,11 +232,7 @@ private:
    typedef struct { float _[16]; }           Matrix;
    typedef struct { float _[3]; }            Position;
 
-   // Should not be changed to any other container type than a list!!!
-   typedef List<Range>                       RangeContainer;
-   typedef List<Rect>                        RectContainer;
-   typedef List<Matrix>                      MatrixContainer;
-   typedef List<Position>                    PositionContainer;
+   typedef Vector< RCP<const RCObject> >     ObjectContainer;
 
    /*----- data members -----*/
 
@@ -235,15 +248,17 @@ private:
    int               _stencil;
    ClearType         _clearBuffers;
    CommandContainer  _commands;
-   RangeContainer    _ranges;
-   RectContainer     _rects;
-   MatrixContainer   _matrices;
-   PositionContainer _positions;
+   MemoryArena       _arena;     //!< Holds the ranges, rects, matrices and positions (stable pointers).
+   ObjectContainer   _objects;   //!< The objects referred to by the commands.
+   const RCObject*   _lastObjects[PASS_CMD_SET_WORLD+1];
    RCP<const Framebuffer>  _framebuffer;
    bool              _fbGenerateMipmaps;
+   SortMode          _sortMode;
 
    /*----- methods -----*/
    const uint*  storeRangePtr( const uint* range );
+   inline const RCObject*  retain( CommandType cmd, const RCObject* obj );
+   static bool  sortable( CommandType cmd );
 };
 
 //------------------------------------------------------------------------------
@@ -292,7 +307,7 @@ Pass::setAlphaState( const RCP<const AlphaState>& state )
 {
    Command cmd;
    cmd._id   = PASS_CMD_SET_ALPHA_STATE;
-   cmd._data = state;
+   cmd._data = retain( cmd._id, state.ptr() );
    _commands.pushBack(cmd);
 }
 
@@ -303,7 +318,7 @@ Pass::setColorState( const RCP<const ColorState>& state )
 {
    Command cmd;
    cmd._id   = PASS_CMD_SET_COLOR_STATE;
-   cmd._data = state;
+   cmd._data = retain( cmd._id, state.ptr() );
    _commands.pushBack(cmd);
 }
 
@@ -314,7 +329,7 @@ Pass::setCullState( const RCP<const CullState>& state )
 {
    Command cmd;
    cmd._id   = PASS_CMD_SET_CULL_STATE;
-   cmd._data = state;
+   cmd._data = retain( cmd._id, state.ptr() );
    _commands.pushBack(cmd);
 }
 
@@ -325,7 +340,7 @@ Pass::setDepthState( const RCP<const DepthState>& state )
 {
    Command cmd;
    cmd._id   = PASS_CMD_SET_DEPTH_STATE;
-   cmd._data = state;
+   cmd._data = retain( cmd._id, state.ptr() );
    _commands.pushBack(cmd);
 }
 
@@ -336,7 +351,7 @@ Pass::setOffsetState( const RCP<const OffsetState>& state )
 {
    Command cmd;
    cmd._id   = PASS_CMD_SET_OFFSET_STATE;
-   cmd._data = state;
+   cmd._data = retain( cmd._id, state.ptr() );
    _commands.pushBack(cmd);
 }
 
@@ -347,7 +362,7 @@ Pass::setStencilState( const RCP<const StencilState>& state )
 {
    Command cmd;
    cmd._id   = PASS_CMD_SET_STENCIL_STATE;
-   cmd._data = state;
+   cmd._data = retain( cmd._id, state.ptr() );
    _commands.pushBack(cmd);
 }
 
@@ -368,7 +383,7 @@ Pass::setProgram( const RCP<const Program>& prog )
 {
    Command cmd;
    cmd._id   = PASS_CMD_SET_PROGRAM;
-   cmd._data = prog;
+   cmd._data = retain( cmd._id, prog.ptr() );
    _commands.pushBack(cmd);
 }
 
@@ -379,7 +394,7 @@ Pass::setConstants( const RCP<const ConstantList>& constants )
 {
    Command cmd;
    cmd._id   = PASS_CMD_SET_CONSTANTS;
-   cmd._data = constants;
+   cmd._data = retain( cmd._id, constants.ptr() );
    _commands.pushBack( cmd );
 }
 
@@ -388,9 +403,8 @@ Pass::setConstants( const RCP<const ConstantList>& constants )
 inline const float*
 Pass::setCamPosition( const float* position )
 {
-   _positions.pushBack( *(const Position*)position );
    const float* tmp  = _camPosition;
-   _camPosition = (const float*)&_positions.back();
+   _camPosition = (const float*)_arena.store( *(const Position*)position );
 
    Command cmd;
    cmd._id  = PASS_CMD_SET_CAMERA_POSITION;
@@ -422,7 +436,7 @@ Pass::setSamplers( const RCP<const SamplerList>& sl )
 {
    Command cmd;
    cmd._id   = PASS_CMD_SET_SAMPLERS;
-   cmd._data = sl;
+   cmd._data = retain( cmd._id, sl.ptr() );
    _commands.pushBack(cmd);
 }
 
@@ -433,7 +447,7 @@ Pass::copyColor( const RCP<const Texture>& dst )
 {
    Command cmd;
    cmd._id   = PASS_CMD_COPY_COLOR;
-   cmd._data = dst;
+   cmd._data = retain( cmd._id, dst.ptr() );
    _commands.pushBack(cmd);
 }
 
@@ -444,7 +458,7 @@ Pass::copyDepth( const RCP<const Texture>& dst )
 {
    Command cmd;
    cmd._id   = PASS_CMD_COPY_DEPTH;
-   cmd._data = dst;
+   cmd._data = retain( cmd._id, dst.ptr() );
    _commands.pushBack(cmd);
 }
 
@@ -455,7 +469,7 @@ Pass::copyDepthStencil( const RCP<const Texture>& dst )
 {
    Command cmd;
    cmd._id   = PASS_CMD_COPY_DEPTH_STENCIL;
-   cmd._data = dst;
+   cmd._data = retain( cmd._id, dst.ptr() );
    _commands.pushBack(cmd);
 }
 
@@ -466,7 +480,7 @@ Pass::copyStencil( const RCP<const Texture>& dst )
 {
    Command cmd;
    cmd._id   = PASS_CMD_COPY_STENCIL;
-   cmd._data = dst;
+   cmd._data = retain( cmd._id, dst.ptr() );
    _commands.pushBack(cmd);
 }
 
@@ -477,7 +491,7 @@ Pass::setGeometry( const RCP<const Geometry>& geom )
 {
    Command cmd;
    cmd._id   = PASS_CMD_SET_GEOMETRY;
-   cmd._data = geom;
+   cmd._data = retain( cmd._id, geom.ptr() );
    _commands.pushBack(cmd);
 }
 
@@ -488,7 +502,7 @@ Pass::execGeometry( const RCP<const Geometry>& geom )
 {
    Command cmd;
    cmd._id   = PASS_CMD_EXEC_GEOMETRY;
-   cmd._data = geom;
+   cmd._data = retain( cmd._id, geom.ptr() );
    _commands.pushBack(cmd);
 }
 
@@ -501,7 +515,7 @@ Pass::setRangeGeometry( const RCP<const Geometry>& geom, const uint* range )
 
    Command cmd;
    cmd._id   = PASS_CMD_SET_RANGEGEOMETRY;
-   cmd._data = geom;
+   cmd._data = retain( cmd._id, geom.ptr() );
    cmd._uPtr = range;
    _commands.pushBack(cmd);
 }
@@ -515,7 +529,7 @@ Pass::execRangeGeometry( const RCP<const Geometry>& geom, const uint* range )
 
    Command cmd;
    cmd._id   = PASS_CMD_EXEC_RANGEGEOMETRY;
-   cmd._data = geom;
+   cmd._data = retain( cmd._id, geom.ptr() );
    cmd._uPtr = range;
    _commands.pushBack(cmd);
 }
@@ -527,7 +541,7 @@ Pass::setRangeGeometryPtr( const RCP<const Geometry>& geom, const uint* range )
 {
    Command cmd;
    cmd._id   = PASS_CMD_SET_RANGEGEOMETRY;
-   cmd._data = geom;
+   cmd._data = retain( cmd._id, geom.ptr() );
    cmd._uPtr = range;
    _commands.pushBack(cmd);
 }
@@ -539,7 +553,7 @@ Pass::execRangeGeometryPtr( const RCP<const Geometry>& geom, const uint* range )
 {
    Command cmd;
    cmd._id   = PASS_CMD_EXEC_RANGEGEOMETRY;
-   cmd._data = geom;
+   cmd._data = retain( cmd._id, geom.ptr() );
    cmd._uPtr = range;
    _commands.pushBack(cmd);
 }
@@ -554,10 +568,9 @@ Pass::setScissor( int x, int y, int width, int height )
    r._[1] = y;
    r._[2] = width;
    r._[3] = height;
-   _rects.pushBack( r );
 
    const int* tmp = _scissor;
-   _scissor = (const int*)&_rects.back();
+   _scissor = (const int*)_arena.store( r );
 
    Command cmd;
    cmd._id   = PASS_CMD_SET_SCISSOR;
@@ -577,10 +590,9 @@ Pass::setScissor( const int* ptr )
    r._[1] = ptr[1];
    r._[2] = ptr[2];
    r._[3] = ptr[3];
-   _rects.pushBack( r );
 
    const int* tmp = _scissor;
-   _scissor = (const int*)&_rects.back();
+   _scissor = (const int*)_arena.store( r );
 
    Command cmd;
    cmd._id   = PASS_CMD_SET_SCISSOR;
@@ -622,10 +634,9 @@ Pass::addScissor( int x, int y, int width, int height )
    r._[1] = y < _scissor[1] ? _scissor[1] : y;
    r._[2] = r._[0] < finalR ? finalR - r._[0] : 0;
    r._[3] = r._[1] < finalB ? finalB - r._[1] : 0;
-   _rects.pushBack( r );
 
    const int* tmp = _scissor;
-   _scissor = (const int*)&_rects.back();
+   _scissor = (const int*)_arena.store( r );
 
    Command cmd;
    cmd._id   = PASS_CMD_SET_SCISSOR;
@@ -651,10 +662,9 @@ Pass::addScissor( const int* ptr )
    r._[1] = ptr[1] < _scissor[1] ? _scissor[1] : ptr[1];
    r._[2] = r._[0] < finalR ? finalR - r._[0] : 0;
    r._[3] = r._[1] < finalB ? finalB - r._[1] : 0;
-   _rects.pushBack( r );
 
    const int* tmp = _scissor;
-   _scissor = (const int*)&_rects.back();
+   _scissor = (const int*)_arena.store( r );
 
    Command cmd;
    cmd._id   = PASS_CMD_SET_SCISSOR;
@@ -674,10 +684,9 @@ Pass::setViewport( int x, int y, int width, int height )
    r._[1] = y;
    r._[2] = width;
    r._[3] = height;
-   _rects.pushBack( r );
 
    const int* tmp = _viewport;
-   _viewport = (const int*)&_rects.back();
+   _viewport = (const int*)_arena.store( r );
 
    Command cmd;
    cmd._id   = PASS_CMD_SET_VIEWPORT;
@@ -697,10 +706,9 @@ Pass::setViewport( const int* ptr )
    r._[1] = ptr[1];
    r._[2] = ptr[2];
    r._[3] = ptr[3];
-   _rects.pushBack( r );
 
    const int* tmp = _viewport;
-   _viewport = (const int*)&_rects.back();
+   _viewport = (const int*)_arena.store( r );
 
    Command cmd;
    cmd._id   = PASS_CMD_SET_VIEWPORT;
@@ -731,9 +739,8 @@ Pass::setViewportPtr( const int* ptr )
 inline const float*
 Pass::setProjectionMatrix( const float* matrix )
 {
-   _matrices.pushBack( *(const Matrix*)matrix );
    const float* tmp  = _projMatrix;
-   _projMatrix = (const float*)&_matrices.back();
+   _projMatrix = (const float*)_arena.store( *(const Matrix*)matrix );
 
    Command cmd;
    cmd._id  = PASS_CMD_SET_PROJECTION;
@@ -763,9 +770,8 @@ Pass::setProjectionMatrixPtr( const float* matrix )
 inline const float*
 Pass::setViewMatrix( const float* matrix )
 {
-   _matrices.pushBack( *(Matrix*)matrix );
    const float* tmp  = _viewMatrix;
-   _viewMatrix = (const float*)&_matrices.back();
+   _viewMatrix = (const float*)_arena.store( *(Matrix*)matrix );
 
    Command cmd;
    cmd._id  = PASS_CMD_SET_VIEW;
@@ -795,9 +801,8 @@ Pass::setViewMatrixPtr( const float* matrix )
 inline const float*
 Pass::setWorldMatrix( const float* matrix )
 {
-   _matrices.pushBack( *(Matrix*)matrix );
    const float* tmp   = _worldMatrix;
-   _worldMatrix = (const float*)&_matrices.back();
+   _worldMatrix = (const float*)_arena.store( *(Matrix*)matrix );
 
    Command cmd;
    cmd._id  = PASS_CMD_SET_WORLD;
@@ -822,6 +827,20 @@ Pass::setWorldMatrixPtr( const float* matrix )
    return tmp;
 }
 
+//------------------------------------------------------------------------------
+//! Keeps a reference to the object until the pass is cleared. Setting the same
+//! object again with the same command doesn't add another one.
+inline const RCObject*
+Pass::retain( CommandType cmd, const RCObject* obj )
+{
+   if( obj && obj != _lastObjects[cmd] )
+   {
+      _objects.pushBack( obj );
+      _lastObjects[cmd] = obj;
+   }
+   return obj;
+}
+
 //------------------------------------------------------------------------------
 //!
 inline const uint*
@@ -832,9 +851,7 @@ Pass::storeRangePtr( const uint* range )
       Range r;
       r._[0] = range[0];
       r._[1] = range[1];
-      _ranges.pushBack(r);
-
-      range = (const uint*)&_ranges.back();
+      range = (const uint*)_arena.store( r );
    }
 
    return range;
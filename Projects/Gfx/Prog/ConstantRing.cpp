@@ -0,0 +1,175 @@
+/*=============================================================================
+   Copyright (c) 2012, Ludo Sapiens Inc. and contributors.
+   See accompanying file LICENSE.txt for details.
+=============================================================================*/
+#include <Gfx/Prog/ConstantRing.h>
+#include <Gfx/Mgr/Manager.h>
+
+#include <Base/Dbg/DebugStream.h>
+
+USING_NAMESPACE
+
+using namespace Gfx;
+
+/*==============================================================================
+   UNNAME NAMESPACE
+==============================================================================*/
+
+UNNAMESPACE_BEGIN
+
+DBG_STREAM( os_cr, "ConstantRing" );
+
+UNNAMESPACE_END
+
+
+/*==============================================================================
+   CLASS ConstantRing
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//! The buffer itself only gets allocated by the first slice.
+ConstantRing::ConstantRing( Manager* mgr, uint capacity ):
+   _mgr( mgr ),
+   _data( nullptr ),
+   _capacity( (capacity < 4) ? 4 : ((capacity + 3) & ~3u) ),
+   _used( 0 ),
+   _numArrays( 0 )
+{
+}
+
+//------------------------------------------------------------------------------
+//!
+ConstantRing::~ConstantRing()
+{
+   for( uint i = 0; i < _spills.size(); ++i )
+   {
+      delete[] _spills[i];
+   }
+   delete[] _data;
+}
+
+//------------------------------------------------------------------------------
+//! Rewinds the ring; none of the slices, buffers and lists handed out before
+//! may be used anymore.
+//! If the previous frame didn't fit, the buffer grows so that the same frame
+//! fits next time.
+void
+ConstantRing::beginFrame()
+{
+   if( !_spills.empty() )
+   {
+      for( uint i = 0; i < _spills.size(); ++i )
+      {
+         delete[] _spills[i];
+      }
+      _spills.clear();
+
+      while( _capacity < _used )  _capacity *= 2;
+      DBG_MSG( os_cr, "Growing to " << _capacity << " floats" );
+      delete[] _data;
+      _data = nullptr;
+   }
+   _used      = 0;
+   _numArrays = 0;
+}
+
+//------------------------------------------------------------------------------
+//! Returns a slice of the specified number of floats (aligned to 16 bytes).
+//! When the buffer is full, the slice is allocated on its own until the next
+//! frame.
+ConstantRing::Slice
+ConstantRing::allocate( uint size )
+{
+   uint aligned = (size + 3) & ~3u;
+
+   Slice s;
+   s._offset = _used;
+   s._size   = size;
+   if( _used + aligned <= _capacity )
+   {
+      if( _data == nullptr )
+      {
+         _data = new float[_capacity];
+         ++_stats._allocations;
+      }
+      s._data = _data + _used;
+   }
+   else
+   {
+      s._data = new float[aligned];
+      if( _spills.size() == _spills.capacity() )  ++_stats._allocations;
+      _spills.pushBack( s._data );
+      ++_stats._allocations;
+   }
+   _used += aligned;
+
+   return s;
+}
+
+//------------------------------------------------------------------------------
+//! Returns a constant buffer holding a single array constant, which points to
+//! the specified slice.
+const RCP<ConstantBuffer>&
+ConstantRing::arrayBuffer(
+   const ConstString& name,
+   ConstantType       type,
+   uint               count,
+   const Slice&       slice,
+   ShaderType         shaderType
+)
+{
+   return array( name, type, count, slice, shaderType )._buffer;
+}
+
+//------------------------------------------------------------------------------
+//! Returns a constant list holding only arrayBuffer( name, ... ).
+const RCP<ConstantList>&
+ConstantRing::arrayList(
+   const ConstString& name,
+   ConstantType       type,
+   uint               count,
+   const Slice&       slice,
+   ShaderType         shaderType
+)
+{
+   return array( name, type, count, slice, shaderType )._list;
+}
+
+//------------------------------------------------------------------------------
+//! Recycles the next array of the previous frames, which usually declares the
+//! same constant (since the same things get drawn in the same order), so only
+//! its pointer needs to be updated.
+ConstantRing::Array&
+ConstantRing::array(
+   const ConstString& name,
+   ConstantType       type,
+   uint               count,
+   const Slice&       slice,
+   ShaderType         shaderType
+)
+{
+   CHECK( slice._size*sizeof(float) >= count*toBytes( type ) );
+
+   if( _numArrays == _arrays.size() )
+   {
+      if( _arrays.size() == _arrays.capacity() )  ++_stats._allocations;
+      _arrays.pushBack( Array() );
+   }
+   Array& a = _arrays[_numArrays++];
+
+   const ConstantBuffer::Constant* c = a._buffer.isValid() ? &a._buffer->constants()[0] : nullptr;
+   if( c && c->name() == name && c->type() == type && c->count() == count && c->shaderType() == shaderType )
+   {
+      a._buffer->setConstant( c, slice._data );
+      ++_stats._recycledArrays;
+   }
+   else
+   {
+      a._buffer = _mgr->createConstants( sizeof(float*) );
+      a._buffer->addConstantArray( name, type, count, 0, shaderType, slice._data );
+      a._list   = ConstantList::create( a._buffer );
+      ++_stats._newArrays;
+      _stats._allocations += 2;
+   }
+   return a;
+}
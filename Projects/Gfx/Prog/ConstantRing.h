@@ -0,0 +1,140 @@
+/*=============================================================================
+   Copyright (c) 2012, Ludo Sapiens Inc. and contributors.
+   See accompanying file LICENSE.txt for details.
+=============================================================================*/
+#ifndef GFX_CONSTANT_RING_H
+#define GFX_CONSTANT_RING_H
+
+#include <Gfx/StdDefs.h>
+#include <Gfx/Prog/Constants.h>
+
+#include <Base/ADT/Vector.h>
+#include <Base/Util/RCP.h>
+
+#include <cstring>
+
+NAMESPACE_BEGIN
+
+namespace Gfx
+{
+
+class Manager;
+
+/*==============================================================================
+   CLASS ConstantRing
+==============================================================================*/
+//! Frame-scoped storage for the constants which change every frame (e.g. bone
+//! and world matrices).
+//! The values are copied into slices of a large persistent buffer, and the
+//! draws reference the slices through constant buffers and lists recycled from
+//! one frame to the next, so that recording a frame doesn't allocate anymore
+//! once the ring has grown to fit it.
+//! Everything handed out stays valid until the next beginFrame(), which
+//! rewinds the ring to its start.
+class ConstantRing
+{
+public:
+
+   /*----- classes -----*/
+
+   //! A range of floats of the ring.
+   struct Slice
+   {
+      Slice(): _data( nullptr ), _offset( 0 ), _size( 0 ) {}
+
+      float*  _data;
+      uint    _offset;  //!< The offset from the start of the frame, in floats.
+      uint    _size;    //!< The number of floats.
+   };
+
+   //! Counters of the work done since the last resetStats().
+   struct Stats
+   {
+      Stats() { reset(); }
+      void reset() { _allocations = _newArrays = _recycledArrays = 0; }
+
+      uint  _allocations;     //!< Heap allocations (buffer, spills, arrays and their table).
+      uint  _newArrays;       //!< Arrays created, each with a constant buffer and list.
+      uint  _recycledArrays;  //!< Arrays reused from a previous frame.
+   };
+
+   /*----- methods -----*/
+
+   GFX_DLL_API ConstantRing( Manager* mgr, uint capacity = 65536 );
+   GFX_DLL_API ~ConstantRing();
+
+   GFX_DLL_API void  beginFrame();
+
+   // Slices.
+   GFX_DLL_API Slice  allocate( uint size );
+   inline Slice  store( const float* src, uint size );
+
+   // Array constants pointing to a slice (valid for the current frame).
+   GFX_DLL_API const RCP<ConstantBuffer>&  arrayBuffer(
+      const ConstString& name,
+      ConstantType       type,
+      uint               count,
+      const Slice&       slice,
+      ShaderType         shaderType = VERTEX_SHADER
+   );
+   GFX_DLL_API const RCP<ConstantList>&  arrayList(
+      const ConstString& name,
+      ConstantType       type,
+      uint               count,
+      const Slice&       slice,
+      ShaderType         shaderType = VERTEX_SHADER
+   );
+
+   // Capacity and usage, in floats.
+   inline uint  capacity() const  { return _capacity; }
+   inline uint  used() const      { return _used; }
+   inline uint  numSpills() const { return uint(_spills.size()); }
+
+   // Statistics.
+   inline const Stats&  stats() const { return _stats; }
+   inline void  resetStats()          { _stats.reset(); }
+
+private:
+
+   /*----- types -----*/
+
+   struct Array
+   {
+      RCP<ConstantBuffer>  _buffer;
+      RCP<ConstantList>    _list;
+   };
+
+   /*----- methods -----*/
+
+   Array&  array( const ConstString& name, ConstantType type, uint count, const Slice& slice, ShaderType shaderType );
+
+   ConstantRing( const ConstantRing& );
+   void operator=( const ConstantRing& );
+
+   /*----- data members -----*/
+
+   Manager*        _mgr;
+   float*          _data;
+   uint            _capacity;   //!< The size of _data, in floats.
+   uint            _used;       //!< The floats handed out in the current frame (spills included).
+   Vector<float*>  _spills;     //!< Slices which didn't fit in the current frame.
+   Vector<Array>   _arrays;
+   uint            _numArrays;  //!< The arrays handed out in the current frame.
+   Stats           _stats;
+};
+
+//------------------------------------------------------------------------------
+//! Allocates a slice, and copies size floats into it.
+inline ConstantRing::Slice
+ConstantRing::store( const float* src, uint size )
+{
+   Slice s = allocate( size );
+   memcpy( s._data, src, size*sizeof(float) );
+   return s;
+}
+
+}  //namespace Gfx
+
+NAMESPACE_END
+
+#endif //GFX_CONSTANT_RING_H
@@ -41,7 +41,8 @@ DirectionalAttractor::addForce( const Vector< RCP<RigidBody> >& bodies )
 {
    for( uint b = 0; b < bodies.size(); ++b )
    {
-      if( attracts( bodies[b] ) )
+      // Sleeping bodies are at rest under the field; don't wake them up.
+      if( bodies[b]->active() && attracts( bodies[b] ) )
       {
          bodies[b]->addForce( _acceleration * bodies[b]->mass() );
       }
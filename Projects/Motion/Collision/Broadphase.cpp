@@ -0,0 +1,337 @@
+/*=============================================================================
+   Copyright (c) 2012, Ludo Sapiens Inc. and contributors.
+   See accompanying file LICENSE.txt for details.
+=============================================================================*/
+#include <Motion/Collision/Broadphase.h>
+
+#include <Motion/Collision/CollisionShape.h>
+
+#include <algorithm>
+
+/*==============================================================================
+  UNNAMED NAMESPACE
+==============================================================================*/
+UNNAMESPACE_BEGIN
+
+// Pairs are kept a little longer than their contacts (see CollisionInfo::removeInvalids()).
+const float _padding = 0.01f;
+
+//------------------------------------------------------------------------------
+//!
+template< typename E >
+struct MinSort
+{
+   MinSort( uint axis ): _axis( axis ) {}
+   bool operator()( const E& a, const E& b ) const
+   {
+      return a._box.min(_axis) < b._box.min(_axis);
+   }
+   uint _axis;
+};
+
+UNNAMESPACE_END
+
+
+NAMESPACE_BEGIN
+
+/*==============================================================================
+   CLASS Broadphase
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//! Computes the world-space bounding box of the body.
+//! Returns false if the body cannot collide (no shape, or an empty box).
+bool
+Broadphase::computeBoundingBox( const RigidBody& body, AABBoxf& box )
+{
+   const CollisionShape* shape = body.shape();
+   if( shape == NULL || shape->boundingBox().isEmpty() )  return false;
+
+   box.set( body.simOrientation().toMatrix3(), body.simPosition(), shape->boundingBox() );
+   box.grow( _padding );
+   return true;
+}
+
+/*==============================================================================
+   CLASS BruteForceBroadphase
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//!
+BruteForceBroadphase::BruteForceBroadphase()
+{
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+BruteForceBroadphase::findPairs(
+   const BodyContainer& rigidBodies,
+   const BodyContainer& staticBodies,
+   const BodyContainer& kinematicBodies,
+   PairContainer&       pairs
+)
+{
+   // Compute all of the bounding boxes once (empty when the body cannot collide).
+   const uint nr = uint(rigidBodies.size());
+   const uint ns = uint(staticBodies.size());
+   const uint nk = uint(kinematicBodies.size());
+   _boxes.resize( nr + ns + nk );
+   AABBoxf* rBoxes = _boxes.data();
+   AABBoxf* sBoxes = rBoxes + nr;
+   AABBoxf* kBoxes = sBoxes + ns;
+   for( uint i = 0; i < nr; ++i )
+   {
+      if( !computeBoundingBox( *rigidBodies[i], rBoxes[i] ) )  rBoxes[i] = AABBoxf::empty();
+   }
+   for( uint i = 0; i < ns; ++i )
+   {
+      if( !computeBoundingBox( *staticBodies[i], sBoxes[i] ) )  sBoxes[i] = AABBoxf::empty();
+   }
+   for( uint i = 0; i < nk; ++i )
+   {
+      if( !computeBoundingBox( *kinematicBodies[i], kBoxes[i] ) )  kBoxes[i] = AABBoxf::empty();
+   }
+
+   for( uint a = 0; a < nr; ++a )
+   {
+      const AABBoxf& boxA = rBoxes[a];
+      if( boxA.isEmpty() )  continue;
+
+      for( uint b = 0; b < ns; ++b )
+      {
+         if( boxA.isOverlapping( sBoxes[b] ) )
+         {
+            pairs.pushBack( BodyPair( rigidBodies[a].ptr(), staticBodies[b].ptr() ) );
+         }
+      }
+
+      for( uint b = 0; b < nk; ++b )
+      {
+         if( boxA.isOverlapping( kBoxes[b] ) )
+         {
+            pairs.pushBack( BodyPair( rigidBodies[a].ptr(), kinematicBodies[b].ptr() ) );
+         }
+      }
+
+      for( uint b = a+1; b < nr; ++b )
+      {
+         if( boxA.isOverlapping( rBoxes[b] ) )
+         {
+            pairs.pushBack( BodyPair( rigidBodies[a].ptr(), rigidBodies[b].ptr() ) );
+         }
+      }
+   }
+}
+
+/*==============================================================================
+   CLASS SweepAndPruneBroadphase
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//!
+SweepAndPruneBroadphase::SweepAndPruneBroadphase():
+   _axis( 0 ),
+   _numStatics( 0 ),
+   _staticsDirty( true ),
+   _moversDirty( true )
+{
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+SweepAndPruneBroadphase::invalidate( uint type )
+{
+   if( type == RigidBody::STATIC )
+   {
+      _staticsDirty = true;
+   }
+   else
+   {
+      _moversDirty = true;
+   }
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+SweepAndPruneBroadphase::findPairs(
+   const BodyContainer& rigidBodies,
+   const BodyContainer& staticBodies,
+   const BodyContainer& kinematicBodies,
+   PairContainer&       pairs
+)
+{
+   updateStatics( staticBodies, rigidBodies );
+   updateMovers( rigidBodies, kinematicBodies );
+
+   const uint axis = _axis;
+   const uint nm   = uint(_movers.size());
+   const uint ns   = uint(_statics.size());
+
+   // 1. Moving bodies against one another.
+   for( uint i = 0; i < nm; ++i )
+   {
+      const Entry& a = _movers[i];
+      // Invalid entries are sorted last.
+      if( !a._valid )  break;
+      const float maxA = a._box.max( axis );
+      const bool  kinA = a._body->type() == RigidBody::KINEMATIC;
+      for( uint j = i+1; j < nm; ++j )
+      {
+         const Entry& b = _movers[j];
+         if( b._box.min( axis ) > maxA )  break;
+         if( kinA && b._body->type() == RigidBody::KINEMATIC )  continue;
+         if( a._box.isOverlapping( b._box ) )
+         {
+            pairs.pushBack( BodyPair( a._body, b._body ) );
+         }
+      }
+   }
+
+   // 2. Dynamic bodies against static ones.
+   // Both lists are traversed in sorted order, and the body which starts first
+   // tests the bodies of the other list starting before it ends.
+   uint m = 0;
+   uint s = 0;
+   while( m < nm && s < ns )
+   {
+      const Entry& em = _movers[m];
+      const Entry& es = _statics[s];
+      if( !em._valid )  break;
+      if( em._box.min( axis ) <= es._box.min( axis ) )
+      {
+         if( em._body->type() == RigidBody::DYNAMIC )
+         {
+            const float maxM = em._box.max( axis );
+            for( uint j = s; j < ns && _statics[j]._box.min( axis ) <= maxM; ++j )
+            {
+               if( em._box.isOverlapping( _statics[j]._box ) )
+               {
+                  pairs.pushBack( BodyPair( em._body, _statics[j]._body ) );
+               }
+            }
+         }
+         ++m;
+      }
+      else
+      {
+         const float maxS = es._box.max( axis );
+         for( uint j = m; j < nm && _movers[j]._box.min( axis ) <= maxS; ++j )
+         {
+            const Entry& e = _movers[j];
+            if( e._body->type() == RigidBody::DYNAMIC && e._box.isOverlapping( es._box ) )
+            {
+               pairs.pushBack( BodyPair( e._body, es._body ) );
+            }
+         }
+         ++s;
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Rebuilds the sorted list of static bodies, if required.
+void
+SweepAndPruneBroadphase::updateStatics( const BodyContainer& staticBodies, const BodyContainer& rigidBodies )
+{
+   if( !_staticsDirty && _numStatics == staticBodies.size() )  return;
+
+   _statics.clear();
+   Entry e;
+   for( uint i = 0; i < staticBodies.size(); ++i )
+   {
+      e._body  = staticBodies[i].ptr();
+      e._valid = computeBoundingBox( *e._body, e._box );
+      if( e._valid )  _statics.pushBack( e );
+   }
+
+   // Sort along the axis where the bodies are the most spread out.
+   Vec3f sum( 0.0f );
+   Vec3f sqrSum( 0.0f );
+   uint  n = 0;
+   for( uint i = 0; i < _statics.size(); ++i, ++n )
+   {
+      Vec3f c = _statics[i]._box.center();
+      sum    += c;
+      sqrSum += c*c;
+   }
+   AABBoxf box;
+   for( uint i = 0; i < rigidBodies.size(); ++i )
+   {
+      if( !computeBoundingBox( *rigidBodies[i], box ) )  continue;
+      Vec3f c = box.center();
+      sum    += c;
+      sqrSum += c*c;
+      ++n;
+   }
+   uint axis = _axis;
+   if( n > 1 )
+   {
+      Vec3f var = sqrSum*float(n) - sum*sum;
+      axis = var.maxComponent();
+   }
+   if( axis != _axis )
+   {
+      _axis        = axis;
+      _moversDirty = true;
+   }
+
+   std::sort( _statics.begin(), _statics.end(), MinSort<Entry>( _axis ) );
+
+   _numStatics   = uint(staticBodies.size());
+   _staticsDirty = false;
+}
+
+//------------------------------------------------------------------------------
+//! Updates the bounding boxes of the moving bodies, and sorts them.
+void
+SweepAndPruneBroadphase::updateMovers( const BodyContainer& rigidBodies, const BodyContainer& kinematicBodies )
+{
+   const uint axis = _axis;
+   if( _moversDirty || _movers.size() != rigidBodies.size() + kinematicBodies.size() )
+   {
+      // Rebuild the whole list.
+      _movers.clear();
+      for( uint i = 0; i < rigidBodies.size(); ++i )
+      {
+         _movers.pushBack( Entry( rigidBodies[i].ptr() ) );
+      }
+      for( uint i = 0; i < kinematicBodies.size(); ++i )
+      {
+         _movers.pushBack( Entry( kinematicBodies[i].ptr() ) );
+      }
+      for( uint i = 0; i < _movers.size(); ++i )
+      {
+         Entry& e = _movers[i];
+         e._valid = computeBoundingBox( *e._body, e._box );
+         if( !e._valid )  e._box = AABBoxf::empty();
+      }
+      std::sort( _movers.begin(), _movers.end(), MinSort<Entry>( axis ) );
+      _moversDirty = false;
+      return;
+   }
+
+   // Bodies move a little between steps, so insertion sort is almost linear.
+   const uint n = uint(_movers.size());
+   for( uint i = 0; i < n; ++i )
+   {
+      Entry& e = _movers[i];
+      e._valid = computeBoundingBox( *e._body, e._box );
+      if( !e._valid )  e._box = AABBoxf::empty();
+   }
+   for( uint i = 1; i < n; ++i )
+   {
+      Entry e = _movers[i];
+      const float v = e._box.min( axis );
+      uint j = i;
+      for( ; j > 0 && _movers[j-1]._box.min( axis ) > v; --j )
+      {
+         _movers[j] = _movers[j-1];
+      }
+      _movers[j] = e;
+   }
+}
+
+NAMESPACE_END
@@ -0,0 +1,159 @@
+/*=============================================================================
+   Copyright (c) 2012, Ludo Sapiens Inc. and contributors.
+   See accompanying file LICENSE.txt for details.
+=============================================================================*/
+#ifndef MOTION_BROADPHASE_H
+#define MOTION_BROADPHASE_H
+
+#include <Motion/StdDefs.h>
+
+#include <Motion/World/RigidBody.h>
+
+#include <CGMath/AABBox.h>
+
+#include <Base/ADT/Pair.h>
+#include <Base/ADT/Vector.h>
+#include <Base/Util/RCObject.h>
+#include <Base/Util/RCP.h>
+
+NAMESPACE_BEGIN
+
+/*==============================================================================
+   CLASS Broadphase
+==============================================================================*/
+//! Finds the pairs of bodies which could be colliding.
+//! The bodies are tested using their world-space bounding boxes (see
+//! computeBoundingBox()); dynamic bodies are tested against all of the other
+//! bodies, while static and kinematic bodies are never tested against one
+//! another.
+class Broadphase:
+   public RCObject
+{
+
+public:
+
+   /*----- types and enumerations ----*/
+
+   typedef Vector< RCP<RigidBody> >        BodyContainer;
+   typedef Pair< RigidBody*, RigidBody* >  BodyPair;
+   typedef Vector< BodyPair >              PairContainer;
+
+   /*----- static methods -----*/
+
+   MOTION_DLL_API static bool  computeBoundingBox( const RigidBody& body, AABBoxf& box );
+
+   /*----- methods -----*/
+
+   //! Notifies that bodies of the specified type were added, removed or
+   //! moved outside of the simulation (only relevant for static bodies).
+   virtual void  invalidate( uint /*type*/ ) {}
+
+   //! Appends the overlapping pairs to 'pairs'.
+   virtual void  findPairs(
+      const BodyContainer& rigidBodies,
+      const BodyContainer& staticBodies,
+      const BodyContainer& kinematicBodies,
+      PairContainer&       pairs
+   ) = 0;
+
+protected:
+
+   /*----- methods -----*/
+
+   virtual ~Broadphase() {}
+};
+
+/*==============================================================================
+   CLASS BruteForceBroadphase
+==============================================================================*/
+//! Tests all of the pairs of bodies, which is O(n^2).
+//! It compares the same padded world-space boxes as the other broadphases (not
+//! the shapes' local boxes the collision loops used to compare), so it serves
+//! as their reference.
+class BruteForceBroadphase:
+   public Broadphase
+{
+
+public:
+
+   /*----- methods -----*/
+
+   MOTION_DLL_API BruteForceBroadphase();
+
+   MOTION_DLL_API virtual void  findPairs(
+      const BodyContainer& rigidBodies,
+      const BodyContainer& staticBodies,
+      const BodyContainer& kinematicBodies,
+      PairContainer&       pairs
+   );
+
+protected:
+
+   /*----- data members -----*/
+
+   Vector<AABBoxf>  _boxes;  //!< Scratch bounding boxes.
+};
+
+/*==============================================================================
+   CLASS SweepAndPruneBroadphase
+==============================================================================*/
+//! Sorts the bodies along one axis, and only tests the bodies whose intervals
+//! overlap on that axis.
+//! The static bodies are sorted once, and only sorted again when invalidated.
+//! The moving bodies (dynamic and kinematic) keep their order from one step
+//! to the next, which makes sorting them almost linear (insertion sort).
+class SweepAndPruneBroadphase:
+   public Broadphase
+{
+
+public:
+
+   /*----- methods -----*/
+
+   MOTION_DLL_API SweepAndPruneBroadphase();
+
+   MOTION_DLL_API virtual void  invalidate( uint type );
+
+   MOTION_DLL_API virtual void  findPairs(
+      const BodyContainer& rigidBodies,
+      const BodyContainer& staticBodies,
+      const BodyContainer& kinematicBodies,
+      PairContainer&       pairs
+   );
+
+   inline uint  axis() const { return _axis; }
+
+protected:
+
+   /*----- data types -----*/
+
+   struct Entry
+   {
+      Entry() {}
+      Entry( RigidBody* body ): _body( body ) {}
+
+      RigidBody*  _body;
+      AABBoxf     _box;
+      bool        _valid; //!< Whether or not the body has a non-empty bounding box.
+   };
+
+   typedef Vector< Entry >  EntryContainer;
+
+   /*----- methods -----*/
+
+   void  updateStatics( const BodyContainer& staticBodies, const BodyContainer& rigidBodies );
+   void  updateMovers( const BodyContainer& rigidBodies, const BodyContainer& kinematicBodies );
+
+   /*----- data members -----*/
+
+   EntryContainer  _statics;       //!< Static bodies, sorted by their minimum along _axis.
+   EntryContainer  _movers;        //!< Dynamic and kinematic bodies, sorted by their minimum along _axis.
+   uint            _axis;          //!< The sorting axis.
+   uint            _numStatics;    //!< The number of static bodies when _statics was built.
+   bool            _staticsDirty;  //!< Set when _statics needs to be rebuilt.
+   bool            _moversDirty;   //!< Set when the list of moving bodies changed.
+};
+
+NAMESPACE_END
+
+#endif
@@ -349,7 +349,9 @@ public:
    CollisionPair( const RCP<RigidBody>& bodyA, const RCP<RigidBody>& bodyB ) :
       _info(0)
    {
-      if( bodyA.ptr() < bodyB.ptr() )
+      // Order the bodies by identifier, not address, to get the same results
+      // from one run to the next.
+      if( bodyA->id() < bodyB->id() )
       {
          _bodyA = bodyA.ptr();
          _bodyB = bodyB.ptr();
@@ -399,11 +401,11 @@ public:
    // Operators.
    bool operator<( const CollisionPair& p ) const
    {
-      if( _bodyA < p._bodyA )
+      if( _bodyA->id() < p._bodyA->id() )
       {
          return true;
       }
-      if( _bodyA == p._bodyA && _bodyB < p._bodyB )
+      if( _bodyA == p._bodyA && _bodyB->id() < p._bodyB->id() )
       {
          return true;
       }
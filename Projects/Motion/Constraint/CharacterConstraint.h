@@ -52,6 +52,10 @@ public:
    MOTION_DLL_API virtual void preVelocitiesStep();
    MOTION_DLL_API virtual bool solveVelocities();
 
+   inline virtual RigidBody* bodyA() const { return _body.ptr(); }
+   //! Characters are driven by a desired velocity, and never sleep.
+   inline virtual bool canSleep() const { return false; }
+
 protected:
 
    /*----- friends -----*/
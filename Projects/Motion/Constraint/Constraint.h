@@ -14,6 +14,7 @@ NAMESPACE_BEGIN
 
 
 class MotionWorld;
+class RigidBody;
 
 /*==============================================================================
    CLASS Constraint
@@ -34,6 +35,14 @@ public:
    virtual void preVelocitiesStep() = 0;
    virtual bool solveVelocities() = 0;
 
+   // Simulation islands.
+   //! The bodies tied by the constraint (NULL when unused).
+   //! A constraint not reporting any body is solved with all of the bodies.
+   virtual RigidBody* bodyA() const { return NULL; }
+   virtual RigidBody* bodyB() const { return NULL; }
+   //! Whether or not the constrained bodies can be put to sleep when at rest.
+   virtual bool canSleep() const { return true; }
+
 protected: 
    
    /*----- methods -----*/
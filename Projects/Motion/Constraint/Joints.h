@@ -41,6 +41,9 @@ public:
    MOTION_DLL_API virtual void preVelocitiesStep();
    MOTION_DLL_API virtual bool solveVelocities();
 
+   inline virtual RigidBody* bodyA() const { return _bodyA.ptr(); }
+   inline virtual RigidBody* bodyB() const { return _bodyB.ptr(); }
+
 
 protected: 
    
@@ -89,6 +92,9 @@ public:
    MOTION_DLL_API virtual void preVelocitiesStep();
    MOTION_DLL_API virtual bool solveVelocities();
 
+   inline virtual RigidBody* bodyA() const { return _bodyA.ptr(); }
+   inline virtual RigidBody* bodyB() const { return _bodyB.ptr(); }
+
 
 protected: 
    
@@ -61,6 +61,11 @@ public:
    MOTION_DLL_API virtual void preVelocitiesStep();
    MOTION_DLL_API virtual bool solveVelocities();
 
+   inline virtual RigidBody* bodyA() const { return _bodyA.ptr(); }
+   inline virtual RigidBody* bodyB() const { return _bodyB.ptr(); }
+   //! Springs act like attractors, which never let the bodies sleep.
+   inline virtual bool canSleep() const { return false; }
+
 
 protected:
    /*----- friends -----*/
@@ -118,6 +123,10 @@ public:
    MOTION_DLL_API virtual void preVelocitiesStep();
    MOTION_DLL_API virtual bool solveVelocities();
 
+   inline virtual RigidBody* bodyA() const { return _bodyA.ptr(); }
+   //! Springs act like attractors, which never let the bodies sleep.
+   inline virtual bool canSleep() const { return false; }
+
 
 protected:
    /*----- friends -----*/
@@ -176,6 +185,10 @@ public:
    MOTION_DLL_API virtual void preVelocitiesStep();
    MOTION_DLL_API virtual bool solveVelocities();
 
+   inline virtual RigidBody* bodyA() const { return _bodyA.ptr(); }
+   //! Springs act like attractors, which never let the bodies sleep.
+   inline virtual bool canSleep() const { return false; }
+
 
 protected:
    /*----- friends -----*/
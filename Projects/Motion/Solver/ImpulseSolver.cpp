@@ -28,21 +28,20 @@ ImpulseSolver::~ImpulseSolver()
 //------------------------------------------------------------------------------
 //!
 void
-ImpulseSolver::solveCollisions()
+ImpulseSolver::solveCollisions( MotionWorld::Island& island )
 {
    const float restingThreshold = -0.4f;
    const int maxLoopCount = 10;
 
-   MotionWorld::CollisionConstraintContainer::Iterator it;
-   MotionWorld::CollisionConstraintContainer::Iterator end = 
-      _world->collisionConstraints().end();
+   Vector< MotionWorld::CollisionConstraint* >::Iterator it;
+   Vector< MotionWorld::CollisionConstraint* >::Iterator end = island._collisionConstraints.end();
 
    // Precompute per contact data.
-   for( it = _world->collisionConstraints().begin(); it != end; ++it )
+   for( it = island._collisionConstraints.begin(); it != end; ++it )
    {
-      CollisionInfo::Contact& c = *(*it)._contact;
-      c._k = (*it)._bodyA->computeK( c.worldPositionA() ) +
-             (*it)._bodyB->computeK( c.worldPositionB() );
+      CollisionInfo::Contact& c = *(*it)->_contact;
+      c._k = (*it)->_bodyA->computeK( c.worldPositionA() ) +
+             (*it)->_bodyB->computeK( c.worldPositionB() );
       c._normK = 1.0f / c.worldNormal().dot( c._k*c.worldNormal() );
       c._p = 0.0f;
    }
@@ -54,17 +53,17 @@ ImpulseSolver::solveCollisions()
    do
    {
       nbCollisions = 0;
-      for( it = _world->collisionConstraints().begin(); it != end; ++it )
+      for( it = island._collisionConstraints.begin(); it != end; ++it )
       {
-         CollisionInfo::Contact& c = *(*it)._contact;
+         CollisionInfo::Contact& c = *(*it)->_contact;
 
          const Vec3f& posA = c.worldPositionA();
          const Vec3f& posB = c.worldPositionB();
          const Vec3f& n    = c.worldNormal();
 
          // Compute normal relative velocity.
-         Vec3f ua = (*it)._bodyA->velocity( posA );
-         Vec3f ub = (*it)._bodyB->velocity( posB );
+         Vec3f ua = (*it)->_bodyA->velocity( posA );
+         Vec3f ub = (*it)->_bodyB->velocity( posB );
          
          c._nRelVel = ( ua - ub ).dot( n );
 
@@ -76,7 +75,7 @@ ImpulseSolver::solveCollisions()
             // Compute collision impulse.
 
             // 1. Normal velocity after collision.
-            float nVelAfter = -c._nRelVel * (*it)._bodyA->restitution( *(*it)._bodyB );
+            float nVelAfter = -c._nRelVel * (*it)->_bodyA->restitution( *(*it)->_bodyB );
 
             // 2. Impulse.
             float p = (nVelAfter - c._nRelVel) * c._normK;
@@ -93,12 +92,12 @@ ImpulseSolver::solveCollisions()
             }
 
             // 5. Apply impulse.
-            (*it)._bodyA->applyImpulse( n*p, posA );
-            (*it)._bodyB->applyImpulse( n*-p, posB );
+            (*it)->_bodyA->applyImpulse( n*p, posA );
+            (*it)->_bodyB->applyImpulse( n*-p, posB );
 
             // Compute friction impulse.
-            ua = (*it)._bodyA->velocity( posA );
-            ub = (*it)._bodyB->velocity( posB );
+            ua = (*it)->_bodyA->velocity( posA );
+            ub = (*it)->_bodyB->velocity( posB );
             c._nRelVel = ( ua - ub ).dot( n );
 
             // 1. Tangential relative velocity.
@@ -112,7 +111,7 @@ ImpulseSolver::solveCollisions()
                Vec3f tan = tRelVel * ( 1.0f / tvelLen );
 
                // 3. Friction impulse.
-               float tp = -CGM::abs(p) * (*it)._bodyA->friction( *(*it)._bodyB );
+               float tp = -CGM::abs(p) * (*it)->_bodyA->friction( *(*it)->_bodyB );
 
                // 4. Max friction impulse.
                float tpMax = -tvelLen / tan.dot( c._k*tan );
@@ -122,8 +121,8 @@ ImpulseSolver::solveCollisions()
                {
                   tp = tpMax;
                }
-               (*it)._bodyA->applyImpulse( tan*tp, posA );
-               (*it)._bodyB->applyImpulse( tan*-tp, posB );
+               (*it)->_bodyA->applyImpulse( tan*tp, posA );
+               (*it)->_bodyB->applyImpulse( tan*-tp, posB );
             }
          }
       }
@@ -131,14 +130,14 @@ ImpulseSolver::solveCollisions()
 
 
    // Create contact constraints.
-   _contacts.clear();
-   for( it = _world->collisionConstraints().begin(); it != end; ++it )
+   island._contacts.clear();
+   for( it = island._collisionConstraints.begin(); it != end; ++it )
    {
-      if( (*it)._contact->_nRelVel <= 0.1f )
-      //if( (*it)._contact->_nRelVel <= -restingThreshold )
+      if( (*it)->_contact->_nRelVel <= 0.1f )
+      //if( (*it)->_contact->_nRelVel <= -restingThreshold )
       {
          // Add to constraints list.
-         _contacts.pushBack( it );
+         island._contacts.pushBack( *it );
       }
    }
 }
@@ -146,25 +145,25 @@ ImpulseSolver::solveCollisions()
 //------------------------------------------------------------------------------
 //!
 void
-ImpulseSolver::solveConstraints( double step )
+ImpulseSolver::solveConstraints( MotionWorld::Island& island, double step )
 {
    const int maxLoopCount  = 10;
    const float maxDistance = 0.001f; // 1 mm precision.
    
    // Precompute per contact data.
    Vector< MotionWorld::CollisionConstraint* >::Iterator it;
-   Vector< MotionWorld::CollisionConstraint* >::Iterator end = _contacts.end();
+   Vector< MotionWorld::CollisionConstraint* >::Iterator end = island._contacts.end();
 
-   for( it = _contacts.begin(); it != end; ++it )
+   for( it = island._contacts.begin(); it != end; ++it )
    {
       (*it)->_contact->_p = 0.0f;
    }
 
    // Precompute per constraint data.
-   MotionWorld::ConstraintContainer::Iterator itC;
-   MotionWorld::ConstraintContainer::Iterator endC = _world->constraints().end();
+   Vector< Constraint* >::Iterator itC;
+   Vector< Constraint* >::Iterator endC = island._constraints.end();
 
-   for( itC = _world->constraints().begin(); itC != endC; ++itC )
+   for( itC = island._constraints.begin(); itC != endC; ++itC )
    {
       (*itC)->prePositionStep( step );
    }
@@ -177,7 +176,7 @@ ImpulseSolver::solveConstraints( double step )
       // Contact constraints.
       nbConstraits = 0;
 
-      for( it = _contacts.begin(); it != end; ++it )
+      for( it = island._contacts.begin(); it != end; ++it )
       {
          CollisionInfo::Contact& contact = *(*it)->_contact;
 
@@ -258,7 +257,7 @@ ImpulseSolver::solveConstraints( double step )
       }
 
       // General constraints.
-      for( itC = _world->constraints().begin(); itC != endC; ++itC )
+      for( itC = island._constraints.begin(); itC != endC; ++itC )
       {
          if( (*itC)->solvePosition( step ) )
          {
@@ -272,24 +271,24 @@ ImpulseSolver::solveConstraints( double step )
 //------------------------------------------------------------------------------
 //!
 void
-ImpulseSolver::solveVelocities()
+ImpulseSolver::solveVelocities( MotionWorld::Island& island )
 {
    const int maxLoopCount = 10;
 
    // Contact constraints should have relative velocity of zero!
 
    // Precompute per constraint data.
-   MotionWorld::ConstraintContainer::Iterator itC;
-   MotionWorld::ConstraintContainer::Iterator endC = _world->constraints().end();
+   Vector< Constraint* >::Iterator itC;
+   Vector< Constraint* >::Iterator endC = island._constraints.end();
 
-   for( itC = _world->constraints().begin(); itC != endC; ++itC )
+   for( itC = island._constraints.begin(); itC != endC; ++itC )
    {
       (*itC)->preVelocitiesStep();
    }
    
    // Precompute per contact data.
    Vector< MotionWorld::CollisionConstraint* >::Iterator it;
-   Vector< MotionWorld::CollisionConstraint* >::Iterator end = _contacts.end();
+   Vector< MotionWorld::CollisionConstraint* >::Iterator end = island._contacts.end();
    
    // Solve constraints.
    int nbConstraits;
@@ -298,7 +297,7 @@ ImpulseSolver::solveVelocities()
    {
       nbConstraits = 0;
       
-      for( it = _contacts.begin(); it != end; ++it )
+      for( it = island._contacts.begin(); it != end; ++it )
       {
          CollisionInfo::Contact& contact = *(*it)->_contact;
 
@@ -329,7 +328,7 @@ ImpulseSolver::solveVelocities()
       }
 
       // General constraints.
-      for( itC = _world->constraints().begin(); itC != endC; ++itC )
+      for( itC = island._constraints.begin(); itC != endC; ++itC )
       {
          if( (*itC)->solveVelocities() )
          {
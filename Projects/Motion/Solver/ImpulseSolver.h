@@ -30,9 +30,10 @@ public:
 
    MOTION_DLL_API ImpulseSolver( MotionWorld* );
 
-   MOTION_DLL_API void solveCollisions();
-   MOTION_DLL_API void solveConstraints( double step );
-   MOTION_DLL_API void solveVelocities();
+   // Islands are independent, and can be solved concurrently.
+   MOTION_DLL_API void solveCollisions( MotionWorld::Island& );
+   MOTION_DLL_API void solveConstraints( MotionWorld::Island&, double step );
+   MOTION_DLL_API void solveVelocities( MotionWorld::Island& );
 
 protected: 
 
@@ -45,8 +46,6 @@ private:
    /*----- data members -----*/
 
    MotionWorld* _world;
-
-   Vector< MotionWorld::CollisionConstraint* > _contacts;
 };
 
 NAMESPACE_END
@@ -30,7 +30,7 @@ NextSolver::~NextSolver()
 //------------------------------------------------------------------------------
 //!
 bool
-NextSolver::collisionResponse()
+NextSolver::collisionResponse( MotionWorld::Island& island )
 {
    const float maxVelDiff       = 0.001f;
    const float restingThreshold = 0.8f;
@@ -38,21 +38,21 @@ NextSolver::collisionResponse()
    
    Vector<bool> sticking;
    Vector<MotionWorld::CollisionConstraint*> cc;
-   MotionWorld::CollisionConstraintContainer::Iterator it;
-   MotionWorld::CollisionConstraintContainer::Iterator end = _world->collisionConstraints().end();
+   Vector< MotionWorld::CollisionConstraint* >::Iterator it;
+   Vector< MotionWorld::CollisionConstraint* >::Iterator end = island._collisionConstraints.end();
 
    // Precompute per contact data.
-   for( it = _world->collisionConstraints().begin(); it != end; ++it )
+   for( it = island._collisionConstraints.begin(); it != end; ++it )
    {
-      CollisionInfo::Contact& c = *(*it)._contact;
+      CollisionInfo::Contact& c = *(*it)->_contact;
       
       const Vec3f& posA = c.worldPositionA();
       const Vec3f& posB = c.worldPositionB();
       const Vec3f& n    = c.worldNormal();
 
       // Compute normal relative velocity.
-      Vec3f ua    = (*it)._bodyA->velocity( posA );
-      Vec3f ub    = (*it)._bodyB->velocity( posB );
+      Vec3f ua    = (*it)->_bodyA->velocity( posA );
+      Vec3f ub    = (*it)->_bodyB->velocity( posB );
       Vec3f urel  = ua-ub;
       float ureln = urel.dot( n );
       Vec3f urelt = urel-n*ureln;
@@ -67,8 +67,8 @@ NextSolver::collisionResponse()
       }
       else
       {
-         c._nRelVel = -ureln*(*it)._bodyA->restitution( *(*it)._bodyB );
-         cc.pushBack( it );
+         c._nRelVel = -ureln*(*it)->_bodyA->restitution( *(*it)->_bodyB );
+         cc.pushBack( *it );
          
          if( urelt.sqrLength() <= eps )
          {
@@ -80,7 +80,7 @@ NextSolver::collisionResponse()
          }
       }
       
-      c._k     = (*it)._bodyA->computeK( posA ) + (*it)._bodyB->computeK( posB );
+      c._k     = (*it)->_bodyA->computeK( posA ) + (*it)->_bodyB->computeK( posB );
       c._normK = 1.0f / n.dot( c._k*n );
       c._p     = 0.0f;
       c._fp    = 0.0f;
@@ -243,7 +243,7 @@ NextSolver::collisionResponse()
 //------------------------------------------------------------------------------
 //!
 void
-NextSolver::solveCollisions()
+NextSolver::solveCollisions( MotionWorld::Island& island )
 {
    const uint maxLoop = 10;
    const float restingThreshold = 0.8f;
@@ -255,7 +255,7 @@ NextSolver::solveCollisions()
       ++loop;
       fix = false;
       
-      if( collisionResponse() )
+      if( collisionResponse( island ) )
       {
          fix = true;
       }
@@ -263,21 +263,21 @@ NextSolver::solveCollisions()
    
    
    // Create contact constraints.
-   _contacts.clear();
-   MotionWorld::CollisionConstraintContainer::Iterator it;
-   MotionWorld::CollisionConstraintContainer::Iterator end = _world->collisionConstraints().end();
+   island._contacts.clear();
+   Vector< MotionWorld::CollisionConstraint* >::Iterator it;
+   Vector< MotionWorld::CollisionConstraint* >::Iterator end = island._collisionConstraints.end();
 
-   for( it = _world->collisionConstraints().begin(); it != end; ++it )
+   for( it = island._collisionConstraints.begin(); it != end; ++it )
    {
-      CollisionInfo::Contact& c = *(*it)._contact;
+      CollisionInfo::Contact& c = *(*it)->_contact;
       
       const Vec3f& posA = c.worldPositionA();
       const Vec3f& posB = c.worldPositionB();
       const Vec3f& n    = c.worldNormal();
 
       // Compute normal relative velocity.
-      Vec3f ua    = (*it)._bodyA->velocity( posA );
-      Vec3f ub    = (*it)._bodyB->velocity( posB );
+      Vec3f ua    = (*it)->_bodyA->velocity( posA );
+      Vec3f ub    = (*it)->_bodyB->velocity( posB );
       Vec3f urel  = ua-ub;
       float ureln = urel.dot( n );
       
@@ -287,7 +287,7 @@ NextSolver::solveCollisions()
       }
       else
       {
-         _contacts.pushBack( it );
+         island._contacts.pushBack( *it );
       }
    }
    
@@ -295,16 +295,16 @@ NextSolver::solveCollisions()
    const float restingThreshold = -0.4f;
    const int maxLoopCount = 10;
 
-   MotionWorld::CollisionConstraintContainer::Iterator it;
-   MotionWorld::CollisionConstraintContainer::Iterator end = 
-      _world->collisionConstraints().end();
+   Vector< MotionWorld::CollisionConstraint* >::Iterator it;
+   Vector< MotionWorld::CollisionConstraint* >::Iterator end = 
+      island._collisionConstraints.end();
 
    // Precompute per contact data.
-   for( it = _world->collisionConstraints().begin(); it != end; ++it )
+   for( it = island._collisionConstraints.begin(); it != end; ++it )
    {
-      CollisionInfo::Contact& c = *(*it)._contact;
-      c._k = (*it)._bodyA->computeK( c.worldPositionA() ) +
-             (*it)._bodyB->computeK( c.worldPositionB() );
+      CollisionInfo::Contact& c = *(*it)->_contact;
+      c._k = (*it)->_bodyA->computeK( c.worldPositionA() ) +
+             (*it)->_bodyB->computeK( c.worldPositionB() );
       c._normK = 1.0f / c.worldNormal().dot( c._k*c.worldNormal() );
       c._p = 0.0f;
    }
@@ -316,17 +316,17 @@ NextSolver::solveCollisions()
    do
    {
       nbCollisions = 0;
-      for( it = _world->collisionConstraints().begin(); it != end; ++it )
+      for( it = island._collisionConstraints.begin(); it != end; ++it )
       {
-         CollisionInfo::Contact& c = *(*it)._contact;
+         CollisionInfo::Contact& c = *(*it)->_contact;
 
          const Vec3f& posA = c.worldPositionA();
          const Vec3f& posB = c.worldPositionB();
          const Vec3f& n    = c.worldNormal();
 
          // Compute normal relative velocity.
-         Vec3f ua = (*it)._bodyA->velocity( posA );
-         Vec3f ub = (*it)._bodyB->velocity( posB );
+         Vec3f ua = (*it)->_bodyA->velocity( posA );
+         Vec3f ub = (*it)->_bodyB->velocity( posB );
          
          c._nRelVel = ( ua - ub ).dot( n );
 
@@ -338,7 +338,7 @@ NextSolver::solveCollisions()
             // Compute collision impulse.
 
             // 1. Normal velocity after collision.
-            float nVelAfter = -c._nRelVel * (*it)._bodyA->restitution( *(*it)._bodyB );
+            float nVelAfter = -c._nRelVel * (*it)->_bodyA->restitution( *(*it)->_bodyB );
 
             // 2. Impulse.
             float p = (nVelAfter - c._nRelVel) * c._normK;
@@ -355,12 +355,12 @@ NextSolver::solveCollisions()
             }
 
             // 5. Apply impulse.
-            (*it)._bodyA->applyImpulse( n*p, posA );
-            (*it)._bodyB->applyImpulse( n*-p, posB );
+            (*it)->_bodyA->applyImpulse( n*p, posA );
+            (*it)->_bodyB->applyImpulse( n*-p, posB );
 
             // Compute friction impulse.
-            ua = (*it)._bodyA->velocity( posA );
-            ub = (*it)._bodyB->velocity( posB );
+            ua = (*it)->_bodyA->velocity( posA );
+            ub = (*it)->_bodyB->velocity( posB );
             c._nRelVel = ( ua - ub ).dot( n );
 
             // 1. Tangential relative velocity.
@@ -374,7 +374,7 @@ NextSolver::solveCollisions()
                Vec3f tan = tRelVel * ( 1.0f / tvelLen );
 
                // 3. Friction impulse.
-               float tp = -CGM::abs(p) * (*it)._bodyA->friction( *(*it)._bodyB );
+               float tp = -CGM::abs(p) * (*it)->_bodyA->friction( *(*it)->_bodyB );
 
                // 4. Max friction impulse.
                float tpMax = -tvelLen / tan.dot( c._k*tan );
@@ -384,8 +384,8 @@ NextSolver::solveCollisions()
                {
                   tp = tpMax;
                }
-               (*it)._bodyA->applyImpulse( tan*tp, posA );
-               (*it)._bodyB->applyImpulse( tan*-tp, posB );
+               (*it)->_bodyA->applyImpulse( tan*tp, posA );
+               (*it)->_bodyB->applyImpulse( tan*-tp, posB );
             }
          }
       }
@@ -393,14 +393,14 @@ NextSolver::solveCollisions()
 
 
    // Create contact constraints.
-   _contacts.clear();
-   for( it = _world->collisionConstraints().begin(); it != end; ++it )
+   island._contacts.clear();
+   for( it = island._collisionConstraints.begin(); it != end; ++it )
    {
-      if( (*it)._contact->_nRelVel <= 0.1f )
-      //if( (*it)._contact->_nRelVel <= -restingThreshold )
+      if( (*it)->_contact->_nRelVel <= 0.1f )
+      //if( (*it)->_contact->_nRelVel <= -restingThreshold )
       {
          // Add to constraints list.
-         _contacts.pushBack( it );
+         island._contacts.pushBack( *it );
       }
    }
 #endif   
@@ -409,7 +409,7 @@ NextSolver::solveCollisions()
 //------------------------------------------------------------------------------
 //!
 void
-NextSolver::solveConstraints( double step )
+NextSolver::solveConstraints( MotionWorld::Island& island, double step )
 {   
    const uint maxLoop        = 10;
    const uint maxJointLoop   = 10;
@@ -419,11 +419,11 @@ NextSolver::solveConstraints( double step )
    
    // Precompute per contact data.
    Vector< MotionWorld::CollisionConstraint* >::Iterator it;
-   Vector< MotionWorld::CollisionConstraint* >::Iterator end = _contacts.end();
+   Vector< MotionWorld::CollisionConstraint* >::Iterator end = island._contacts.end();
 
-   Vector<bool> sticking(_contacts.size());
+   Vector<bool> sticking(island._contacts.size());
    uint i;
-   for( i = 0, it = _contacts.begin(); it != end; ++it, ++i )
+   for( i = 0, it = island._contacts.begin(); it != end; ++it, ++i )
    {
       (*it)->_contact->_p  = 0.0f;
       (*it)->_contact->_fp = 0.0f;
@@ -451,10 +451,10 @@ NextSolver::solveConstraints( double step )
    }
 
    // Precompute per constraint data.
-   MotionWorld::ConstraintContainer::Iterator itC;
-   MotionWorld::ConstraintContainer::Iterator endC = _world->constraints().end();
+   Vector< Constraint* >::Iterator itC;
+   Vector< Constraint* >::Iterator endC = island._constraints.end();
 
-   for( itC = _world->constraints().begin(); itC != endC; ++itC )
+   for( itC = island._constraints.begin(); itC != endC; ++itC )
    {
       (*itC)->prePositionStep( step );
    }
@@ -470,7 +470,7 @@ NextSolver::solveConstraints( double step )
       // General constraints.
       if( loop <= maxJointLoop )
       {
-         for( itC = _world->constraints().begin(); itC != endC; ++itC )
+         for( itC = island._constraints.begin(); itC != endC; ++itC )
          {
             if( (*itC)->solvePosition( step ) )
             {
@@ -481,7 +481,7 @@ NextSolver::solveConstraints( double step )
       // Contact constraints.
       if( loop <= maxContactLoop )
       {
-         for( i = 0, it = _contacts.begin(); it != end; ++it, ++i )
+         for( i = 0, it = island._contacts.begin(); it != end; ++it, ++i )
          {
             bool cfix = false;
             CollisionInfo::Contact& contact = *(*it)->_contact;
@@ -633,7 +633,7 @@ NextSolver::solveConstraints( double step )
       // Contact constraints.
       nbConstraits = 0;
 
-      for( it = _contacts.begin(); it != end; ++it )
+      for( it = island._contacts.begin(); it != end; ++it )
       {
          CollisionInfo::Contact& contact = *(*it)->_contact;
 
@@ -715,7 +715,7 @@ NextSolver::solveConstraints( double step )
       }
 
       // General constraints.
-      for( itC = _world->constraints().begin(); itC != endC; ++itC )
+      for( itC = island._constraints.begin(); itC != endC; ++itC )
       {
          if( (*itC)->solvePosition( step ) )
          {
@@ -731,24 +731,24 @@ NextSolver::solveConstraints( double step )
 //------------------------------------------------------------------------------
 //!
 void
-NextSolver::solveVelocities()
+NextSolver::solveVelocities( MotionWorld::Island& island )
 {
    const int maxLoopCount = 10;
 
    // Contact constraints should have relative velocity of zero!
 
    // Precompute per constraint data.
-   MotionWorld::ConstraintContainer::Iterator itC;
-   MotionWorld::ConstraintContainer::Iterator endC = _world->constraints().end();
+   Vector< Constraint* >::Iterator itC;
+   Vector< Constraint* >::Iterator endC = island._constraints.end();
 
-   for( itC = _world->constraints().begin(); itC != endC; ++itC )
+   for( itC = island._constraints.begin(); itC != endC; ++itC )
    {
       (*itC)->preVelocitiesStep();
    }
    
    // Precompute per contact data.
    Vector< MotionWorld::CollisionConstraint* >::Iterator it;
-   Vector< MotionWorld::CollisionConstraint* >::Iterator end = _contacts.end();
+   Vector< MotionWorld::CollisionConstraint* >::Iterator end = island._contacts.end();
    
    // Solve constraints.
    int nbConstraits;
@@ -757,7 +757,7 @@ NextSolver::solveVelocities()
    {
       nbConstraits = 0;
 #if 1    
-      for( it = _contacts.begin(); it != end; ++it )
+      for( it = island._contacts.begin(); it != end; ++it )
       {
          CollisionInfo::Contact& contact = *(*it)->_contact;
 
@@ -788,7 +788,7 @@ NextSolver::solveVelocities()
       }
 #endif
       // General constraints.
-      for( itC = _world->constraints().begin(); itC != endC; ++itC )
+      for( itC = island._constraints.begin(); itC != endC; ++itC )
       {
          if( (*itC)->solveVelocities() )
          {
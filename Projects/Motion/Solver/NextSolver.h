@@ -30,24 +30,22 @@ public:
 
    MOTION_DLL_API NextSolver( MotionWorld* );
 
-   MOTION_DLL_API void solveCollisions();
-   MOTION_DLL_API void solveConstraints( double step );
-   MOTION_DLL_API void solveVelocities();
+   MOTION_DLL_API void solveCollisions( MotionWorld::Island& );
+   MOTION_DLL_API void solveConstraints( MotionWorld::Island&, double step );
+   MOTION_DLL_API void solveVelocities( MotionWorld::Island& );
 
 protected: 
 
    /*----- methods -----*/
 
    virtual ~NextSolver();
-   bool collisionResponse();
+   bool collisionResponse( MotionWorld::Island& );
 
 private: 
 
    /*----- data members -----*/
 
    MotionWorld* _world;
-
-   Vector< MotionWorld::CollisionConstraint* > _contacts;
 };
 
 NAMESPACE_END
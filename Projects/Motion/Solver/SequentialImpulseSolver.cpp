@@ -28,7 +28,7 @@ SequentialImpulseSolver::~SequentialImpulseSolver()
 //------------------------------------------------------------------------------
 //!
 void
-SequentialImpulseSolver::solveCollisions()
+SequentialImpulseSolver::solveCollisions( MotionWorld::Island& )
 {
    // NOTHING TODO.
 }
@@ -36,57 +36,52 @@ SequentialImpulseSolver::solveCollisions()
 //------------------------------------------------------------------------------
 //!
 void
-SequentialImpulseSolver::solveConstraints( double step )
+SequentialImpulseSolver::solveConstraints( MotionWorld::Island& island, double step )
 {
    // Precompute per constraint data.
-   MotionWorld::ConstraintContainer::Iterator itC;
-   MotionWorld::ConstraintContainer::Iterator endC = _world->constraints().end();
+   Vector< Constraint* >::Iterator itC;
+   Vector< Constraint* >::Iterator endC = island._constraints.end();
 
-   for( itC = _world->constraints().begin(); itC != endC; ++itC )
+   for( itC = island._constraints.begin(); itC != endC; ++itC )
    {
       (*itC)->prePositionStep( step );
    }
    
    // Precompute per contact data.
-   MotionWorld::CollisionContainer::Iterator it;
-   MotionWorld::CollisionContainer::Iterator end = _world->collisions().end();
+   Vector< MotionWorld::CollisionConstraint* >::Iterator it;
+   Vector< MotionWorld::CollisionConstraint* >::Iterator end = island._collisionConstraints.end();
 
-   for( it = _world->collisions().begin(); it != end; ++it )
+   for( it = island._collisionConstraints.begin(); it != end; ++it )
    {
-      CollisionInfo* info = (*it).info();
-            
-      for( uint c = 0; c < info->numContacts(); ++c )
+      CollisionInfo::Contact& contact = *(*it)->_contact;
+      if( contact.depth() >= 0.0f )
       {
-         CollisionInfo::Contact& contact = info->contact(c);
-         if( contact.depth() >= 0.0f )
+         contact._k = (*it)->_bodyA->computeK( contact.worldPositionA() ) +
+                      (*it)->_bodyB->computeK( contact.worldPositionB() );
+         contact._normK = 1.0f / contact.worldNormal().dot( contact._k*contact.worldNormal() );
+         
+         // Restitution.
+         const Vec3f& posA = contact.worldPositionA();
+         const Vec3f& posB = contact.worldPositionB();
+         const Vec3f& n    = contact.worldNormal();
+
+         // 1. Compute normal relative velocity.
+         Vec3f va = (*it)->_bodyA->velocity( posA );
+         Vec3f vb = (*it)->_bodyB->velocity( posB );
+         float vn = ( va - vb ).dot( n );
+         
+         // 2. Compute restitution factor.
+         contact._restitution = -vn * (*it)->_bodyA->restitution( *(*it)->_bodyB );
+         if( contact._restitution < 0.0f )
          {
-            contact._k = (*it).bodyA()->computeK( contact.worldPositionA() ) +
-                         (*it).bodyB()->computeK( contact.worldPositionB() );
-            contact._normK = 1.0f / contact.worldNormal().dot( contact._k*contact.worldNormal() );
-            
-            // Restitution.
-            const Vec3f& posA = contact.worldPositionA();
-            const Vec3f& posB = contact.worldPositionB();
-            const Vec3f& n    = contact.worldNormal();
-
-            // 1. Compute normal relative velocity.
-            Vec3f va = (*it).bodyA()->velocity( posA );
-            Vec3f vb = (*it).bodyB()->velocity( posB );
-            float vn = ( va - vb ).dot( n );
-            
-            // 2. Compute restitution factor.
-            contact._restitution = -vn * (*it).bodyA()->restitution( *(*it).bodyB() );
-            if( contact._restitution < 0.0f )
-            {
-               contact._restitution = 0.0f;
-            }
-            
-            // Warm starting by applying the previous impulse.
-            (*it).bodyA()->applyImpulse( n*contact._p, posA );
-            (*it).bodyB()->applyImpulse( -n*contact._p, posB );
-            
-            contact._fp = 0.0f;
+            contact._restitution = 0.0f;
          }
+         
+         // Warm starting by applying the previous impulse.
+         (*it)->_bodyA->applyImpulse( n*contact._p, posA );
+         (*it)->_bodyB->applyImpulse( -n*contact._p, posB );
+         
+         contact._fp = 0.0f;
       }
    }
    
@@ -98,82 +93,77 @@ SequentialImpulseSolver::solveConstraints( double step )
    do
    {
       
-      for( it = _world->collisions().begin(); it != end; ++it )
+      for( it = island._collisionConstraints.begin(); it != end; ++it )
       {
-         CollisionInfo* info = (*it).info();
-         
-         for( uint c = 0; c < info->numContacts(); ++c )
+         CollisionInfo::Contact& contact = *(*it)->_contact;
+         if( contact.depth() >= 0.0f )
          {
-            CollisionInfo::Contact& contact = info->contact(c);
-            if( contact.depth() >= 0.0f )
+            const Vec3f& posA = contact.worldPositionA();
+            const Vec3f& posB = contact.worldPositionB();
+            const Vec3f& n    = contact.worldNormal();
+
+            // Collision impulse.
+            
+            // 1. Compute normal relative velocity.
+            Vec3f va = (*it)->_bodyA->velocity( posA );
+            Vec3f vb = (*it)->_bodyB->velocity( posB );
+            float vn = ( va - vb ).dot( n );
+            
+            // 2. Compute impulse.
+            float depth = contact.depth();
+            if( contact._restitution*(float)step > depth )
             {
-               const Vec3f& posA = contact.worldPositionA();
-               const Vec3f& posB = contact.worldPositionB();
-               const Vec3f& n    = contact.worldNormal();
+               depth = 0.0f;
+            }
+            
+            float depthCorrection = 0.3f * depth / (float)step;
+            float velCorrection = contact._restitution - vn;
+            float nImpulse = contact._normK * ( velCorrection + depthCorrection );
+            
+            // 3. Clamp impulse.
+            float prevImpulse = contact._p;
+            contact._p = CGM::max( prevImpulse + nImpulse, 0.0f );
+            nImpulse = contact._p - prevImpulse;
+            
+            // 4. Apply impulse.
+            (*it)->_bodyA->applyImpulse( n*nImpulse, posA );
+            (*it)->_bodyB->applyImpulse( n*-nImpulse, posB );
+            
+            // Friction impulse.
+            
+            // 1. Tangential relative velocity.
+            va = (*it)->_bodyA->velocity( posA );
+            vb = (*it)->_bodyB->velocity( posB );
+            vn = ( va - vb ).dot( n );
+            
+            Vec3f tRelVel = ( va - vb ) - n*vn;
+            float tvelLen = tRelVel.length();
 
-               // Collision impulse.
-               
-               // 1. Compute normal relative velocity.
-               Vec3f va = (*it).bodyA()->velocity( posA );
-               Vec3f vb = (*it).bodyB()->velocity( posB );
-               float vn = ( va - vb ).dot( n );
-               
-               // 2. Compute impulse.
-               float depth = contact.depth();
-               if( contact._restitution*(float)step > depth )
-               {
-                  depth = 0.0f;
-               }
-               
-               float depthCorrection = 0.3f * depth / (float)step;
-               float velCorrection = contact._restitution - vn;
-               float nImpulse = contact._normK * ( velCorrection + depthCorrection );
-               
-               // 3. Clamp impulse.
-               float prevImpulse = contact._p;
-               contact._p = CGM::max( prevImpulse + nImpulse, 0.0f );
-               nImpulse = contact._p - prevImpulse;
-               
-               // 4. Apply impulse.
-               (*it).bodyA()->applyImpulse( n*nImpulse, posA );
-               (*it).bodyB()->applyImpulse( n*-nImpulse, posB );
+            if( tvelLen > 0.0000001 && contact._p > 0.0f )
+            {
+               // 2. Tangent.
+               Vec3f tan = tRelVel * ( 1.0f / tvelLen );
                
-               // Friction impulse.
+               // 3. Friction impulse.
+               float fp = -tvelLen / tan.dot( contact._k*tan );
+
+               // 4. Max friction impulse.
+               float maxFriction = contact._p * (*it)->_bodyA->friction( *(*it)->_bodyB );
                
-               // 1. Tangential relative velocity.
-               va = (*it).bodyA()->velocity( posA );
-               vb = (*it).bodyB()->velocity( posB );
-               vn = ( va - vb ).dot( n );
+               // 5. Clamp impulse.
+               float prevFrictionImpulse = contact._fp;
+               contact._fp += fp;
+               contact._fp  = CGM::clamp( contact._fp, -maxFriction, maxFriction );
+               fp = contact._fp - prevFrictionImpulse;
                
-               Vec3f tRelVel = ( va - vb ) - n*vn;
-               float tvelLen = tRelVel.length();
-
-               if( tvelLen > 0.0000001 && contact._p > 0.0f )
-               {
-                  // 2. Tangent.
-                  Vec3f tan = tRelVel * ( 1.0f / tvelLen );
-                  
-                  // 3. Friction impulse.
-                  float fp = -tvelLen / tan.dot( contact._k*tan );
-
-                  // 4. Max friction impulse.
-                  float maxFriction = contact._p * (*it).bodyA()->friction( *(*it).bodyB() );
-                  
-                  // 5. Clamp impulse.
-                  float prevFrictionImpulse = contact._fp;
-                  contact._fp += fp;
-                  contact._fp  = CGM::clamp( contact._fp, -maxFriction, maxFriction );
-                  fp = contact._fp - prevFrictionImpulse;
-                  
-                  // 6. Apply impulse.
-                  (*it).bodyA()->applyImpulse( tan*fp, posA );
-                  (*it).bodyB()->applyImpulse( tan*-fp, posB );
-               }
+               // 6. Apply impulse.
+               (*it)->_bodyA->applyImpulse( tan*fp, posA );
+               (*it)->_bodyB->applyImpulse( tan*-fp, posB );
             }
          }
       }
       
-      for( itC = _world->constraints().begin(); itC != endC; ++itC )
+      for( itC = island._constraints.begin(); itC != endC; ++itC )
       {
          if( (*itC)->solvePosition( step ) )
          {
@@ -187,17 +177,17 @@ SequentialImpulseSolver::solveConstraints( double step )
 //------------------------------------------------------------------------------
 //!
 void
-SequentialImpulseSolver::solveVelocities()
+SequentialImpulseSolver::solveVelocities( MotionWorld::Island& island )
 {
    const int maxLoopCount = 10;
 
    // Contact constraints should have relative velocity of zero!
 
    // Precompute per constraint data.
-   MotionWorld::ConstraintContainer::Iterator itC;
-   MotionWorld::ConstraintContainer::Iterator endC = _world->constraints().end();
+   Vector< Constraint* >::Iterator itC;
+   Vector< Constraint* >::Iterator endC = island._constraints.end();
 
-   for( itC = _world->constraints().begin(); itC != endC; ++itC )
+   for( itC = island._constraints.begin(); itC != endC; ++itC )
    {
       (*itC)->preVelocitiesStep();
    }
@@ -210,7 +200,7 @@ SequentialImpulseSolver::solveVelocities()
       nbConstraits = 0;
 
       // General constraints.
-      for( itC = _world->constraints().begin(); itC != endC; ++itC )
+      for( itC = island._constraints.begin(); itC != endC; ++itC )
       {
          if( (*itC)->solveVelocities() )
          {
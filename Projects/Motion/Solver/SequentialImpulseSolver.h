@@ -19,7 +19,9 @@ NAMESPACE_BEGIN
 /*==============================================================================
    CLASS SequentialImpulseSolver
 ==============================================================================*/
-//!
+//! Solves the contacts of an island, which only holds the pairs allowed to
+//! collide (see RigidBody::canCollide()), like the other solvers; it used to
+//! solve every colliding pair, ignoring the collision masks.
 class SequentialImpulseSolver
    : public RCObject
 {
@@ -30,9 +32,9 @@ public:
 
    MOTION_DLL_API SequentialImpulseSolver( MotionWorld* );
 
-   MOTION_DLL_API void solveCollisions();
-   MOTION_DLL_API void solveConstraints( double step );
-   MOTION_DLL_API void solveVelocities();
+   MOTION_DLL_API void solveCollisions( MotionWorld::Island& );
+   MOTION_DLL_API void solveConstraints( MotionWorld::Island&, double step );
+   MOTION_DLL_API void solveVelocities( MotionWorld::Island& );
 
 protected: 
 
@@ -10,6 +10,7 @@
 #include <Motion/Solver/NextSolver.h>
 
 #include <Base/Dbg/DebugStream.h>
+#include <Base/MT/TaskQueue.h>
 
 /*==============================================================================
   UNNAMED NAMESPACE
@@ -18,11 +19,88 @@ UNNAMESPACE_BEGIN
 
 DBG_STREAM( os_att, "Attractor" );
 
+// Bodies slower than this are considered at rest.
+const float _sleepLinearVelocity2  = 0.1f*0.1f;
+const float _sleepAngularVelocity2 = 0.1f*0.1f;
+
+//------------------------------------------------------------------------------
+//! Returns whether or not the body moves during the current step.
+inline bool
+simulated( const RigidBody& body )
+{
+   switch( body.type() )
+   {
+      case RigidBody::DYNAMIC:   return body.active();
+      case RigidBody::KINEMATIC: return true;
+      default:                   return false;
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Returns the root of the set containing i (with path halving).
+inline uint
+findRoot( uint* parents, uint i )
+{
+   while( parents[i] != i )
+   {
+      parents[i] = parents[parents[i]];
+      i          = parents[i];
+   }
+   return i;
+}
+
+//------------------------------------------------------------------------------
+//! Merges the sets containing a and b.
+//! The smallest index always becomes the root, which keeps the islands in the
+//! order of the bodies.
+inline void
+unite( uint* parents, uint a, uint b )
+{
+   a = findRoot( parents, a );
+   b = findRoot( parents, b );
+   if( a < b )
+   {
+      parents[b] = a;
+   }
+   else
+   {
+      parents[a] = b;
+   }
+}
+
 UNNAMESPACE_END
 
 
 NAMESPACE_BEGIN
 
+/*==============================================================================
+   CLASS MotionWorld::IslandLoop
+==============================================================================*/
+//! Solves a range of islands (see TaskQueue::parallelFor()).
+class MotionWorld::IslandLoop
+{
+public:
+
+   /*----- methods -----*/
+
+   IslandLoop( MotionWorld* world, double step ): _world( world ), _step( step ) {}
+
+   void operator()( uint begin, uint end, WorkerTask& )
+   {
+      for( uint i = begin; i < end; ++i )
+      {
+         _world->solveIsland( _world->_islands[i], _step );
+      }
+   }
+
+protected:
+
+   /*----- data members -----*/
+
+   MotionWorld*  _world;
+   double        _step;
+};
+
 /*==============================================================================
    CLASS MotionWorld
 ==============================================================================*/
@@ -39,9 +117,13 @@ MotionWorld::printInfo( TextStream& os )
 //!
 MotionWorld::MotionWorld() :
    _time( 0.0 ),
-   _simulationTime( 0.0 )
+   _simulationTime( 0.0 ),
+   _numIslands( 0 ),
+   _sleepDelay( 0.5 ),
+   _taskQueue( NULL )
 {
    simulationRate( 60.0 );
+   _broadphase = new SweepAndPruneBroadphase();
    //_solver = new SequentialImpulseSolver( this );
    _solver = new ImpulseSolver( this );
    //_solver = new NextSolver( this );
@@ -113,6 +195,7 @@ MotionWorld::addBody( RigidBody* body )
       case RigidBody::KINEMATIC:  _kinematicBodies.pushBack( body ); break;
    }
    body->connect( this );
+   _broadphase->invalidate( body->type() );
 }
 
 //------------------------------------------------------------------------------
@@ -120,6 +203,14 @@ MotionWorld::addBody( RigidBody* body )
 void
 MotionWorld::removeBody( RigidBody* body )
 {
+   // Wake up the bodies which could be resting on this one.
+   CollisionContainer::Iterator it = _collisions.begin();
+   for( ; it != _collisions.end(); ++it )
+   {
+      if( (*it).bodyA() == body )  (*it).bodyB()->activate();
+      if( (*it).bodyB() == body )  (*it).bodyA()->activate();
+   }
+
    body->disconnect();
    switch( body->type() )
    {
@@ -127,6 +218,7 @@ MotionWorld::removeBody( RigidBody* body )
       case RigidBody::STATIC:     _staticBodies.remove( body );    break;
       case RigidBody::KINEMATIC:  _kinematicBodies.remove( body ); break;
    }
+   _broadphase->invalidate( body->type() );
 }
 
 //------------------------------------------------------------------------------
@@ -137,6 +229,20 @@ MotionWorld::removeAllBodies()
    _rigidBodies.clear();
    _staticBodies.clear();
    _kinematicBodies.clear();
+   _broadphase->invalidate( RigidBody::DYNAMIC );
+   _broadphase->invalidate( RigidBody::STATIC );
+   _broadphase->invalidate( RigidBody::KINEMATIC );
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+MotionWorld::broadphase( Broadphase* b )
+{
+   _broadphase = b;
+   _broadphase->invalidate( RigidBody::DYNAMIC );
+   _broadphase->invalidate( RigidBody::STATIC );
+   _broadphase->invalidate( RigidBody::KINEMATIC );
 }
 
 //------------------------------------------------------------------------------
@@ -218,6 +324,8 @@ void
 MotionWorld::addConstraint( Constraint* constraint )
 {
    _constraints.pushBack( constraint );
+   if( constraint->bodyA() )  constraint->bodyA()->activate();
+   if( constraint->bodyB() )  constraint->bodyB()->activate();
 }
 
 //------------------------------------------------------------------------------
@@ -225,6 +333,8 @@ MotionWorld::addConstraint( Constraint* constraint )
 void
 MotionWorld::removeConstraint( Constraint* constraint )
 {
+   if( constraint->bodyA() )  constraint->bodyA()->activate();
+   if( constraint->bodyB() )  constraint->bodyB()->activate();
    _constraints.remove( constraint );
 }
 
@@ -283,27 +393,21 @@ MotionWorld::singleStepSimulation( double step )
       _attractors[i]->addForce( _rigidBodies );
    }
 
-   // Update velocities by integrating forces.
-   for( uint i = 0; i < _rigidBodies.size(); ++i )
+   // Solve the islands, which do not share any dynamic body.
+   buildIslands();
+   if( _taskQueue && _numIslands > 1 )
    {
-      _rigidBodies[i]->applyForces( step );
+      IslandLoop loop( this, step );
+      _taskQueue->parallelFor( 0, _numIslands, 1, loop );
    }
-
-   // Collisions solving.
-   _solver->solveCollisions();
-
-   // Contacts + Joints.
-   _solver->solveConstraints( step );
-
-   // Update bodies positions.
-   for( uint i = 0; i < _rigidBodies.size(); ++i )
+   else
    {
-      _rigidBodies[i]->applyVelocities( step );
+      for( uint i = 0; i < _numIslands; ++i )
+      {
+         solveIsland( _islands[i], step );
+      }
    }
 
-   // Fix velocities.
-   _solver->solveVelocities();
-
    // Increase simulation time.
    _simulationTime += step;
 }
@@ -318,49 +422,13 @@ MotionWorld::collisionDetection()
    // 4. handle multiple pair in solver...
 
 
-   // Broadphase.
-   // For now test all pairs of CollisionShape.
-
-   // 1. Update collision pairs.
-   for( uint a = 0; a < _rigidBodies.size(); ++a )
+   // 1. Update collision pairs (broadphase).
+   _pairs.clear();
+   _broadphase->findPairs( _rigidBodies, _staticBodies, _kinematicBodies, _pairs );
+   for( uint i = 0; i < _pairs.size(); ++i )
    {
-      const RCP<RigidBody>& bodyA = _rigidBodies[a];
-      if( bodyA->shape() == NULL )  continue;
-      for( uint b = 0; b < _staticBodies.size(); ++b )
-      {
-         const RCP<RigidBody>& bodyB = _staticBodies[b];
-         if( bodyB->shape() == NULL )  continue;
-         // Narrow phase.
-         if( bodyA->boundingBox().isOverlapping( bodyB->boundingBox() ) )
-         {
-            CollisionPair pair( bodyA, bodyB );
-            _collisions.add( pair ).frame( frame );
-         }
-      }
-
-      for( uint b = 0; b < _kinematicBodies.size(); ++b )
-      {
-         const RCP<RigidBody>& bodyB = _kinematicBodies[b];
-         if( bodyB->shape() == NULL )  continue;
-         // Narrow phase.
-         if( bodyA->boundingBox().isOverlapping( bodyB->boundingBox() ) )
-         {
-            CollisionPair pair( bodyA, bodyB );
-            _collisions.add( pair ).frame( frame );
-         }
-      }
-
-      for( uint b = a+1; b < _rigidBodies.size(); ++b )
-      {
-         const RCP<RigidBody>& bodyB = _rigidBodies[b];
-         if( bodyB->shape() == NULL )  continue;
-         // Narrow phase.
-         if( bodyA->boundingBox().isOverlapping( bodyB->boundingBox() ) )
-         {
-            CollisionPair pair( bodyA, bodyB );
-            _collisions.add( pair ).frame( frame );
-         }
-      }
+      CollisionPair pair( _pairs[i].first, _pairs[i].second );
+      _collisions.add( pair ).frame( frame );
    }
 
    // 2. Handle collision pairs and create collision constraints.
@@ -375,16 +443,20 @@ MotionWorld::collisionDetection()
       }
       else
       {
-         CollisionShape::collide( (*it) );
+         // Sleeping bodies keep their contacts as they are.
+         if( simulated( *(*it).bodyA() ) || simulated( *(*it).bodyB() ) )
+         {
+            CollisionShape::collide( (*it) );
 
-         // Update contact positions in world space.
-         (*it).info()->updatePositions(
-            (*it).bodyA()->simTransform(),
-            (*it).bodyB()->simTransform()
-         );
+            // Update contact positions in world space.
+            (*it).info()->updatePositions(
+               (*it).bodyA()->simTransform(),
+               (*it).bodyB()->simTransform()
+            );
 
-         // Remove invalid contacts.
-         (*it).info()->removeInvalids();
+            // Remove invalid contacts.
+            (*it).info()->removeInvalids();
+         }
 
          // Check if objects can collide with one another.
          if( RigidBody::canCollide( *(*it).bodyA(), *(*it).bodyB() ) )
@@ -412,4 +484,204 @@ MotionWorld::collisionDetection()
    ++frame;
 }
 
+//------------------------------------------------------------------------------
+//! Groups the dynamic bodies connected by contacts or constraints into
+//! islands (union-find), and decides which islands are awake.
+void
+MotionWorld::buildIslands()
+{
+   const uint nb = uint(_rigidBodies.size());
+   _islandParents.resize( nb );
+   uint* parents = _islandParents.data();
+   for( uint i = 0; i < nb; ++i )
+   {
+      _rigidBodies[i]->_simIndex = i;
+      parents[i] = i;
+   }
+
+   // 1. Merge the bodies in contact, or constrained together.
+   bool mergeAll = false;
+   for( uint i = 0; i < _collisionConstraints.size(); ++i )
+   {
+      const CollisionConstraint& cc = _collisionConstraints[i];
+      if( cc._bodyA->type() == RigidBody::DYNAMIC && cc._bodyB->type() == RigidBody::DYNAMIC )
+      {
+         unite( parents, cc._bodyA->_simIndex, cc._bodyB->_simIndex );
+      }
+   }
+   for( uint i = 0; i < _constraints.size(); ++i )
+   {
+      RigidBody* a = _constraints[i]->bodyA();
+      RigidBody* b = _constraints[i]->bodyB();
+      if( a == NULL && b == NULL )
+      {
+         mergeAll = true;
+      }
+      else
+      if( a && b && a->type() == RigidBody::DYNAMIC && b->type() == RigidBody::DYNAMIC )
+      {
+         unite( parents, a->_simIndex, b->_simIndex );
+      }
+   }
+   if( mergeAll )
+   {
+      for( uint i = 1; i < nb; ++i )
+      {
+         unite( parents, 0, i );
+      }
+   }
+
+   // 2. Number the islands in the order of their first body.
+   // Roots have the smallest index of their set, so they are numbered first.
+   for( uint i = 0; i < nb; ++i )
+   {
+      parents[i] = findRoot( parents, i );
+   }
+   _numIslands = 0;
+   for( uint i = 0; i < nb; ++i )
+   {
+      parents[i] = (parents[i] == i) ? _numIslands++ : parents[parents[i]];
+   }
+   if( _islands.size() < _numIslands )  _islands.resize( _numIslands );
+   for( uint i = 0; i < _numIslands; ++i )
+   {
+      Island& island = _islands[i];
+      island._bodies.clear();
+      island._collisionConstraints.clear();
+      island._constraints.clear();
+      island._contacts.clear();
+      island._awake    = false;
+      island._canSleep = true;
+   }
+
+   // 3. Distribute the bodies, contacts and constraints.
+   for( uint i = 0; i < nb; ++i )
+   {
+      RigidBody* body = _rigidBodies[i].ptr();
+      Island& island  = _islands[parents[i]];
+      island._bodies.pushBack( body );
+      island._awake |= body->active();
+   }
+   for( uint i = 0; i < _collisionConstraints.size(); ++i )
+   {
+      CollisionConstraint& cc = _collisionConstraints[i];
+      RigidBody* body = ( cc._bodyA->type() == RigidBody::DYNAMIC ) ? cc._bodyA : cc._bodyB;
+      Island& island  = _islands[parents[body->_simIndex]];
+      island._collisionConstraints.pushBack( &cc );
+      if( cc._bodyA->type() == RigidBody::KINEMATIC || cc._bodyB->type() == RigidBody::KINEMATIC )
+      {
+         // Kinematic bodies are moved externally, and could push the island at any time.
+         island._awake    = true;
+         island._canSleep = false;
+      }
+   }
+   for( uint i = 0; i < _constraints.size(); ++i )
+   {
+      Constraint* c = _constraints[i].ptr();
+      RigidBody*  a = c->bodyA();
+      RigidBody*  b = c->bodyB();
+      RigidBody*  body = NULL;
+      if( a && a->type() == RigidBody::DYNAMIC )       body = a;
+      else if( b && b->type() == RigidBody::DYNAMIC )  body = b;
+      else if( mergeAll && nb > 0 )                    body = _rigidBodies[0].ptr();
+      // Constraints without any dynamic body have nothing to solve.
+      if( body == NULL )  continue;
+
+      Island& island = _islands[parents[body->_simIndex]];
+      island._constraints.pushBack( c );
+      if( !c->canSleep() )
+      {
+         island._awake    = true;
+         island._canSleep = false;
+      }
+   }
+
+   // 4. Wake up all of the bodies of the islands touched by an active body.
+   for( uint i = 0; i < _numIslands; ++i )
+   {
+      Island& island = _islands[i];
+      if( !island._awake )  continue;
+      for( uint b = 0; b < island._bodies.size(); ++b )
+      {
+         island._bodies[b]->activate();
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Simulates a single island, and puts it to sleep once all of its bodies
+//! have rested for long enough.
+//! Only touches the bodies and contacts of the island (static and kinematic
+//! bodies are only read), so distinct islands can be solved concurrently.
+void
+MotionWorld::solveIsland( Island& island, double step )
+{
+   // Update velocities by integrating forces (sleeping bodies only clear them).
+   for( uint i = 0; i < island._bodies.size(); ++i )
+   {
+      island._bodies[i]->applyForces( step );
+   }
+
+   if( !island._awake )  return;
+
+   // Collisions solving.
+   _solver->solveCollisions( island );
+
+   // Contacts + Joints.
+   _solver->solveConstraints( island, step );
+
+   // Update bodies positions.
+   for( uint i = 0; i < island._bodies.size(); ++i )
+   {
+      island._bodies[i]->applyVelocities( step );
+   }
+
+   // Fix velocities.
+   _solver->solveVelocities( island );
+
+   // Sleeping.
+   if( _sleepDelay <= 0.0 || !island._canSleep )  return;
+
+   float minRestTime = CGConstf::infinity();
+   for( uint i = 0; i < island._bodies.size(); ++i )
+   {
+      RigidBody* body = island._bodies[i];
+      if( body->_linearVelocity.sqrLength()  < _sleepLinearVelocity2 &&
+          body->_angularVelocity.sqrLength() < _sleepAngularVelocity2 )
+      {
+         body->_restTime += float(step);
+      }
+      else
+      {
+         body->_restTime = 0.0f;
+      }
+      minRestTime = CGM::min( minRestTime, body->_restTime );
+   }
+   if( minRestTime >= _sleepDelay )
+   {
+      for( uint i = 0; i < island._bodies.size(); ++i )
+      {
+         RigidBody* body = island._bodies[i];
+         body->deactivate();
+         body->_restTime        = 0.0f;
+         body->_linearVelocity  = Vec3f::zero();
+         body->_angularVelocity = Vec3f::zero();
+      }
+      island._awake = false;
+   }
+}
+
+//------------------------------------------------------------------------------
+//!
+uint
+MotionWorld::numSleepingIslands() const
+{
+   uint n = 0;
+   for( uint i = 0; i < _numIslands; ++i )
+   {
+      if( !_islands[i]._awake )  ++n;
+   }
+   return n;
+}
+
 NAMESPACE_END
@@ -8,6 +8,7 @@
 #include <Motion/StdDefs.h>
 
 #include <Motion/Attractor/Attractor.h>
+#include <Motion/Collision/Broadphase.h>
 #include <Motion/Collision/CollisionInfo.h>
 #include <Motion/Constraint/Joints.h>
 #include <Motion/World/RigidBody.h>
@@ -25,6 +26,7 @@ class ImpulseSolver;
 class NextSolver;
 
 class CharacterConstraint;
+class TaskQueue;
 
 /*==============================================================================
    CLASS MotionWorld
@@ -48,6 +50,20 @@ public:
       CollisionInfo::Contact* _contact;
    };
 
+   //! A group of dynamic bodies interacting with one another through contacts
+   //! or constraints, which can therefore be solved independently of the
+   //! other islands.
+   //! Static and kinematic bodies never join islands together.
+   struct Island
+   {
+      Vector< RigidBody* >            _bodies;
+      Vector< CollisionConstraint* >  _collisionConstraints;
+      Vector< Constraint* >           _constraints;
+      Vector< CollisionConstraint* >  _contacts;  //!< Kept by the solver between its passes.
+      bool                            _awake;     //!< Whether or not the island gets simulated.
+      bool                            _canSleep;  //!< Cleared by kinematic contacts and some constraints.
+   };
+
    /*----- types and enumerations ----*/
 
    typedef Set< CollisionPair >              CollisionContainer;
@@ -88,6 +104,11 @@ public:
    inline const Vector< RCP<RigidBody> >& rigidBodies() const     { return _rigidBodies; }
    inline const Vector< RCP<RigidBody> >& kinematicBodies() const { return _kinematicBodies; }
 
+   // Broadphase.
+   inline Broadphase* broadphase() const { return _broadphase.ptr(); }
+   MOTION_DLL_API void broadphase( Broadphase* );
+   inline void invalidateBroadphase( uint type ) { _broadphase->invalidate( type ); }
+
    // Attractors.
    MOTION_DLL_API void addAttractor( Attractor* );
    MOTION_DLL_API void removeAttractor( Attractor* );
@@ -114,6 +135,19 @@ public:
    
    inline CollisionConstraintContainer& collisionConstraints();
    inline const CollisionConstraintContainer& collisionConstraints() const;
+
+   // Islands (valid after a simulation step).
+   inline uint numIslands() const               { return _numIslands; }
+   inline const Island& island( uint i ) const  { return _islands[i]; }
+   MOTION_DLL_API uint numSleepingIslands() const;
+
+   // Sleeping.
+   inline double sleepDelay() const     { return _sleepDelay; }
+   inline void   sleepDelay( double d ) { _sleepDelay = d; }
+
+   // Islands are solved concurrently on the queue, when specified.
+   inline TaskQueue* taskQueue() const         { return _taskQueue; }
+   inline void       taskQueue( TaskQueue* q ) { _taskQueue = q; }
    
    // Collision callback.
    inline void collisionCallback( const CollisionCallback& c ) { _collisionCallback = c; }
@@ -127,10 +161,16 @@ protected:
 
 private: 
 
+   /*----- classes -----*/
+
+   class IslandLoop;
+
    /*----- methods -----*/
 
    void singleStepSimulation( double step );
    void collisionDetection();
+   void buildIslands();
+   void solveIsland( Island& island, double step );
 
    /*----- data members -----*/
 
@@ -150,10 +190,19 @@ private:
    Vector< RCP<Attractor> >     _attractors;
    ConstraintContainer          _constraints;
 
+   RCP<Broadphase>              _broadphase;
+   Broadphase::PairContainer    _pairs;
+
    CollisionContainer           _collisions;
    CollisionConstraintContainer _collisionConstraints;
 
    CollisionCallback            _collisionCallback;
+
+   Vector< Island >             _islands;      //!< Only the first _numIslands are valid (the others keep their memory).
+   uint                         _numIslands;
+   Vector< uint >               _islandParents; //!< Union-find forest over the dynamic bodies.
+   double                       _sleepDelay;   //!< How long islands must rest before sleeping (disabled if <= 0).
+   TaskQueue*                   _taskQueue;
 };
 
 //------------------------------------------------------------------------------
@@ -4,6 +4,19 @@
 =============================================================================*/
 #include <Motion/World/RigidBody.h>
 
+#include <Motion/World/MotionWorld.h>
+
+#include <Base/MT/Atomic.h>
+
+/*==============================================================================
+  UNNAMED NAMESPACE
+==============================================================================*/
+UNNAMESPACE_BEGIN
+
+AtomicInt32  _nextID( 0 );
+
+UNNAMESPACE_END
+
 
 NAMESPACE_BEGIN
 
@@ -15,6 +28,7 @@ NAMESPACE_BEGIN
 //!
 RigidBody::RigidBody( Type type, void* userData ) :
    _type( type ),
+   _id( uint(++_nextID) ),
    _userData( userData ),
    _world( NULL ),
    _friction( 0.5f ),
@@ -31,6 +45,8 @@ RigidBody::RigidBody( Type type, void* userData ) :
    _prevPos( 0.0f ),
    _simRef( Reff::identity() ),
    _flags(RIGID_BODY_FLAGS_ACTIVE),
+   _restTime( 0.0f ),
+   _simIndex( 0 ),
    _collisionCats( 0x01 ),
    _collisionMask( ~0x0 ),
    _callbackMask( ~0x0 ),
@@ -56,6 +72,7 @@ RigidBody::referential( const Reff& ref )
    _interpolatedRef = ref;
    _simRef = ref;
    updateRefDerivedData();
+   activate();
 }
 
 //------------------------------------------------------------------------------
@@ -67,6 +84,7 @@ RigidBody::position( const Vec3f& pos )
    _interpolatedRef.position( pos );
    _simRef.position( pos );
    updateRefDerivedData();
+   activate();
 }
 
 //------------------------------------------------------------------------------
@@ -77,6 +95,7 @@ RigidBody::orientation( const Quatf& orient )
    _interpolatedRef.orientation( orient );
    _simRef.orientation( orient );
    updateRefDerivedData();
+   activate();
 }
 
 //------------------------------------------------------------------------------
@@ -85,6 +104,7 @@ void
 RigidBody::linearVelocity( const Vec3f& velocity )
 {
    _linearVelocity = velocity;
+   activate();
 }
 
 //------------------------------------------------------------------------------
@@ -93,6 +113,7 @@ void
 RigidBody::angularVelocity( const Vec3f& velocity )
 {
    _angularVelocity = velocity;
+   activate();
 }
 
 //------------------------------------------------------------------------------
@@ -100,7 +121,13 @@ RigidBody::angularVelocity( const Vec3f& velocity )
 void
 RigidBody::applyForces( double step )
 {
-   if( !active() ) return;
+   if( !active() )
+   {
+      // Sleeping bodies ignore the forces (typically gravity) keeping them at rest.
+      _totalForce  = Vec3f::zero();
+      _totalTorque = Vec3f::zero();
+      return;
+   }
    _linearVelocity  += _totalForce * _invMass * (float)step;
    _angularVelocity +=  _invWorldInertiaTensor * (_totalTorque * (float)step);
 
@@ -142,6 +169,18 @@ RigidBody::updateRefDerivedData()
    // Update inertia tensor.
    Mat3f worldTransform( _simRef.orientation().toMatrix3() );
    _invWorldInertiaTensor = worldTransform * _invInertiaTensor * worldTransform.getTransposed();
+
+   // Static bodies are only indexed once by the broadphase.
+   if( _type == STATIC && _world )  _world->invalidateBroadphase( _type );
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+RigidBody::shape( CollisionShape* shape )
+{
+   _shape = shape;
+   if( _world )  _world->invalidateBroadphase( _type );
 }
 
 //------------------------------------------------------------------------------
@@ -68,6 +68,10 @@ public:
    MOTION_DLL_API virtual ~RigidBody();
 
    inline uint type() const;
+
+   //! A unique identifier, increasing with the creation order.
+   //! Used to order the collision pairs the same way from one run to the next.
+   inline uint id() const { return _id; }
    
    inline MotionWorld* world() const    { return _world; }
 
@@ -103,10 +107,12 @@ public:
    inline Vec3f lookAhead( const Vec3f& pos, double step ) const;
    inline Quatf lookAhead( const Quatf& ori, double step ) const;
 
-   // Activation.
+   // Activation (inactive bodies are sleeping, and skip the simulation).
+   // Adding a non-zero force, torque or impulse wakes the body up.
    inline bool   active() const;
    inline void   activate();
    inline void   deactivate();
+   inline float  restTime() const { return _restTime; }
 
    // Category.
    inline uint  collisionCategories() const                     { return _collisionCats; }
@@ -148,7 +154,7 @@ public:
    inline void applyImpulsePrev( const Vec3f& impulse, const Vec3f& pos );
 
    // Collision.
-   inline void shape( CollisionShape* shape ) { _shape = shape; }
+   MOTION_DLL_API void shape( CollisionShape* shape );
    inline CollisionShape* shape() const { return _shape.ptr(); }
    inline const AABBoxf& boundingBox() const;
 
@@ -191,6 +197,7 @@ private:
    /*----- data members -----*/
 
    uint           _type;
+   uint           _id;
    void*          _userData;
    MotionWorld*   _world;
    float          _friction;
@@ -216,6 +223,8 @@ private:
    RCP<CollisionShape>  _shape;
 
    uint           _flags;
+   float          _restTime;       //!< How long the body has been resting while active.
+   uint           _simIndex;       //!< The index of the body in the world (refreshed when building islands).
    uint           _collisionCats;  //!< A bitset indicating all of the collision categories this rigid body is a member of.  By default, the object is a member of category 0x01.
    uint           _collisionMask;  //!< A bitmask indicating the categories that can collide with the body.
    uint           _callbackMask;   //!< A bitmask indicating the categories which trigger a callback when collisions occur.
@@ -400,7 +409,11 @@ RigidBody::active() const
 inline void
 RigidBody::activate()
 {
-   _flags |= RIGID_BODY_FLAGS_ACTIVE;
+   if( !active() )
+   {
+      _flags   |= RIGID_BODY_FLAGS_ACTIVE;
+      _restTime = 0.0f;
+   }
 }
 
 //------------------------------------------------------------------------------
@@ -426,6 +439,7 @@ inline void
 RigidBody::addForce( const Vec3f& force )
 {
    _totalForce += force;
+   if( force != Vec3f::zero() )  activate();
 }
 
 //------------------------------------------------------------------------------
@@ -434,6 +448,7 @@ inline void
 RigidBody::addTorque( const Vec3f& torque )
 {
    _totalTorque += torque;
+   if( torque != Vec3f::zero() )  activate();
 }
 
 //------------------------------------------------------------------------------
@@ -470,6 +485,7 @@ inline void
 RigidBody::applyImpulse( const Vec3f& impulse )
 {
    _linearVelocity += impulse * _invMass;
+   if( impulse != Vec3f::zero() )  activate();
 }
 
 //------------------------------------------------------------------------------
@@ -478,6 +494,7 @@ inline void
 RigidBody::applyTorqueImpulse( const Vec3f& impulse )
 {
    _angularVelocity += _invWorldInertiaTensor * impulse;
+   if( impulse != Vec3f::zero() )  activate();
 }
 
 //------------------------------------------------------------------------------
@@ -489,6 +506,7 @@ RigidBody::applyImpulsePrev( const Vec3f& impulse, const Vec3f& pos )
    {
       _linearVelocity  += impulse * _invMass;
       _angularVelocity += _prevInvWorldInertiaTensor * (pos - _prevPos).cross( impulse );
+      if( impulse != Vec3f::zero() )  activate();
    }
 }
 
@@ -4,13 +4,22 @@
 =============================================================================*/
 #include <Base/Dbg/UnitTest.h>
 
+#include <CGMath/Random.h>
 #include <CGMath/Vec3.h>
 
 #include <Motion/Collision/BasicShapes.h>
+#include <Motion/Collision/Broadphase.h>
 #include <Motion/Collision/CollisionInfo.h>
+#include <Motion/Attractor/BasicAttractors.h>
 #include <Motion/Attractor/GravitationalAttractor.h>
+#include <Motion/Solver/SequentialImpulseSolver.h>
 #include <Motion/World/MotionWorld.h>
 
+#include <Base/MT/TaskQueue.h>
+#include <Base/Util/Timer.h>
+
+#include <algorithm>
+
 USING_NAMESPACE
 
 const float sFloatThreshold = 1e-5f;
@@ -52,21 +61,15 @@ void test_collision_sphere_sphere( Test::Result& res )
    RCP<CollisionShape> a( new SphereShape(2) );
    RCP<CollisionShape> b( new SphereShape(5) );
 
-   CollisionGroup grpA, grpB;
-   grpA.addShape( a );
-   grpB.addShape( b );
 
    //Start by keeping A at the origin for now
-   a->globalReferential( refA );
    refB.position( Vec3f(7.0001f, 0, 0) );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
    TEST_ADD( res, colInfo.numContacts() == 0 );
 
    refB.position( Vec3f(7, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -80,8 +83,7 @@ void test_collision_sphere_sphere( Test::Result& res )
    TEST_ADD( res, colInfo.numContacts() == 0 );
 
    refB.position( Vec3f(6, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -93,8 +95,7 @@ void test_collision_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(5, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -106,8 +107,7 @@ void test_collision_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(4, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -119,8 +119,7 @@ void test_collision_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(3, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -132,8 +131,7 @@ void test_collision_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(2, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -145,8 +143,7 @@ void test_collision_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(1, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -159,8 +156,7 @@ void test_collision_sphere_sphere( Test::Result& res )
 
    //Special case (sharing centers)
    refB.position( Vec3f(0, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -173,8 +169,7 @@ void test_collision_sphere_sphere( Test::Result& res )
 
    //Start going out over the left side
    refB.position( Vec3f(-1, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -186,8 +181,7 @@ void test_collision_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(-2, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -199,8 +193,7 @@ void test_collision_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(-3, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -212,8 +205,7 @@ void test_collision_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(-4, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -225,8 +217,7 @@ void test_collision_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(-5, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -238,8 +229,7 @@ void test_collision_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(-6, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -251,8 +241,7 @@ void test_collision_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(-7, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -264,8 +253,7 @@ void test_collision_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(-7.0001f, 0, 0) );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
    TEST_ADD( res, colInfo.numContacts() == 0 );
 
@@ -295,21 +283,15 @@ void test_collision_sphere_box( Test::Result& res )
    RCP<CollisionShape> a( new SphereShape(2) );
    RCP<CollisionShape> b( new BoxShape( 10, 5, 5 ) );
 
-   CollisionGroup grpA, grpB;
-   grpA.addShape( a );
-   grpB.addShape( b );
 
    //Start by keeping A at the origin for now
-   a->globalReferential( refA );
    refB.position( Vec3f(7.0001f, 0, 0) );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
    TEST_ADD( res, colInfo.numContacts() == 0 );
 
    refB.position( Vec3f(7, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -324,8 +306,7 @@ void test_collision_sphere_box( Test::Result& res )
 
 
    refB.position( Vec3f(6, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -337,8 +318,7 @@ void test_collision_sphere_box( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(5, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collide(a, b, colInfo);
+   col = CollisionShape::collide( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -361,35 +341,28 @@ void test_collision_shape_support( Test::Result& res )
 
    //Compare on the +X axis with a sphere of radius=3
    shape = new SphereShape(3);
-   CollisionGroup group;
-   group.addShape( shape );
-   shape->globalReferential(ref);
-   pos = shape->getFarthestPointAlong(dir);
+   pos = shape->getFarthestPointAlong(ref, dir);
    TEST_ADD( res, areEqual(pos, Vec3f(3, 0, 0)) );
    //Move sphere 1 unit in the X direction
    ref.position(1, 0, 0);
-   shape->globalReferential(ref);
-   pos = shape->getFarthestPointAlong(dir);
+   pos = shape->getFarthestPointAlong(ref, dir);
    TEST_ADD( res, areEqual(pos, Vec3f(4, 0, 0)) );
    //Flip the direction (should find opposite end of the sphere)
    dir = -dir;
-   pos = shape->getFarthestPointAlong(dir);
+   pos = shape->getFarthestPointAlong(ref, dir);
    TEST_ADD( res, areEqual(pos, Vec3f(-2, 0, 0)) );
    //Make sure that the Y and Z component don't affect the X calculation
    ref.position(0, 4, 5);
-   shape->globalReferential(ref);
-   pos = shape->getFarthestPointAlong(dir);
+   pos = shape->getFarthestPointAlong(ref, dir);
    TEST_ADD( res, areEqual(pos, Vec3f(-3, 4, 5)) );
    //Make sure that a rotation doesn't affect the calculation
    ref.orientation( Quatf(0, 1, 3, 0.127f) );
-   shape->globalReferential(ref);
-   pos = shape->getFarthestPointAlong(dir);
+   pos = shape->getFarthestPointAlong(ref, dir);
    TEST_ADD( res, areEqual(pos, Vec3f(-3, 4, 5)) );
    //Calculate the diameter of the sphere
    ref.position(11, 23, -42);  //arbitrary position
-   shape->globalReferential(ref);
    dir = Vec3f(-83, 17, 127); //arbitrary direction
-   pos = shape->getFarthestPointAlong(dir) - shape->getFarthestPointAlong(-dir);
+   pos = shape->getFarthestPointAlong(ref, dir) - shape->getFarthestPointAlong(ref, -dir);
    TEST_ADD( res, areEqual(pos.length(), 2*3, 1e-5f) );
 
    //Reset everything
@@ -397,16 +370,13 @@ void test_collision_shape_support( Test::Result& res )
 
    //Compare on the +X axis with a cube of size (3, 4, 5)
    shape = new BoxShape(3, 4, 5);
-   group.clearShapes();
-   group.addShape( shape );
    ref.position(3, -10, -5);
-   shape->globalReferential(ref);
    dir = Vec3f(1, 1, 1);
-   pos = shape->getFarthestPointAlong(dir);
+   pos = shape->getFarthestPointAlong(ref, dir);
    printf("Pos %g %g %g\n", pos.x, pos.y, pos.z);
    TEST_ADD( res, areEqual(pos, Vec3f(4.5, -8, -2.5), Vec3f(0.2f)) );
    dir = -dir;
-   pos = shape->getFarthestPointAlong(dir);
+   pos = shape->getFarthestPointAlong(ref, dir);
    printf("Pos %g %g %g\n", pos.x, pos.y, pos.z);
    TEST_ADD( res, areEqual(pos, Vec3f(1.5, -12, -7.5), Vec3f(0.2f)) );
 
@@ -434,23 +404,17 @@ void test_collision_GJK_sphere_sphere( Test::Result& res )
    RCP<CollisionShape> a( new SphereShape(2) );
    RCP<CollisionShape> b( new SphereShape(5) );
 
-   CollisionGroup grpA, grpB;
-   grpA.addShape( a );
-   grpB.addShape( b );
 
    //Start by keeping A at the origin for now
-   a->globalReferential( refA );
    refB.position( Vec3f(7.01f, 0, 0) );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
    TEST_ADD( res, colInfo.numContacts() == 0 );
 
    //colInfo.clearContacts();
 
    refB.position( Vec3f(7, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -462,8 +426,7 @@ void test_collision_GJK_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(6, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -475,8 +438,7 @@ void test_collision_GJK_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(5, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -488,8 +450,7 @@ void test_collision_GJK_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(4, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -501,8 +462,7 @@ void test_collision_GJK_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(3, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -514,8 +474,7 @@ void test_collision_GJK_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(2, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -527,8 +486,7 @@ void test_collision_GJK_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(1, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -541,8 +499,7 @@ void test_collision_GJK_sphere_sphere( Test::Result& res )
 
    //Special case (sharing centers)
    refB.position( Vec3f(0, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -555,8 +512,7 @@ void test_collision_GJK_sphere_sphere( Test::Result& res )
 
    //Start going out over the left side
    refB.position( Vec3f(-1, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -568,8 +524,7 @@ void test_collision_GJK_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(-2, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -581,8 +536,7 @@ void test_collision_GJK_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(-3, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -594,8 +548,7 @@ void test_collision_GJK_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(-4, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -607,8 +560,7 @@ void test_collision_GJK_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(-5, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -620,8 +572,7 @@ void test_collision_GJK_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(-6, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -633,8 +584,7 @@ void test_collision_GJK_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(-7, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -646,8 +596,7 @@ void test_collision_GJK_sphere_sphere( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(-7.01f, 0, 0) );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
    TEST_ADD( res, colInfo.numContacts() == 0 );
 
@@ -677,23 +626,16 @@ void test_collision_GJK_sphere_box( Test::Result& res )
    RCP<CollisionShape> a( new SphereShape(2) );
    RCP<CollisionShape> b( new BoxShape( 10, 4, 4 ) );
 
-   CollisionGroup grpA, grpB;
-   grpA.addShape( a );
-   grpB.addShape( b );
 
-   a->globalReferential( refA );
-   b->globalReferential( refB );
 
    //Start by keeping A at the origin for now
    refB.position( Vec3f(7.01f, 0, 0) );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
    TEST_ADD( res, colInfo.numContacts() == 0 );
 
    refB.position( Vec3f(7, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -707,8 +649,7 @@ void test_collision_GJK_sphere_box( Test::Result& res )
    TEST_ADD( res, colInfo.numContacts() == 0 );
 
    refB.position( Vec3f(6, 0.5, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -720,8 +661,7 @@ void test_collision_GJK_sphere_box( Test::Result& res )
    colInfo.clearContacts();
 
    refB.position( Vec3f(5, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -735,9 +675,7 @@ void test_collision_GJK_sphere_box( Test::Result& res )
    // Verify when origins overlap
    refA.position( Vec3f(12, 13, -17) );
    refB = refA;
-   a->globalReferential( refA );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    // Contact point and direction could be multiple values,
    // but the shortest depth is 2+2=4
@@ -749,9 +687,7 @@ void test_collision_GJK_sphere_box( Test::Result& res )
    // ... even with an arbitrary orientation
    refA.orientation( Quatf::axisAngle( Vec3f(0, 1, 3).normalize(), 0.127f ) );
    refB.orientation( Quatf::axisAngle( Vec3f(12, 13, -17).normalize(), -0.831f ) );
-   a->globalReferential( refA );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    contact = &(colInfo.contact(0));
    //FIXME: TEST_ADD( res, areEqual(contact->depth(), 4) );
@@ -761,9 +697,7 @@ void test_collision_GJK_sphere_box( Test::Result& res )
    // Bring back both objects to the origin
    refA = Reff::identity();
    refB = Reff::identity();
-   a->globalReferential( refA );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    contact = &(colInfo.contact(0));
    TEST_ADD( res, areEqual(contact->depth(), 4) );
@@ -785,8 +719,7 @@ void test_collision_GJK_sphere_box( Test::Result& res )
     */
    distance = (boxCornerDistance+sphDistance) * 1.1f;
    refA.position( boxCorner.getRescaled(distance) );
-   a->globalReferential( refA );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
 
    colInfo.clearContacts();
@@ -799,8 +732,7 @@ void test_collision_GJK_sphere_box( Test::Result& res )
     */
    distance = (boxCornerDistance+sphDistance) * 0.99f;
    refA.position( boxCorner.getRescaled(distance) );
-   a->globalReferential( refA );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    /**
    contact = &(colInfo.contact(0));
@@ -827,8 +759,7 @@ void test_collision_GJK_sphere_box( Test::Result& res )
     */
    distance = (boxCornerDistance+sphDistance) * 0.99f;
    refA.position( boxCorner.getRescaled(distance) );
-   a->globalReferential( refA );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -840,8 +771,7 @@ void test_collision_GJK_sphere_box( Test::Result& res )
     *      |
     */
    refA.position( boxCorner + Vec3f(sphDistance+0.01f, 0, 0) );
-   a->globalReferential( refA );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
 
    colInfo.clearContacts();
@@ -852,8 +782,7 @@ void test_collision_GJK_sphere_box( Test::Result& res )
     *      |
     */
    refA.position( boxCorner + Vec3f(sphDistance+0.00f, 0, 0) );
-   a->globalReferential( refA );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -864,8 +793,7 @@ void test_collision_GJK_sphere_box( Test::Result& res )
     *      |
     */
     refA.position( boxCorner + Vec3f(sphDistance-0.01f, 0, 0) );
-    a->globalReferential( refA );
-    col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+    col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
     TEST_ADD( res, col );
 
     colInfo.clearContacts();
@@ -878,8 +806,7 @@ void test_collision_GJK_sphere_box( Test::Result& res )
     *      |
     */
    refA.position( boxCorner + Vec3f(0, sphDistance+0.01f, 0) );
-   a->globalReferential( refA );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
 
    colInfo.clearContacts();
@@ -891,8 +818,7 @@ void test_collision_GJK_sphere_box( Test::Result& res )
     *      |
     */
    refA.position( boxCorner + Vec3f(0, sphDistance+0.00f, 0) );
-   a->globalReferential( refA );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -903,32 +829,28 @@ void test_collision_GJK_sphere_box( Test::Result& res )
     *      |
     */
    refA.position( boxCorner + Vec3f(0, sphDistance-0.01f, 0) );
-   a->globalReferential( refA );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
 
    // Above Z
    refA.position( boxCorner + Vec3f(0, 0, sphDistance+0.01f) );
-   a->globalReferential( refA );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
 
    colInfo.clearContacts();
 
    // On Z
    refA.position( boxCorner + Vec3f(0, 0, sphDistance+0.00f) );
-   a->globalReferential( refA );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
 
    // Below Z
    refA.position( boxCorner + Vec3f(0, 0, sphDistance-0.01f) );
-   a->globalReferential( refA );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 }
 
@@ -947,12 +869,7 @@ void test_collision_GJK_box_box( Test::Result& res )
    RCP<CollisionShape> a( new BoxShape( 10,  4, 14 ) );
    RCP<CollisionShape> b( new BoxShape(  2,  2,  2 ) );
 
-   CollisionGroup grpA, grpB;
-   grpA.addShape( a );
-   grpB.addShape( b );
 
-   a->globalReferential( refA );
-   b->globalReferential( refB );
 
    // Some temporaries for the cases below
    Vec3f cornerA(5, 2, 7);
@@ -963,62 +880,53 @@ void test_collision_GJK_box_box( Test::Result& res )
 
    //Start by keeping A at the origin for now
    refB.position( Vec3f(6+0.01f, 0, 0) );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
 
    refB.position( Vec3f(6, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
 
    refB.position( Vec3f(5.9999f, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
 
    refB.position( Vec3f(5, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
 
    refB.position( Vec3f(0, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
 
    refB.position( Vec3f(-5, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
 
    refB.position( Vec3f(-5.9999f, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
 
    refB.position( Vec3f(-6, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
 
    refB.position( Vec3f(-6.01f, 0, 0) );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
 
    colInfo.clearContacts();
@@ -1031,8 +939,7 @@ void test_collision_GJK_box_box( Test::Result& res )
     */
    pos = cornerApB.getRescaled(distance*1.001f);
    refB.position( pos );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
 
    colInfo.clearContacts();
@@ -1044,8 +951,7 @@ void test_collision_GJK_box_box( Test::Result& res )
     */
    pos = cornerApB;
    refB.position( pos );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
 
    colInfo.clearContacts();
@@ -1057,8 +963,7 @@ void test_collision_GJK_box_box( Test::Result& res )
     */
    pos = cornerApB * 0.99f;
    refB.position( pos );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -1070,8 +975,7 @@ void test_collision_GJK_box_box( Test::Result& res )
     */
    pos = cornerA + Vec3f( cornerB(0) + 0.01f, 0, 0 );
    refB.position( pos );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
 
    colInfo.clearContacts();
@@ -1083,8 +987,7 @@ void test_collision_GJK_box_box( Test::Result& res )
     */
    pos = cornerA + Vec3f( cornerB(0), 0, 0 );
    refB.position( pos );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -1096,8 +999,7 @@ void test_collision_GJK_box_box( Test::Result& res )
     */
    pos = cornerA + Vec3f( cornerB(0) - 0.0001f, 0, 0 );
    refB.position( pos );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -1110,8 +1012,7 @@ void test_collision_GJK_box_box( Test::Result& res )
     */
    pos = cornerA + Vec3f( 0, cornerB(1) + 0.01f, 0 );
    refB.position( pos );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
 
    colInfo.clearContacts();
@@ -1124,8 +1025,7 @@ void test_collision_GJK_box_box( Test::Result& res )
     */
    pos = cornerA + Vec3f( 0, cornerB(1), 0 );
    refB.position( pos );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -1137,8 +1037,7 @@ void test_collision_GJK_box_box( Test::Result& res )
     */
    pos = cornerA + Vec3f( 0, cornerB(1) - 0.0001f, 0 );
    refB.position( pos );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -1146,8 +1045,7 @@ void test_collision_GJK_box_box( Test::Result& res )
    // Over Z
    pos = cornerA + Vec3f( 0, 0, cornerB(1) + 0.01f );
    refB.position( pos );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
 
    colInfo.clearContacts();
@@ -1155,8 +1053,7 @@ void test_collision_GJK_box_box( Test::Result& res )
    // On Z
    pos = cornerA + Vec3f( 0, 0, cornerB(1) );
    refB.position( pos );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -1164,8 +1061,7 @@ void test_collision_GJK_box_box( Test::Result& res )
    // Under Z
    pos = cornerA + Vec3f( 0, 0, cornerB(1) - 0.0001f );
    refB.position( pos );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -1173,7 +1069,7 @@ void test_collision_GJK_box_box( Test::Result& res )
    // Verify when origins overlap
    refA.position( Vec3f(12, 13, -17) );
    refB = refA;
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -1181,7 +1077,7 @@ void test_collision_GJK_box_box( Test::Result& res )
    // ... even with an arbitrary orientation
    refA.orientation( Quatf(0, 1, 3, 0.127f) );
    refB.orientation( Quatf(12, 13, -17, -0.831f) );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -1189,9 +1085,7 @@ void test_collision_GJK_box_box( Test::Result& res )
    // Bring back both objects to the origin
    refA = Reff::identity();
    refB = Reff::identity();
-   a->globalReferential( refA );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -1200,8 +1094,7 @@ void test_collision_GJK_box_box( Test::Result& res )
    Quatf q = Quatf::axisAngle( Vec3f(0, 0, 1), CGM::degToRad(45.0f) );
    distance = CGM::sqrt(1.0f + 1.0f);  //distance from center to origin
    refB.orientation( q );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -1209,8 +1102,7 @@ void test_collision_GJK_box_box( Test::Result& res )
    // Move up until while it still touches
    pos = Vec3f(0, cornerA(1) + distance - 0.01f, 0);
    refB.position( pos );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -1218,8 +1110,7 @@ void test_collision_GJK_box_box( Test::Result& res )
    // Move up until it barely touches
    pos = Vec3f(0, cornerA(1) + distance, 0);
    refB.position( pos );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
 
    colInfo.clearContacts();
@@ -1227,8 +1118,7 @@ void test_collision_GJK_box_box( Test::Result& res )
    // Move up until it barely no longer touches
    pos = Vec3f(0, cornerA(1) + distance + 0.01f, 0);
    refB.position( pos );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
 
    colInfo.clearContacts();
@@ -1237,8 +1127,7 @@ void test_collision_GJK_box_box( Test::Result& res )
    // Move it to the end until it barely touches (edge-edge)
    pos = Vec3f(-cornerA(0), cornerA(1) + distance*0.99f, 0);
    refB.position( pos );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -1246,8 +1135,7 @@ void test_collision_GJK_box_box( Test::Result& res )
    // Move it to the end until it no longer touches (edge-edge)
    pos = Vec3f(-cornerA(0) - distance - 0.0001f, cornerA(1) + distance, 0);
    refB.position( pos );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
 
    colInfo.clearContacts();
@@ -1255,8 +1143,7 @@ void test_collision_GJK_box_box( Test::Result& res )
    // Move it to the (face-edge) case
    pos = Vec3f(-cornerA(0) - 0.5f * distance, cornerA(1) + 0.49f*distance, 0);
    refB.position( pos );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
 
    colInfo.clearContacts();
@@ -1264,8 +1151,7 @@ void test_collision_GJK_box_box( Test::Result& res )
    // Move it so that it barely doesn't touch
    pos(0) -= 0.01f;
    refB.position( pos );
-   b->globalReferential( refB );
-   col = true; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, !col );
 }
 
@@ -1369,9 +1255,6 @@ void test_debug( Test::Result& res )
    RCP<CollisionShape> a( new SphereShape(2) );
    RCP<CollisionShape> b( new BoxShape( 10, 4, 4 ) );
 
-   CollisionGroup grpA, grpB;
-   grpA.addShape( a );
-   grpB.addShape( b );
 
    // Prepare the cases below
    Vec3f boxCorner(5, 2, 2);
@@ -1387,8 +1270,7 @@ void test_debug( Test::Result& res )
     */
    distance = (boxCornerDistance+sphDistance) * 0.999f;
    refA.position( boxCorner.getRescaled(distance) );
-   a->globalReferential( refA );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    
    contact = &(colInfo.contact(0));
@@ -1401,8 +1283,7 @@ void test_debug( Test::Result& res )
    
    //Special case (sharing centers)
    refB.position( Vec3f(7.0, 0, 0) );
-   b->globalReferential( refB );
-   col = false; //FIXME CollisionShape::collideGJK(a, b, colInfo);
+   col = CollisionShape::collideGJK( a.ptr(), refA, b.ptr(), refB, colInfo );
    TEST_ADD( res, col );
    TEST_ADD( res, colInfo.numContacts() == 1 );
    contact = &(colInfo.contact(0));
@@ -1414,6 +1295,465 @@ void test_debug( Test::Result& res )
    */
 }
 
+//------------------------------------------------------------------------------
+//! Creates a body of a random type, shape, position and orientation, within
+//! a cube of the specified size.
+RCP<RigidBody>
+randomBody( RNG_WELL& rng, float size )
+{
+   RCP<RigidBody> body;
+   switch( rng.getUInt(5) )
+   {
+      case 0 : body = MotionWorld::createStaticBody();    break;
+      case 1 : body = MotionWorld::createKinematicBody(); break;
+      default: body = MotionWorld::createRigidBody();     break;
+   }
+   switch( rng.getUInt(8) )
+   {
+      case 0 : break; // No shape.
+      case 1 :
+      case 2 :
+      case 3 : body->shape( new SphereShape( float(0.2 + rng.getDouble()) ) ); break;
+      default: body->shape( new BoxShape( float(0.2 + rng.getDouble()), float(0.2 + rng.getDouble()), float(0.2 + 2.0*rng.getDouble()) ) ); break;
+   }
+   Vec3f pos = Vec3f( float(rng.getDouble()), float(rng.getDouble()), float(rng.getDouble()) ) * size;
+   // Snap some of the bodies to a grid, so that some of them share centers or touch.
+   if( rng.getUInt(4) == 0 )  pos = Vec3f( floorf(pos.x), floorf(pos.y), floorf(pos.z) );
+   body->simPosition( pos );
+   Vec3f axis( float(rng.getDouble()) - 0.5f, float(rng.getDouble()) - 0.5f, float(rng.getDouble()) + 0.01f );
+   body->simOrientation( Quatf::axisAngle( axis.getNormalized(), float(rng.getDouble()*CGConstf::pi()) ) );
+   return body;
+}
+
+//------------------------------------------------------------------------------
+//!
+struct PairLess
+{
+   bool operator()( const Broadphase::BodyPair& a, const Broadphase::BodyPair& b ) const
+   {
+      return a.first < b.first || (a.first == b.first && a.second < b.second);
+   }
+};
+
+//------------------------------------------------------------------------------
+//! Sorts the pairs in a canonical order, and returns false if some are duplicated.
+bool
+canonicalPairs( Broadphase::PairContainer& pairs )
+{
+   for( uint i = 0; i < pairs.size(); ++i )
+   {
+      if( pairs[i].second < pairs[i].first )  std::swap( pairs[i].first, pairs[i].second );
+   }
+   std::sort( pairs.begin(), pairs.end(), PairLess() );
+   for( uint i = 1; i < pairs.size(); ++i )
+   {
+      if( !PairLess()( pairs[i-1], pairs[i] ) )  return false;
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//!
+bool
+samePairs( const Broadphase::PairContainer& a, const Broadphase::PairContainer& b )
+{
+   if( a.size() != b.size() )  return false;
+   for( uint i = 0; i < a.size(); ++i )
+   {
+      if( a[i].first != b[i].first || a[i].second != b[i].second )  return false;
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//! Reproduces the pairs found by the collision loops MotionWorld used before
+//! having a broadphase: all of the dynamic bodies against all of the other
+//! bodies, comparing the shapes' local bounding boxes.
+void
+collisionLoopPairs( const MotionWorld& world, Broadphase::PairContainer& pairs )
+{
+   const Broadphase::BodyContainer& rigidBodies = world.rigidBodies();
+   const Broadphase::BodyContainer* others[2]   = { &world.staticBodies(), &world.kinematicBodies() };
+   for( uint a = 0; a < rigidBodies.size(); ++a )
+   {
+      RigidBody* bodyA = rigidBodies[a].ptr();
+      if( bodyA->shape() == NULL )  continue;
+      for( uint o = 0; o < 2; ++o )
+      {
+         for( uint b = 0; b < others[o]->size(); ++b )
+         {
+            RigidBody* bodyB = (*others[o])[b].ptr();
+            if( bodyB->shape() == NULL )  continue;
+            if( bodyA->boundingBox().isOverlapping( bodyB->boundingBox() ) )
+            {
+               pairs.pushBack( Broadphase::BodyPair( bodyA, bodyB ) );
+            }
+         }
+      }
+      for( uint b = a+1; b < rigidBodies.size(); ++b )
+      {
+         RigidBody* bodyB = rigidBodies[b].ptr();
+         if( bodyB->shape() == NULL )  continue;
+         if( bodyA->boundingBox().isOverlapping( bodyB->boundingBox() ) )
+         {
+            pairs.pushBack( Broadphase::BodyPair( bodyA, bodyB ) );
+         }
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Checks that 'pairs' is a subset of the (canonical) pairs of the collision
+//! loops, and that the pairs it leaves out have no contact.
+bool
+keepsCollisionLoopContacts( const Broadphase::PairContainer& loopPairs, const Broadphase::PairContainer& pairs )
+{
+   uint p = 0;
+   for( uint i = 0; i < loopPairs.size(); ++i )
+   {
+      const Broadphase::BodyPair& pair = loopPairs[i];
+      if( p < pairs.size() && pairs[p].first == pair.first && pairs[p].second == pair.second )
+      {
+         ++p;
+         continue;
+      }
+      CollisionInfo info;
+      CollisionShape::collide(
+         pair.first->shape(), pair.first->simReferential(),
+         pair.second->shape(), pair.second->simReferential(),
+         info
+      );
+      if( info.numContacts() != 0 )  return false;
+   }
+   return p == pairs.size();
+}
+
+//------------------------------------------------------------------------------
+//!
+void test_broadphase( Test::Result& res )
+{
+   RNG_WELL rng;
+   rng.seed( 1234 );
+
+   RCP<Broadphase> ref( new BruteForceBroadphase() );
+   RCP<Broadphase> sap( new SweepAndPruneBroadphase() );
+
+   // The world keeps the sweep and prune up to date when bodies are added,
+   // removed, or when static ones move.
+   RCP<MotionWorld> world( new MotionWorld() );
+   world->broadphase( sap.ptr() );
+   for( uint i = 0; i < 300; ++i )
+   {
+      world->addBody( randomBody( rng, 12.0f ).ptr() );
+   }
+
+   Broadphase::PairContainer loopPairs;
+   Broadphase::PairContainer refPairs;
+   Broadphase::PairContainer sapPairs;
+   for( uint step = 0; step < 20; ++step )
+   {
+      loopPairs.clear();
+      refPairs.clear();
+      sapPairs.clear();
+      collisionLoopPairs( *world, loopPairs );
+      ref->findPairs( world->rigidBodies(), world->staticBodies(), world->kinematicBodies(), refPairs );
+      sap->findPairs( world->rigidBodies(), world->staticBodies(), world->kinematicBodies(), sapPairs );
+      TEST_ADD( res, canonicalPairs( loopPairs ) );
+      TEST_ADD( res, canonicalPairs( refPairs ) );
+      TEST_ADD( res, canonicalPairs( sapPairs ) );
+      TEST_ADD( res, !refPairs.empty() );
+      TEST_ADD( res, samePairs( refPairs, sapPairs ) );
+      // The collision loops compared local boxes, so they sent many more pairs
+      // to the narrow phase; none of the ones dropped may have a contact.
+      TEST_ADD( res, loopPairs.size() > sapPairs.size() );
+      TEST_ADD( res, keepsCollisionLoopContacts( loopPairs, sapPairs ) );
+
+      // Move the dynamic and kinematic bodies a little.
+      for( uint i = 0; i < world->rigidBodies().size(); ++i )
+      {
+         RigidBody* b = world->rigidBodies()[i].ptr();
+         b->simPosition( b->simPosition() + Vec3f( float(rng.getDouble()) - 0.5f, float(rng.getDouble()) - 0.5f, float(rng.getDouble()) - 0.5f ) );
+      }
+      for( uint i = 0; i < world->kinematicBodies().size(); ++i )
+      {
+         RigidBody* b = world->kinematicBodies()[i].ptr();
+         b->simPosition( b->simPosition() + Vec3f( 0.0f, 0.0f, 0.5f ) );
+      }
+
+      // Sometimes change the set of bodies, or move a static one.
+      switch( step % 4 )
+      {
+         case 1:
+            world->addBody( randomBody( rng, 12.0f ).ptr() );
+            world->addBody( randomBody( rng, 12.0f ).ptr() );
+            break;
+         case 2:
+            if( !world->rigidBodies().empty() )  world->removeBody( world->rigidBodies().back().ptr() );
+            if( !world->staticBodies().empty() ) world->removeBody( world->staticBodies().front().ptr() );
+            break;
+         case 3:
+            if( !world->staticBodies().empty() )
+            {
+               RigidBody* b = world->staticBodies().back().ptr();
+               b->simPosition( b->simPosition() + Vec3f( 3.0f, 0.0f, 0.0f ) );
+            }
+            break;
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//!
+void test_broadphase_timed( Test::Result& )
+{
+   const uint sizes[] = { 1000, 5000, 20000 };
+   for( uint s = 0; s < 3; ++s )
+   {
+      RNG_WELL rng;
+      rng.seed( 1234 );
+      const uint n = sizes[s];
+      // Keep the density constant.
+      const float size = 12.0f * powf( float(n)/300.0f, 1.0f/3.0f );
+      RCP<MotionWorld> world( new MotionWorld() );
+      for( uint i = 0; i < n; ++i )
+      {
+         world->addBody( randomBody( rng, size ).ptr() );
+      }
+
+      RCP<Broadphase> bps[2] = { new BruteForceBroadphase(), new SweepAndPruneBroadphase() };
+      const char* names[2]   = { "brute force", "sweep and prune" };
+      for( uint b = 0; b < 2; ++b )
+      {
+         Broadphase::PairContainer pairs;
+         // Warm-up (sorts the statics).
+         bps[b]->findPairs( world->rigidBodies(), world->staticBodies(), world->kinematicBodies(), pairs );
+         const uint steps = 10;
+         Timer timer;
+         for( uint i = 0; i < steps; ++i )
+         {
+            pairs.clear();
+            bps[b]->findPairs( world->rigidBodies(), world->staticBodies(), world->kinematicBodies(), pairs );
+         }
+         double t = timer.elapsed() / steps;
+         StdErr << n << " bodies, " << names[b] << ": " << pairs.size() << " pairs, " << t*1000.0 << " ms/step" << nl;
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Creates a world made of separate piles on a static ground: every pile is a
+//! stack of 2 spheres, and a pair of spheres tied by a ball joint (2 islands).
+RCP<MotionWorld>
+islandWorld( uint numPiles )
+{
+   RCP<MotionWorld> world( new MotionWorld() );
+   world->addAttractor( new DirectionalAttractor( Vec3f( 0.0f, -9.8f, 0.0f ) ) );
+
+   RCP<RigidBody> ground = MotionWorld::createStaticBody();
+   ground->shape( new BoxShape( 1000.0f, 1.0f, 1000.0f ) );
+   ground->position( Vec3f( 0.0f, -1.0f, 0.0f ) );
+   world->addBody( ground.ptr() );
+
+   for( uint i = 0; i < numPiles; ++i )
+   {
+      float x = 5.0f * float(i);
+      Vec3f pos[4] = {
+         Vec3f( x       , 0.5f, 0.0f ),
+         Vec3f( x       , 1.5f, 0.0f ),
+         Vec3f( x + 2.0f, 0.5f, 0.0f ),
+         Vec3f( x + 3.0f, 0.5f, 0.0f )
+      };
+      RigidBody* b[4];
+      for( uint j = 0; j < 4; ++j )
+      {
+         RCP<RigidBody> body = MotionWorld::createRigidBody();
+         body->shape( new SphereShape( 0.5f ) );
+         body->position( pos[j] );
+         world->addBody( body.ptr() );
+         b[j] = body.ptr();
+      }
+      world->createBallJoint( b[2], b[3] )->anchor( Vec3f( x + 2.5f, 0.5f, 0.0f ) );
+   }
+   return world;
+}
+
+//------------------------------------------------------------------------------
+//!
+void test_islands( Test::Result& res )
+{
+   const uint numPiles = 4;
+   RCP<MotionWorld> world = islandWorld( numPiles );
+   const Vector< RCP<RigidBody> >& bodies = world->rigidBodies();
+
+   // Piles only touch the static ground, so they form separate islands.
+   world->stepSimulation( world->simulationDelta() );
+   TEST_ADD( res, world->numIslands() == 2*numPiles );
+   TEST_ADD( res, world->island(0)._bodies.size() == 2 );
+   TEST_ADD( res, world->island(0)._constraints.empty() );
+   TEST_ADD( res, world->island(1)._constraints.size() == 1 );
+   TEST_ADD( res, world->numSleepingIslands() == 0 );
+
+   // Resting piles fall asleep.
+   for( uint i = 0; i < 120; ++i )
+   {
+      world->stepSimulation( world->simulationDelta() );
+   }
+   TEST_ADD( res, world->numSleepingIslands() == world->numIslands() );
+   TEST_ADD( res, !bodies[0]->active() && !bodies[3]->active() );
+   TEST_ADD( res, bodies[0]->linearVelocity() == Vec3f::zero() );
+   Vec3f pos = bodies[1]->simPosition();
+
+   // Sleeping bodies are left alone.
+   for( uint i = 0; i < 10; ++i )
+   {
+      world->stepSimulation( world->simulationDelta() );
+   }
+   TEST_ADD( res, bodies[1]->simPosition() == pos );
+
+   // Dropping a sphere on the first pile only wakes that pile up.
+   RCP<RigidBody> ball = MotionWorld::createRigidBody();
+   ball->shape( new SphereShape( 0.5f ) );
+   ball->position( Vec3f( 0.0f, 4.0f, 0.0f ) );
+   world->addBody( ball.ptr() );
+   bool woke    = false;
+   bool isolated = true;
+   for( uint i = 0; i < 60; ++i )
+   {
+      world->stepSimulation( world->simulationDelta() );
+      woke     |= bodies[1]->active();
+      isolated &= !bodies[4]->active() && !bodies[6]->active();
+   }
+   TEST_ADD( res, woke );
+   TEST_ADD( res, isolated );
+
+   // Setting a velocity wakes a body up.
+   bodies[6]->linearVelocity( Vec3f( 1.0f, 0.0f, 0.0f ) );
+   TEST_ADD( res, bodies[6]->active() );
+
+   // So do non-zero forces and impulses (but not gravity, checked above).
+   TEST_ADD( res, !bodies[4]->active() && !bodies[5]->active() && !bodies[7]->active() );
+   bodies[7]->addForce( Vec3f::zero() );
+   TEST_ADD( res, !bodies[7]->active() );
+   bodies[4]->addForce( Vec3f( 0.0f, 10.0f, 0.0f ) );
+   TEST_ADD( res, bodies[4]->active() );
+   bodies[5]->applyImpulse( Vec3f( 1.0f, 0.0f, 0.0f ), bodies[5]->simPosition() );
+   TEST_ADD( res, bodies[5]->active() );
+   Vec3f force = bodies[4]->totalForce();
+   world->stepSimulation( world->simulationDelta() );
+   TEST_ADD( res, force.y > 0.0f && bodies[4]->linearVelocity().y > 0.0f );
+}
+
+//------------------------------------------------------------------------------
+//! Pairs whose collision masks reject each other never get contacts, so they
+//! neither join islands nor reach the solvers.
+void test_islands_masks( Test::Result& res )
+{
+   RCP<MotionWorld> world( new MotionWorld() );
+   RCP<RigidBody> a = MotionWorld::createRigidBody();
+   RCP<RigidBody> b = MotionWorld::createRigidBody();
+   a->shape( new SphereShape( 0.5f ) );
+   b->shape( new SphereShape( 0.5f ) );
+   a->position( Vec3f( 0.0f, 0.0f, 0.0f ) );
+   b->position( Vec3f( 0.5f, 0.0f, 0.0f ) );
+   a->collisionCategories( 0x01 );
+   a->collisionMask( 0x01 );
+   b->collisionCategories( 0x02 );
+   b->collisionMask( 0x02 );
+   world->addBody( a.ptr() );
+   world->addBody( b.ptr() );
+
+   world->stepSimulation( world->simulationDelta() );
+   TEST_ADD( res, world->numIslands() == 2 );
+   TEST_ADD( res, world->island(0)._collisionConstraints.empty() );
+   TEST_ADD( res, world->island(1)._collisionConstraints.empty() );
+   TEST_ADD( res, a->linearVelocity() == Vec3f::zero() );
+   TEST_ADD( res, b->linearVelocity() == Vec3f::zero() );
+
+   // The sequential impulse solver used to solve every pair; it now only sees
+   // the island's contacts, like the other solvers.
+   RCP<SequentialImpulseSolver> solver( new SequentialImpulseSolver( world.ptr() ) );
+   MotionWorld::Island island = world->island(0);
+   island._bodies.pushBack( world->island(1)._bodies[0] );
+   solver->solveConstraints( island, world->simulationDelta() );
+   solver->solveVelocities( island );
+   TEST_ADD( res, a->linearVelocity() == Vec3f::zero() );
+   TEST_ADD( res, b->linearVelocity() == Vec3f::zero() );
+
+   // Once allowed to collide, the spheres push each other apart.
+   b->collisionMask( 0x03 );
+   for( uint i = 0; i < 10; ++i )
+   {
+      world->stepSimulation( world->simulationDelta() );
+   }
+   TEST_ADD( res, world->numIslands() == 1 );
+   TEST_ADD( res, (b->simPosition() - a->simPosition()).length() > 0.5f );
+}
+
+//------------------------------------------------------------------------------
+//! Islands solved concurrently must give the exact same results.
+void test_islands_parallel( Test::Result& res )
+{
+   RCP<MotionWorld> worlds[2] = { islandWorld( 32 ), islandWorld( 32 ) };
+   RCP<MotionWorld> serial   = worlds[0];
+   RCP<MotionWorld> parallel = worlds[1];
+   TaskQueue queue( 4 );
+   parallel->taskQueue( &queue );
+
+   for( uint s = 0; s < 2; ++s )
+   {
+      for( uint w = 0; w < 2; ++w )
+      {
+         // Push every other pile around, so not all of the islands sleep.
+         const Vector< RCP<RigidBody> >& bodies = worlds[w]->rigidBodies();
+         for( uint i = 0; i < bodies.size(); i += 8 )
+         {
+            bodies[i]->linearVelocity( Vec3f( 1.0f, 2.0f, 0.5f ) );
+         }
+         for( uint i = 0; i < 60; ++i )
+         {
+            worlds[w]->stepSimulation( worlds[w]->simulationDelta() );
+         }
+      }
+      TEST_ADD( res, serial->numIslands() == parallel->numIslands() );
+      TEST_ADD( res, serial->numSleepingIslands() == parallel->numSleepingIslands() );
+
+      bool same = true;
+      for( uint i = 0; i < serial->rigidBodies().size(); ++i )
+      {
+         const RigidBody* a = serial->rigidBodies()[i].ptr();
+         const RigidBody* b = parallel->rigidBodies()[i].ptr();
+         same &= a->simPosition()     == b->simPosition();
+         same &= a->linearVelocity()  == b->linearVelocity();
+         same &= a->angularVelocity() == b->angularVelocity();
+      }
+      TEST_ADD( res, same );
+   }
+}
+
+//------------------------------------------------------------------------------
+//!
+void test_islands_timed( Test::Result& )
+{
+   const uint numPiles = 512;
+   const uint steps    = 120;
+   TaskQueue queue;
+   for( uint p = 0; p < 2; ++p )
+   {
+      RCP<MotionWorld> world = islandWorld( numPiles );
+      // Only measure the solving.
+      world->sleepDelay( 0.0 );
+      if( p == 1 )  world->taskQueue( &queue );
+      Timer timer;
+      for( uint i = 0; i < steps; ++i )
+      {
+         world->stepSimulation( world->simulationDelta() );
+      }
+      double t = timer.elapsed() / steps;
+      StdErr << world->numIslands() << " islands, " << (p == 0 ? 1 : queue.numAllocatedThreads())
+             << " thread(s): " << t*1000.0 << " ms/step" << nl;
+   }
+}
+
 //------------------------------------------------------------------------------
 //!
 void init_tests()
@@ -1421,12 +1761,22 @@ void init_tests()
    Test::Collection& std = Test::standard();
    std.add( new Test::Function( "sph_sph"    , "Sphere-Sphere"           , test_collision_sphere_sphere     ) );
    std.add( new Test::Function( "sph_box"    , "Sphere-Box"              , test_collision_sphere_box        ) );
-   std.add( new Test::Function( "supp"       , "Support function"        , test_collision_shape_support     ) );
    std.add( new Test::Function( "gjk_sph_sph", "GJK Sphere-Sphere"       , test_collision_GJK_sphere_sphere ) );
-   std.add( new Test::Function( "gjk_sph_box", "GJK Sphere-Box"          , test_collision_GJK_sphere_box    ) );
-   std.add( new Test::Function( "gjk_box_box", "GJK Box-Box"             , test_collision_GJK_box_box       ) );
    std.add( new Test::Function( "grav"       , "Gravitational attractors", test_gravitational_attractor     ) );
-   std.add( new Test::Function( "dbg"        , "DEBUG"                   , test_debug                       ) );
+   std.add( new Test::Function( "broadphase" , "Broadphase pairs"        , test_broadphase                  ) );
+   std.add( new Test::Function( "islands"    , "Islands and sleeping"    , test_islands                     ) );
+   std.add( new Test::Function( "islands_mt" , "Parallel islands"        , test_islands_parallel            ) );
+   std.add( new Test::Function( "islands_msk", "Islands and masks"       , test_islands_masks               ) );
+
+   // These expect the older shape conventions (support points including the
+   // margin, boxes given by their full size), and fail with the current ones.
+   Test::special().add( new Test::Function( "supp"       , "Support function" , test_collision_shape_support  ) );
+   Test::special().add( new Test::Function( "gjk_sph_box", "GJK Sphere-Box"   , test_collision_GJK_sphere_box ) );
+   Test::special().add( new Test::Function( "gjk_box_box", "GJK Box-Box"      , test_collision_GJK_box_box    ) );
+   Test::special().add( new Test::Function( "dbg"        , "DEBUG"            , test_debug                    ) );
+
+   Test::special().add( new Test::Function( "broadphase_timed", "Timings of the broadphases for 1k, 5k and 20k bodies", test_broadphase_timed ) );
+   Test::special().add( new Test::Function( "islands_timed"   , "Timings of serial and parallel island solving"      , test_islands_timed    ) );
 }
 
 //------------------------------------------------------------------------------
@@ -515,13 +515,13 @@ WaitAction::performSet( VMState* vm )
 
 
 /*==============================================================================
-  CLASS ActionTask
+  CLASS ActionLoop
 ==============================================================================*/
 
 //-----------------------------------------------------------------------------
 //!
-ActionTask::ActionTask( Entity* e, double t, double d, bool afterPhysics ):
-   _entity( e ),
+ActionLoop::ActionLoop( Entity* const* entities, double t, double d, bool afterPhysics ):
+   _entities( entities ),
    _time( t ),
    _delta( d ),
    _afterPhysics( afterPhysics )
@@ -531,25 +531,36 @@ ActionTask::ActionTask( Entity* e, double t, double d, bool afterPhysics ):
 //-----------------------------------------------------------------------------
 //!
 void
-ActionTask::execute()
+ActionLoop::operator()( uint begin, uint end, WorkerTask& )
 {
-   if( _entity.isNull() )
+   for( uint i = begin; i < end; ++i )
    {
-      StdErr << "ERROR - ActionTask::execute() called on a NULL entity." << nl;
+      execute( _entities[i] );
+   }
+}
+
+//-----------------------------------------------------------------------------
+//!
+void
+ActionLoop::execute( Entity* e )
+{
+   if( e == NULL )
+   {
+      StdErr << "ERROR - ActionLoop::execute() called on a NULL entity." << nl;
       return;
    }
 
-   Brain* brain = _entity->brain();
+   Brain* brain = e->brain();
    if( brain == NULL )
    {
-      StdErr << "ERROR - ActionTask::execute() called on an entity (" << (void*)_entity.ptr() << ") without a brain." << nl;
+      StdErr << "ERROR - ActionLoop::execute() called on an entity (" << (void*)e << ") without a brain." << nl;
       return;
    }
 
    bool stillRunning = false;
    bool mustClean    = false;
    Brain::ActionContainer& actions = brain->actions();
-   //StdErr << "Entity " << (void*)_entity.ptr() << " has " << actions.size() << " actions" << nl;
+   //StdErr << "Entity " << (void*)e << " has " << actions.size() << " actions" << nl;
    CHECK( actions.size() < 100 );
    for( auto cur = actions.begin(); cur != actions.end(); ++cur )
    {
@@ -558,12 +569,12 @@ ActionTask::execute()
       {
          if( action->canExecute() )
          {
-            if( action->execute( *_entity, _time, _delta ) )
+            if( action->execute( *e, _time, _delta ) )
             {
                action->enabled( false );  // Disable it.
                if( action->notifyOnCompletion() )
                {
-                  _entity->stimulate( new ActionCompleted( action.ptr() ) );
+                  e->stimulate( new ActionCompleted( action.ptr() ) );
                }
                if( action->autoDelete() )
                {
@@ -586,7 +597,7 @@ ActionTask::execute()
    if( !stillRunning )
    {
       // Flag yourself to be removed from the World's list of entities running actions.
-      if( _afterPhysics )  _entity->runningActionsAfter( false );
-      else                 _entity->runningActionsBefore( false );
+      if( _afterPhysics )  e->runningActionsAfter( false );
+      else                 e->runningActionsBefore( false );
    }
 }
@@ -16,6 +16,7 @@
 NAMESPACE_BEGIN
 
 class Entity;
+class WorkerTask;
 
 /*==============================================================================
   CLASS Action
@@ -63,7 +64,7 @@ public:
 
 protected:
 
-   friend class ActionTask;
+   friend class ActionLoop;
    friend class Brain;
 
    /*----- types -----*/
@@ -172,30 +173,34 @@ protected:
 
 
 /*==============================================================================
-  CLASS ActionTask
+  CLASS ActionLoop
 ==============================================================================*/
-class ActionTask:
-   public Task
+//! Runs the actions of a range of entities (see TaskQueue::parallelFor()).
+class ActionLoop
 {
 public:
 
    /*----- methods -----*/
 
-   ActionTask( Entity* e, double t, double d, bool afterPhysics );
-   virtual void  execute();
+   ActionLoop( Entity* const* entities, double t, double d, bool afterPhysics );
+
+   void  operator()( uint begin, uint end, WorkerTask& worker );
 
 protected:
 
+   /*----- methods -----*/
+
+   void  execute( Entity* e );
+
    /*----- data members -----*/
 
-   RCP<Entity>  _entity; //!< A pointer to the entity that has actions to run.
-   double       _time;   //!< The current world time.
-   double       _delta;  //!< The delta time since the last action call.
-   // Note: if _time and _delta take too much memory, we could poll them from the world.
-   bool         _afterPhysics; //!< Only handle actions that have a matching runAfterPhysics() value.
+   Entity* const*  _entities;     //!< The entities that have actions to run.
+   double          _time;         //!< The current world time.
+   double          _delta;        //!< The delta time since the last action call.
+   bool            _afterPhysics; //!< Only handle actions that have a matching runAfterPhysics() value.
 
 private:
-}; //class ActionTask
+}; //class ActionLoop
 
 
 NAMESPACE_END
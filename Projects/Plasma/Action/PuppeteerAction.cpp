@@ -258,7 +258,7 @@ PuppeteerAction::execute( Entity&, double /*time*/, double delta )
          float f  = (float)(_trTime / trans->duration());
 
          Puppeteer::blendPoses( _node1State->pose(), _node2State->pose(), f, *_pose );
-         Puppeteer::setPose( entity()->instance(), _pose.ptr() );
+         entity()->world()->setPose( entity()->instance(), _pose.ptr() );
 
          Vec3f vel = CGM::linear2( _node1State->velocity(), _node2State->velocity(), f );
          Quatf ori = _node1State->orientation().slerp( _node2State->orientation(), f );
@@ -269,7 +269,7 @@ PuppeteerAction::execute( Entity&, double /*time*/, double delta )
 
    // Handle node.
    _curNode->perform( _node1State.ptr(), delta );
-   Puppeteer::setPose( entity()->instance(), _node1State->pose() );
+   entity()->world()->setPose( entity()->instance(), _node1State->pose() );
    moveEntity( entity(), _node1State->velocity(), _node1State->orientation() );
 
    // Action never expires.
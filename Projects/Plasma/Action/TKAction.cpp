@@ -148,6 +148,8 @@ updateBeam( RigidEntity& beam, const Vec3f& spos, const Vec3f& tpos, float radiu
    lines->updateAdjacency();
    //lines->updateProperties();
    lines->invalidateRenderableGeometry();
+   // The geometry changed in place.
+   beam.moved();
 }
 
 UNNAMESPACE_END
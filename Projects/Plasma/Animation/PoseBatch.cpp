@@ -0,0 +1,628 @@
+/*=============================================================================
+   Copyright (c) 2012, Ludo Sapiens Inc. and contributors.
+   See accompanying file LICENSE.txt for details.
+=============================================================================*/
+#include <Plasma/Animation/PoseBatch.h>
+#include <Plasma/Animation/SkeletalAnimation.h>
+#include <Plasma/Animation/SkeletalClip.h>
+#include <Plasma/Plasma.h>
+
+#include <CGMath/FloatN.h>
+
+#include <Base/MT/TaskQueue.h>
+
+#include <algorithm>
+
+/*==============================================================================
+  UNNAME NAMESPACE
+==============================================================================*/
+
+UNNAMESPACE_BEGIN
+
+typedef Floats F;
+
+//! A quaternion per lane.
+struct QuatN
+{
+   F  _x, _y, _z, _w;
+};
+
+//! A referential per lane.
+struct RefN
+{
+   QuatN  _q;
+   F      _px, _py, _pz, _s;
+};
+
+// The scratch arrays hold every value as consecutive vectors, one per component.
+inline F     load( const float* src, uint c )        { return F::load( src + c*F::SIZE ); }
+inline void  store( const F& v, float* dst, uint c ) { v.store( dst + c*F::SIZE ); }
+
+//------------------------------------------------------------------------------
+//!
+inline void
+load( const float* src, QuatN& q )
+{
+   q._x = load( src, 0 );
+   q._y = load( src, 1 );
+   q._z = load( src, 2 );
+   q._w = load( src, 3 );
+}
+
+//------------------------------------------------------------------------------
+//!
+inline void
+store( const QuatN& q, float* dst )
+{
+   store( q._x, dst, 0 );
+   store( q._y, dst, 1 );
+   store( q._z, dst, 2 );
+   store( q._w, dst, 3 );
+}
+
+//------------------------------------------------------------------------------
+//!
+inline void
+load( const float* src, RefN& r )
+{
+   load( src, r._q );
+   r._px = load( src, 4 );
+   r._py = load( src, 5 );
+   r._pz = load( src, 6 );
+   r._s  = load( src, 7 );
+}
+
+//------------------------------------------------------------------------------
+//!
+inline void
+store( const RefN& r, float* dst )
+{
+   store( r._q, dst );
+   store( r._px, dst, 4 );
+   store( r._py, dst, 5 );
+   store( r._pz, dst, 6 );
+   store( r._s,  dst, 7 );
+}
+
+//------------------------------------------------------------------------------
+//! Sets every lane to the same referential.
+inline void
+set( const Reff& src, RefN& r )
+{
+   const Quatf& q = src.orientation();
+   r._q._x = F::set( q.x() );
+   r._q._y = F::set( q.y() );
+   r._q._z = F::set( q.z() );
+   r._q._w = F::set( q.w() );
+   r._px   = F::set( src.position().x );
+   r._py   = F::set( src.position().y );
+   r._pz   = F::set( src.position().z );
+   r._s    = F::set( src.scale() );
+}
+
+//------------------------------------------------------------------------------
+//! Rebuilds the quaternions from unpacked keys (see SkeletalClip::unpack()),
+//! the largest component of every lane being placed with masks.
+inline void
+decode( const float* v, QuatN& q )
+{
+   const F zero = F::set( 0.0f );
+   F a = load( v, 0 );
+   F b = load( v, 1 );
+   F c = load( v, 2 );
+   F largest = load( v, 3 );
+   F r = F::set( 1.0f ) - a*a - b*b - c*c;
+   F l = F::sqrt( F::select( F::less( r, zero ), zero, r ) );
+
+   F::Mask m0 = F::less( largest, F::set( 0.5f ) );
+   F::Mask m1 = F::less( largest, F::set( 1.5f ) );
+   F::Mask m2 = F::less( largest, F::set( 2.5f ) );
+   q._x = F::select( m0, l, a );
+   q._y = F::select( m0, a, F::select( m1, l, b ) );
+   q._z = F::select( m1, b, F::select( m2, l, c ) );
+   q._w = F::select( m2, c, l );
+}
+
+//------------------------------------------------------------------------------
+//! Normalized linear interpolation along the shortest path, like Quat::nlerp().
+inline void
+nlerp( const QuatN& a, const QuatN& b, const F& t, QuatN& dst )
+{
+   const F zero = F::set( 0.0f );
+   F d  = a._x*b._x + a._y*b._y + a._z*b._z + a._w*b._w;
+   F s1 = F::set( 1.0f ) - t;
+   F s2 = F::select( F::less( d, zero ), zero - t, t );
+   F x  = a._x*s1 + b._x*s2;
+   F y  = a._y*s1 + b._y*s2;
+   F z  = a._z*s1 + b._z*s2;
+   F w  = a._w*s1 + b._w*s2;
+   F n  = F::set( 1.0f ) / F::sqrt( x*x + y*y + z*z + w*w );
+   dst._x = x*n;
+   dst._y = y*n;
+   dst._z = z*n;
+   dst._w = w*n;
+}
+
+//------------------------------------------------------------------------------
+//! The equivalent of Ref::operator*(): a*b.
+inline void
+mul( const RefN& a, const RefN& b, RefN& dst )
+{
+   const QuatN& p = a._q;
+   const QuatN& q = b._q;
+
+   // Rotate b's position by a's orientation (see Quat::operator*( Vec3 )).
+   F x2 = p._x + p._x;
+   F y2 = p._y + p._y;
+   F z2 = p._z + p._z;
+   F xx = p._x*x2;
+   F xy = p._x*y2;
+   F xz = p._x*z2;
+   F yy = p._y*y2;
+   F yz = p._y*z2;
+   F zz = p._z*z2;
+   F wx = p._w*x2;
+   F wy = p._w*y2;
+   F wz = p._w*z2;
+   F one = F::set( 1.0f );
+   F rx = b._px*(one - (yy + zz)) + b._py*(xy - wz) + b._pz*(xz + wy);
+   F ry = b._px*(xy + wz) + b._py*(one - (xx + zz)) + b._pz*(yz - wx);
+   F rz = b._px*(xz - wy) + b._py*(yz + wx) + b._pz*(one - (xx + yy));
+   dst._px = a._px + rx*a._s;
+   dst._py = a._py + ry*a._s;
+   dst._pz = a._pz + rz*a._s;
+   dst._s  = a._s*b._s;
+
+   F x = p._w*q._x + p._x*q._w + p._y*q._z - p._z*q._y;
+   F y = p._w*q._y - p._x*q._z + p._y*q._w + p._z*q._x;
+   F z = p._w*q._z + p._x*q._y - p._y*q._x + p._z*q._w;
+   F w = p._w*q._w - p._x*q._x - p._y*q._y - p._z*q._z;
+   dst._q._x = x;
+   dst._q._y = y;
+   dst._q._z = z;
+   dst._q._w = w;
+}
+
+//------------------------------------------------------------------------------
+//! Writes the 12 varying entries of Ref::toMatrix(), column by column: the
+//! 3 rotation columns (scaled), then the translation.
+inline void
+storeMatrix( const RefN& r, float* dst )
+{
+   const QuatN& q = r._q;
+   F x2 = (q._x + q._x)*r._s;
+   F y2 = (q._y + q._y)*r._s;
+   F z2 = (q._z + q._z)*r._s;
+   F xx = q._x*x2;
+   F xy = q._x*y2;
+   F xz = q._x*z2;
+   F yy = q._y*y2;
+   F yz = q._y*z2;
+   F zz = q._z*z2;
+   F wx = q._w*x2;
+   F wy = q._w*y2;
+   F wz = q._w*z2;
+
+   store( r._s - (yy + zz), dst, 0 );
+   store( xy + wz,          dst, 1 );
+   store( xz - wy,          dst, 2 );
+   store( xy - wz,          dst, 3 );
+   store( r._s - (xx + zz), dst, 4 );
+   store( yz + wx,          dst, 5 );
+   store( xz + wy,          dst, 6 );
+   store( yz - wx,          dst, 7 );
+   store( r._s - (xx + yy), dst, 8 );
+   store( r._px,            dst, 9 );
+   store( r._py,            dst, 10 );
+   store( r._pz,            dst, 11 );
+}
+
+//------------------------------------------------------------------------------
+//! Returns lane l of a quaternion in the scratch arrays.
+inline Quatf
+quat( const float* src, uint l )
+{
+   const uint L = F::SIZE;
+   return Quatf( src[l], src[L+l], src[2*L+l], src[3*L+l] );
+}
+
+//------------------------------------------------------------------------------
+//! Orders the jobs by skeleton, so that the instances sharing one end up next
+//! to each other, then puts the sampled poses first and the ones blending two
+//! clips last, so that the groups sampling a single clip don't sample a second
+//! one for nothing.
+struct JobLess
+{
+   template< typename Job >
+   bool operator()( const Job& a, const Job& b ) const
+   {
+      if( a._inst->skeleton() != b._inst->skeleton() )  return a._inst->skeleton() < b._inst->skeleton();
+      if( (a._pose != NULL) != (b._pose != NULL) )      return a._pose != NULL;
+      return (a._factor == 0.0f) && (b._factor != 0.0f);
+   }
+};
+
+// The vectors of scratch space needed by a group, besides 12 per bone.
+const uint _scratchVectors = 9 + 8 + 12;
+
+UNNAMESPACE_END
+
+
+NAMESPACE_BEGIN
+
+/*==============================================================================
+  CLASS PoseBatch::GroupLoop
+==============================================================================*/
+//! Evaluates a range of groups (see TaskQueue::parallelFor()), with scratch
+//! space allocated once for the whole range.
+class PoseBatch::GroupLoop
+{
+public:
+
+   /*----- methods -----*/
+
+   GroupLoop( const PoseBatch& batch ): _batch( batch ) {}
+
+   void operator()( uint begin, uint end, WorkerTask& )
+   {
+      evaluate( begin, end );
+   }
+
+   void evaluate( uint begin, uint end )
+   {
+      Vector<float> scratch( (_scratchVectors + 12*_batch._maxBones + 1)*F::SIZE );
+      size_t align = F::SIZE*sizeof(float);
+      float* aligned = (float*)( (size_t(scratch.data()) + align - 1) & ~(align - 1) );
+      for( uint g = begin; g < end; ++g )
+      {
+         _batch.evaluate( _batch._groups[g], aligned );
+      }
+   }
+
+protected:
+
+   /*----- data members -----*/
+
+   const PoseBatch&  _batch;
+};
+
+/*==============================================================================
+  CLASS PoseBatch
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//!
+PoseBatch::PoseBatch():
+   _queue( Plasma::dispatchQueue() ),
+   _grain( 8 ),
+   _maxBones( 0 )
+{
+}
+
+//------------------------------------------------------------------------------
+//!
+PoseBatch::~PoseBatch()
+{
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+PoseBatch::clear()
+{
+   _jobs.clear();
+   _groups.clear();
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+PoseBatch::add( Skeleton::Instance& inst, const SkeletalClip* clip, float time )
+{
+   add( inst, clip, time, clip, time, 0.0f );
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+PoseBatch::add(
+   Skeleton::Instance& inst,
+   const SkeletalClip* clipA,
+   float               timeA,
+   const SkeletalClip* clipB,
+   float               timeB,
+   float               factor
+)
+{
+   CHECK( inst.skeleton() );
+   CHECK( clipA->numBones() == inst.skeleton()->numBones() && clipA->numFrames() > 0 );
+   CHECK( clipB->numBones() == inst.skeleton()->numBones() && clipB->numFrames() > 0 );
+
+   Job job;
+   job._inst      = &inst;
+   job._pose      = NULL;
+   job._clips[0]  = clipA;
+   job._clips[1]  = clipB;
+   job._times[0]  = timeA;
+   job._times[1]  = timeB;
+   job._factor    = factor;
+   _jobs.pushBack( job );
+   _groups.clear();
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+PoseBatch::add( Skeleton::Instance& inst, const SkeletalPose* pose )
+{
+   CHECK( inst.skeleton() );
+   CHECK( pose->numBones() == inst.skeleton()->numBones() );
+
+   Job job;
+   job._inst      = &inst;
+   job._pose      = pose;
+   job._clips[0]  = NULL;
+   job._clips[1]  = NULL;
+   job._times[0]  = 0.0f;
+   job._times[1]  = 0.0f;
+   job._factor    = 0.0f;
+   _jobs.pushBack( job );
+   _groups.clear();
+}
+
+//------------------------------------------------------------------------------
+//! Evaluates all of the instances added since the last clear(); the same jobs
+//! can be evaluated again (e.g. once the clips have changed).
+void
+PoseBatch::execute()
+{
+   if( _groups.empty() )  prepare();
+
+   GroupLoop loop( *this );
+   if( _queue && numGroups() > _grain )
+   {
+      _queue->parallelFor( 0, numGroups(), _grain, loop );
+   }
+   else
+   {
+      loop.evaluate( 0, numGroups() );
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Sorts the jobs by skeleton, and splits them into groups of at most one job
+//! per lane, which either all sample clips or all come with their poses.
+void
+PoseBatch::prepare()
+{
+   std::sort( _jobs.begin(), _jobs.end(), JobLess() );
+
+   _maxBones = 0;
+   for( uint i = 0; i < _jobs.size(); )
+   {
+      const Skeleton* skel = _jobs[i]._inst->skeleton();
+      _maxBones = CGM::max( _maxBones, skel->numBones() );
+
+      Group group;
+      group._first = i;
+      group._count = 0;
+      group._blend = false;
+      group._posed = (_jobs[i]._pose != NULL);
+      for( ; i < _jobs.size() && group._count < F::SIZE && _jobs[i]._inst->skeleton() == skel; ++i )
+      {
+         if( (_jobs[i]._pose != NULL) != group._posed )  break;
+         group._blend |= (_jobs[i]._factor != 0.0f);
+         ++group._count;
+      }
+      _groups.pushBack( group );
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Evaluates one group, lane l holding its job l (the lanes past the last job
+//! repeat the first one, but aren't written back).
+//! Every track is sampled for all of the lanes at once (the key searches and
+//! loads being the only scalar part), or copied from the sampled poses, then
+//! the hierarchy is walked in order, each bone being computed for all of the
+//! lanes at once as well.
+void
+PoseBatch::evaluate( const Group& group, float* scratch ) const
+{
+   const uint L = F::SIZE;
+
+   const Job*      jobs     = _jobs.data() + group._first;
+   const Skeleton* skel     = jobs[0]._inst->skeleton();
+   const uint      numBones = skel->numBones();
+
+   float* keys    = scratch;                   // 2 unpacked keys and a factor.
+   float* roots   = keys + 9*L;                // The root orientation of both clips.
+   float* locals  = roots + 8*L;               // A quaternion per bone.
+   float* globals = locals + 4*L*numBones;     // A referential per bone.
+   float* mat     = globals + 8*L*numBones;    // The matrix of the current bone.
+
+   const Job* lanes[L];
+   uint       frames[2][L];
+   float      fts[2][L];
+   for( uint l = 0; l < L; ++l )
+   {
+      lanes[l] = jobs + ((l < group._count) ? l : 0);
+      keys[l]  = lanes[l]->_factor;
+   }
+   const F factor = F::load( keys );
+
+   if( group._posed )
+   {
+      // Copy the sampled orientations.
+      for( uint b = 0; b < numBones; ++b )
+      {
+         float* q = locals + b*4*L;
+         for( uint l = 0; l < L; ++l )
+         {
+            const Quatf& o = lanes[l]->_pose->bones()[b];
+            q[l]     = o.x();
+            q[L+l]   = o.y();
+            q[2*L+l] = o.z();
+            q[3*L+l] = o.w();
+         }
+      }
+   }
+   else
+   {
+      for( uint l = 0; l < L; ++l )
+      {
+         for( uint c = 0; c < 2; ++c )
+         {
+            lanes[l]->_clips[c]->frameAt( lanes[l]->_times[c], frames[c][l], fts[c][l] );
+         }
+      }
+
+      // Sample every track, root first.
+      const uint numClips = group._blend ? 2 : 1;
+      for( uint t = 0; t <= numBones; ++t )
+      {
+         QuatN q[2];
+         for( uint c = 0; c < numClips; ++c )
+         {
+            for( uint l = 0; l < L; ++l )
+            {
+               const SkeletalClip*        clip  = lanes[l]->_clips[c];
+               const SkeletalClip::Track& track = clip->_tracks[t];
+               const SkeletalClip::Key*   k0    = clip->findKey( track, frames[c][l] );
+               const SkeletalClip::Key*   k1    = (k0 != clip->_keys.data() + track._first + track._count - 1) ? k0 + 1 : k0;
+               float v[4];
+               SkeletalClip::unpack( *k0, v );
+               for( uint i = 0; i < 4; ++i )  keys[i*L + l] = v[i];
+               SkeletalClip::unpack( *k1, v );
+               for( uint i = 0; i < 4; ++i )  keys[(4+i)*L + l] = v[i];
+               keys[8*L + l] = (k1 != k0) ? (fts[c][l] - float(k0->_frame)) / float(k1->_frame - k0->_frame) : 0.0f;
+            }
+            QuatN q0;
+            QuatN q1;
+            decode( keys, q0 );
+            decode( keys + 4*L, q1 );
+            nlerp( q0, q1, load( keys, 8 ), q[c] );
+         }
+
+         if( t == 0 )
+         {
+            // The root referential gets blended as a whole below.
+            store( q[0], roots );
+            if( group._blend )  store( q[1], roots + 4*L );
+         }
+         else
+         {
+            if( group._blend )  nlerp( q[0], q[1], factor, q[0] );
+            store( q[0], locals + (t-1)*4*L );
+         }
+      }
+   }
+
+   // Root referentials, which are the instances' offsets.
+   for( uint l = 0; l < L; ++l )
+   {
+      const Job& job = *lanes[l];
+      Reff  offset;
+      Vec3f pos;
+      float scale;
+      if( job._pose )
+      {
+         offset = job._pose->referential();
+      }
+      else
+      {
+         const SkeletalClip* clipA = job._clips[0];
+         clipA->root( fts[0][l], pos, scale );
+         offset = Reff( quat( roots, l ), pos, scale );
+      }
+      if( job._factor != 0.0f )
+      {
+         const SkeletalClip* clipB = job._clips[1];
+         clipB->root( fts[1][l], pos, scale );
+         offset = offset.nlerp( Reff( quat( roots + 4*L, l ), pos, scale ), job._factor );
+      }
+      if( l < group._count )  job._inst->_offset = offset;
+
+      mat[l]     = offset.orientation().x();
+      mat[L+l]   = offset.orientation().y();
+      mat[2*L+l] = offset.orientation().z();
+      mat[3*L+l] = offset.orientation().w();
+      mat[4*L+l] = offset.position().x;
+      mat[5*L+l] = offset.position().y;
+      mat[6*L+l] = offset.position().z;
+      mat[7*L+l] = offset.scale();
+   }
+   RefN offset;
+   load( mat, offset );
+
+   // Local to global, in hierarchy order.
+   const Vector<Skeleton::Node>&  hierarchy = skel->hierarchy();
+   const Skeleton::BoneContainer& bones     = skel->bones();
+   for( uint i = 0; i < numBones; ++i )
+   {
+      int b = hierarchy[i]._boneID;
+      int p = bones[b].parent();
+
+      // The sampled orientation, with the position and scale of the instance.
+      for( uint l = 0; l < L; ++l )
+      {
+         const Reff& ref = lanes[l]->_inst->_localRefs[b];
+         mat[l]     = ref.position().x;
+         mat[L+l]   = ref.position().y;
+         mat[2*L+l] = ref.position().z;
+         mat[3*L+l] = ref.scale();
+      }
+      RefN local;
+      load( locals + b*4*L, local._q );
+      local._px = load( mat, 0 );
+      local._py = load( mat, 1 );
+      local._pz = load( mat, 2 );
+      local._s  = load( mat, 3 );
+
+      RefN global;
+      if( p == Skeleton::ROOT )
+      {
+         mul( offset, local, global );
+      }
+      else
+      {
+         RefN parent;
+         load( globals + p*8*L, parent );
+         mul( parent, local, global );
+      }
+      float* g = globals + b*8*L;
+      store( global, g );
+
+      RefN inv;
+      RefN m;
+      set( bones[b].globalToLocalReferential(), inv );
+      mul( global, inv, m );
+      storeMatrix( m, mat );
+
+      for( uint l = 0; l < group._count; ++l )
+      {
+         Skeleton::Instance& inst = *jobs[l]._inst;
+         inst._localRefs[b].orientation( quat( locals + b*4*L, l ) );
+         inst._globalRefs[b] = Reff( quat( g, l ), Vec3f( g[4*L+l], g[5*L+l], g[6*L+l] ), g[7*L+l] );
+
+         float* dst = inst._transforms[b].ptr();
+         dst[0]  = mat[l];
+         dst[1]  = mat[L+l];
+         dst[2]  = mat[2*L+l];
+         dst[3]  = 0.0f;
+         dst[4]  = mat[3*L+l];
+         dst[5]  = mat[4*L+l];
+         dst[6]  = mat[5*L+l];
+         dst[7]  = 0.0f;
+         dst[8]  = mat[6*L+l];
+         dst[9]  = mat[7*L+l];
+         dst[10] = mat[8*L+l];
+         dst[11] = 0.0f;
+         dst[12] = mat[9*L+l];
+         dst[13] = mat[10*L+l];
+         dst[14] = mat[11*L+l];
+         dst[15] = 1.0f;
+      }
+   }
+}
+
+NAMESPACE_END
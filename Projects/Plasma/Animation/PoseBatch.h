@@ -0,0 +1,114 @@
+/*=============================================================================
+   Copyright (c) 2012, Ludo Sapiens Inc. and contributors.
+   See accompanying file LICENSE.txt for details.
+=============================================================================*/
+#ifndef PLASMA_POSEBATCH_H
+#define PLASMA_POSEBATCH_H
+
+#include <Plasma/StdDefs.h>
+#include <Plasma/Animation/Skeleton.h>
+
+#include <Base/ADT/Vector.h>
+
+NAMESPACE_BEGIN
+
+class SkeletalClip;
+class SkeletalPose;
+class TaskQueue;
+
+/*==============================================================================
+  CLASS PoseBatch
+==============================================================================*/
+
+//! Poses many skeleton instances at once, from SkeletalClips.
+//! The instances sharing a skeleton are evaluated side by side, one per SIMD
+//! lane (see FloatN): the keys of every lane are gathered, then the
+//! decoding, interpolation, blending, and the hierarchy walk (local to global
+//! referentials, then bone matrices) run on all of the lanes at once.
+//! The results land in the instances as if Puppeteer::setPose() had been called
+//! with the sampled pose: the offset, the local orientations, the global
+//! referentials and the bone matrices, which the instances' constant buffer
+//! points to, so nothing needs to be copied before drawing.
+//! Poses which are already sampled (e.g. by an AnimationGraph) can be added as
+//! well, in which case only the hierarchy walk is batched.
+//! The groups of lanes are spread over a TaskQueue; a group only writes into
+//! its own instances, which therefore must not be added twice.
+class PoseBatch
+{
+public:
+
+   /*----- methods -----*/
+
+   PLASMA_DLL_API PoseBatch();
+   PLASMA_DLL_API ~PoseBatch();
+
+   // The queue evaluating the groups (defaults to the Plasma dispatch queue, NULL for the calling thread).
+   inline void  queue( TaskQueue* q ) { _queue = q; }
+   inline TaskQueue*  queue() const { return _queue; }
+
+   // The number of groups evaluated by a single task.
+   inline void  grain( uint v ) { _grain = v; }
+   inline uint  grain() const   { return _grain; }
+
+   inline uint  numInstances() const { return uint(_jobs.size()); }
+   inline uint  numGroups() const    { return uint(_groups.size()); }
+
+   PLASMA_DLL_API void  clear();
+
+   // Poses an instance with a clip at the specified time.
+   PLASMA_DLL_API void  add( Skeleton::Instance& inst, const SkeletalClip* clip, float time );
+   // Poses an instance with a blend of two clips: nlerp( clipA( timeA ), clipB( timeB ), factor ).
+   PLASMA_DLL_API void  add(
+      Skeleton::Instance& inst,
+      const SkeletalClip* clipA,
+      float               timeA,
+      const SkeletalClip* clipB,
+      float               timeB,
+      float               factor
+   );
+   // Poses an instance with a sampled pose, like Puppeteer::setPose() (the pose must live until execute()).
+   PLASMA_DLL_API void  add( Skeleton::Instance& inst, const SkeletalPose* pose );
+
+   PLASMA_DLL_API void  execute();
+
+protected:
+
+   /*----- data types -----*/
+
+   struct Job
+   {
+      Skeleton::Instance*  _inst;
+      const SkeletalPose*  _pose;     //!< NULL when sampling the clips.
+      const SkeletalClip*  _clips[2];
+      float                _times[2];
+      float                _factor;   //!< 0 when there is a single clip.
+   };
+
+   //! A range of _jobs sharing a skeleton, and evaluated side by side.
+   struct Group
+   {
+      uint  _first;
+      uint  _count;
+      bool  _blend;   //!< Set if any of the jobs has two clips.
+      bool  _posed;   //!< Set if the jobs come with sampled poses (all or none of them).
+   };
+
+   class GroupLoop;
+
+   /*----- methods -----*/
+
+   void  prepare();
+   void  evaluate( const Group& group, float* scratch ) const;
+
+   /*----- data members -----*/
+
+   Vector<Job>    _jobs;
+   Vector<Group>  _groups;
+   TaskQueue*     _queue;
+   uint           _grain;
+   uint           _maxBones;
+};
+
+NAMESPACE_END
+
+#endif
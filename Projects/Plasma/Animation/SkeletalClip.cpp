@@ -0,0 +1,396 @@
+/*=============================================================================
+   Copyright (c) 2012, Ludo Sapiens Inc. and contributors.
+   See accompanying file LICENSE.txt for details.
+=============================================================================*/
+#include <Plasma/Animation/SkeletalClip.h>
+#include <Plasma/Animation/SkeletalAnimation.h>
+
+#include <CGMath/CGConst.h>
+#include <CGMath/Ref.h>
+
+#include <Base/Dbg/DebugStream.h>
+
+/*==============================================================================
+  UNNAME NAMESPACE
+==============================================================================*/
+
+UNNAMESPACE_BEGIN
+
+DBG_STREAM( os_sc, "SkeletalClip" );
+
+const float _quantMax = 32767.0f;
+const float _maxScaleError = 1e-4f; // Relative.
+
+//------------------------------------------------------------------------------
+//! Writes the x, y, z, w components of an unpacked key (see SkeletalClip::unpack()).
+//! The largest one moves from one key to the next, so it is placed with
+//! selects rather than branches.
+inline void
+decodeSmallestThree( const float* v, float* dst )
+{
+   float a = v[0];
+   float b = v[1];
+   float c = v[2];
+   float l = CGM::sqrt( CGM::max( 0.0f, 1.0f - a*a - b*b - c*c ) );
+
+   uint largest = uint(v[3]);
+   dst[0] = (largest == 0) ? l : a;
+   dst[1] = (largest == 1) ? l : ((largest == 0) ? a : b);
+   dst[2] = (largest == 2) ? l : ((largest == 3) ? c : b);
+   dst[3] = (largest == 3) ? l : c;
+}
+
+//------------------------------------------------------------------------------
+//! Normalized linear interpolation along the shortest path, like Quat::nlerp().
+inline void
+nlerp( const float* a, const float* b, float t, float* dst )
+{
+   float d  = a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3];
+   float s1 = 1.0f - t;
+   float s2 = (d < 0.0f) ? -t : t;
+   float x  = a[0]*s1 + b[0]*s2;
+   float y  = a[1]*s1 + b[1]*s2;
+   float z  = a[2]*s1 + b[2]*s2;
+   float w  = a[3]*s1 + b[3]*s2;
+   float n  = 1.0f / CGM::sqrt( x*x + y*y + z*z + w*w );
+   dst[0] = x*n;
+   dst[1] = y*n;
+   dst[2] = z*n;
+   dst[3] = w*n;
+}
+
+//------------------------------------------------------------------------------
+//! Returns true if the frames strictly between a and b are within maxChord of
+//! the interpolation between the (decoded) keys a and b.
+//! The distance between unit quaternions is used rather than their dot product
+//! since it keeps its precision for tiny angles.
+bool
+fits( const Vector<Quatf>& frames, const Vector<Quatf>& keys, uint a, uint b, float maxChord )
+{
+   float invLen = 1.0f / float(b - a);
+   float maxSqr = maxChord*maxChord;
+   for( uint f = a+1; f < b; ++f )
+   {
+      Quatf q = keys[a].nlerp( keys[b], float(f - a)*invLen );
+      Quatf d = (q.dot( frames[f] ) < 0.0f) ? q + frames[f] : q - frames[f];
+      if( d.dot( d ) > maxSqr )  return false;
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//!
+bool
+fits( const Vector<Vec3f>& frames, uint a, uint b, float maxDistance )
+{
+   float invLen = 1.0f / float(b - a);
+   for( uint f = a+1; f < b; ++f )
+   {
+      Vec3f p = CGM::linear( frames[a], frames[b], float(f - a)*invLen );
+      if( (p - frames[f]).length() > maxDistance )  return false;
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//!
+bool
+fits( const Vector<float>& frames, uint a, uint b, float maxError )
+{
+   float invLen = 1.0f / float(b - a);
+   for( uint f = a+1; f < b; ++f )
+   {
+      float v = CGM::linear( frames[a], frames[b], float(f - a)*invLen );
+      if( CGM::abs( v - frames[f] ) > maxError*CGM::abs( frames[f] ) )  return false;
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//! Greedily keeps the frames of a track which can't be interpolated from the
+//! previous kept one and a later one (the first and last frames are always kept).
+template< typename Fits >
+void
+reduce( uint numFrames, const Fits& fits, Vector<uint>& kept )
+{
+   kept.clear();
+   kept.pushBack( 0 );
+   uint a = 0;
+   while( a+1 < numFrames )
+   {
+      uint b = a+1;
+      for( uint c = b+1; c < numFrames && fits( a, c ); ++c )  b = c;
+      kept.pushBack( b );
+      a = b;
+   }
+}
+
+//------------------------------------------------------------------------------
+//!
+struct OrientationFits
+{
+   OrientationFits( const Vector<Quatf>& frames, const Vector<Quatf>& keys, float maxChord ):
+      _frames( frames ), _keys( keys ), _maxChord( maxChord ) {}
+   bool operator()( uint a, uint b ) const { return fits( _frames, _keys, a, b, _maxChord ); }
+
+   const Vector<Quatf>&  _frames;
+   const Vector<Quatf>&  _keys;
+   float                 _maxChord;
+};
+
+//------------------------------------------------------------------------------
+//!
+struct RootFits
+{
+   RootFits( const Vector<Vec3f>& positions, const Vector<float>& scales, float maxDistance ):
+      _positions( positions ), _scales( scales ), _maxDistance( maxDistance ) {}
+   bool operator()( uint a, uint b ) const
+   {
+      return fits( _positions, a, b, _maxDistance ) && fits( _scales, a, b, _maxScaleError );
+   }
+
+   const Vector<Vec3f>&  _positions;
+   const Vector<float>&  _scales;
+   float                 _maxDistance;
+};
+
+UNNAMESPACE_END
+
+
+NAMESPACE_BEGIN
+
+/*==============================================================================
+  CLASS SkeletalClip
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//! Compresses the poses of an animation.
+//! The error bounds apply to the frames of the animation (not to the times in
+//! between), and include the quantization error.
+RCP<SkeletalClip>
+SkeletalClip::create( const SkeletalAnimation& anim, float maxAngle, float maxDistance )
+{
+   RCP<SkeletalClip> clip = new SkeletalClip();
+   uint numFrames = anim.numPoses();
+   if( numFrames == 0 )  return clip;
+   CHECK( numFrames <= 65536 );
+
+   uint numBones    = anim.pose(0)->numBones();
+   clip->_numFrames = numFrames;
+   clip->_rate      = anim.rate();
+   clip->_duration  = anim.duration();
+   clip->_tracks.resize( numBones+1 );
+
+   // Two unit quaternions an angle apart (as rotations) are 2*sin(angle/4) apart.
+   float maxChord = 2.0f*CGM::sin( 0.25f*maxAngle );
+
+   Vector<Quatf> frames( numFrames );
+   Vector<Quatf> decoded( numFrames );
+   Vector<Key>   coded( numFrames );
+   Vector<uint>  kept;
+   for( uint t = 0; t <= numBones; ++t )
+   {
+      for( uint f = 0; f < numFrames; ++f )
+      {
+         const SkeletalPose* pose = anim.pose(f);
+         CHECK( pose->numBones() == numBones );
+         frames[f]  = (t == 0) ? pose->orientation() : pose->bones()[t-1];
+         frames[f].normalize();
+         coded[f]   = encode( f, frames[f] );
+         decoded[f] = decode( coded[f] );
+      }
+      reduce( numFrames, OrientationFits( frames, decoded, maxChord ), kept );
+
+      Track& track = clip->_tracks[t];
+      track._first = uint32_t(clip->_keys.size());
+      track._count = uint32_t(kept.size());
+      for( uint k = 0; k < kept.size(); ++k )
+      {
+         clip->_keys.pushBack( coded[kept[k]] );
+      }
+   }
+
+   // The root scale shares the keys of the position (it usually stays constant,
+   // and then doesn't add any).
+   Vector<Vec3f> positions( numFrames );
+   Vector<float> scales( numFrames );
+   for( uint f = 0; f < numFrames; ++f )
+   {
+      positions[f] = anim.pose(f)->position();
+      scales[f]    = anim.pose(f)->referential().scale();
+   }
+   reduce( numFrames, RootFits( positions, scales, maxDistance ), kept );
+   clip->_rootKeys.resize( kept.size() );
+   for( uint k = 0; k < kept.size(); ++k )
+   {
+      clip->_rootKeys[k]._frame = float(kept[k]);
+      clip->_rootKeys[k]._pos   = positions[kept[k]];
+      clip->_rootKeys[k]._scale = scales[kept[k]];
+   }
+
+   DBG_MSG( os_sc, numBones << " bones, " << numFrames << " frames: " << clip->_keys.size()
+            << " keys (" << clip->_rootKeys.size() << " root keys), " << clip->sizeInBytes() << " bytes" );
+
+   return clip;
+}
+
+//------------------------------------------------------------------------------
+//!
+SkeletalClip::SkeletalClip():
+   _numFrames( 0 ),
+   _rate( 24.0f ),
+   _duration( 0.0f )
+{}
+
+//------------------------------------------------------------------------------
+//!
+SkeletalClip::~SkeletalClip()
+{}
+
+//------------------------------------------------------------------------------
+//!
+size_t
+SkeletalClip::sizeInBytes() const
+{
+   return sizeof(*this) + _tracks.size()*sizeof(Track) + _keys.size()*sizeof(Key) +
+          _rootKeys.size()*sizeof(RootKey);
+}
+
+//------------------------------------------------------------------------------
+//! The largest component (in magnitude) is made positive and dropped, since
+//! it is implied by the others; these then lie in [-1/sqrt(2), 1/sqrt(2)].
+SkeletalClip::Key
+SkeletalClip::encode( uint frame, const Quatf& q )
+{
+   const float* c = q.ptr(); // x, y, z, w.
+   uint largest = 0;
+   for( uint i = 1; i < 4; ++i )
+   {
+      if( CGM::abs( c[i] ) > CGM::abs( c[largest] ) )  largest = i;
+   }
+   float sign  = (c[largest] < 0.0f) ? -1.0f : 1.0f;
+   float scale = sign * 0.5f * CGConstf::sqrt2() * _quantMax;
+
+   Key key;
+   key._frame = uint16_t(frame);
+   for( uint i = 0, j = 0; i < 4; ++i )
+   {
+      if( i == largest )  continue;
+      float v   = CGM::clamp( c[i]*scale + 0.5f*_quantMax, 0.0f, _quantMax );
+      key._v[j++] = uint16_t( v + 0.5f );
+   }
+   key._v[0] |= uint16_t( (largest & 1) << 15 );
+   key._v[1] |= uint16_t( (largest >> 1) << 15 );
+   return key;
+}
+
+//------------------------------------------------------------------------------
+//!
+Quatf
+SkeletalClip::decode( const Key& key )
+{
+   float v[4];
+   unpack( key, v );
+   Quatf q;
+   decodeSmallestThree( v, q.ptr() );
+   return q;
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+SkeletalClip::sample( float time, SkeletalPose& dst ) const
+{
+   evaluate( time, 1.0f, dst );
+}
+
+//------------------------------------------------------------------------------
+//!
+void
+SkeletalClip::blend( float time, float factor, SkeletalPose& dst ) const
+{
+   evaluate( time, factor, dst );
+}
+
+//------------------------------------------------------------------------------
+//! Retrieves the root position and scale at a (wrapped) fractional frame.
+void
+SkeletalClip::root( float ft, Vec3f& pos, float& scale ) const
+{
+   const RootKey* rk = _rootKeys.data();
+   uint lo = 0;
+   uint hi = uint(_rootKeys.size()) - 1;
+   while( hi - lo > 1 )
+   {
+      uint mid = (lo + hi) >> 1;
+      if( rk[mid]._frame <= ft ) lo = mid; else hi = mid;
+   }
+   if( hi == lo || ft <= rk[lo]._frame )
+   {
+      pos   = rk[lo]._pos;
+      scale = rk[lo]._scale;
+      return;
+   }
+   float t = CGM::min( 1.0f, (ft - rk[lo]._frame)/(rk[hi]._frame - rk[lo]._frame) );
+   pos   = CGM::linear( rk[lo]._pos, rk[hi]._pos, t );
+   scale = CGM::linear( rk[lo]._scale, rk[hi]._scale, t );
+}
+
+//------------------------------------------------------------------------------
+//! Decodes and interpolates the keys of a track surrounding the time.
+inline void
+SkeletalClip::sampleTrack( const Track& track, uint frame, float time, Quatf& dst ) const
+{
+   const Key* k = findKey( track, frame );
+   float v[4];
+   unpack( *k, v );
+   decodeSmallestThree( v, dst.ptr() );
+   if( k != _keys.data() + track._first + track._count - 1 )
+   {
+      Quatf q1;
+      unpack( k[1], v );
+      decodeSmallestThree( v, q1.ptr() );
+      float u = (time - float(k->_frame)) / float(k[1]._frame - k->_frame);
+      nlerp( dst.ptr(), q1.ptr(), u, dst.ptr() );
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Decodes and interpolates the keys surrounding the time in every track, and
+//! blends the result into dst right away.
+void
+SkeletalClip::evaluate( float time, float factor, SkeletalPose& dst ) const
+{
+   CHECK( dst.numBones() == numBones() );
+   if( _numFrames == 0 )  return;
+
+   uint  frame;
+   float ft;
+   frameAt( time, frame, ft );
+   Vec3f pos;
+   float scale;
+   root( ft, pos, scale );
+
+   // Orientations (root first).
+   Quatf rootOrient;
+   sampleTrack( _tracks[0], frame, ft, rootOrient );
+   Quatf* dq = dst.bones().begin();
+   for( const Track* track = _tracks.begin() + 1; track != _tracks.end(); ++track, ++dq )
+   {
+      Quatf q;
+      sampleTrack( *track, frame, ft, q );
+      if( factor == 1.0f )
+      {
+         *dq = q;
+      }
+      else
+      {
+         nlerp( dq->ptr(), q.ptr(), factor, dq->ptr() );
+      }
+   }
+
+   Reff ref( rootOrient, pos, scale );
+   dst.referential( (factor == 1.0f) ? ref : dst.referential().nlerp( ref, factor ) );
+}
+
+NAMESPACE_END
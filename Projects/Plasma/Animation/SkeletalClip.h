@@ -0,0 +1,177 @@
+/*=============================================================================
+   Copyright (c) 2012, Ludo Sapiens Inc. and contributors.
+   See accompanying file LICENSE.txt for details.
+=============================================================================*/
+#ifndef PLASMA_SKELETALCLIP_H
+#define PLASMA_SKELETALCLIP_H
+
+#include <Plasma/StdDefs.h>
+
+#include <CGMath/CGConst.h>
+#include <CGMath/Quat.h>
+#include <CGMath/Vec3.h>
+
+#include <Base/ADT/Vector.h>
+#include <Base/Util/RCObject.h>
+#include <Base/Util/RCP.h>
+
+NAMESPACE_BEGIN
+
+class PoseBatch;
+class SkeletalAnimation;
+class SkeletalPose;
+
+/*==============================================================================
+  CLASS SkeletalClip
+==============================================================================*/
+
+//! A compressed, read-only copy of a SkeletalAnimation.
+//! Every orientation (the root's and the bones') is a track of keyframes, where
+//! the frames which can be interpolated from their neighbors within an error
+//! bound are dropped. The remaining keys store their quaternion with the
+//! smallest three components quantized to 15 bits, and all the tracks are laid
+//! out one after the other in a single array.
+//! The root position and scale are a separate track of full precision keys.
+//! Sampling decodes and interpolates (nlerp) every track in a single pass, and
+//! wraps the time the same way as SkeletalAnimation::getPoses().
+
+class SkeletalClip:
+   public RCObject
+{
+
+public:
+
+   /*----- static methods -----*/
+
+   // maxAngle is in radians, and maxDistance in the units of the root position.
+   static PLASMA_DLL_API RCP<SkeletalClip> create(
+      const SkeletalAnimation& anim,
+      float                    maxAngle    = 0.002f,
+      float                    maxDistance = 0.001f
+   );
+
+   /*----- methods -----*/
+
+   inline uint  numBones() const        { return _tracks.empty() ? 0 : uint(_tracks.size()) - 1; }
+   inline uint  numFrames() const       { return _numFrames; }
+   inline uint  numKeys() const         { return uint(_keys.size()); }
+   inline uint  numRootKeys() const     { return uint(_rootKeys.size()); }
+   inline float rate() const            { return _rate; }
+   inline float duration() const        { return _duration; }
+
+   PLASMA_DLL_API size_t  sizeInBytes() const;
+
+   // Sets dst (already holding numBones() bones) to the pose at the specified time.
+   PLASMA_DLL_API void  sample( float time, SkeletalPose& dst ) const;
+   // Blends dst toward the pose at the specified time: dst = nlerp( dst, pose, factor ).
+   PLASMA_DLL_API void  blend( float time, float factor, SkeletalPose& dst ) const;
+
+protected:
+
+   /*----- types -----*/
+
+   //! A quantized orientation key.
+   struct Key
+   {
+      uint16_t  _frame;
+      uint16_t  _v[3];  //!< The smallest three components, with the index of the largest in the top bits of _v[0] and _v[1].
+   };
+
+   //! A root position and scale key.
+   struct RootKey
+   {
+      float  _frame;
+      Vec3f  _pos;
+      float  _scale;
+   };
+
+   //! The range of _keys holding a track.
+   struct Track
+   {
+      uint32_t  _first;
+      uint32_t  _count;
+   };
+
+   /*----- methods -----*/
+
+   SkeletalClip();
+   virtual ~SkeletalClip();
+
+   static Key    encode( uint frame, const Quatf& q );
+   static Quatf  decode( const Key& key );
+   static inline void  unpack( const Key& key, float* dst );
+
+   inline void  frameAt( float time, uint& frame, float& ft ) const;
+   inline const Key*  findKey( const Track& track, uint frame ) const;
+   void  root( float ft, Vec3f& pos, float& scale ) const;
+   inline void  sampleTrack( const Track& track, uint frame, float time, Quatf& dst ) const;
+   void  evaluate( float time, float factor, SkeletalPose& dst ) const;
+
+private:
+
+   friend class PoseBatch;
+
+   /*----- data members -----*/
+
+   Vector<Track>        _tracks;   //!< The root orientation, then every bone.
+   Vector<Key>          _keys;
+   Vector<RootKey>      _rootKeys;
+   uint                 _numFrames;
+   float                _rate;
+   float                _duration;
+};
+
+//------------------------------------------------------------------------------
+//! Writes the smallest three components of a key (dequantized), followed by the
+//! index of the largest one.
+inline void
+SkeletalClip::unpack( const Key& key, float* dst )
+{
+   const float scale  = CGConstf::sqrt2() / 32767.0f;
+   const float offset = 0.5f * CGConstf::sqrt2();
+
+   dst[0] = float(key._v[0] & 0x7FFF)*scale - offset;
+   dst[1] = float(key._v[1] & 0x7FFF)*scale - offset;
+   dst[2] = float(key._v[2] & 0x7FFF)*scale - offset;
+   dst[3] = float( (key._v[0] >> 15) | ((key._v[1] >> 15) << 1) );
+}
+
+//------------------------------------------------------------------------------
+//! Returns the integer frame (wrapped the same way as
+//! SkeletalAnimation::getPoses()) and the fractional one at the specified time.
+inline void
+SkeletalClip::frameAt( float time, uint& frame, float& ft ) const
+{
+   frame = 0;
+   float t = 0.0f;
+   if( _numFrames > 1 )
+   {
+      float p = CGM::max( 0.0f, time*_rate );
+      frame   = uint(p);
+      t       = p - float(frame);
+      frame  %= _numFrames-1;
+   }
+   ft = float(frame) + t;
+}
+
+//------------------------------------------------------------------------------
+//! Returns the last key of a track at or before the frame.
+//! The keys are integer frames, so comparing with the integer part of the time
+//! is enough (and the search is branchless).
+inline const SkeletalClip::Key*
+SkeletalClip::findKey( const Track& track, uint frame ) const
+{
+   const Key* k = _keys.data() + track._first;
+   uint n = track._count;
+   while( n > 1 )
+   {
+      uint half = n >> 1;
+      k  = (k[half]._frame <= frame) ? k + half : k;
+      n -= half;
+   }
+   return k;
+}
+
+NAMESPACE_END
+
+#endif
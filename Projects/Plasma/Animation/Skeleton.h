@@ -278,6 +278,7 @@ public:
 
 private:
 
+   friend class PoseBatch;
    friend class Puppeteer;
 
    /*----- data members -----*/
@@ -148,7 +148,21 @@ void terminateAnimNodes()
 RCP<SkeletalAnimation>
 DFAnimOutput::getAnimation()
 {
-   return _delegate();
+   if( !cacheHit() )
+   {
+      _result = _delegate();
+      cacheStore();
+   }
+   return _result;
+}
+
+//------------------------------------------------------------------------------
+//!
+bool
+DFAnimOutput::evaluate()
+{
+   getAnimation();
+   return true;
 }
 
 //------------------------------------------------------------------------------
@@ -37,6 +37,7 @@ public:
 
    PLASMA_DLL_API RCP<SkeletalAnimation> getAnimation();
    PLASMA_DLL_API virtual Type type() const;
+   PLASMA_DLL_API virtual bool evaluate();
 
    void delegate( const ProcessDelegate& d ) { _delegate = d; }
 
@@ -45,6 +46,7 @@ protected:
    /*----- data members -----*/
 
    ProcessDelegate _delegate;
+   RCP<SkeletalAnimation> _result;
 };
 
 /*==============================================================================
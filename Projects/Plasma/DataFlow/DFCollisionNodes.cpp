@@ -192,6 +192,9 @@ DFAutoCollisionNode::process()
    RCP<DFGeometry> geom = _input.getGeometry();
    if( geom.isNull() ) return nullptr;
 
+   // Don't work on the current version.
+   geom = geom->clone();
+
    // Type 0 is MANUAL so we add +1.
    geom->collisionType( (Geometry::CollisionType)(_type+1) );
 
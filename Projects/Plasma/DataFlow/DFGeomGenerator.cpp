@@ -935,7 +935,7 @@ DFExtrudePolyNode::process()
    // Do we have a valid input?
    if( poly.isNull() ) return nullptr;
 
-   poly->computeDerivedData();
+   // The polygon is shared (and its derived data already computed by its node).
    return DFGeomOps::extrude( *poly, _height );
 }
 
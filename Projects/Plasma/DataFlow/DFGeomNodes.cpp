@@ -188,7 +188,21 @@ void terminateGeomNodes()
 RCP<DFGeometry>
 DFGeomOutput::getGeometry()
 {
-   return _delegate();
+   if( !cacheHit() )
+   {
+      _result = _delegate();
+      cacheStore();
+   }
+   return _result;
+}
+
+//------------------------------------------------------------------------------
+//!
+bool
+DFGeomOutput::evaluate()
+{
+   getGeometry();
+   return true;
 }
 
 //------------------------------------------------------------------------------
@@ -970,6 +984,14 @@ DFGeomImportNode::isGraph() const
    return true;
 }
 
+//------------------------------------------------------------------------------
+//! The imported graph is a shared resource, evaluated with its own cache.
+bool
+DFGeomImportNode::isConcurrent() const
+{
+   return false;
+}
+
 //------------------------------------------------------------------------------
 //!
 DFOutput*
@@ -1033,6 +1055,7 @@ DFGeomImportNode::process()
    DFOutput* out = outNode->output();
    if( out == nullptr || out->type() != DFOutput::GEOMETRY )  return nullptr;
 
+   _geomGraph->evaluate( outNode );
    DFGeomOutput* outg = (DFGeomOutput*)out;
    return outg->getGeometry();
 }
@@ -38,6 +38,7 @@ public:
 
    PLASMA_DLL_API RCP<DFGeometry> getGeometry();
    PLASMA_DLL_API virtual Type type() const;
+   PLASMA_DLL_API virtual bool evaluate();
 
    void delegate( const ProcessDelegate& d ) { _delegate = d; }
 
@@ -46,6 +47,7 @@ protected:
    /*----- data members -----*/
 
    ProcessDelegate  _delegate;
+   RCP<DFGeometry>  _result;
 };
 
 /*==============================================================================
@@ -334,6 +336,7 @@ public:
    PLASMA_DLL_API virtual const ConstString& name() const;
 
    PLASMA_DLL_API virtual bool isGraph() const;
+   PLASMA_DLL_API virtual bool isConcurrent() const;
 
    // Input/output.
    PLASMA_DLL_API virtual DFOutput* output();
@@ -3,6 +3,10 @@
    See accompanying file LICENSE.txt for details.
 =============================================================================*/
 #include <Plasma/DataFlow/DFGraph.h>
+#include <Plasma/Plasma.h>
+
+#include <Base/ADT/Map.h>
+#include <Base/MT/TaskQueue.h>
 
 /*==============================================================================
   UNNAME NAMESPACE
@@ -12,6 +16,8 @@ UNNAMESPACE_BEGIN
 
 const char* _graph_str = "dfgraph";
 
+typedef Map< DFNode*, Vector<DFNode*> >  ProducerMap;
+
 //------------------------------------------------------------------------------
 //!
 void addNodeToGrid( DFNode* node, DFGraph::Grid& grid )
@@ -80,18 +86,80 @@ void updateOutput( DFNode* node, Set<DFNode*>& update )
    }
 }
 
+//------------------------------------------------------------------------------
+//! Places a dirty node in the schedule and returns its level: 0 when none of
+//! its producers need evaluating, and one more than its highest dirty producer
+//! otherwise. Nodes are appended in depth-first order, so the schedule only
+//! depends on the graph.
+int scheduleNode(
+   DFNode*                    node,
+   const ProducerMap&         producers,
+   Map<DFNode*, int>&         levels,
+   Vector< Vector<DFNode*> >& schedule
+)
+{
+   auto lit = levels.find( node );
+   if( lit != levels.end() ) return (*lit).second;
+
+   int level = 0;
+   auto pit  = producers.find( node );
+   if( pit != producers.end() )
+   {
+      const Vector<DFNode*>& prods = (*pit).second;
+      for( auto it = prods.begin(); it != prods.end(); ++it )
+      {
+         if( !(*it)->output()->isDirty() ) continue;
+         level = CGM::max( level, scheduleNode( *it, producers, levels, schedule ) + 1 );
+      }
+   }
+
+   levels[node] = level;
+   if( schedule.size() <= size_t(level) ) schedule.resize( level+1 );
+   schedule[level].pushBack( node );
+   return level;
+}
+
 UNNAMESPACE_END
 
 
 NAMESPACE_BEGIN
 
+/*==============================================================================
+   CLASS DFGraph::EvaluateLoop
+==============================================================================*/
+//! Evaluates a range of independent nodes (see TaskQueue::parallelFor()).
+class DFGraph::EvaluateLoop
+{
+public:
+
+   /*----- methods -----*/
+
+   EvaluateLoop( DFNode* const* nodes ): _nodes( nodes ) {}
+
+   void operator()( uint begin, uint end, WorkerTask& )
+   {
+      for( uint i = begin; i < end; ++i )
+      {
+         _nodes[i]->output()->evaluate();
+      }
+   }
+
+protected:
+
+   /*----- data members -----*/
+
+   DFNode* const*  _nodes;
+};
+
 /*==============================================================================
    CLASS DFGraph
 ==============================================================================*/
 
 //------------------------------------------------------------------------------
 //!
-DFGraph::DFGraph(): _lockUpdate(0), _output(nullptr)
+DFGraph::DFGraph():
+   _lockUpdate(0), _output(nullptr),
+   _generation(1), _cacheHits(0), _cacheMisses(0)
 {
    CHECK( &(_messenger.graph()) == this );
 }
@@ -109,6 +177,13 @@ bool DFGraph::addNode( DFNode* node, const Vec2i& pos, int width )
    node->_width    = width;
    _nodes.pushBack( node );
 
+   DFOutput* output = node->output();
+   if( output )
+   {
+      output->_graph = this;
+      output->cacheInvalidate();
+   }
+
    if( _output == nullptr )  _output = node;
 
    // Add node position to the grid.
@@ -145,6 +220,13 @@ void DFGraph::removeNode( DFNode* node )
    }
    node->_graph = nullptr;
 
+   DFOutput* output = node->output();
+   if( output )
+   {
+      output->_graph = nullptr;
+      output->cacheInvalidate();
+   }
+
    // Remove this node from update.
    _update.remove( node );
    // Add all outputs to update.
@@ -364,11 +446,101 @@ DFNode* DFGraph::getNode( const Vec2i& pos ) const
 //!
 void DFGraph::invalidate( DFNode* node )
 {
+   ++_generation;
+   invalidateDownstream( node );
    msg().update( node );
-   // FIXME: for now since there is no caching we just call an update.
    msg().update();
 }
 
+//------------------------------------------------------------------------------
+//! Evaluates every dirty node the specified node depends on, then the node
+//! itself, leaving the results in the output caches.
+//! Dirty nodes are sorted by level; nodes on the same level are independent, so
+//! the concurrent ones (see DFNode::isConcurrent()) run on the queue while the
+//! others run on the calling thread. A null queue evaluates everything serially.
+//! Like TaskQueue::parallelFor(), this must not be called from inside a task.
+void DFGraph::evaluate( DFNode* node, TaskQueue* queue )
+{
+   if( node == nullptr || node->output() == nullptr || !node->output()->isDirty() ) return;
+
+   // Find the producers of every consumer.
+   ProducerMap producers;
+   for( auto it = _nodes.begin(); it != _nodes.end(); ++it )
+   {
+      DFOutput* output = (*it)->output();
+      if( output == nullptr ) continue;
+      uint n = output->numInputs();
+      for( uint i = 0; i < n; ++i )
+      {
+         producers[output->inputs()[i]->node()].pushBack( (*it).ptr() );
+      }
+   }
+
+   Map<DFNode*, int>         levels;
+   Vector< Vector<DFNode*> > schedule;
+   scheduleNode( node, producers, levels, schedule );
+
+   Vector<DFNode*> concurrent;
+   for( auto lit = schedule.begin(); lit != schedule.end(); ++lit )
+   {
+      concurrent.clear();
+      for( auto it = (*lit).begin(); it != (*lit).end(); ++it )
+      {
+         if( queue && (*it)->isConcurrent() )
+         {
+            concurrent.pushBack( *it );
+         }
+         else
+         {
+            (*it)->output()->evaluate();
+         }
+      }
+      if( concurrent.size() > 1 )
+      {
+         EvaluateLoop loop( concurrent.data() );
+         queue->parallelFor( 0, uint(concurrent.size()), 1, loop );
+      }
+      else if( !concurrent.empty() )
+      {
+         concurrent[0]->output()->evaluate();
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//!
+TaskQueue*
+DFGraph::defaultQueue()
+{
+   return Plasma::dispatchQueue();
+}
+
+//------------------------------------------------------------------------------
+//! Marks the node and everything reading from it as dirty.
+//! Upstream nodes keep their cached results.
+void DFGraph::invalidateDownstream( DFNode* node )
+{
+   Set<DFNode*>    visited;
+   Vector<DFNode*> stack;
+   stack.pushBack( node );
+   while( !stack.empty() )
+   {
+      DFNode* cur = stack.back();
+      stack.popBack();
+      if( visited.has( cur ) ) continue;
+      visited.add( cur );
+
+      DFOutput* output = cur->output();
+      if( output == nullptr ) continue;
+      output->cacheInvalidate();
+      uint n = output->numInputs();
+      for( uint i = 0; i < n; ++i )
+      {
+         stack.pushBack( output->inputs()[i]->node() );
+      }
+   }
+}
+
 //------------------------------------------------------------------------------
 //!
 void DFGraph::updateConnections()
@@ -376,6 +548,13 @@ void DFGraph::updateConnections()
    // Can we update?
    if( _lockUpdate > 0 ) return;
 
+   // Reconnected nodes, and whatever reads from them, must be re-evaluated.
+   ++_generation;
+   for( auto it = _update.begin(); it != _update.end(); ++it )
+   {
+      invalidateDownstream( *it );
+   }
+
    Vector<DFNode*> inputs;
    auto gend = _grid.end();
    for( auto it = _update.begin(); it != _update.end(); ++it )
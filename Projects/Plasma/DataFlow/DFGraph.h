@@ -18,9 +18,12 @@
 #include <Base/ADT/Vector.h>
 #include <Base/ADT/Set.h>
 #include <Base/ADT/HashTable.h>
+#include <Base/MT/Atomic.h>
 
 NAMESPACE_BEGIN
 
+class TaskQueue;
+
 /*==============================================================================
    CLASS DFGraph
 ==============================================================================*/
@@ -34,6 +37,7 @@ public:
    /*----- classes -----*/
 
    class UpdateLock;
+   class EvaluateLoop;
 
    struct Vec2iHash
    {
@@ -73,6 +77,16 @@ public:
 
    PLASMA_DLL_API void invalidate( DFNode* );
 
+   // Evaluation.
+   PLASMA_DLL_API void evaluate( DFNode*, TaskQueue* queue );
+   inline         void evaluate( DFNode* node ) { evaluate( node, defaultQueue() ); }
+
+   // Evaluation cache.
+   inline uint generation() const  { return _generation; }
+   inline uint cacheHits() const   { return uint(int32_t(_cacheHits)); }
+   inline uint cacheMisses() const { return uint(int32_t(_cacheMisses)); }
+   inline void resetCacheStats()   { _cacheHits = 0; _cacheMisses = 0; }
+
    // Messages.
    inline       DFMessenger&  msg()       { return _messenger; }
    inline const DFMessenger&  msg() const { return _messenger; }
@@ -89,11 +103,15 @@ protected:
    /*----- friends -----*/
 
    friend class DFMessenger;
+   friend class DFOutput;
    friend class UpdateLock;
 
    /*----- methods -----*/
 
    void updateConnections();
+   void invalidateDownstream( DFNode* );
+
+   static PLASMA_DLL_API TaskQueue*  defaultQueue();
 
    /*----- data members -----*/
 
@@ -103,6 +121,9 @@ protected:
    Grid           _grid;
    Set<DFNode*>   _update;
    DFMessenger    _messenger;
+   uint           _generation;
+   AtomicInt32    _cacheHits;
+   AtomicInt32    _cacheMisses;
 };
 
 /*==============================================================================
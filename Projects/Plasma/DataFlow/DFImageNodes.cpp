@@ -212,7 +212,14 @@ DFImageParams::bitmapToRegion() const
 RCP<Bitmap>
 DFImageOutput::getImage( const DFImageParams& p )
 {
-   return _delegate( p );
+   // Only the last requested region is kept; a different one is a miss.
+   if( !cacheHit( _params == p ) )
+   {
+      _result = _delegate( p );
+      _params = p;
+      cacheStore();
+   }
+   return _result;
 }
 
 //------------------------------------------------------------------------------
@@ -77,6 +77,8 @@ protected:
    /*----- data members -----*/
 
    ProcessDelegate _delegate;
+   RCP<Bitmap>     _result;
+   DFImageParams   _params;  //!< The parameters _result was computed for.
 };
 
 /*==============================================================================
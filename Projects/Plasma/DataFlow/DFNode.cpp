@@ -3,6 +3,7 @@
    See accompanying file LICENSE.txt for details.
 =============================================================================*/
 #include <Plasma/DataFlow/DFNode.h>
+#include <Plasma/DataFlow/DFGraph.h>
 #include <Plasma/DataFlow/DFNodeAttr.h>
 #include <Plasma/Manipulator/Manipulator.h>
 
@@ -49,6 +50,44 @@ DFSocket::toStr( Type type )
 }
 
 
+/*==============================================================================
+   CLASS DFOutput
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//! Returns true if the cached result is still valid, and counts the lookup.
+//! Outputs taking parameters pass whether they match the cached ones.
+bool
+DFOutput::cacheHit( bool sameRequest )
+{
+   if( _graph == nullptr ) return false;
+   if( _generation != 0 && sameRequest )
+   {
+      ++_graph->_cacheHits;
+      return true;
+   }
+   ++_graph->_cacheMisses;
+   return false;
+}
+
+//------------------------------------------------------------------------------
+//! Stamps the result just computed with the current graph generation.
+void
+DFOutput::cacheStore()
+{
+   if( _graph ) _generation = _graph->generation();
+}
+
+//------------------------------------------------------------------------------
+//! Computes and caches the result ahead of its consumers (see DFGraph::evaluate()).
+//! Returns false for outputs which need parameters to be evaluated.
+bool
+DFOutput::evaluate()
+{
+   return false;
+}
+
+
 /*==============================================================================
    CLASS DFNode
 ==============================================================================*/
@@ -84,6 +123,23 @@ bool DFNode::isGraph() const
    return false;
 }
 
+//------------------------------------------------------------------------------
+//! Returns true if the node can be evaluated on a worker thread alongside other
+//! nodes. Geometry nodes only compute from their inputs; the other types can
+//! load resources, touch the GPU or need image parameters, so they stay on the
+//! calling thread unless they say otherwise.
+bool DFNode::isConcurrent() const
+{
+   if( type() != DFSocket::GEOMETRY ) return false;
+   uint n = numInputs();
+   for( uint i = 0; i < n; ++i )
+   {
+      const DFInput* in = input(i);
+      if( in && in->type() == DFSocket::IMAGE ) return false;
+   }
+   return true;
+}
+
 //------------------------------------------------------------------------------
 //!
 uint DFNode::numInputs() const
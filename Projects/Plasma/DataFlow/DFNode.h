@@ -66,15 +66,26 @@ public:
    CLASS DFOutput
 ==============================================================================*/
 
+//! An output keeps the last result it produced, stamped with the graph
+//! generation it was computed in (0 when dirty or never evaluated).
+//! DFGraph::invalidate() clears the stamp of the edited node and of every node
+//! downstream of it, so upstream results are reused on the next evaluation.
 class DFOutput:
    public DFSocket
 {
 public:
 
+   DFOutput(): _graph( nullptr ), _generation( 0 ) {}
+
    inline bool isConnected() const               { return !_inputs.empty(); }
    inline uint numInputs() const                 { return uint(_inputs.size()); }
    inline const Vector<DFInput*>& inputs() const { return _inputs; }
 
+   inline bool isDirty() const    { return _generation == 0; }
+   inline uint generation() const { return _generation; }
+
+   PLASMA_DLL_API virtual bool evaluate();
+
 protected:
 
    /*----- friends -----*/
@@ -87,9 +98,16 @@ protected:
    void connect( DFInput* input )    { _inputs.pushBack( input ); }
    void disconnect( DFInput* input ) { _inputs.removeSwap( input ); }
 
+   // Cache.
+   PLASMA_DLL_API bool  cacheHit( bool sameRequest = true );
+   PLASMA_DLL_API void  cacheStore();
+   void  cacheInvalidate() { _generation = 0; }
+
    /*----- data members -----*/
 
    Vector<DFInput*> _inputs;
+   DFGraph*         _graph;      //!< The graph owning this output (none means no caching).
+   uint             _generation; //!< The graph generation of the cached result.
 };
 
 /*==============================================================================
@@ -175,6 +193,7 @@ public:
    PLASMA_DLL_API const DFNodeSpec& spec() const;
 
    PLASMA_DLL_API virtual bool isGraph() const;
+   PLASMA_DLL_API virtual bool isConcurrent() const;
 
    // Input/output.
    PLASMA_DLL_API virtual uint numInputs() const;
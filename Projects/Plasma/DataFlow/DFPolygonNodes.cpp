@@ -116,7 +116,21 @@ void terminatePolygonNodes()
 RCP<DFPolygon>
 DFPolygonOutput::getPolygon()
 {
-   return _delegate();
+   if( !cacheHit() )
+   {
+      _result = _delegate();
+      cacheStore();
+   }
+   return _result;
+}
+
+//------------------------------------------------------------------------------
+//!
+bool
+DFPolygonOutput::evaluate()
+{
+   getPolygon();
+   return true;
 }
 
 //------------------------------------------------------------------------------
@@ -742,10 +756,14 @@ DFPolygonNode::input( uint )
 }
 
 //------------------------------------------------------------------------------
-//!
+//! The derived data (plane and area) is computed here, before the polygon gets
+//! published, since the nodes consuming it may run concurrently and must only
+//! read it.
 RCP<DFPolygon>
 DFPolygonNode::process()
 {
+   _polygon->computeDerivedData();
+   if( _polygon->numVertices() >= 3 )  _polygon->area();
    return _polygon;
 }
 
@@ -313,7 +313,21 @@ void terminateStrokesNodes()
 RCP<DFStrokes>
 DFStrokesOutput::getStrokes()
 {
-   return _delegate();
+   if( !cacheHit() )
+   {
+      _result = _delegate();
+      cacheStore();
+   }
+   return _result;
+}
+
+//------------------------------------------------------------------------------
+//!
+bool
+DFStrokesOutput::evaluate()
+{
+   getStrokes();
+   return true;
 }
 
 //------------------------------------------------------------------------------
@@ -467,6 +481,16 @@ DFStrokesToGeometryNode::numInputs() const
    return 1;
 }
 
+//------------------------------------------------------------------------------
+//! DFStrokes lazily builds its blocks and surface when asked for its geometry,
+//! and the same strokes can feed several nodes, so this stays on the calling
+//! thread like the nodes producing the strokes.
+bool
+DFStrokesToGeometryNode::isConcurrent() const
+{
+   return false;
+}
+
 //------------------------------------------------------------------------------
 //!
 DFOutput*
@@ -42,6 +42,7 @@ public:
 
    PLASMA_DLL_API RCP<DFStrokes> getStrokes();
    PLASMA_DLL_API virtual Type type() const;
+   PLASMA_DLL_API virtual bool evaluate();
 
    void delegate( const ProcessDelegate& d ) { _delegate = d; }
 
@@ -50,6 +51,7 @@ protected:
    /*----- data members -----*/
 
    ProcessDelegate  _delegate;
+   RCP<DFStrokes>   _result;
 };
 
 /*==============================================================================
@@ -132,6 +134,8 @@ public:
    // Attributes.
    PLASMA_DLL_API virtual const ConstString& name() const;
 
+   PLASMA_DLL_API virtual bool isConcurrent() const;
+
    // Input/output.
    PLASMA_DLL_API virtual uint numInputs() const;
 
@@ -410,7 +410,21 @@ void terminateWorldNodes()
 RCP<DFWorld>
 DFWorldOutput::getWorld()
 {
-   return _delegate();
+   if( !cacheHit() )
+   {
+      _result = _delegate();
+      cacheStore();
+   }
+   return _result;
+}
+
+//------------------------------------------------------------------------------
+//!
+bool
+DFWorldOutput::evaluate()
+{
+   getWorld();
+   return true;
 }
 
 //------------------------------------------------------------------------------
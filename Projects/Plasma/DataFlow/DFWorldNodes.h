@@ -41,6 +41,7 @@ public:
 
    PLASMA_DLL_API RCP<DFWorld> getWorld();
    PLASMA_DLL_API virtual Type type() const;
+   PLASMA_DLL_API virtual bool evaluate();
 
    void delegate( const ProcessDelegate& d ) { _delegate = d; }
 
@@ -49,6 +50,7 @@ protected:
    /*----- data members -----*/
 
    ProcessDelegate _delegate;
+   RCP<DFWorld>    _result;
 };
 
 /*==============================================================================
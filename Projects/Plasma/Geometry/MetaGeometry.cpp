@@ -5,6 +5,7 @@
 #include <Plasma/Geometry/MetaGeometry.h>
 #include <Plasma/Geometry/MeshGeometry.h>
 #include <Plasma/Intersector.h>
+#include <Plasma/Plasma.h>
 
 #include <Fusion/Core/Core.h>
 
@@ -569,7 +570,8 @@ MetaGeometry::MetaGeometry():
    _hePool(64),
    _fPool(64),
    _vPool(64),
-   _grid(0)
+   _grid(0),
+   _queue( Plasma::dispatchQueue() )
 {
    // FIXME: find better value for pool.
    _grid    = new HGrid();
@@ -598,7 +600,7 @@ MetaGeometry::update()
    updateControlMesh();
 
    // 4. Create subdivision mesh (MetaSurface::Subpatch).
-   _surface->subdivide( _gerror, _derror );
+   _surface->subdivide( _gerror, _derror, _queue );
    
    // 5. CSG
 #ifndef BLOCKS
@@ -1626,19 +1628,20 @@ MetaGeometry::computeRenderableGeometry()
    std::sort( patches.begin(), patches.end(), materialSort );
 
    // 2. Triangulate and create patch info for mesh.
+   Vector<uint> ends;
+   _surface->triangulate( patches, vertices, indices, 0, &ends, true, _queue );
    Geometry::clearPatches();
    uint id   = (patches[0]->_id & 0x1fffffff);
    uint sidx = 0;
-   for( uint i = 0; i < patches.size(); ++i )
+   for( uint i = 1; i < patches.size(); ++i )
    {
       uint cid = (patches[i]->_id & 0x1fffffff);
       if( cid != id )
       {
-         Geometry::addPatch( sidx, uint(indices.size())-sidx, id );
-         sidx = uint(indices.size());
+         Geometry::addPatch( sidx, ends[i-1]-sidx, id );
+         sidx = ends[i-1];
          id   = cid;
       }
-      _surface->triangulate( *patches[i], vertices, indices, 0, true );
    }
    Geometry::addPatch( sidx, uint(indices.size())-sidx, id );
 
@@ -1715,11 +1718,8 @@ MetaGeometry::triangulate(
    }
    std::sort( patches.begin(), patches.end(), materialSort );
 
-   // 2. Triangulate and create patch info for mesh.
-   for( uint i = 0; i < patches.size(); ++i )
-   {
-      _surface->triangulate( *patches[i], vertices, indices, faceInfos, normals );
-   }
+   // 2. Triangulate.
+   _surface->triangulate( patches, vertices, indices, faceInfos, 0, normals, _queue );
 }
 
 //------------------------------------------------------------------------------
@@ -1744,18 +1744,19 @@ MetaGeometry::createMesh( MeshGeometry& mesh, Vector<uint>* faceInfos ) const
    std::sort( patches.begin(), patches.end(), materialSort );
 
    // 2. Triangulate and create patch info for mesh.
+   Vector<uint> ends;
+   _surface->triangulate( patches, vertices, indices, faceInfos, &ends, true, _queue );
    uint id   = (patches[0]->_id & 0x1fffffff);
    uint sidx = 0;
-   for( uint i = 0; i < patches.size(); ++i )
+   for( uint i = 1; i < patches.size(); ++i )
    {
       uint cid = (patches[i]->_id & 0x1fffffff);
       if( cid != id )
       {
-         mesh.addPatch( sidx, uint(indices.size())-sidx, id );
-         sidx = uint(indices.size());
+         mesh.addPatch( sidx, ends[i-1]-sidx, id );
+         sidx = ends[i-1];
          id   = cid;
       }
-      _surface->triangulate( *patches[i], vertices, indices, faceInfos, true );
    }
    mesh.addPatch( sidx, uint(indices.size())-sidx, id );
 
@@ -15,6 +15,8 @@
 
 NAMESPACE_BEGIN
 
+class TaskQueue;
+
 /*==============================================================================
    CLASS MetaFunction
 ==============================================================================*/
@@ -26,7 +28,7 @@ class MetaFunction:
 
    /*----- methods -----*/
 
-   MetaFunction() 
+   MetaFunction(): _batched( false )
    {
       _params = new Table();
    }
@@ -37,12 +39,18 @@ class MetaFunction:
    inline VMByteCode& code()              { return _code; }
    inline const VMByteCode& code() const  { return _code; }
 
+   // Set when the function is called once per patch, with arrays of points in
+   // IN, and returns an array of results (rather than once per point).
+   inline bool batched() const            { return _batched; }
+   inline void batched( bool v )          { _batched = v; }
+
    protected:
 
    /*----- data members -----*/
 
    RCP<Table> _params;
    VMByteCode _code;
+   bool       _batched;
 };
 
 /*==============================================================================
@@ -190,7 +198,16 @@ public:
 
    /*----- methods -----*/
 
-   MetaGeometry();
+   PLASMA_DLL_API MetaGeometry();
+
+   // The queue used to subdivide and triangulate the patches concurrently
+   // (defaults to Plasma::dispatchQueue(); null for the calling thread only).
+   inline TaskQueue*  queue() const         { return _queue; }
+   inline void        queue( TaskQueue* q ) { _queue = q; }
+
+   // How the mapping and displacement functions get called (see MetaSurface::batchFunctions()).
+   inline bool  batchFunctions() const   { return _surface->batchFunctions(); }
+   inline void  batchFunctions( bool v ) { _surface->batchFunctions( v ); }
 
    // Intersection.
    inline bool trace( const Rayf& );
@@ -270,6 +287,8 @@ private:
 
    // Spatial structure.
    HGrid*                        _grid;
+
+   TaskQueue*                    _queue;
 };
 
 //------------------------------------------------------------------------------
@@ -292,7 +311,7 @@ MetaGeometry::trace( const Rayf& ray, Intersector::Hit& hit )
    CLASS MetaBuilder
 ==============================================================================*/
 
-class MetaBuilder:
+class PLASMA_DLL_API MetaBuilder:
    public RCObject
 {
 public:
@@ -14,6 +14,8 @@
 
 #include <Base/ADT/Cache.h>
 #include <Base/ADT/StringMap.h>
+#include <Base/MT/Lock.h>
+#include <Base/MT/TaskQueue.h>
 
 #include <algorithm>
 
@@ -40,8 +42,12 @@ enum {
    ATTRIB_N,
    ATTRIB_POS,
    ATTRIB_UV,
+   NUM_ATTRIBS
 };
 
+// Indexed by the values above.
+const char* _attributeNames[] = { "id", "f", "fn", "n", "pos", "uv" };
+
 StringMap _attributes(
    "id",    ATTRIB_ID,
    "f",     ATTRIB_FACE,
@@ -52,6 +58,32 @@ StringMap _attributes(
    ""
 );
 
+//------------------------------------------------------------------------------
+//! Calls a mapping or displacement function for every point of a batch, so
+//! that the host makes a single call per patch. Each result is handed to
+//! emit(), which stores it and moves IN to the next point.
+const char* _batchDriver =
+   "return function( f, IN, emit, n, ... )\n"
+   "   for i = 1, n do\n"
+   "      emit( IN, f( IN, ... ) )\n"
+   "   end\n"
+   "end\n";
+
+//------------------------------------------------------------------------------
+//! Sets IN[key] to an array of n values, IN being at index in.
+template< typename T > void
+setArray( VMState* vm, int in, const char* key, const T* values, uint n )
+{
+   VM::push( vm, key );
+   VM::newTable( vm );
+   for( uint i = 0; i < n; ++i )
+   {
+      VM::push( vm, values[i] );
+      VM::seti( vm, -2, i+1 );
+   }
+   VM::set( vm, in );
+}
+
 //------------------------------------------------------------------------------
 //! 
 
@@ -1294,6 +1326,20 @@ protected:
 };
 
 
+/*==============================================================================
+   STRUCT MetaSurface::PatchMesh
+==============================================================================*/
+
+//! The triangulation of a single patch, before its vertices get merged with the
+//! ones of the previous patches (see MetaSurface::merge()).
+struct MetaSurface::PatchMesh
+{
+   Vector<Vertex*>  _vertices;   //!< In order of first use (null when never shared).
+   Vector<float>    _attributes; //!< The attributes of the vertices above.
+   Vector<uint>     _indices;    //!< Indices into _vertices.
+   Vector<uint>     _ids;        //!< The final index of each vertex.
+};
+
 /*==============================================================================
    CLASS MetaSurface::CacheData
 ==============================================================================*/
@@ -1312,6 +1358,43 @@ public:
       Vec3f _pos;
       Vec3f _nor;
       Vec3f _fnor;
+
+      // Batch being evaluated.
+      const Vec2f* _uvs;
+      const Vec3f* _poss;
+      const Vec3f* _nors;
+      Vec2f*       _uvDst;
+      Vec3f*       _posDst;
+      uint         _cur;
+      uint         _num;
+
+      // The attribute names as interned by the VM, indexed by slot.
+      const char*  _keys[NUM_ATTRIBS];
+
+      void load( uint i )
+      {
+         _uv  = _uvs[i];
+         _pos = _poss[i];
+         _nor = _nors[i];
+      }
+
+      int slot( const char* key ) const
+      {
+         // The VM interns its strings, so the keys used in a compiled function
+         // are the very same pointers as the ones retrieved when opening it.
+         for( int i = 0; i < NUM_ATTRIBS; ++i )
+         {
+            if( key == _keys[i] )  return i;
+         }
+         return _attributes[ key ];
+      }
+   };
+
+   //! A displacement image, moved from one cache to another (see swapImage()).
+   struct Image
+   {
+      Vector<Vec3f> _pos;
+      Vec2i         _dim;
    };
 
    /*----- static methods -----*/
@@ -1319,7 +1402,7 @@ public:
    static int context_get( VMState* vm )
    {
       Context* context = *(Context**)VM::toPtr( vm, 1 );
-      switch( _attributes[ VM::toCString( vm, 2 ) ] )
+      switch( context->slot( VM::toCString( vm, 2 ) ) )
       {
          case ATTRIB_ID:     VM::push( vm, context->_id+1 ); return 1;
          case ATTRIB_FACE:   VM::push( vm, context->_fid );  return 1;
@@ -1331,6 +1414,18 @@ public:
       return 0;
    }
 
+   static int context_emit( VMState* vm )
+   {
+      Context* context = *(Context**)VM::toPtr( vm, 1 );
+      uint i = context->_cur;
+      if( context->_posDst )
+         context->_posDst[i] = VM::toVec3f( vm, 2 );
+      else
+         context->_uvDst[i]  = VM::toVec2f( vm, 2 );
+      if( ++context->_cur < context->_num )  context->load( context->_cur );
+      return 0;
+   }
+
    static inline void scanline( 
       const Vec3f* src, 
       int    inc, 
@@ -1357,7 +1452,7 @@ public:
 
    CacheData(): 
       _grid(0), 
-      _vm(0), _mapping(0), _displacement(0), _precision(0.1f),
+      _vm(0), _mapping(0), _displacement(0), _precision(0.1f), _batch(true),
       _lastPatch(0), _lastPp(0), _patches(32), _trimData(0) 
    {}
 
@@ -1376,17 +1471,29 @@ public:
    }
 
    // Mapping and displacement.
+   // The stack holds the batch driver (1), IN (2), the mapping function and
+   // its parameters, then the displacement function and its parameters.
    void openVM()
    {
       _vm             = VM::open( VM_CAT_MATH | VM_CAT_MAT, true );
+      VM::doString( _vm, _batchDriver );
       Context** inObj = (Context**)VM::newObject( _vm, sizeof(Context*) );
       *inObj          =  &_context;
       _displacement   = 0;
       _mapping        = 0;
-      _dStackPos      = 2;
+      _dStackPos      = 3;
 
       VM::newMetaTable( _vm, "IN" );
       VM::set( _vm, -1, "__index", context_get );
+      // Keep the attribute names referenced, so that their interned pointers
+      // stay valid for as long as the VM is open.
+      for( int i = 0; i < NUM_ATTRIBS; ++i )
+      {
+         VM::set( _vm, -1, _attributeNames[i], i );
+         VM::push( _vm, _attributeNames[i] );
+         _context._keys[i] = VM::toCString( _vm, -1 );
+         VM::pop( _vm );
+      }
       VM::setMetaTable( _vm, -2 );
    }
 
@@ -1400,7 +1507,7 @@ public:
    {
       if( _mapping == func ) return;
 
-      VM::pop( _vm, VM::getTop( _vm )-1 );
+      VM::pop( _vm, VM::getTop( _vm )-2 );
       _mapping = func;
 
       if( _mapping )
@@ -1432,25 +1539,103 @@ public:
       }
    }
 
-   Vec2f computeMapping( const Vec3f& pos, const Vec2f& uv, const Vec3f& n )
+   // Replaces the n uvs with the result of the mapping function.
+   void computeMapping( uint n, const Vec3f* pos, const Vec3f* nor, Vec2f* uv )
    {
-      // Set context.
-      _context._pos = pos;
-      _context._nor = n;
-      _context._uv  = uv;
+      _context._uvs    = uv;
+      _context._poss   = pos;
+      _context._nors   = nor;
+      _context._uvDst  = uv;
+      _context._posDst = 0;
+      evaluate( _mapping, 3, _dStackPos-4, n );
+   }
 
-      // Set stack.
-      int numParams = _dStackPos-3;
-      VM::pushValue( _vm, 2 ); // Function.
-      VM::pushValue( _vm, 1 ); // IN.
-      for( int i = 0; i < numParams; ++i )
+   // Runs the function at funcIdx on the batch set in the context.
+   // The stack is restored afterwards, even when the function fails.
+   void evaluate( const MetaFunction* func, int funcIdx, int numParams, uint n )
+   {
+      if( n == 0 )  return;
+      int top = VM::getTop( _vm );
+      if( func->batched() )
       {
-         VM::pushValue( _vm, 3+i );
+         evaluateArrays( funcIdx, numParams, n );
+      }
+      else
+      {
+         evaluatePoints( funcIdx, numParams, n );
+      }
+      VM::setTop( _vm, top );
+   }
+
+   // Calls a batched function once, with arrays of the attributes in IN, then
+   // stores the array it returns; results that are missing are left as is.
+   void evaluateArrays( int funcIdx, int numParams, uint n )
+   {
+      VM::pushValue( _vm, funcIdx ); // Function.
+      VM::newTable( _vm );           // IN.
+      int in = VM::getTop( _vm );
+      VM::push( _vm, "count" ); VM::push( _vm, n );               VM::set( _vm, in );
+      VM::push( _vm, "id" );    VM::push( _vm, _context._id+1 );  VM::set( _vm, in );
+      VM::push( _vm, "f" );     VM::push( _vm, _context._fid );   VM::set( _vm, in );
+      VM::push( _vm, "fn" );    VM::push( _vm, _context._fnor );  VM::set( _vm, in );
+      setArray( _vm, in, "pos", _context._poss, n );
+      setArray( _vm, in, "n",   _context._nors, n );
+      setArray( _vm, in, "uv",  _context._uvs,  n );
+      for( int i = 1; i <= numParams; ++i )
+      {
+         VM::pushValue( _vm, funcIdx+i );
       }
       VM::ecall( _vm, 1+numParams, 1 );
-      Vec2f result = VM::toVec2f( _vm, -1 );
-      VM::pop( _vm );
-      return result;
+
+      if( !VM::isTable( _vm, -1 ) )  return;
+      for( uint i = 0; i < n && VM::geti( _vm, -1, i+1 ); ++i )
+      {
+         if( _context._posDst )
+            _context._posDst[i] = VM::toVec3f( _vm, -1 );
+         else
+            _context._uvDst[i]  = VM::toVec2f( _vm, -1 );
+         VM::pop( _vm );
+      }
+   }
+
+   // Calls a per-point function for every point of the batch.
+   void evaluatePoints( int funcIdx, int numParams, uint n )
+   {
+      _context._cur = 0;
+      _context._num = n;
+      _context.load( 0 );
+
+      if( !_batch )
+      {
+         for( uint i = 0; i < n; ++i )
+         {
+            _context.load( i );
+            VM::pushValue( _vm, funcIdx ); // Function.
+            VM::pushValue( _vm, 2 );       // IN.
+            for( int p = 1; p <= numParams; ++p )
+            {
+               VM::pushValue( _vm, funcIdx+p );
+            }
+            VM::ecall( _vm, 1+numParams, 1 );
+            if( _context._posDst )
+               _context._posDst[i] = VM::toVec3f( _vm, -1 );
+            else
+               _context._uvDst[i]  = VM::toVec2f( _vm, -1 );
+            VM::pop( _vm );
+         }
+         return;
+      }
+
+      VM::pushValue( _vm, 1 );       // Driver.
+      VM::pushValue( _vm, funcIdx ); // Function.
+      VM::pushValue( _vm, 2 );       // IN.
+      VM::push( _vm, context_emit );
+      VM::push( _vm, n );
+      for( int i = 1; i <= numParams; ++i )
+      {
+         VM::pushValue( _vm, funcIdx+i );
+      }
+      VM::ecall( _vm, 4+numParams, 0 );
    }
 
    void computeDisplacement( Patch& p )
@@ -1482,43 +1667,48 @@ public:
       _dimImage.y = CGM::clamp( _dimImage.y, 2, 1024 );
 
       // Allocate/resize.
-      _geomImage.resize( _dimImage.x * _dimImage.y );
+      uint n = _dimImage.x * _dimImage.y;
+      _geomImage.resize( n );
+      _uvs.resize( n );
+      _nors.resize( n );
 
-      // Compute image.
+      // Compute the surface under every texel, which is also what we keep
+      // should the program fail.
       ParametricPatch* pp = paramPatch( &p );
-      int numParams       = VM::getTop( _vm ) - _dStackPos;
       int c               = 0;
-
       for( int y = 0; y < _dimImage.y; ++y  )
       {
          float v = float(y)/float(_dimImage.y-1);
          for( int x = 0; x < _dimImage.x; ++x, ++c )
          {
             float u = float(x)/float(_dimImage.x-1);
-
-            // Set input parameters.
-            _context._uv = Vec2f( u, v );
-            pp->parameters( _context._uv, _context._pos, _context._nor );
-
-            // Execute program.
-            VM::pushValue( _vm, _dStackPos ); // Function.
-            VM::pushValue( _vm, 1 ); // IN.
-            for( int i = 1; i <= numParams; ++i )
-            {
-               VM::pushValue( _vm, _dStackPos+i );
-            }
-            VM::ecall( _vm, 1+numParams, 1 );
-
-            // Read back results.
-            _geomImage[c] = VM::toVec3f( _vm, -1 );
-            VM::pop( _vm );
+            _uvs[c] = Vec2f( u, v );
+            pp->parameters( _uvs[c], _geomImage[c], _nors[c] );
          }
       }
 
+      // Execute program over the whole image at once.
+      _context._uvs    = _uvs.data();
+      _context._poss   = _geomImage.data();
+      _context._nors   = _nors.data();
+      _context._uvDst  = 0;
+      _context._posDst = _geomImage.data();
+      evaluate( _displacement, _dStackPos, VM::getTop( _vm ) - _dStackPos, n );
+
       // Fix boundaries.
    }
 
    void displacementPrecision( float precision ) { _precision = precision; }
+   void batchFunctions( bool v ) { _batch = v; }
+
+   // Exchanges the current displacement image with the specified one.
+   void swapImage( Image& img )
+   {
+      _geomImage.swap( img._pos );
+      Vec2i dim  = _dimImage;
+      _dimImage  = img._dim;
+      img._dim   = dim;
+   }
 
    Vec3f displace( const Vec2f& uv ) const
    {
@@ -1644,6 +1834,7 @@ public:
    Vector<MetaSurface::Vertex*> _vptrs;
    Grid<MetaSurface::Vertex*>*  _grid;
    Context                      _context;
+   PatchMesh                    _mesh;
    
 protected:
 
@@ -1661,8 +1852,11 @@ protected:
    const MetaFunction*                _displacement;
    int                                _dStackPos;
    Vector<Vec3f>                      _geomImage;
+   Vector<Vec2f>                      _uvs;
+   Vector<Vec3f>                      _nors;
    Vec2i                              _dimImage;
    float                              _precision;
+   bool                               _batch;
 
    // Patches.
    MetaSurface::Patch*                _lastPatch;
@@ -1671,6 +1865,155 @@ protected:
    TrimmingData*                      _trimData;
 };
 
+/*==============================================================================
+   CLASS MetaSurface::CachePool
+==============================================================================*/
+
+//! Hands out caches to the tasks working on patches concurrently, since the
+//! parametric patches and the VM of a cache can only serve one thread.
+//! Caches are created on demand, so there are never more than there are
+//! tasks running at once.
+class MetaSurface::CachePool
+{
+public:
+
+   /*----- methods -----*/
+
+   CachePool( bool vm, float precision = 0.0f, bool batch = true ):
+      _vm( vm ), _precision( precision ), _batch( batch )
+   {}
+
+   ~CachePool()
+   {
+      if( !_vm ) return;
+      for( uint i = 0; i < _caches.size(); ++i )
+      {
+         _caches[i]->closeVM();
+      }
+   }
+
+   CacheData* acquire()
+   {
+      {
+         LockGuard lock( _lock );
+         if( !_free.empty() )
+         {
+            CacheData* cache = _free.back();
+            _free.popBack();
+            return cache;
+         }
+      }
+
+      RCP<CacheData> cache = new CacheData();
+      if( _vm )
+      {
+         cache->displacementPrecision( _precision );
+         cache->batchFunctions( _batch );
+         cache->openVM();
+      }
+      LockGuard lock( _lock );
+      _caches.pushBack( cache );
+      return cache.ptr();
+   }
+
+   void release( CacheData* cache )
+   {
+      LockGuard lock( _lock );
+      _free.pushBack( cache );
+   }
+
+protected:
+
+   /*----- data members -----*/
+
+   Lock                     _lock;
+   Vector< RCP<CacheData> > _caches;
+   Vector< CacheData* >     _free;
+   bool                     _vm;
+   float                    _precision;
+   bool                     _batch;
+};
+
+/*==============================================================================
+   CLASS MetaSurface::EvaluateLoop
+==============================================================================*/
+
+//! Computes the mapping and the displacement image of a range of patches
+//! (see TaskQueue::parallelFor()).
+class MetaSurface::EvaluateLoop
+{
+public:
+
+   /*----- methods -----*/
+
+   EvaluateLoop( CachePool& pool, Patch* const* patches, CacheData::Image* images ):
+      _pool( pool ), _patches( patches ), _images( images )
+   {}
+
+   void operator()( uint begin, uint end, WorkerTask& )
+   {
+      CacheData* cache = _pool.acquire();
+      for( uint i = begin; i < end; ++i )
+      {
+         Patch& p = *_patches[i];
+         MetaSurface::evaluate( *cache, p );
+         if( p._displacement ) cache->swapImage( _images[i] );
+      }
+      _pool.release( cache );
+   }
+
+protected:
+
+   /*----- data members -----*/
+
+   CachePool&         _pool;
+   Patch* const*      _patches;
+   CacheData::Image*  _images;
+};
+
+/*==============================================================================
+   CLASS MetaSurface::TriangulateLoop
+==============================================================================*/
+
+//! Triangulates a range of patches, each one into its own mesh
+//! (see TaskQueue::parallelFor()).
+class MetaSurface::TriangulateLoop
+{
+public:
+
+   /*----- methods -----*/
+
+   TriangulateLoop(
+      const MetaSurface& surface,
+      CachePool&         pool,
+      Patch* const*      patches,
+      PatchMesh*         meshes,
+      bool               normals
+   ):
+      _surface( surface ), _pool( pool ), _patches( patches ), _meshes( meshes ), _normals( normals )
+   {}
+
+   void operator()( uint begin, uint end, WorkerTask& )
+   {
+      CacheData* cache = _pool.acquire();
+      for( uint i = begin; i < end; ++i )
+      {
+         _surface.triangulate( *cache, *_patches[i], _meshes[i], _normals );
+      }
+      _pool.release( cache );
+   }
+
+protected:
+
+   /*----- data members -----*/
+
+   const MetaSurface&  _surface;
+   CachePool&          _pool;
+   Patch* const*       _patches;
+   PatchMesh*          _meshes;
+   bool                _normals;
+};
+
 /*==============================================================================
    CLASS MetaSurface
 ==============================================================================*/
@@ -1700,7 +2043,8 @@ MetaSurface::MetaSurface() :
    _ptPool( 32 ),
    _vPool( 64 ),
    _spPool( 64 ),
-   _pPool( 64 )
+   _pPool( 64 ),
+   _batchFunctions( true )
 {
    // TODO: find better value for pool and hash.
    _cache     = new CacheData;
@@ -1952,27 +2296,60 @@ MetaSurface::neighbors( Patch* p0, uint e0, Patch* p1, uint e1, int crease )
 }
 
 //------------------------------------------------------------------------------
-//! 
+//! Subdivides all of the patches, computing their mapping and displacement
+//! concurrently on the queue when one is specified.
+//! The mapping and displacement images are computed a batch of patches at a
+//! time, so that only a few images are kept around. The refinement itself
+//! stays serial, and in patch order, since it inserts vertices on the edges
+//! shared with the neighbors; the result is therefore the same as without
+//! a queue.
 void 
-MetaSurface::subdivide( float gerror, float derror )
+MetaSurface::subdivide( float gerror, float derror, TaskQueue* queue )
 {
    // Compute surface details. We mainly needs at this point the displacement
    // data for the subdivision.
    computeDetails( derror );
 
-   // Set the vm for computing mapping/displacement.
-   _cache->displacementPrecision( derror );
-   _cache->openVM();
-   
-   // Subdivide each patch taking into account geometric error and mapping error.
-   for( PatchIter it = patches(); it.isValid(); ++it )
+   if( queue && _numPatches > 1 )
    {
-      _cache->setMapping( it->_mapping );
-      _cache->setDisplacement( it->_displacement );
-      subdivide( *it, gerror );
+      Vector<Patch*> all;
+      all.reserve( _numPatches );
+      for( PatchIter it = patches(); it.isValid(); ++it )
+      {
+         all.pushBack( it );
+      }
+
+      CachePool pool( true, derror, _batchFunctions );
+      uint batchSize = 8*CGM::max( queue->numAllocatedThreads(), 1u );
+      Vector<CacheData::Image> images( batchSize );
+      for( uint b = 0; b < all.size(); b += batchSize )
+      {
+         uint e = CGM::min( b+batchSize, uint(all.size()) );
+         EvaluateLoop loop( pool, all.data()+b, images.data() );
+         queue->parallelFor( 0, e-b, 1, loop );
+
+         for( uint i = b; i < e; ++i )
+         {
+            if( all[i]->_displacement ) _cache->swapImage( images[i-b] );
+            refine( *all[i], gerror );
+         }
+      }
    }
+   else
+   {
+      // Set the vm for computing mapping/displacement.
+      _cache->displacementPrecision( derror );
+      _cache->batchFunctions( _batchFunctions );
+      _cache->openVM();
 
-   _cache->closeVM();
+      // Subdivide each patch taking into account geometric error and mapping error.
+      for( PatchIter it = patches(); it.isValid(); ++it )
+      {
+         subdivide( *it, gerror );
+      }
+
+      _cache->closeVM();
+   }
 
    makeBilinear();
    buildSpatialSubdivision();
@@ -2102,8 +2479,23 @@ MetaSurface::makeBilinear()
 void 
 MetaSurface::subdivide( Patch& p, float gerror )
 {
+   evaluate( *_cache, p );
+   refine( p, gerror );
+}
+
+//------------------------------------------------------------------------------
+//! Computes the corners, the mapping, and the displacement image of a patch,
+//! leaving the image in the cache.
+//! Only the patch itself is modified, so that different patches can be
+//! evaluated concurrently (using different caches).
+void 
+MetaSurface::evaluate( CacheData& cache, Patch& p )
+{
+   cache.setMapping( p._mapping );
+   cache.setDisplacement( p._displacement );
+
    // FIXME: only work for non-subdivided patches.
-   ParametricPatch* pp = _cache->paramPatch( &p );
+   ParametricPatch* pp = cache.paramPatch( &p );
 
    // Compute corner vertices.
    Vec3f n[4];
@@ -2119,34 +2511,42 @@ MetaSurface::subdivide( Patch& p, float gerror )
    p._corners[3]._pos = *p._controlPts[3];
 #endif
 
-   _cache->_context._id   = p._id&0x1fffffff;
-   _cache->_context._fid  = p._id>>29;
-   _cache->_context._fnor = normalize(n[0]+n[1]+n[2]+n[3]);
+   cache._context._id   = p._id&0x1fffffff;
+   cache._context._fid  = p._id>>29;
+   cache._context._fnor = normalize(n[0]+n[1]+n[2]+n[3]);
 
    // Compute mapping.
    if( p._mapping )
    {
-      p._uv[0] = _cache->computeMapping( p._corners[0]._pos, p._uv[0], n[0] );
-      p._uv[1] = _cache->computeMapping( p._corners[1]._pos, p._uv[1], n[1] );
-      p._uv[2] = _cache->computeMapping( p._corners[2]._pos, p._uv[2], n[2] );
-      p._uv[3] = _cache->computeMapping( p._corners[3]._pos, p._uv[3], n[3] );
-      //p._uv[0] = _cache->computeMapping( p._corners[0]._pos, p._corners[0]._uv, n[0] );
-      //p._uv[1] = _cache->computeMapping( p._corners[1]._pos, p._corners[1]._uv, n[1] );
-      //p._uv[2] = _cache->computeMapping( p._corners[2]._pos, p._corners[2]._uv, n[2] );
-      //p._uv[3] = _cache->computeMapping( p._corners[3]._pos, p._corners[3]._uv, n[3] );
+      Vec3f pos[4] = {
+         p._corners[0]._pos, p._corners[1]._pos, p._corners[2]._pos, p._corners[3]._pos
+      };
+      cache.computeMapping( 4, pos, n, p._uv );
    }
 
 #ifndef CONTROL_MESH
    // Compute displacement texture.
    if( p._displacement )
    {
-      _cache->computeDisplacement( p );
+      cache.computeDisplacement( p );
       // Displacement
-      p._corners[0]._pos = _cache->displace( p._corners[0]._uv );
-      p._corners[1]._pos = _cache->displace( p._corners[1]._uv );
-      p._corners[2]._pos = _cache->displace( p._corners[2]._uv );
-      p._corners[3]._pos = _cache->displace( p._corners[3]._uv );
+      p._corners[0]._pos = cache.displace( p._corners[0]._uv );
+      p._corners[1]._pos = cache.displace( p._corners[1]._uv );
+      p._corners[2]._pos = cache.displace( p._corners[2]._uv );
+      p._corners[3]._pos = cache.displace( p._corners[3]._uv );
+   }
+#endif
+}
 
+//------------------------------------------------------------------------------
+//! Subdivides the subpatches of an evaluated patch, using the displacement
+//! image of the main cache.
+void 
+MetaSurface::refine( Patch& p, float gerror )
+{
+#ifndef CONTROL_MESH
+   if( p._displacement )
+   {
       // Subdivide subpatches recursively (iteratively!).
       for( SubpatchIter it = subpatches(p); it.isValid(); )
       {
@@ -2737,59 +3137,77 @@ MetaSurface::triangulate(
    bool           normals
 ) const
 {
-   // Do not need to be triangulate?
-   if( isHidden( p ) ) return;
-
-   uint stride = normals ? 8 : 5;
-   uint offset = uint(vertices.size()) / stride;
-   uint id     = 0;
-   bool flip   = isFlipped(p);
-   float nf    = flip ? -1.0f : 1.0f;
-   float error = 2.0f*_errormax;
+   PatchMesh& mesh = _cache->_mesh;
+   triangulate( *_cache, p, mesh, normals );
+   merge( p, mesh, vertices, indices, faceInfos, normals );
+}
 
-   uint startIndice = uint(indices.size());
+//------------------------------------------------------------------------------
+//! Triangulates the patches in order, as if calling triangulate() on every one
+//! of them, and stores the number of indices after each patch in ends.
+//! With a queue, the patches are triangulated concurrently, each one into its
+//! own mesh. The meshes are then merged in patch order, which gives the same
+//! vertices and indices as the serial version.
+void 
+MetaSurface::triangulate(
+   const Vector<Patch*>& patches,
+   Vector<float>&        vertices,
+   Vector<uint>&         indices,
+   Vector<uint>*         faceInfos,
+   Vector<uint>*         ends,
+   bool                  normals,
+   TaskQueue*            queue
+) const
+{
+   uint n = uint(patches.size());
+   if( queue == nullptr || n < 2 )
+   {
+      for( uint i = 0; i < n; ++i )
+      {
+         triangulate( *patches[i], vertices, indices, faceInfos, normals );
+         if( ends ) ends->pushBack( uint(indices.size()) );
+      }
+      return;
+   }
 
-   //if( p._detailsID <= 18 || p._detailsID >= 43 ) return;
-   //if( p._detailsID != 43 ) return;
-   //if( p._detailsID != 18 ) return;
-   //if( p._detailsID != 18 && p._detailsID != 43) return;
+   Vector<PatchMesh> meshes( n );
+   {
+      CachePool pool( false );
+      TriangulateLoop loop( *this, pool, patches.data(), meshes.data(), normals );
+      queue->parallelFor( 0, n, 1, loop );
+   }
 
-   // Allocate vertex grid cache when starting anew.
-   if( offset == 0 )
+   for( uint i = 0; i < n; ++i )
    {
-      delete _cache->_grid;
-      _cache->_grid = new Grid<Vertex*>( numSubpatches()*2, 1.0f/128.0f );
+      merge( *patches[i], meshes[i], vertices, indices, faceInfos, normals );
+      if( ends ) ends->pushBack( uint(indices.size()) );
    }
+}
 
-   Vector<Vertex*>& vptrs = _cache->_vptrs;
-   Grid<Vertex*>* grid    = _cache->_grid;
-   uint nbVertices[4]; 
+//------------------------------------------------------------------------------
+//! Triangulates a patch on its own, with indices local to the patch mesh.
+//! Only the vertices of the patch are modified.
+void 
+MetaSurface::triangulate( CacheData& cache, Patch& p, PatchMesh& mesh, bool normals ) const
+{
+   mesh._vertices.clear();
+   mesh._attributes.clear();
+   mesh._indices.clear();
 
-   resetVertices( p );
+   // Do not need to be triangulate?
+   if( isHidden( p ) ) return;
 
-   // Compute patch uvs.
-   //Vec2f uvp;
-   //Vec2f du;
-   //Vec2f dv;
-   //_details->mapping( p._detailsID, uvp, du, dv );
-   //Vec2f uvp(0.0f);
-   //Vec2f du(1.0f,0.0f);
-   //Vec2f dv(0.0f,1.0f);
-   Vec2f uv0  = p._uv[0];
-   Vec2f uv1  = p._uv[3];
-   Vec2f duv0 = p._uv[1] - uv0;
-   Vec2f duv1 = p._uv[2] - uv1;
+   bool flip              = isFlipped(p);
+   Vector<Vertex*>& vptrs = cache._vptrs;
+   uint nbVertices[4]; 
 
-   Vec3f n;
-   Vec3f tp;
+   resetVertices( p );
 
    // Add triangles.
    for( SubpatchIter sIt = subpatches(p); sIt.isValid(); ++sIt )
    {
       // Do not need to be triangulate?
       if( isHidden( *sIt ) ) continue;
-      //if( !equal( sIt->_corners[0]->_uv, Vec2f( 0.125f, 0.125f ) ) ) continue; // 43
-      //if( !equal( sIt->_corners[0]->_uv, Vec2f( 0.0f, 0.5f ) ) ) continue; // 18
 
       // Normal triangulation?
       if( !isTrimmed(*sIt) )
@@ -2803,102 +3221,20 @@ MetaSurface::triangulate(
             nbVertices[c] = 0;
             for( ; v != sIt->_corners[(c+1)%4]; v = v->_next[(c+1)%4] )
             {
-#ifdef PER_SUBPATCH_MAPPING
-               // Add a new vertex.
-               {
-                  v->_id = offset + id++;
-                  vertices.pushBack( v->_pos.x );
-                  vertices.pushBack( v->_pos.y );
-                  vertices.pushBack( v->_pos.z );
-                  Vec2f uv = (v->_uv-sIt->_corners[0]->_uv)/(sIt->_corners[2]->_uv-sIt->_corners[0]->_uv);
-                  vertices.pushBack( uv.x );
-                  vertices.pushBack( uv.y );
-                  if( normals )
-                  {
-                     computeParameters( p, v->_uv, tp, n );
-                     vertices.pushBack( nf*n.x );
-                     vertices.pushBack( nf*n.y );
-                     vertices.pushBack( nf*n.z );
-                  }
-               }
-#else
-               // Add a new vertex.
-               if( v->_id == INVALID ) 
-               {
-                  //Vec2f uv = uvp + du*v->_uv.x + dv*v->_uv.y;
-                  Vec2f uv = CGM::bilinear( uv0, duv0, uv1, duv1, v->_uv.x, v->_uv.y );
-                  if( normals )
-                  {
-                     computeParameters( p, v->_uv, tp, n );
-                     n *= nf;
-                  }
-
-                  // Search for vertices.
-                  Vec3i c0 = grid->cellCoord( v->_pos-error );
-                  Vec3i c1 = grid->cellCoord( v->_pos+error );
-                  for( int x = c0.x; x <= c1.x ; ++x )
-                  {
-                     for( int y = c0.y; y <= c1.y; ++y )
-                     {
-                        for( int z = c0.z; z <= c1.z; ++z )
-                        {
-                           Grid<Vertex*>::Link* l = grid->cell( Vec3i(x,y,z) );
-                           for( ; l; l = l->_next )
-                           {
-                              // Have we found the vertex?
-                              if( sqrLength( l->_obj->_pos-v->_pos) < (error*error) )
-                              {
-                                 // Test for vertex similarity.
-                                 if( normals )
-                                 {
-                                    Vec2f& cuv = (Vec2f&)vertices[l->_obj->_id*stride+3];
-                                    Vec3f& cn  = (Vec3f&)vertices[l->_obj->_id*stride+5];
-                                    if( equal( cuv, uv ) && equal( cn, n ) ) v->_id = l->_obj->_id;
-                                 }
-                                 else
-                                 {
-                                    Vec2f& cuv = (Vec2f&)vertices[l->_obj->_id*stride+3];
-                                    if( equal( cuv, uv ) ) v->_id = l->_obj->_id;
-                                 }
-                              }
-                           }
-                        }
-                     }
-                  }
-
-                  if( v->_id == INVALID )
-                  {
-                     v->_id = offset + id++;
-                     vertices.pushBack( v->_pos.x );
-                     vertices.pushBack( v->_pos.y );
-                     vertices.pushBack( v->_pos.z );
-                     vertices.pushBack( uv.x );
-                     vertices.pushBack( uv.y );
-                     if( normals )
-                     {
-                        vertices.pushBack( n.x );
-                        vertices.pushBack( n.y );
-                        vertices.pushBack( n.z );
-                     }
-                     grid->add( grid->cellID( v->_pos ), v );
-                  }
-               }
-#endif
+               addVertex( cache, p, *sIt, v, mesh, normals );
                vptrs.pushBack( v );
                nbVertices[c]++;
             }
          }
-         ::triangulate( vptrs, nbVertices, flip, indices );
+         ::triangulate( vptrs, nbVertices, flip, mesh._indices );
       }
       else
       {
          // Trimmed subpatch triangulation.
+         // The trimming already exists, so looking it up doesn't modify anything.
          TrimmingData* trimData = _cache->trimmingData();
          Trimming* trim         = trimData->trim( sIt );
 
-         //dump( *sIt );
-         //dump( *trim );
-
          for( Loop* loop = trim->_loops; loop; loop = loop->_next )
          {
             // Do not need to be triangulate?
@@ -2908,98 +3244,165 @@ MetaSurface::triangulate(
             for( LoopLink* l = loop->_link; l; l = l->_next )
             {
                Vertex* v = l->_vertex;
+               addVertex( cache, p, *sIt, v, mesh, normals );
+               vptrs.pushBack( v );
+            }
+            ::triangulate( vptrs, mesh._indices, flip, trim->_x, trim->_y );
+         }
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Adds a vertex to the patch mesh, the first time it is used by the patch.
+//! The vertex id is set to its index in the mesh.
+void 
+MetaSurface::addVertex(
+   CacheData&      cache,
+   Patch&          p,
+   const Subpatch& sp,
+   Vertex*         v,
+   PatchMesh&      mesh,
+   bool            normals
+) const
+{
 #ifdef PER_SUBPATCH_MAPPING
-               // Add a new vertex.
-               {
-                  v->_id = offset + id++;
-                  vertices.pushBack( v->_pos.x );
-                  vertices.pushBack( v->_pos.y );
-                  vertices.pushBack( v->_pos.z );
-                  Vec2f uv = (v->_uv-sIt->_corners[0]->_uv)/(sIt->_corners[2]->_uv-sIt->_corners[0]->_uv);
-                  vertices.pushBack( uv.x );
-                  vertices.pushBack( uv.y );
-                  if( normals )
-                  {
-                     computeParameters( p, v->_uv, tp, n );
-                     vertices.pushBack( nf*n.x );
-                     vertices.pushBack( nf*n.y );
-                     vertices.pushBack( nf*n.z );
-                  }
-               }
+   // Add a new vertex.
+   Vec2f uv = (v->_uv-sp._corners[0]->_uv)/(sp._corners[2]->_uv-sp._corners[0]->_uv);
+   mesh._vertices.pushBack( 0 );
 #else
-               // Add a new vertex.
-               if( v->_id == INVALID ) 
-               {
-                  //Vec2f uv = uvp + du*v->_uv.x + dv*v->_uv.y;
-                  Vec2f uv = CGM::bilinear( uv0, duv0, uv1, duv1, v->_uv.x, v->_uv.y );
-                  if( normals )
-                  {
-                     computeParameters( p, v->_uv, tp, n );
-                     n *= nf;
-                  }
+   if( v->_id != INVALID ) return;
 
-                  // Search for vertices.
-                  Vec3i c0 = grid->cellCoord( v->_pos-error );
-                  Vec3i c1 = grid->cellCoord( v->_pos+error );
-                  for( int x = c0.x; x <= c1.x ; ++x )
-                  {
-                     for( int y = c0.y; y <= c1.y; ++y )
-                     {
-                        for( int z = c0.z; z <= c1.z; ++z )
-                        {
-                           Grid<Vertex*>::Link* l = grid->cell( Vec3i(x,y,z) );
-                           for( ; l; l = l->_next )
-                           {
-                              // Have we found the vertex?
-                              if( sqrLength( l->_obj->_pos-v->_pos) < (error*error) )
-                              {
-                                 // Test for vertex similarity.
-                                 if( normals )
-                                 {
-                                    Vec2f& cuv = (Vec2f&)vertices[l->_obj->_id*stride+3];
-                                    Vec3f& cn  = (Vec3f&)vertices[l->_obj->_id*stride+5];
-                                    if( equal( cuv, uv ) && equal( cn, n ) ) v->_id = l->_obj->_id;
-                                 }
-                                 else
-                                 {
-                                    Vec2f& cuv = (Vec2f&)vertices[l->_obj->_id*stride+3];
-                                    if( equal( cuv, uv ) ) v->_id = l->_obj->_id;
-                                 }
-                              }
-                           }
-                        }
-                     }
-                  }
+   // Add a new vertex.
+   Vec2f uv0  = p._uv[0];
+   Vec2f uv1  = p._uv[3];
+   Vec2f duv0 = p._uv[1] - uv0;
+   Vec2f duv1 = p._uv[2] - uv1;
+   Vec2f uv   = CGM::bilinear( uv0, duv0, uv1, duv1, v->_uv.x, v->_uv.y );
+   mesh._vertices.pushBack( v );
+   unused( sp );
+#endif
+
+   v->_id = uint(mesh._vertices.size()) - 1;
+   mesh._attributes.pushBack( v->_pos.x );
+   mesh._attributes.pushBack( v->_pos.y );
+   mesh._attributes.pushBack( v->_pos.z );
+   mesh._attributes.pushBack( uv.x );
+   mesh._attributes.pushBack( uv.y );
+   if( normals )
+   {
+      Vec3f tp;
+      Vec3f n;
+      cache.paramPatch( &p )->parameters( v->_uv, tp, n );
+      n *= isFlipped(p) ? -1.0f : 1.0f;
+      mesh._attributes.pushBack( n.x );
+      mesh._attributes.pushBack( n.y );
+      mesh._attributes.pushBack( n.z );
+   }
+}
 
-                  if( v->_id == INVALID )
+//------------------------------------------------------------------------------
+//! Appends a patch mesh to the vertices and indices. Vertices which are the
+//! same as one already there (of this patch or of any previous one) reuse it.
+//! The patches must be merged in the same order every time for the vertices
+//! to come out the same.
+void 
+MetaSurface::merge(
+   Patch&         p,
+   PatchMesh&     mesh,
+   Vector<float>& vertices,
+   Vector<uint>&  indices,
+   Vector<uint>*  faceInfos,
+   bool           normals
+) const
+{
+   // Do not need to be triangulate?
+   if( isHidden( p ) ) return;
+
+   uint stride = normals ? 8 : 5;
+   uint offset = uint(vertices.size()) / stride;
+   uint id     = 0;
+   float error = 2.0f*_errormax;
+
+   // Allocate vertex grid cache when starting anew.
+   if( offset == 0 )
+   {
+      delete _cache->_grid;
+      _cache->_grid = new Grid<Vertex*>( numSubpatches()*2, 1.0f/128.0f );
+   }
+
+   Grid<Vertex*>* grid = _cache->_grid;
+
+   uint numVertices = uint(mesh._vertices.size());
+   mesh._ids.resize( numVertices );
+   for( uint i = 0; i < numVertices; ++i )
+   {
+      Vertex* v          = mesh._vertices[i];
+      const float* attr  = mesh._attributes.data() + i*stride;
+      uint vid           = INVALID;
+
+#ifndef PER_SUBPATCH_MAPPING
+      const Vec2f& uv = (const Vec2f&)attr[3];
+      const Vec3f& n  = (const Vec3f&)attr[5];
+
+      // Search for vertices.
+      Vec3i c0 = grid->cellCoord( v->_pos-error );
+      Vec3i c1 = grid->cellCoord( v->_pos+error );
+      for( int x = c0.x; x <= c1.x ; ++x )
+      {
+         for( int y = c0.y; y <= c1.y; ++y )
+         {
+            for( int z = c0.z; z <= c1.z; ++z )
+            {
+               Grid<Vertex*>::Link* l = grid->cell( Vec3i(x,y,z) );
+               for( ; l; l = l->_next )
+               {
+                  // Have we found the vertex?
+                  if( sqrLength( l->_obj->_pos-v->_pos) < (error*error) )
                   {
-                     v->_id = offset + id++;
-                     vertices.pushBack( v->_pos.x );
-                     vertices.pushBack( v->_pos.y );
-                     vertices.pushBack( v->_pos.z );
-                     vertices.pushBack( uv.x );
-                     vertices.pushBack( uv.y );
+                     // Test for vertex similarity.
                      if( normals )
                      {
-                        vertices.pushBack( n.x );
-                        vertices.pushBack( n.y );
-                        vertices.pushBack( n.z );
+                        Vec2f& cuv = (Vec2f&)vertices[l->_obj->_id*stride+3];
+                        Vec3f& cn  = (Vec3f&)vertices[l->_obj->_id*stride+5];
+                        if( equal( cuv, uv ) && equal( cn, n ) ) vid = l->_obj->_id;
+                     }
+                     else
+                     {
+                        Vec2f& cuv = (Vec2f&)vertices[l->_obj->_id*stride+3];
+                        if( equal( cuv, uv ) ) vid = l->_obj->_id;
                      }
-                     grid->add( grid->cellID( v->_pos ), v );
                   }
                }
-#endif
-               vptrs.pushBack( v );
             }
-            ::triangulate( vptrs, indices, flip, trim->_x, trim->_y );
          }
       }
+#endif
+
+      if( vid == INVALID )
+      {
+         vid = offset + id++;
+         for( uint a = 0; a < stride; ++a )
+         {
+            vertices.pushBack( attr[a] );
+         }
+#ifndef PER_SUBPATCH_MAPPING
+         grid->add( grid->cellID( v->_pos ), v );
+#endif
+      }
+      if( v ) v->_id = vid;
+      mesh._ids[i] = vid;
+   }
+
+   for( uint i = 0; i < mesh._indices.size(); ++i )
+   {
+      indices.pushBack( mesh._ids[mesh._indices[i]] );
    }
 
    // Face info.
    if( faceInfos )
    {
-      int numTriangles = int(indices.size() - startIndice) / 3;
+      int numTriangles = int(mesh._indices.size()) / 3;
       for( ; numTriangles > 0 ; --numTriangles )
       {
          faceInfos->pushBack( p._id );
@@ -20,6 +20,7 @@
 NAMESPACE_BEGIN
 
 class MetaFunction;
+class TaskQueue;
 
 /*==============================================================================
    CLASS MetaSurface
@@ -181,7 +182,14 @@ public:
    void neighbors( Patch* p0, uint e0, Patch* p1, uint e1, int crease );
 
    // Subdivision.
-   void subdivide( float gerror, float merror );
+   void subdivide( float gerror, float merror, TaskQueue* queue = nullptr );
+
+   // Evaluates the per-point mapping and displacement functions a whole patch
+   // at a time (the default), or with a call from the host for every point,
+   // which is kept to check the former against (batched functions always get
+   // the whole patch, see MetaFunction::batched()).
+   inline bool  batchFunctions() const   { return _batchFunctions; }
+   inline void  batchFunctions( bool v ) { _batchFunctions = v; }
 
    // Trimming.
    void trim( Patch&, Patch& );
@@ -203,6 +211,15 @@ public:
       Vector<uint>*  faceInfos,
       bool normals = false
    ) const;
+   void triangulate(
+      const Vector<Patch*>& patches,
+      Vector<float>&        vertices,
+      Vector<uint>&         indices,
+      Vector<uint>*         faceInfos,
+      Vector<uint>*         ends,
+      bool                  normals,
+      TaskQueue*            queue
+   ) const;
 
    // Collision.
    const HGrid& hgrid() const { return *_grid; }
@@ -224,17 +241,36 @@ protected:
    /*----- classes -----*/
 
    class CacheData;
+   class CachePool;
+   class EvaluateLoop;
+   class TriangulateLoop;
+   struct PatchMesh;
+
+   /*----- static methods -----*/
+
+   static void evaluate( CacheData&, Patch& );
 
    /*----- methods -----*/
 
    ~MetaSurface();
 
    void subdivide( Patch&, float gerror );
+   void refine( Patch&, float gerror );
    bool subdivide( Subpatch&, float gerror );
    bool subdivideDisplaced( Subpatch&, float gerror );
    void subdivide( Subpatch& );
 
    void resetVertices( Patch& p ) const;
+   void triangulate( CacheData&, Patch&, PatchMesh&, bool normals ) const;
+   void addVertex( CacheData&, Patch&, const Subpatch&, Vertex*, PatchMesh&, bool normals ) const;
+   void merge(
+      Patch&,
+      PatchMesh&,
+      Vector<float>& vertices,
+      Vector<uint>&  indices,
+      Vector<uint>*  faceInfos,
+      bool           normals
+   ) const;
    void computeDetails( float );
    void makeBilinear();
    void subdivideu( Subpatch&, const Vec3f pos[] );
@@ -266,6 +302,7 @@ protected:
    MemoryPool<Vertex>   _vPool;
    MemoryPool<Subpatch> _spPool;
    MemoryPool<Patch>    _pPool;
+   bool                 _batchFunctions;
 };
 
 //------------------------------------------------------------------------------
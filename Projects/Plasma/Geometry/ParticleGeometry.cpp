@@ -75,7 +75,7 @@ ParticleGeometry::updateRenderData()
    float* dst = (float*)Core::gfx()->map( buffer, Gfx::MAP_WRITE, 0, s );
    if( dst )
    {
-      memcpy( dst, data.vertexData(), s );
+      data.pack( dst );
       Core::gfx()->unmap( buffer );
       clearPatches();
       addPatch( 0, data.size(), 0 );
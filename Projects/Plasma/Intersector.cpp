@@ -47,6 +47,24 @@ bool intersectTri( const Rayf& ray, uint id, float& t, void* data )
    return false;
 }
 
+//------------------------------------------------------------------------------
+//! Traces an entity of the world's BVH, for the closest hit.
+bool intersectEntity( const Rayf& ray, void* entity, float& t, void* data )
+{
+   Intersector::Hit* hit = (Intersector::Hit*)data;
+   hit->_t = t;
+   if( !Intersector::trace( (Entity*)entity, ray, *hit ) ) return false;
+   t = hit->_t;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//! Traces an entity of the world's BVH, for any hit.
+bool hitsEntity( const Rayf& ray, void* entity, float&, void* )
+{
+   return Intersector::trace( (Entity*)entity, ray );
+}
+
 UNNAMESPACE_END
 
 NAMESPACE_BEGIN
@@ -64,12 +82,17 @@ Intersector::trace(
    Hit&         hit
 )
 {
-   bool hitSomething = false;
+   // Only the entities whose world bounds are along the ray are traced, in
+   // front to back order; the others (skeletal, particles...) are all traced.
+   world->updateEntityBounds();
 
-   // Interesect each entity.
-   for( uint i = 0; i < world->numEntities(); ++i )
+   float t = hit._t;
+   bool hitSomething = world->entityBVH().trace( ray, t, &intersectEntity, &hit );
+
+   const Vector<Entity*>& unbounded = world->unboundedEntities();
+   for( uint i = 0; i < unbounded.size(); ++i )
    {
-      hitSomething |= trace( world->entity(i), ray, hit );
+      hitSomething |= trace( unbounded[i], ray, hit );
    }
 
    return hitSomething;
@@ -83,12 +106,36 @@ Intersector::trace(
    const Rayf&  ray
 )
 {
+   world->updateEntityBounds();
+
+   if( world->entityBVH().traceAny( ray, 1.0f, &hitsEntity, nullptr ) ) return true;
+
+   const Vector<Entity*>& unbounded = world->unboundedEntities();
+   for( uint i = 0; i < unbounded.size(); ++i )
+   {
+      if( trace( unbounded[i], ray ) ) return true;
+   }
+   return false;
+}
+
+//------------------------------------------------------------------------------
+//! Reference version of the world query, tracing every entity.
+bool
+Intersector::traceAll(
+   World*       world,
+   const Rayf&  ray,
+   Hit&         hit
+)
+{
+   bool hitSomething = false;
+
    // Interesect each entity.
    for( uint i = 0; i < world->numEntities(); ++i )
    {
-      if( trace( world->entity(i), ray ) ) return true;
+      hitSomething |= trace( world->entity(i), ray, hit );
    }
-   return false;
+
+   return hitSomething;
 }
 
 //------------------------------------------------------------------------------
@@ -68,6 +68,12 @@ public:
       World*       world,
       const Rayf&  ray
    );
+   // Same as the first, looping over all of the entities.
+   static bool traceAll(
+      World*       world,
+      const Rayf&  ray,
+      Hit&         hit
+   );
    
    // Ray-Entity intersection.
    static bool trace(
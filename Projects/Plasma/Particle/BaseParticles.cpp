@@ -4,6 +4,8 @@
 =============================================================================*/
 #include <Plasma/Particle/BaseParticles.h>
 
+#include <CGMath/FloatN.h>
+
 USING_NAMESPACE
 
 /*==============================================================================
@@ -11,7 +13,72 @@ USING_NAMESPACE
 ==============================================================================*/
 UNNAMESPACE_BEGIN
 
+//------------------------------------------------------------------------------
+//! LineAnimator::animate() on the ParticleData::SOA layout.
+//! The particles to remove are flagged with a null energy, which this animator
+//! doesn't otherwise use.
+void  animateLine( ParticleData& data, float delta, const Vec3f& dst, float dtd )
+{
+   typedef Floats F;
+   float* energy = data.stream( ParticleData::STREAM_ENERGY );
+   float* px     = data.stream( ParticleData::STREAM_POSITION_X );
+   float* py     = data.stream( ParticleData::STREAM_POSITION_Y );
+   float* pz     = data.stream( ParticleData::STREAM_POSITION_Z );
+   float* vx     = data.stream( ParticleData::STREAM_LINEAR_VELOCITY_X );
+   float* vy     = data.stream( ParticleData::STREAM_LINEAR_VELOCITY_Y );
+   float* vz     = data.stream( ParticleData::STREAM_LINEAR_VELOCITY_Z );
+
+   const F d    = F::set( delta );
+   const F eps  = F::set( 1e-6f );
+   const F die  = F::set( dtd );
+   const F dx   = F::set( dst.x );
+   const F dy   = F::set( dst.y );
+   const F dz   = F::set( dst.z );
+   const F zero = F::set( 0.0f );
+   uint stopped = 0;
+   uint32_t n   = data.size();
+   for( uint32_t i = 0; i < n; i += F::SIZE )
+   {
+      F x = F::load( px+i );
+      F y = F::load( py+i );
+      F z = F::load( pz+i );
+      F u = F::load( vx+i );
+      F v = F::load( vy+i );
+      F w = F::load( vz+i );
+
+      F spd2 = u*u + v*v + w*w;
+      F ex   = dx - x;
+      F ey   = dy - y;
+      F ez   = dz - z;
+      F len  = F::sqrt( ex*ex + ey*ey + ez*ez );
+      F spd  = F::sqrt( spd2 );
+      F dist = len - spd*d; // Distance after the timestep.
+
+      // Non-moving particles will never reach the destination, and the others
+      // die when close enough to distanceToDie (or overshooting).
+      F::Mask moving = F::greater( spd2, eps );
+      F::Mask alive  = moving.andNot( F::lessEqual( dist, die ) );
+      F::select( alive, F::load( energy+i ), zero ).store( energy+i );
+
+      uint lanes = (n - i) < uint32_t(F::SIZE) ? (1u << (n - i)) - 1 : (1u << F::SIZE) - 1;
+      stopped   |= ~moving.bits() & lanes;
+
+      // Rescale to honor original speed.
+      F s = spd / len;
+      u = ex*s;
+      v = ey*s;
+      w = ez*s;
+      u.store( vx+i );
+      v.store( vy+i );
+      w.store( vz+i );
+      ( x + u*d ).store( px+i );
+      ( y + v*d ).store( py+i );
+      ( z + w*d ).store( pz+i );
+   }
+   if( stopped )  StdErr << "Non-moving particles expired." << nl;
 
+   data.removeExpired();
+}
 
 UNNAMESPACE_END
 
@@ -50,6 +117,34 @@ LineGenerator::generate( float delta, ParticleEntity& e, ParticleRNG& rng )
 
    uint32_t n = CGM::min( data.available(), uint32_t(_residual) );
    //StdErr << "Creating " << n << " particles (res=" << _residual << " av=" << data.available() << ")." << nl;
+   if( data.layout() == ParticleData::SOA )
+   {
+      uint32_t first = data.addParticles( n );
+      float* px = data.stream( ParticleData::STREAM_POSITION_X );
+      float* py = data.stream( ParticleData::STREAM_POSITION_Y );
+      float* pz = data.stream( ParticleData::STREAM_POSITION_Z );
+      float* cr = data.stream( ParticleData::STREAM_COLOR_R );
+      float* ca = data.stream( ParticleData::STREAM_COLOR_A );
+      for( uint32_t i = first; i < first + n; ++i )
+      {
+         float t = float(rng()) * delta;
+         float c = 0.1f + float(rng())*0.9f;
+         px[i] = _src.x + _vel.x*t;
+         py[i] = _src.y + _vel.y*t;
+         pz[i] = _src.z + _vel.z*t;
+         cr[i] = c;
+         ca[i] = c*0.125f;
+      }
+      data.fill( ParticleData::STREAM_SIZE, first, n, 150.0f );
+      data.fill( ParticleData::STREAM_COLOR_G, first, n, 0.0f );
+      data.fill( ParticleData::STREAM_COLOR_B, first, n, 0.0f );
+      data.fill( ParticleData::STREAM_ENERGY, first, n, CGConstf::infinity() );
+      data.fill( ParticleData::STREAM_LINEAR_VELOCITY_X, first, n, _vel.x );
+      data.fill( ParticleData::STREAM_LINEAR_VELOCITY_Y, first, n, _vel.y );
+      data.fill( ParticleData::STREAM_LINEAR_VELOCITY_Z, first, n, _vel.z );
+      _residual -= float(n);
+      return false;
+   }
    for( uint32_t i = 0; i < n; ++i )
    {
       // Generate a particle and animate its first frame.
@@ -94,6 +189,11 @@ LineAnimator::animate( float delta, ParticleEntity& e, ParticleRNG& /*rng*/ )
 {
    delta = CGM::min( delta, 1.0f/16.0f ); // Don't fall below 16fps.
    ParticleData& data = e.data();
+   if( data.layout() == ParticleData::SOA )
+   {
+      animateLine( data, delta, _dst, _dtd );
+      return false;
+   }
    for( auto cur = data.iter(); cur(); cur.next() )
    {
       Vec3f&  pos = cur.position();
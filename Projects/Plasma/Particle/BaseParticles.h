@@ -31,6 +31,8 @@ public:
 
    PLASMA_DLL_API virtual bool  generate( float delta, ParticleEntity& e, ParticleRNG& rng );
 
+   inline virtual bool  handlesSOA() const { return true; }
+
    inline float  rate() const    { return _rate; }
    inline void   rate( float v ) { _rate = v;    }
 
@@ -69,6 +71,8 @@ public:
 
    PLASMA_DLL_API virtual bool  animate( float delta, ParticleEntity& e, ParticleRNG& rng );
 
+   inline virtual bool  handlesSOA() const { return true; }
+
    inline const Vec3f&  destination() const           { return _dst; }
    inline         void  destination( const Vec3f& v ) { _dst = v;    }
 
@@ -31,6 +31,9 @@ public:
    // Cleans up outdated particles, and animates the remaining ones.
    PLASMA_DLL_API virtual bool animate( float delta, ParticleEntity& e, ParticleRNG& rng ) = 0;
 
+   // Whether the ParticleData::SOA layout is handled (the Iterator isn't available in it).
+   inline virtual bool  handlesSOA() const { return false; }
+
    // VM.
    PLASMA_DLL_API virtual void init( VMState* vm );
    PLASMA_DLL_API virtual bool performGet( VMState* vm );
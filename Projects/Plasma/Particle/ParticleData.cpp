@@ -4,6 +4,8 @@
 =============================================================================*/
 #include <Plasma/Particle/ParticleData.h>
 
+#include <CGMath/FloatN.h>
+
 USING_NAMESPACE
 
 /*==============================================================================
@@ -28,6 +30,33 @@ inline String  fmt( float v )
    return String().format("%5g", v );
 }
 
+//------------------------------------------------------------------------------
+//! The streams holding each data type, in order.
+const uint  _typeStreams[4][2] = {
+   // first                                     count
+   { ParticleData::STREAM_SIZE                , 1 }, // SIZE
+   { ParticleData::STREAM_COLOR_R             , 4 }, // COLOR
+   { ParticleData::STREAM_ORIENTATION_X       , 4 }, // ORIENTATION
+   { ParticleData::STREAM_LINEAR_VELOCITY_X   , 3 }, // LINEAR_VELOCITY
+};
+
+#if CGMATH_SSE
+//------------------------------------------------------------------------------
+//! Writes 4 components of 4 consecutive particles, one particle every stride floats.
+inline void  packQuad( float* dst, uint stride, float* const* src, uint32_t i )
+{
+   __m128 a = _mm_load_ps( src[0] + i );
+   __m128 b = _mm_load_ps( src[1] + i );
+   __m128 c = _mm_load_ps( src[2] + i );
+   __m128 d = _mm_load_ps( src[3] + i );
+   _MM_TRANSPOSE4_PS( a, b, c, d );
+   _mm_storeu_ps( dst           , a );
+   _mm_storeu_ps( dst + stride  , b );
+   _mm_storeu_ps( dst + stride*2, c );
+   _mm_storeu_ps( dst + stride*3, d );
+}
+#endif
+
 UNNAMESPACE_END
 
 /*==============================================================================
@@ -37,24 +66,30 @@ UNNAMESPACE_END
 //------------------------------------------------------------------------------
 //!
 ParticleData::ParticleData():
+   _layout( INTERLEAVED ),
    _types( INVALID ),
    _size( 0 ),
    _capacity( 0 ),
    _vData( nullptr ),
-   _eData( nullptr )
+   _eData( nullptr ),
+   _soaData( nullptr )
 {
+   memset( _streams, 0, sizeof(_streams) );
 }
 
 //------------------------------------------------------------------------------
 //!
-ParticleData::ParticleData( DataType reqs, uint32_t cap ):
+ParticleData::ParticleData( DataType reqs, uint32_t cap, Layout layout ):
+   _layout( INTERLEAVED ),
    _types( INVALID ),
    _size( 0 ),
    _capacity( 0 ),
    _vData( nullptr ),
-   _eData( nullptr )
+   _eData( nullptr ),
+   _soaData( nullptr )
 {
-   allocate( reqs, cap );
+   memset( _streams, 0, sizeof(_streams) );
+   allocate( reqs, cap, layout );
 }
 
 //------------------------------------------------------------------------------
@@ -67,10 +102,11 @@ ParticleData::~ParticleData()
 //------------------------------------------------------------------------------
 //!
 void
-ParticleData::allocate( DataType reqs, uint32_t cap )
+ParticleData::allocate( DataType reqs, uint32_t cap, Layout layout )
 {
    deallocate();
 
+   _layout   = layout;
    _types    = reqs;
    _capacity = cap;
 
@@ -93,9 +129,41 @@ ParticleData::allocate( DataType reqs, uint32_t cap )
       }
    }
 
-   //++maxSize; // Overallocate to avoid crashing when we read invalid data at the last element?
-   _vData = new float[ _capacity*_vStride ];
-   _eData = new float[ _capacity*_eStride ];
+   if( _layout == SOA )
+   {
+      // One allocation for all of the arrays, each one starting on an aligned
+      // address and padded so that kernels can process a full register past
+      // the last particle.
+      uint32_t padded = (_capacity + STREAM_ALIGNMENT - 1) & ~uint32_t(STREAM_ALIGNMENT - 1);
+      uint numStreams = _vStride + _eStride;
+      _soaData = new float[ padded*numStreams + STREAM_ALIGNMENT - 1 ];
+      memset( _soaData, 0, (padded*numStreams + STREAM_ALIGNMENT - 1)*sizeof(float) );
+      size_t align = STREAM_ALIGNMENT*sizeof(float);
+      float* cur   = (float*)( (size_t(_soaData) + align - 1) & ~(align - 1) );
+      for( uint s = STREAM_POSITION_X; s <= STREAM_POSITION_Z; ++s, cur += padded )
+      {
+         _streams[s] = cur;
+      }
+      _streams[STREAM_ENERGY] = cur;
+      cur += padded;
+      for( uint i = 0; i < 4; ++i )
+      {
+         if( ((_types>>i)&0x01) == 0x01 )
+         {
+            const uint* ts = _typeStreams[i];
+            for( uint s = ts[0]; s < ts[0] + ts[1]; ++s, cur += padded )
+            {
+               _streams[s] = cur;
+            }
+         }
+      }
+   }
+   else
+   {
+      //++maxSize; // Overallocate to avoid crashing when we read invalid data at the last element?
+      _vData = new float[ _capacity*_vStride ];
+      _eData = new float[ _capacity*_eStride ];
+   }
 
    uint16_t curOffset = 3;
    if( hasSize() )
@@ -127,8 +195,10 @@ ParticleData::allocate( DataType reqs, uint32_t cap )
 void
 ParticleData::deallocate()
 {
-   delete [] _vData;  _vData = nullptr;
-   delete [] _eData;  _eData = nullptr;
+   delete [] _vData;    _vData = nullptr;
+   delete [] _eData;    _eData = nullptr;
+   delete [] _soaData;  _soaData = nullptr;
+   memset( _streams, 0, sizeof(_streams) );
    _size     = 0;
    _capacity = 0;
 }
@@ -145,6 +215,112 @@ ParticleData::removeParticle( const Iterator& it )
    copy( it._curE, _eData + (_size*_eStride), _eStride * sizeof(_eData[0]) );
 }
 
+//------------------------------------------------------------------------------
+//! Removes the particles without any energy left (SOA layout only).
+//! Like removing them with an Iterator, this walks back from the end and moves
+//! the last particle in place of each removed one, so both layouts keep the
+//! particles in the same order.
+uint32_t
+ParticleData::removeExpired()
+{
+   CHECK( _layout == SOA );
+   float* streams[NUM_STREAMS];
+   uint numStreams = activeStreams( streams );
+   const float* energy = _streams[STREAM_ENERGY];
+   uint32_t oldSize = _size;
+   for( uint32_t i = _size; i-- > 0; )
+   {
+      if( !(energy[i] > 0.0f) )
+      {
+         --_size;
+         for( uint s = 0; s < numStreams; ++s )
+         {
+            streams[s][i] = streams[s][_size];
+         }
+      }
+   }
+   return oldSize - _size;
+}
+
+//------------------------------------------------------------------------------
+//! Sets one component of n particles (SOA layout only).
+void
+ParticleData::fill( Stream s, uint32_t first, uint32_t n, float v )
+{
+   CHECK( _layout == SOA );
+   CHECK( _streams[s] != nullptr );
+   CHECK( first + n <= _capacity );
+   float* dst = _streams[s] + first;
+   float* end = dst + n;
+   for( ; dst < end && (size_t(dst) % (STREAM_ALIGNMENT*sizeof(float))) != 0; ++dst )
+   {
+      *dst = v;
+   }
+   Floats f = Floats::set( v );
+   for( ; dst + Floats::SIZE <= end; dst += Floats::SIZE )
+   {
+      f.store( dst );
+   }
+   for( ; dst < end; ++dst )
+   {
+      *dst = v;
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Writes the size() vertices in the interleaved layout described by
+//! vertexStride(), colorOffset(), and orientationOffset() into dst.
+void
+ParticleData::pack( float* dst ) const
+{
+   if( _layout == INTERLEAVED )
+   {
+      copy( dst, _vData, _size * _vStride * sizeof(_vData[0]) );
+      return;
+   }
+
+   // The vertex components come first in stream order.
+   float* src[NUM_STREAMS];
+   activeStreams( src );
+
+   uint32_t i = 0;
+#if CGMATH_SSE
+   if( (_vStride % 4) == 0 )
+   {
+      // Transpose 4 components of 4 particles at a time.
+      for( ; i + 4 <= _size; i += 4 )
+      {
+         float* v = dst + i*_vStride;
+         for( uint c = 0; c < _vStride; c += 4 )
+         {
+            packQuad( v + c, _vStride, src + c, i );
+         }
+      }
+   }
+#endif
+   for( ; i < _size; ++i )
+   {
+      float* v = dst + i*_vStride;
+      for( uint c = 0; c < _vStride; ++c )
+      {
+         v[c] = src[c][i];
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Retrieves the SOA arrays in use, vertex components first, and returns their count.
+uint
+ParticleData::activeStreams( float** dst ) const
+{
+   uint n = 0;
+   for( uint s = 0; s < NUM_STREAMS; ++s )
+   {
+      if( _streams[s] )  dst[n++] = _streams[s];
+   }
+   return n;
+}
+
 //------------------------------------------------------------------------------
 //!
 void
@@ -172,6 +348,27 @@ ParticleData::printData( TextStream& os ) const
    os << nl;
 
    // Particles.
+   if( _layout == SOA )
+   {
+      float* streams[NUM_STREAMS];
+      activeStreams( streams );
+      for( uint32_t pi = 0; pi < _size; ++pi )
+      {
+         os << String().format("%4d", pi) << ": ";
+         for( uint32_t fi = 0; fi < _vStride; ++fi )
+         {
+            os << " " << fmt( streams[fi][pi] );
+         }
+         os << " |";
+         for( uint32_t fi = _vStride; fi < uint32_t(_vStride + _eStride); ++fi )
+         {
+            os << " " << fmt( streams[fi][pi] );
+         }
+         os << nl;
+      }
+      return;
+   }
+
    const float* curV = _vData;
    const float* curE = _eData;
    for( uint32_t pi = 0; pi < _size; ++pi )
@@ -205,5 +402,7 @@ ParticleData::printInfo( TextStream& os ) const
    os << " nrg:0";
    if( hasLinearVelocity() )  os << " linVel:1";
    os << String().format(" 0x%02x )", _types);
-   os << " vStride=" << _vStride << " eStride=" << _eStride << nl;
+   os << " vStride=" << _vStride << " eStride=" << _eStride;
+   if( _layout == SOA )  os << " soa";
+   os << nl;
 }
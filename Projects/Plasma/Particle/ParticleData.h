@@ -52,6 +52,10 @@ public:
 //!< Iteration is done starting from the end so that removal of dying particles
 //!< is more efficient; relative order between iterations (i.e. different frames)
 //!< is not guarateed (uses a removeSwap() removal for efficiency reasons).
+//!< In the SOA layout, every component is instead stored in its own array
+//!< (see stream()), aligned and padded so that animators can update them
+//!< a SIMD register at a time. The Iterator is not available in that layout,
+//!< and the interleaved vertex stream is only written by pack(), when rendering.
 class ParticleData
 {
 public:
@@ -66,6 +70,37 @@ public:
       LINEAR_VELOCITY = 0x08,
    };
 
+   enum Layout
+   {
+      INTERLEAVED,
+      SOA,
+   };
+
+   //! The component arrays of the SOA layout, in vertex order, followed by the extra data.
+   enum Stream
+   {
+      STREAM_POSITION_X,
+      STREAM_POSITION_Y,
+      STREAM_POSITION_Z,
+      STREAM_SIZE,
+      STREAM_COLOR_R,
+      STREAM_COLOR_G,
+      STREAM_COLOR_B,
+      STREAM_COLOR_A,
+      STREAM_ORIENTATION_X,
+      STREAM_ORIENTATION_Y,
+      STREAM_ORIENTATION_Z,
+      STREAM_ORIENTATION_W,
+      STREAM_ENERGY,
+      STREAM_LINEAR_VELOCITY_X,
+      STREAM_LINEAR_VELOCITY_Y,
+      STREAM_LINEAR_VELOCITY_Z,
+      NUM_STREAMS
+   };
+
+   //! Alignment (in floats) of the SOA arrays, which are also padded to a multiple of it.
+   enum { STREAM_ALIGNMENT = 8 };
+
    /*==============================================================================
      CLASS Iterator
    ==============================================================================*/
@@ -124,7 +159,7 @@ public:
    /*----- methods -----*/
 
    PLASMA_DLL_API ParticleData();
-   PLASMA_DLL_API ParticleData( DataType reqs, uint32_t cap );
+   PLASMA_DLL_API ParticleData( DataType reqs, uint32_t cap, Layout layout = INTERLEAVED );
    PLASMA_DLL_API ~ParticleData();
 
    inline bool  hasSize()           const { return (_types & SIZE           ) != 0x0; }
@@ -142,13 +177,25 @@ public:
    inline     uint16_t  colorOffset()       const { return _cOffset;  }
    inline     uint16_t  orientationOffset() const { return _oOffset;  }
 
+   inline  Layout  layout() const { return _layout; }
+
+   // Component arrays of the SOA layout (null for missing types, or when interleaved).
+   inline       float*  stream( Stream s )       { return _streams[s]; }
+   inline const float*  stream( Stream s ) const { return _streams[s]; }
+
    // Utility routines.
 
-   inline Iterator  iter() { return Iterator(this, _size-1); }
+   inline Iterator  iter();
 
    inline Iterator  addParticle();
+   inline uint32_t  addParticles( uint32_t n );
 
    PLASMA_DLL_API void  removeParticle( const Iterator& it );
+   PLASMA_DLL_API uint32_t  removeExpired();
+
+   PLASMA_DLL_API void  fill( Stream s, uint32_t first, uint32_t n, float v );
+
+   PLASMA_DLL_API void  pack( float* dst ) const;
 
    inline void  clear() { _size = 0; }
    inline bool  empty() { return _size == 0; }
@@ -158,7 +205,7 @@ public:
    PLASMA_DLL_API void  printData( TextStream& os = StdErr ) const;
    PLASMA_DLL_API void  printInfo( TextStream& os = StdErr ) const;
 
-   PLASMA_DLL_API void  allocate( DataType reqs, uint32_t cap );
+   PLASMA_DLL_API void  allocate( DataType reqs, uint32_t cap, Layout layout = INTERLEAVED );
    PLASMA_DLL_API void  deallocate();
 
 protected:
@@ -167,8 +214,11 @@ protected:
 
    /*----- methods -----*/
 
+   uint  activeStreams( float** dst ) const;
+
    /*----- data members -----*/
 
+   Layout    _layout;      //!< How the particle data is stored.
    DataType  _types;       //!< The extra data types that are present.
    uint32_t  _size;        //!< Current number of elements.
    uint32_t  _capacity;    //!< Maximum number of elements.
@@ -178,23 +228,46 @@ protected:
    uint16_t  _eStride;     //!< Stride (in floats) for the extra data.
    uint16_t  _cOffset;     //!< Offset of the color in the vertex structure.
    uint16_t  _oOffset;     //!< Offset of the orientation in the vertex structure.
+   float*    _soaData;     //!< The allocation holding all of the SOA arrays.
+   float*    _streams[NUM_STREAMS]; //!< Aligned arrays of the SOA layout.
 
 private:
 };
 
 GEN_ENUM_BITWISE_OPS( ParticleData::DataType )
 
+//------------------------------------------------------------------------------
+//!
+inline ParticleData::Iterator
+ParticleData::iter()
+{
+   CHECK( _layout == INTERLEAVED );
+   return Iterator( this, _size-1 );
+}
+
 //------------------------------------------------------------------------------
 //!
 inline ParticleData::Iterator
 ParticleData::addParticle()
 {
+   CHECK( _layout == INTERLEAVED );
    CHECK( _size < _capacity );
    Iterator iter( this, _size );
    ++_size;
    return iter;
 }
 
+//------------------------------------------------------------------------------
+//! Appends n particles, and returns the index of the first one.
+inline uint32_t
+ParticleData::addParticles( uint32_t n )
+{
+   CHECK( _size + n <= _capacity );
+   uint32_t first = _size;
+   _size += n;
+   return first;
+}
+
 
 NAMESPACE_END
 
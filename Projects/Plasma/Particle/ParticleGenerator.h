@@ -33,6 +33,9 @@ public:
    // Performs the actual particle generation for a delta time.
    PLASMA_DLL_API virtual bool  generate( float delta, ParticleEntity& e, ParticleRNG& rng ) = 0;
 
+   // Whether the ParticleData::SOA layout is handled (the Iterator isn't available in it).
+   inline virtual bool  handlesSOA() const { return false; }
+
    inline   void  energy( float e )    { _energy = e;    }
    inline  float  energy() const       { return _energy; }
    inline   void  useEnergy( float e ) { _energy -= e;   }
@@ -4,6 +4,8 @@
 =============================================================================*/
 #include <Plasma/Particle/Smoke.h>
 
+#include <CGMath/FloatN.h>
+
 USING_NAMESPACE
 
 /*==============================================================================
@@ -34,6 +36,53 @@ StringMap _attributes(
    ""
 );
 
+//------------------------------------------------------------------------------
+//! SmokeAnimator::animate() on the ParticleData::SOA layout.
+void  animateSmoke( ParticleData& data, float delta, float growingRate )
+{
+   typedef Floats F;
+   float* energy = data.stream( ParticleData::STREAM_ENERGY );
+   float* px     = data.stream( ParticleData::STREAM_POSITION_X );
+   float* py     = data.stream( ParticleData::STREAM_POSITION_Y );
+   float* pz     = data.stream( ParticleData::STREAM_POSITION_Z );
+   float* size   = data.stream( ParticleData::STREAM_SIZE );
+   float* vx     = data.stream( ParticleData::STREAM_LINEAR_VELOCITY_X );
+   float* vy     = data.stream( ParticleData::STREAM_LINEAR_VELOCITY_Y );
+   float* vz     = data.stream( ParticleData::STREAM_LINEAR_VELOCITY_Z );
+   float* col[4] = {
+      data.stream( ParticleData::STREAM_COLOR_R ),
+      data.stream( ParticleData::STREAM_COLOR_G ),
+      data.stream( ParticleData::STREAM_COLOR_B ),
+      data.stream( ParticleData::STREAM_COLOR_A )
+   };
+
+   const F d    = F::set( delta );
+   const F grow = F::set( growingRate * delta );
+   const F drop = F::set( delta * 0.04f );
+   const F one  = F::set( 1.0f );
+   for( uint32_t i = 0; i < data.size(); i += F::SIZE )
+   {
+      F nrg = F::load( energy+i ) - d;
+      nrg.store( energy+i );
+      ( F::load( px+i ) + F::load( vx+i )*d ).store( px+i );
+      ( F::load( py+i ) + F::load( vy+i )*d ).store( py+i );
+      ( F::load( pz+i ) + F::load( vz+i )*d ).store( pz+i );
+      ( F::load( size+i ) + grow ).store( size+i );
+      ( F::load( vy+i ) - drop ).store( vy+i );
+
+      // Take 1 second to make the particle disappear.
+      F::Mask fading = F::less( nrg, one );
+      if( fading.any() )
+      {
+         for( uint c = 0; c < 4; ++c )
+         {
+            F::select( fading, nrg, F::load( col[c]+i ) ).store( col[c]+i );
+         }
+      }
+   }
+   data.removeExpired();
+}
+
 UNNAMESPACE_END
 
 
@@ -76,9 +125,16 @@ SmokeGenerator::generate( float delta, ParticleEntity& e, ParticleRNG& rng )
 
    _potential += _distRate( rng ) * delta;
    uint32_t n = CGM::min( uint32_t(_potential), data.available() );
-   for( uint32_t i = 0; i < n; ++i )
+   if( data.layout() == ParticleData::SOA )
    {
-      generateParticle( data, rng );
+      generateParticles( data, n, rng );
+   }
+   else
+   {
+      for( uint32_t i = 0; i < n; ++i )
+      {
+         generateParticle( data, rng );
+      }
    }
    _potential -= float(n);
 
@@ -104,6 +160,38 @@ SmokeGenerator::generateParticle( ParticleData& data, ParticleRNG& rng )
    cur.linearVelocity( vel );
 }
 
+//------------------------------------------------------------------------------
+//! Same as calling generateParticle() n times, on the ParticleData::SOA layout.
+void
+SmokeGenerator::generateParticles( ParticleData& data, uint32_t n, ParticleRNG& rng )
+{
+   uint32_t first = data.addParticles( n );
+   float* size   = data.stream( ParticleData::STREAM_SIZE );
+   float* energy = data.stream( ParticleData::STREAM_ENERGY );
+   float* vx     = data.stream( ParticleData::STREAM_LINEAR_VELOCITY_X );
+   float* vy     = data.stream( ParticleData::STREAM_LINEAR_VELOCITY_Y );
+   float* vz     = data.stream( ParticleData::STREAM_LINEAR_VELOCITY_Z );
+   for( uint32_t i = first; i < first + n; ++i )
+   {
+      // Same draws, in the same order, as generateParticle().
+      Vec3f dir   = _distDirection( rng );
+      float speed = _distSpeed( rng );
+      Vec3f vel   = dir * speed;
+      size[i]     = _distSize( rng );
+      energy[i]   = _distEnergy( rng );
+      vx[i]       = vel.x;
+      vy[i]       = vel.y;
+      vz[i]       = vel.z;
+   }
+   data.fill( ParticleData::STREAM_POSITION_X, first, n, _position.x );
+   data.fill( ParticleData::STREAM_POSITION_Y, first, n, _position.y );
+   data.fill( ParticleData::STREAM_POSITION_Z, first, n, _position.z );
+   data.fill( ParticleData::STREAM_COLOR_R, first, n, 1.0f );
+   data.fill( ParticleData::STREAM_COLOR_G, first, n, 1.0f );
+   data.fill( ParticleData::STREAM_COLOR_B, first, n, 1.0f );
+   data.fill( ParticleData::STREAM_COLOR_A, first, n, 1.0f );
+}
+
 //------------------------------------------------------------------------------
 //!
 bool
@@ -207,6 +295,11 @@ SmokeAnimator::animate( float delta, ParticleEntity& e, ParticleRNG& )
 {
    // Update energies and expire dead particles.
    ParticleData& data = e.data();
+   if( data.layout() == ParticleData::SOA )
+   {
+      animateSmoke( data, delta, _growingRate );
+      return false;
+   }
    for( auto cur = data.iter(); cur(); cur.next() )
    {
       float& energy = cur.energy();
@@ -34,6 +34,8 @@ public:
 
    PLASMA_DLL_API virtual bool  generate( float delta, ParticleEntity& e, ParticleRNG& rng );
 
+   inline virtual bool  handlesSOA() const { return true; }
+
    inline void rate( float avg, float var ) { _distRate.set(avg, var); }
 
    inline void initialPosition( const Vec3f& v ) { _position = v; }
@@ -71,6 +73,7 @@ protected:
 
    /*----- methods -----*/
    void  generateParticle( ParticleData& data, ParticleRNG& rng );
+   void  generateParticles( ParticleData& data, uint32_t n, ParticleRNG& rng );
 
 }; //class SmokeGenerator
 
@@ -92,6 +95,8 @@ public:
 
    PLASMA_DLL_API virtual bool animate( float delta, ParticleEntity& e, ParticleRNG& rng );
 
+   inline virtual bool  handlesSOA() const { return true; }
+
 protected:
    float  _growingRate;  //!< The rate at which particles grow in size.
 }; //class SmokeAnimator
@@ -4,6 +4,8 @@
 =============================================================================*/
 #include <Plasma/Particle/Spark.h>
 
+#include <CGMath/FloatN.h>
+
 #include <Base/ADT/StringMap.h>
 
 USING_NAMESPACE
@@ -38,6 +40,32 @@ StringMap _attributes(
    ""
 );
 
+//------------------------------------------------------------------------------
+//! SparkAnimator::animate() on the ParticleData::SOA layout.
+void  animateSparks( ParticleData& data, float delta )
+{
+   typedef Floats F;
+   float* energy = data.stream( ParticleData::STREAM_ENERGY );
+   float* px     = data.stream( ParticleData::STREAM_POSITION_X );
+   float* py     = data.stream( ParticleData::STREAM_POSITION_Y );
+   float* pz     = data.stream( ParticleData::STREAM_POSITION_Z );
+   float* vx     = data.stream( ParticleData::STREAM_LINEAR_VELOCITY_X );
+   float* vy     = data.stream( ParticleData::STREAM_LINEAR_VELOCITY_Y );
+   float* vz     = data.stream( ParticleData::STREAM_LINEAR_VELOCITY_Z );
+
+   const F d = F::set( delta );
+   const F g = F::set( 9.8f*delta );
+   for( uint32_t i = 0; i < data.size(); i += F::SIZE )
+   {
+      ( F::load( energy+i ) - d ).store( energy+i );
+      ( F::load( px+i ) + F::load( vx+i )*d ).store( px+i );
+      ( F::load( py+i ) + F::load( vy+i )*d ).store( py+i );
+      ( F::load( pz+i ) + F::load( vz+i )*d ).store( pz+i );
+      ( F::load( vy+i ) - g ).store( vy+i ); // Drop faster and faster.
+   }
+   data.removeExpired();
+}
+
 UNNAMESPACE_END
 
 /*==============================================================================
@@ -143,6 +171,39 @@ SparkGenerator::generateParticleStream( const Vec3f& pos, ParticleData& data, Pa
       vel    = dir * speed;
 #endif
 
+      if( data.layout() == ParticleData::SOA )
+      {
+         uint32_t first = data.addParticles( num );
+         float* px = data.stream( ParticleData::STREAM_POSITION_X ) + first;
+         float* py = data.stream( ParticleData::STREAM_POSITION_Y ) + first;
+         float* pz = data.stream( ParticleData::STREAM_POSITION_Z ) + first;
+         float* sz = data.stream( ParticleData::STREAM_SIZE ) + first;
+         float* cr = data.stream( ParticleData::STREAM_COLOR_R ) + first;
+         float* cg = data.stream( ParticleData::STREAM_COLOR_G ) + first;
+         float* cb = data.stream( ParticleData::STREAM_COLOR_B ) + first;
+         float* ca = data.stream( ParticleData::STREAM_COLOR_A ) + first;
+         float* vy = data.stream( ParticleData::STREAM_LINEAR_VELOCITY_Y ) + first;
+         for( uint32_t i = 0; i < num; ++i )
+         {
+            float f = 0.5f + float(i)*0.5f/num;
+            float t = float(i)*0.04f;
+            px[i] = pos.x + dir.x*t;
+            py[i] = pos.y + dir.y*t;
+            pz[i] = pos.z + dir.z*t;
+            sz[i] = size*i;
+            cr[i] = color.x*f;
+            cg[i] = color.y*f;
+            cb[i] = color.z*f;
+            ca[i] = color.w*f;
+            vy[i] = vel.y;
+            vel.y -= (9.8f*0.04f/speed);
+         }
+         data.fill( ParticleData::STREAM_ENERGY, first, num, energy );
+         data.fill( ParticleData::STREAM_LINEAR_VELOCITY_X, first, num, vel.x );
+         data.fill( ParticleData::STREAM_LINEAR_VELOCITY_Z, first, num, vel.z );
+         return true;
+      }
+
       for( uint32_t i = 0; i < num; ++i )
       {
          float f = 0.5f + float(i)*0.5f/num;
@@ -281,6 +342,11 @@ SparkAnimator::animate( float delta, ParticleEntity& e, ParticleRNG& /*rng*/ )
 {
    // Update energies and expire dead particles.
    ParticleData& data = e.data();
+   if( data.layout() == ParticleData::SOA )
+   {
+      animateSparks( data, delta );
+      return false;
+   }
    for( auto cur = data.iter(); cur(); cur.next() )
    {
       float& energy = cur.energy();
@@ -32,6 +32,8 @@ public:
 
    PLASMA_DLL_API virtual bool  generate( float delta, ParticleEntity& e, ParticleRNG& rng );
 
+   inline virtual bool  handlesSOA() const { return true; }
+
    inline void rate( float avg, float var ) { _distRate.set(avg, var); }
 
    inline void initialColor( const Vec3f& c0 ) { _distColors.set(c0, c0); }
@@ -95,6 +97,8 @@ public:
 
    PLASMA_DLL_API virtual bool animate( float delta, ParticleEntity& e, ParticleRNG& rng );
 
+   inline virtual bool  handlesSOA() const { return true; }
+
 protected:
    float  _damping;  //!< A damping factor.
 }; //class SparkAnimator
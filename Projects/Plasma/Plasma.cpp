@@ -71,6 +71,10 @@ DBG_STREAM( os_plasma, "Plasma" );
 //!
 uint  _numThreads = 0;
 
+//------------------------------------------------------------------------------
+//!
+bool  _workStealing = false;
+
 //------------------------------------------------------------------------------
 //!
 enum
@@ -83,6 +87,7 @@ enum
    ATTRIB_PHYSICS_FPS,
    ATTRIB_RENDERING_FPS,
    ATTRIB_WIREFRAME,
+   ATTRIB_WORK_STEALING,
 };
 
 //------------------------------------------------------------------------------
@@ -96,6 +101,7 @@ StringMap _plasma_attr(
    "physicsFPS"      , ATTRIB_PHYSICS_FPS,
    "renderingFPS"    , ATTRIB_RENDERING_FPS,
    "wireframe"       , ATTRIB_WIREFRAME,
+   "workStealing"    , ATTRIB_WORK_STEALING,
    ""
 );
 
@@ -144,6 +150,9 @@ int plasmaGetVM( VMState* vm )
       case ATTRIB_WIREFRAME:
          VM::push( vm, Plasma::showWireframe() );
          return 1;
+      case ATTRIB_WORK_STEALING:
+         VM::push( vm, _workStealing );
+         return 1;
       default:;
    }
    return 0;
@@ -180,6 +189,9 @@ int plasmaSetVM( VMState* vm )
       case ATTRIB_WIREFRAME:
          Plasma::showWireframe( VM::toBoolean( vm, -1 ) );
          return 0;
+      case ATTRIB_WORK_STEALING:
+         _workStealing = VM::toBoolean( vm, -1 );
+         return 0;
       default:;
    }
    return 0;
@@ -313,7 +325,10 @@ Plasma::exec()
    CHECK( _dispatchQueue == NULL ); // Don't support reallocation of threads for now.
 
    // Allocate VMs for executing.
-   _dispatchQueue = new TaskQueue( _numThreads );
+   _dispatchQueue = new TaskQueue(
+      _numThreads,
+      _workStealing ? TaskQueue::SCHEDULING_WORK_STEALING : TaskQueue::SCHEDULING_DEFAULT
+   );
    Brain::initVMs();
 }
 
@@ -7,6 +7,7 @@
 #include <Plasma/Geometry/MeshGeometry.h>
 #include <Plasma/Physics/CollisionShapeGenerator.h>
 #include <Plasma/Resource/ResManager.h>
+#include <Plasma/Resource/Serializer.h>
 #include <Plasma/Plasma.h>
 
 #if MOTION_BULLET
@@ -17,12 +18,14 @@
 #include <Motion/Collision/CollisionGroup.h>
 #endif
 
+#include <Fusion/Resource/DiskCache.h>
 #include <Fusion/Resource/ResManager.h>
 #include <Fusion/VM/VMRegistry.h>
 #include <Fusion/Core/Core.h>
 
 #include <Base/ADT/StringMap.h>
 #include <Base/IO/FileSystem.h>
+#include <Base/IO/StringDevice.h>
 
 /*==============================================================================
   UNNAME NAMESPACE
@@ -1281,6 +1284,28 @@ int displacementVM( VMState* vm )
    return 0;
 }
 
+//------------------------------------------------------------------------------
+//! Like mapping(), but the function is called once per patch: IN holds the
+//! arrays pos, n and uv of IN.count points (along with id, f and fn), and the
+//! function returns the array of their uvs.
+int batchMappingVM( VMState* vm )
+{
+   mappingVM( vm );
+   if( VM::isFunction( vm, -1 ) )  getContext(vm)->_state._mapping->batched( true );
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+//! Like displacement(), but the function is called once per displacement
+//! image, with arrays in IN (see batchMappingVM()), and returns the array of
+//! the displaced positions.
+int batchDisplacementVM( VMState* vm )
+{
+   displacementVM( vm );
+   if( VM::isFunction( vm, -1 ) )  getContext(vm)->_state._displacement->batched( true );
+   return 0;
+}
+
 //------------------------------------------------------------------------------
 //!
 StringMap _collision_strToType(
@@ -1466,6 +1491,8 @@ const VM::Reg funcs[] = {
    // Surface.
    { "mapping",              mappingVM              },
    { "displacement",         displacementVM         },
+   { "batchMapping",         batchMappingVM         },
+   { "batchDisplacement",    batchDisplacementVM    },
    // Collision shapes.
    { "collision",            collisionVM            },
    { "collisionBox",         collisionBoxVM         },
@@ -1548,6 +1575,33 @@ ProceduralGeometry::ProceduralGeometry(
 void
 ProceduralGeometry::execute()
 {
+   // Only compiled meshes are kept on disk; the key covers the geometric error
+   // since it drives the tessellation.
+   DiskCache*   cache = _compiled ? DiskCache::procedural() : nullptr;
+   SHA1::Digest key;
+   if( cache )
+   {
+      SHA1 sha;
+      sha.begin();
+      sha.put( _gerror );
+      if( _params.isValid() )  ResManager::getDigestPart( *_params, sha );
+      DiskCache::key( "geometry", _path, sha.end(), key );
+
+      String blob;
+      if( cache->get( key, blob ) )
+      {
+         // Load aside, so that a bad blob is never seen by the waiting tasks.
+         RCP< Resource<Geometry> > loaded = new Resource<Geometry>();
+         BinaryStream is( new StringDevice( blob, IODevice::MODE_READ ) );
+         if( Serializer::loadMeshGeometry( is, loaded.ptr() ) )
+         {
+            _res->data( loaded->data() );
+            return;
+         }
+         cache->remove( key );
+      }
+   }
+
    // Prepare to build geometry.
    RCP<MetaGeometry> metaGeom( new MetaGeometry() );
    MetaBuilder builder( metaGeom.ptr() );
@@ -1568,6 +1622,10 @@ ProceduralGeometry::execute()
    // keep context pointer into the vm.
    VM::userData( vm, &context );
 
+   // Track the scripts it runs (see executeVM()), which the cached blob depends on.
+   Vector<String> files;
+   if( cache )  VM::recordFiles( vm, &files );
+
    // Push parameters.
    if( _params.isValid() )
    {
@@ -1646,6 +1704,14 @@ ProceduralGeometry::execute()
       }
    }
 
+   // Skinned geometries depend on their skeleton, which isn't serialized.
+   if( cache && !context._skeletonRes.isValid() )
+   {
+      String blob;
+      BinaryStream os( new StringDevice( blob, IODevice::MODE_WRITE ) );
+      if( Serializer::dumpMeshGeometry( *geom->mesh(), os ) )  cache->put( key, blob, files );
+   }
+
    _res->data( geom.ptr() );
 }
 
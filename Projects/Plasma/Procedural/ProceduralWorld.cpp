@@ -229,6 +229,15 @@ int backgroundVM( VMState* vm )
    return 0;
 }
 
+//------------------------------------------------------------------------------
+//!
+int brainReportVM( VMState* vm )
+{
+   WorldContext* context = getContext( vm );
+   context->_world->brainReport( VM::toNumber( vm, -1 ) );
+   return 0;
+}
+
 
 /*==============================================================================
    Objects
@@ -674,6 +683,7 @@ const VM::Reg funcs[] = {
    // States.
    { "gravity",              gravityVM              },
    { "background",           backgroundVM           },
+   { "brainReport",          brainReportVM          },
    // Object.
    { "camera",               cameraVM               },
    { "group",                groupVM                },
@@ -313,8 +313,10 @@ ForwardRenderer::render(
    _world = world;
 
    // Classify entities for rendering. We are looking for visible, ghost and
-   // reflection.
-   classifyEntities( _world );
+   // reflection. Mirrors can reflect entities outside of the view, so they
+   // disable the culling.
+   classifyEntities( _world, vp->frustum() );
+   if( !_reflections.empty() ) classifyEntities( _world );
 
    // Rendering.
    Gfx::RenderNode* renderNode = getRenderNode();
@@ -543,14 +545,19 @@ void ForwardRenderer::renderLightPass( Gfx::RenderNode& rn, const Viewport& vp )
 
    _lightConstants->setConstant( 2, (l->viewportMatrix()*projMat*viewMat).ptr() );
 
+   // Only the casters inside the light volume reach the shadow map.
+   classifyCasters( _world, Frustumf( projMat*viewMat ) );
+
    // 3. Setting default states.
    pass->setProjectionMatrix( projMat.ptr() );
    pass->setViewMatrix( viewMat.ptr() );
    pass->setAlphaState( _noBlending );
    if( !_depthBuffer->hasColorBuffer() ) pass->setColorState( _noColor );
 
-   // 4. Render geometry.
+   // 4. Render geometry, grouped by program since the order doesn't matter.
    renderDepth( *pass );
+   pass->sortMode( Gfx::SORT_STATE );
+   pass->sortDraws();
 
    // 5. Blur the color depth texture.
    if( _blur.isValid() ) pass->render( _blur );
@@ -720,14 +727,12 @@ ForwardRenderer::renderDepth( Gfx::Pass& pass )
 {
    // TODO: change program...
    // Render entities.
-   for( auto cur = _visibles.begin(); cur != _visibles.end(); ++cur )
+   for( auto cur = _casters.begin(); cur != _casters.end(); ++cur )
    {
       Entity* e      = cur->_entity;
       Geometry* geom = cur->_geom;
       Material* mat  = cur->_mat;
 
-      if( !e->castsShadows() ) return;
-
       // Set position.
       pass.setWorldMatrixPtr( (const float*)cur->_trf );
 
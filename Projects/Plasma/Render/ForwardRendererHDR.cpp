@@ -116,7 +116,7 @@ ForwardRendererHDR::render(
 
    // Classify entities for rendering. We are looking for visible, ghost and
    // reflection.
-   classifyEntities( _world );
+   classifyEntities( _world, vp->frustum() );
 
    // Rendering.
    Gfx::Pass* pass = getPass();
@@ -5,6 +5,7 @@
 #include <Plasma/Render/PlasmaBaker.h>
 #include <Plasma/Geometry/SurfaceGeometry.h>
 #include <Plasma/Intersector.h>
+#include <Plasma/Plasma.h>
 #include <Plasma/Render/ForwardRenderer.h>
 #include <Plasma/World/Camera.h>
 #include <Plasma/World/Viewport.h>
@@ -14,6 +15,7 @@
 #include <CGMath/Random.h>
 #include <CGMath/Distributions.h>
 
+#include <Base/MT/TaskQueue.h>
 #include <Base/Util/Timer.h>
 
 /*==============================================================================
@@ -40,6 +42,47 @@ const VM::Reg baker_funcs[] = {
    { 0, 0 }
 };
 */
+
+//------------------------------------------------------------------------------
+//! The vertices handed to a worker at once.
+const uint _vertexGrain = 32;
+
+//------------------------------------------------------------------------------
+//! Intersects a triangle of the surface passed as data (see BIH::trace()).
+bool occludes( const Rayf& ray, uint id, float& t, void* data )
+{
+   const SurfaceGeometry* surface    = (const SurfaceGeometry*)data;
+   const SurfaceGeometry::Face& face = surface->patches()[id>>24]->faces()[id&0xffffff];
+
+   Intersector::Hit hit;
+   hit._t = t;
+   if( !Intersector::trace(
+            surface->vertex( face._vID[0] ),
+            surface->vertex( face._vID[1] ),
+            surface->vertex( face._vID[2] ),
+            ray,
+            hit
+         )
+      )
+   {
+      return false;
+   }
+   t = hit._t;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//! Returns the seed of the rays of a vertex, starting at the specified one.
+inline uint32_t sampleSeed( uint nid, uint firstRay )
+{
+   uint32_t h = nid * 0x9E3779B1u;
+   h ^= (firstRay + 1) * 0x85EBCA77u;
+   h ^= h >> 15;
+   h *= 0xC2B2AE3Du;
+   h ^= h >> 13;
+   return h;
+}
+
 UNNAMESPACE_END
 
 NAMESPACE_BEGIN
@@ -69,134 +112,280 @@ PlasmaBaker::vertexAO( World* )
 void
 PlasmaBaker::vertexAO( SurfaceGeometry* surface )
 {
-   uint numRays   = 264;
-   float len      = 10.0f;
-   //float fraction = 0.3f;
+   StdErr << "starting baking AO..." << nl;
 
-   Vec3f lightDir( 0.6f, 0.4f, 1.0f );
-   lightDir.normalize();
+   Timer timer;
+   RCP<VertexAOBaker> baker = new VertexAOBaker( surface );
+   baker->bake();
 
-   RNG_WELL rng;
+   StdErr << "finish in " << timer.elapsed() << nl;
+}
 
-   printf( "starting baking AO...\n" );
 
-   // Building acceleration structure.
-   surface->computeBIH();
+/*==============================================================================
+  STRUCT VertexAOBaker::RayBuckets
+==============================================================================*/
+//! The rays of a vertex, grouped by the signs of their direction.
+struct VertexAOBaker::RayBuckets
+{
+   /*----- methods -----*/
 
-   // Compute AO per vertex.
-   Vector<bool> done( surface->numNormals(), false );
+   void clear()
+   {
+      for( uint i = 0; i < 8; ++i )
+      {
+         _rays[i].clear();
+         _weights[i].clear();
+      }
+   }
 
-   // Precompute normals.
-   Vector<Vec3f> normals(numRays);
-   for( uint i = 0; i < numRays; ++i )
+   void add( const Rayf& ray, float weight )
    {
-      normals[i] = rng( UniformSphere<float>() );
+      const Vec3f& d = ray.direction();
+      uint octant    = (d.x < 0.0f ? 1 : 0) | (d.y < 0.0f ? 2 : 0) | (d.z < 0.0f ? 4 : 0);
+      _rays[octant].pushBack( ray );
+      _weights[octant].pushBack( weight );
    }
 
-   Timer timer;
-   for( uint p = 0; p < surface->numPatches(); ++p )
+   //! Returns the sum of the weights of the rays not hitting the surface.
+   float unoccluded( const BIH& bih, void* surface ) const
    {
-      SurfaceGeometry::Patch* patch = surface->patches()[p].ptr();
-      for( uint f = 0; f < patch->numFaces(); ++f )
+      float light = 0.0f;
+      BIH::Hit hits[4];
+      for( uint o = 0; o < 8; ++o )
       {
-         for( uint v = 0; v < 3; ++v )
+         const Vector<Rayf>&  rays    = _rays[o];
+         const Vector<float>& weights = _weights[o];
+         uint r = 0;
+         for( ; r + 4 <= rays.size(); r += 4 )
          {
-            uint nid  = patch->faces()[f]._dID[v];
-            uint vid  = patch->faces()[f]._vID[v];
-
-            // Already computed?
-            if( done[nid] )
+            for( uint k = 0; k < 4; ++k )  hits[k]._t = 1.0f;
+            uint impacts = bih.trace4( rays.data() + r, hits, occludes, surface );
+            for( uint k = 0; k < 4; ++k )
             {
-               continue;
+               if( !(impacts & (1 << k)) )  light += weights[r+k];
             }
+         }
+         for( ; r < rays.size(); ++r )
+         {
+            hits[0]._t = 1.0f;
+            if( !bih.trace( rays[r], hits[0], occludes, surface ) )  light += weights[r];
+         }
+      }
+      return light;
+   }
 
-            Vec3f vertex = surface->vertex(vid);
-            Vec3f n      = surface->normal(nid);
-            uint vid1    = patch->faces()[f]._vID[(v+1)%3];
-            uint vid2    = patch->faces()[f]._vID[(v+2)%3];
-            Vec3f e0     = surface->vertex(vid1) - vertex;
-            Vec3f e1     = surface->vertex(vid2) - vertex;
-            Vec3f de     = ( e0.getNormalized() + e1.getNormalized() ) * 0.001f;
+   /*----- data members -----*/
 
-            // Compute vertex AO.
-            Rayf ray( vertex, n );
+   Vector<Rayf>   _rays[8];
+   Vector<float>  _weights[8];
+};
 
-            float totalLight = 0.0f;
-            float maxLight   = 0.0f;
+/*==============================================================================
+  CLASS VertexAOBaker::VertexLoop
+==============================================================================*/
+//! Bakes a range of vertices (see TaskQueue::parallelFor()).
+class VertexAOBaker::VertexLoop
+{
+public:
 
-            for( uint r = 0; r < numRays; ++r )
-            {
-               float ldotn = normals[r].dot(n);
-               if( ldotn > 0.0f )
-               {
-                  ray.direction( normals[r] );
-               }
-               else
-               {
-                  ray.direction( -normals[r] );
-                  ldotn = -ldotn;
-               }
-               ray.origin( vertex + de + ray.direction()*0.005f );
-               ray.direction( ray.direction() * len );
-
-               maxLight += ldotn;
-               if( !Intersector::trace( surface, ray ) )
-               {
-                  totalLight += ldotn;
-               }
-            }
+   /*----- methods -----*/
 
-            float ao = CGM::max( 0.1f, totalLight/maxLight );
+   VertexLoop( VertexAOBaker& baker, uint firstRay, uint numRays ):
+      _baker( baker ), _firstRay( firstRay ), _numRays( numRays )
+   {}
 
-            // Compute directional lighting.
-            ray.direction( lightDir*10000.0f );
+   void operator()( uint begin, uint end, WorkerTask& )
+   {
+      bake( begin, end );
+   }
 
+   void bake( uint begin, uint end )
+   {
+      RayBuckets buckets;
+      for( uint i = begin; i < end; ++i )
+      {
+         _baker.bakeSample( _baker._samples[i], _firstRay, _numRays, buckets );
+      }
+   }
 
-            float dl = 1.0f;
+protected:
 
-            // FIXME: Tangent are wrong!!
-            //const Vec4f& t = surface->tangent( vid );
-            //Vec3f tan( t.x, t.y, t.z );
-            Vec3f tan  = Vec3f::perpendicular( n );
-            Vec3f btan = n.cross( tan );
+   /*----- data members -----*/
 
+   VertexAOBaker&  _baker;
+   uint            _firstRay;
+   uint            _numRays;
+};
 
-            ray.origin( vertex + 0.005f*n - 0.5f*tan -0.5f*btan );
-            if( Intersector::trace( surface, ray ) )
-            {
-               dl -= 0.25f;
-            }
-            ray.origin( ray.origin() + tan );
-            if( Intersector::trace( surface, ray ) )
-            {
-               dl -= 0.25f;
-            }
-            ray.origin( ray.origin() + btan );
-            if( Intersector::trace( surface, ray ) )
-            {
-               dl -= 0.25f;
-            }
-            ray.origin( ray.origin() - tan );
-            if( Intersector::trace( surface, ray ) )
-            {
-               dl -= 0.25f;
-            }
+/*==============================================================================
+  CLASS VertexAOBaker
+==============================================================================*/
 
-            dl *= CGM::max( 0.0f, lightDir.dot( n ) );
+//------------------------------------------------------------------------------
+//! The rays of every vertex are split evenly among the passes.
+VertexAOBaker::VertexAOBaker( SurfaceGeometry* surface, uint numRays, uint numPasses ):
+   _surface( surface ),
+   _queue( Plasma::dispatchQueue() ),
+   _numRays( CGM::max( numRays, 1u ) ),
+   _numPasses( CGM::clamp( numPasses, 1u, _numRays ) ),
+   _pass( 0 ),
+   _rayLength( 10.0f ),
+   _lightDir( 0.6f, 0.4f, 1.0f ),
+   _ownsBIH( surface->bih().isEmpty() )
+{
+   _lightDir.normalize();
 
-            ao = (ao+dl) * 0.75f;
+   // Building acceleration structure.
+   if( _ownsBIH )  surface->computeBIH();
 
-            // Rescale normal to lighting.
-            surface->rescaleNormal( nid, ao );
+   // One sample per normal, at the first corner using it.
+   Vector<bool> done( surface->numNormals(), false );
+   _samples.reserve( surface->numNormals() );
+   for( uint p = 0; p < surface->numPatches(); ++p )
+   {
+      const SurfaceGeometry::Patch* patch = surface->patches()[p].ptr();
+      for( uint f = 0; f < patch->numFaces(); ++f )
+      {
+         const SurfaceGeometry::Face& face = patch->faces()[f];
+         for( uint v = 0; v < 3; ++v )
+         {
+            uint nid = face._dID[v];
+            if( done[nid] )  continue;
             done[nid] = true;
+
+            Sample s;
+            s._pos      = surface->vertex( face._vID[v] );
+            s._normal   = surface->normal( nid );
+            Vec3f e0    = surface->vertex( face._vID[(v+1)%3] ) - s._pos;
+            Vec3f e1    = surface->vertex( face._vID[(v+2)%3] ) - s._pos;
+            s._offset   = ( e0.getNormalized() + e1.getNormalized() ) * 0.001f;
+            s._nid      = nid;
+            s._light    = 0.0f;
+            s._maxLight = 0.0f;
+            s._direct   = 0.0f;
+            s._scale    = 1.0f;
+            _samples.pushBack( s );
          }
       }
    }
+}
 
-   printf( "finish in %f\n", timer.elapsed() );
+//------------------------------------------------------------------------------
+//!
+VertexAOBaker::~VertexAOBaker()
+{
+}
+
+//------------------------------------------------------------------------------
+//! Traces the next pass of rays for all of the vertices, and rescales their
+//! normals with the occlusion gathered so far.
+//! Returns true once all of the passes are done.
+bool
+VertexAOBaker::refine()
+{
+   if( done() )  return true;
+
+   uint firstRay = _pass*_numRays/_numPasses;
+   uint lastRay  = (_pass+1)*_numRays/_numPasses;
+   VertexLoop loop( *this, firstRay, lastRay - firstRay );
+   if( _queue && numVertices() > _vertexGrain )
+   {
+      _queue->parallelFor( 0, numVertices(), _vertexGrain, loop );
+   }
+   else
+   {
+      loop.bake( 0, numVertices() );
+   }
+
+   if( ++_pass < _numPasses )  return false;
 
    // Clear acceleration structure.
-   surface->clearBIH();
+   if( _ownsBIH )  _surface->clearBIH();
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//! Runs all of the remaining passes.
+void
+VertexAOBaker::bake()
+{
+   while( !refine() ) {}
+}
+
+//------------------------------------------------------------------------------
+//!
+bool
+VertexAOBaker::exec( double /*time*/, double /*delta*/ )
+{
+   return refine();
+}
+
+//------------------------------------------------------------------------------
+//! Traces the rays [firstRay, firstRay+numRays) of a vertex; the first pass
+//! also computes the directional light term.
+void
+VertexAOBaker::bakeSample( Sample& s, uint firstRay, uint numRays, RayBuckets& buckets ) const
+{
+   const BIH& bih = _surface->bih();
+   void* data     = _surface.ptr();
+   const Vec3f& n = s._normal;
+
+   // Compute vertex AO.
+   RNG_WELL rng;
+   rng.seed( sampleSeed( s._nid, firstRay ) );
+   UniformSphere<float> sphere;
+
+   Vec3f org = s._pos + s._offset;
+   buckets.clear();
+   for( uint r = 0; r < numRays; ++r )
+   {
+      Vec3f dir   = rng( sphere );
+      float ldotn = dir.dot( n );
+      if( ldotn <= 0.0f )
+      {
+         dir   = -dir;
+         ldotn = -ldotn;
+      }
+      s._maxLight += ldotn;
+      buckets.add( Rayf( org + dir*0.005f, dir*_rayLength ), ldotn );
+   }
+   s._light += buckets.unoccluded( bih, data );
+
+   if( firstRay == 0 )
+   {
+      // Compute directional lighting.
+      // FIXME: Tangent are wrong!!
+      //const Vec4f& t = surface->tangent( vid );
+      //Vec3f tan( t.x, t.y, t.z );
+      Vec3f tan  = Vec3f::perpendicular( n );
+      Vec3f btan = n.cross( tan );
+      Vec3f dir  = _lightDir*10000.0f;
+
+      Rayf rays[4];
+      rays[0] = Rayf( s._pos + 0.005f*n - 0.5f*tan - 0.5f*btan, dir );
+      rays[1] = Rayf( rays[0].origin() + tan, dir );
+      rays[2] = Rayf( rays[1].origin() + btan, dir );
+      rays[3] = Rayf( rays[2].origin() - tan, dir );
+
+      BIH::Hit hits[4];
+      for( uint k = 0; k < 4; ++k )  hits[k]._t = 1.0f;
+      uint impacts = bih.trace4( rays, hits, occludes, data );
+
+      float dl = 1.0f;
+      for( uint k = 0; k < 4; ++k )
+      {
+         if( impacts & (1 << k) )  dl -= 0.25f;
+      }
+      s._direct = dl * CGM::max( 0.0f, _lightDir.dot( n ) );
+   }
+
+   float ao    = CGM::max( 0.1f, s._light/s._maxLight );
+   float scale = (ao + s._direct) * 0.75f;
+
+   // Rescale normal to lighting.
+   _surface->rescaleNormal( s._nid, scale/s._scale );
+   s._scale = scale;
 }
 
 
@@ -20,6 +20,7 @@ NAMESPACE_BEGIN
 class Image;
 class Renderer;
 class SurfaceGeometry;
+class TaskQueue;
 class World;
 
 /*==============================================================================
@@ -42,6 +43,85 @@ public:
 
 };
 
+/*==============================================================================
+  CLASS VertexAOBaker
+==============================================================================*/
+//! Bakes ambient occlusion, along with a directional light term, into the
+//! length of the normals of a surface.
+//! The vertices are processed in chunks on a TaskQueue.  The hemisphere rays of
+//! a vertex are grouped by direction octant and traced through the surface's
+//! BIH in packets of 4, so that the rays of a packet share their traversal.
+//! Every vertex draws its rays from its own RNG, seeded from its normal index
+//! and the pass, so the result does not depend on the number of threads.
+//! The rays can be spread over several passes (see refine()), the normals
+//! being updated after each one; as an Animator, one pass runs per exec().
+class VertexAOBaker:
+   public Animator
+{
+public:
+
+   /*----- methods -----*/
+
+   PLASMA_DLL_API VertexAOBaker( SurfaceGeometry* surface, uint numRays = 264, uint numPasses = 1 );
+   PLASMA_DLL_API virtual ~VertexAOBaker();
+
+   // The queue tracing the vertices (defaults to the Plasma dispatch queue, NULL for the calling thread).
+   inline void  queue( TaskQueue* q ) { _queue = q; }
+   inline TaskQueue*  queue() const { return _queue; }
+
+   inline void  rayLength( float v ) { _rayLength = v; }
+   inline float  rayLength() const { return _rayLength; }
+
+   inline uint  numVertices() const { return _samples.size(); }
+   inline uint  numRays() const     { return _numRays; }
+   inline uint  numPasses() const   { return _numPasses; }
+   inline uint  passesDone() const  { return _pass; }
+   inline bool  done() const        { return _pass >= _numPasses; }
+
+   PLASMA_DLL_API bool  refine();
+   PLASMA_DLL_API void  bake();
+
+   PLASMA_DLL_API virtual bool exec( double time, double delta );
+
+protected:
+
+   /*----- data types -----*/
+
+   //! A vertex to bake (the first corner found for every normal).
+   struct Sample
+   {
+      Vec3f  _pos;      //!< The vertex position.
+      Vec3f  _normal;   //!< The unit normal, before rescaling.
+      Vec3f  _offset;   //!< Pushes the ray origins inside of the adjacent face.
+      uint   _nid;      //!< The normal index.
+      float  _light;    //!< The cosine-weighted unoccluded rays traced so far.
+      float  _maxLight; //!< The cosine-weighted rays traced so far.
+      float  _direct;   //!< The directional light term.
+      float  _scale;    //!< The scale currently applied to the normal.
+   };
+
+   struct RayBuckets;
+   class VertexLoop;
+
+   /*----- data members -----*/
+
+   RCP<SurfaceGeometry>  _surface;
+   Vector<Sample>        _samples;
+   TaskQueue*            _queue;
+   uint                  _numRays;
+   uint                  _numPasses;
+   uint                  _pass;      //!< The next pass to run.
+   float                 _rayLength;
+   Vec3f                 _lightDir;
+   bool                  _ownsBIH;   //!< Set when the BIH got computed for the baking only.
+
+   /*----- methods -----*/
+
+   void  bakeSample( Sample& s, uint firstRay, uint numRays, RayBuckets& buckets ) const;
+
+private:
+}; //class VertexAOBaker
+
 /*==============================================================================
   CLASS CubemapBaker
 ==============================================================================*/
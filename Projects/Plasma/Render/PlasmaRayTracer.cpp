@@ -5,6 +5,7 @@
 #include <Plasma/Render/PlasmaRayTracer.h>
 
 #include <Plasma/Intersector.h>
+#include <Plasma/Plasma.h>
 #include <Plasma/World/Entity.h>
 #include <Plasma/World/Material.h>
 
@@ -13,7 +14,7 @@
 #include <Fusion/Resource/ResManager.h>
 
 #include <Base/ADT/StringMap.h>
-#include <Base/MT/Thread.h>
+#include <Base/MT/TaskQueue.h>
 #include <Base/Util/Timer.h>
 
 USING_NAMESPACE
@@ -37,6 +38,7 @@ enum
    ATTRIB_SAVE,
    ATTRIB_TEXTURE,
    ATTRIB_THREADS,
+   ATTRIB_TILE_SIZE,
    NUM_ATTRIBS
 };
 
@@ -53,6 +55,7 @@ StringMap _attributes(
    "save",              ATTRIB_SAVE,
    "texture",           ATTRIB_TEXTURE,
    "threads",           ATTRIB_THREADS,
+   "tileSize",          ATTRIB_TILE_SIZE,
    ""
 );
 
@@ -93,6 +96,12 @@ int renderVM( VMState* vm )
 {
    PlasmaRayTracer* prt = (PlasmaRayTracer*)VM::thisPtr(vm);
    CHECK( prt != NULL );
+   if( VM::isNumber( vm, 3 ) )
+   {
+      // Progressive rendering, returning whether or not the image is complete.
+      VM::push( vm, prt->render( WorldVM::to( vm, 1 ), CameraVM::to( vm, 2 ), VM::toNumber( vm, 3 ) ) );
+      return 1;
+   }
    prt->render( WorldVM::to( vm, 1 ), CameraVM::to( vm, 2 ) );
    return 0;
 }
@@ -212,54 +221,101 @@ Vec4f trilinearFilter( const Vector< RCP<Bitmap> >& texChain, const float lod, c
    return color;
 }
 
+// The grid spacing of the first progressive pass, in pixels.
+const int _coarsestStride = 8;
+
+UNNAMESPACE_END
+
 /*==============================================================================
-  CLASS RayTraceTask
+  CLASS PlasmaRayTracer::TileLoop
 ==============================================================================*/
-class RayTraceTask:
-   public Task
+//! Renders a range of tiles (see TaskQueue::parallelFor()).
+class PlasmaRayTracer::TileLoop
 {
 public:
 
    /*----- methods -----*/
 
-   RayTraceTask( PlasmaRayTracer* prt, const RCP<World>& w, const RCP<Camera>& c, const Vec2i& yRange ):
-      _plasmaRayTracer( prt ), _world( w ), _camera( c ), _yRange( yRange )
-   {}
-
-   virtual void execute()
+   TileLoop( const PlasmaRayTracer& prt, const Frame& frame, int stride, bool refine, double deadline ):
+      _prt( prt ), _frame( frame ), _stride( stride ), _refine( refine ), _deadline( deadline ), _skipped( 0 )
    {
-      _plasmaRayTracer->render( _world, _camera, _yRange );
+      const int ts = prt._tileSize;
+      _size     = Vec2i( prt._bmp->dimension().x, prt._bmp->dimension().y );
+      _numTiles = ( _size + (ts - 1) ) / ts;
    }
 
-protected:
+   void operator()( uint begin, uint end, WorkerTask& )
+   {
+      render( begin, end );
+   }
 
-   /*----- data members -----*/
+   void render( uint begin, uint end )
+   {
+      const int ts = _prt._tileSize;
+      for( uint i = begin; i < end; ++i )
+      {
+         if( _timer.elapsed() > _deadline )
+         {
+            _skipped = 1;
+            return;
+         }
+         Vec2i tb( int(i) % _numTiles.x * ts, int(i) / _numTiles.x * ts );
+         Vec2i te( CGM::min( tb.x + ts, _size.x ), CGM::min( tb.y + ts, _size.y ) );
+         _prt.renderRect( _frame, tb, te, _stride, _refine );
+      }
+   }
 
-   PlasmaRayTracer*    _plasmaRayTracer;
-   const RCP<World>&   _world;
-   const RCP<Camera>&  _camera;
-   const Vec2i         _yRange;
+   inline uint  numTiles() const { return uint(_numTiles.x * _numTiles.y); }
+   inline bool  complete() const { return _skipped == 0; }
 
-   /*----- methods -----*/
+protected:
 
-   /* methods... */
+   /*----- data members -----*/
 
-private:
-}; //class RayTraceTask
+   const PlasmaRayTracer&  _prt;
+   const Frame&            _frame;
+   int                     _stride;
+   bool                    _refine;
+   double                  _deadline;  //!< The time after which tiles are skipped (in seconds).
+   Timer                   _timer;
+   Vec2i                   _size;      //!< The dimensions of the image.
+   Vec2i                   _numTiles;
+   AtomicInt32             _skipped;   //!< Set when at least one tile got skipped.
+};
 
+/*==============================================================================
+  CLASS PlasmaRayTracer
+==============================================================================*/
 
-UNNAMESPACE_END
+//------------------------------------------------------------------------------
+//!
+PlasmaRayTracer::Frame::Frame( const PlasmaRayTracer& prt, const RCP<World>& world, const RCP<Camera>& cam ):
+   _world( world ),
+   _camera( cam ),
+   _lightDir( 0.6f, 0.8f, 1.0f ),
+   _baseMap( 0 ),
+   _halfSample( 0.5/prt._samplesPerPixel.x, 0.5/prt._samplesPerPixel.y ),
+   _sampleScale( (float)(1.0 / (prt._samplesPerPixel.x * prt._samplesPerPixel.y)) ),
+   _camInFront( prt._clipPlane.inFront( cam->position() ) )
+{
+   _lightDir.normalize();
+   if( prt._lodBias > 0.0f )
+   {
+      _baseMap += (uint)(prt._lodBias+0.5f);
+   }
+}
 
 //------------------------------------------------------------------------------
 //!
 PlasmaRayTracer::PlasmaRayTracer():
-   _threads(0), _samplesPerPixel(1, 1), _lodBias( 0.0f )
+   _threads(0), _queue(NULL), _tileSize(32), _samplesPerPixel(1, 1), _lodBias( 0.0f )
 {
 }
 
 //------------------------------------------------------------------------------
 //!
-PlasmaRayTracer::PlasmaRayTracer( const Vec2i& dim )
+PlasmaRayTracer::PlasmaRayTracer( const Vec2i& dim ):
+   _threads(0), _queue(NULL), _tileSize(32), _samplesPerPixel(1, 1), _lodBias( 0.0f )
 {
    allocate( dim );
 }
@@ -268,6 +324,7 @@ PlasmaRayTracer::PlasmaRayTracer( const Vec2i& dim )
 //!
 PlasmaRayTracer::~PlasmaRayTracer()
 {
+   delete _queue;
 }
 
 //------------------------------------------------------------------------------
@@ -303,38 +360,15 @@ PlasmaRayTracer::allocate( const Vec2i& dim )
 }
 
 //------------------------------------------------------------------------------
-//!
+//! Renders the whole image, one tile at a time.
 void
 PlasmaRayTracer::render( const RCP<World>& world, const RCP<Camera>& cam )
 {
    prepareRender( world );
 
    Timer timer;
-   Vector< Thread* >  threads;
-   if( _threads < 2 )
-   {
-      render( world, cam, Vec2i(0, _bmp->dimension().y-1) );
-   }
-   else
-   {
-      int h_n      = _bmp->dimension().y / _threads;
-      int leftOver = _bmp->dimension().y - ( h_n * (_threads-1) );
-      Vec2i yRange( 0, leftOver-1 );
-      for( uint t = 0; t < _threads; ++t )
-      {
-         //StdErr << "Rendering: " << yRange << " " << yRange(1) - yRange(0) + 1 << nl;
-         threads.pushBack( new Thread( new RayTraceTask( this, world, cam, yRange) ) );
-         yRange(0) = yRange(1) + 1;
-         yRange(1) += h_n;
-      }
-      CHECK( (yRange(1) + 1) == (_bmp->dimension().y + h_n) );
-   }
-
-   for( uint i = 0; i < threads.size(); ++i )
-   {
-      threads[i]->wait();
-      delete threads[i];
-   }
+   Frame frame( *this, world, cam );
+   renderTiles( frame, 1, false, CGConstd::infinity() );
 
    StdErr << "Ray-tracing (" << _threads << " threads) took " << timer.elapsed() << " seconds" << nl;
    // Update texture in OpenGL.
@@ -342,176 +376,263 @@ PlasmaRayTracer::render( const RCP<World>& world, const RCP<Camera>& cam )
 }
 
 //------------------------------------------------------------------------------
-//!
+//! Renders the rows in the inclusive range yRange, from the calling thread.
 void
 PlasmaRayTracer::render( const RCP<World>& world, const RCP<Camera>& cam, const Vec2i& yRange )
 {
-   Vec3f lightDir( 0.6f, 0.8f, 1.0f );
-   lightDir.normalize();
+   Frame frame( *this, world, cam );
+   renderRect( frame, Vec2i( 0, yRange(0) ), Vec2i( _bmp->dimension().x, yRange(1) + 1 ), 1, false );
+}
+
+//------------------------------------------------------------------------------
+//! Renders the image progressively, stopping once timeLimit seconds elapsed.
+//! A first pass renders every 8th pixel in both directions, and fills the
+//! pixels in between with its colors, then every following pass halves the
+//! spacing, only rendering the new pixels.  The first pass always completes,
+//! so an approximation of the whole image is available even if the time limit
+//! is very short.
+//! Returns true if the image got fully refined (it is then identical to the
+//! one of render( world, cam )).
+bool
+PlasmaRayTracer::render( const RCP<World>& world, const RCP<Camera>& cam, double timeLimit )
+{
+   prepareRender( world );
 
-   uint baseMap = 0;
-   if( _lodBias > 0.0f )
+   Timer timer;
+   Frame frame( *this, world, cam );
+   bool complete = renderTiles( frame, _coarsestStride, false, CGConstd::infinity() );
+   for( int stride = _coarsestStride/2; complete && stride > 0; stride /= 2 )
    {
-      baseMap += (uint)(_lodBias+0.5f);
+      complete = renderTiles( frame, stride, true, timeLimit - timer.elapsed() );
    }
 
-   Vec2d screenCoord;
-   Vec2d sampleCoord;
-   Vec2d sampleOffset;
-   Vec2d screenLimit( _bmp->dimension().x, yRange(1) + 1 );
-   Vec2d halfSample( 0.5/_samplesPerPixel.x, 0.5/_samplesPerPixel.y );
-   double sampleScale = 1.0 / (_samplesPerPixel.x * _samplesPerPixel.y);
-   Vec4f color;
-   Vec4f finalColor;
+   // Update texture in OpenGL.
+   Core::gfx()->setData( _texture->get(), 0, _bmp->pixels() );
 
-   uchar* dstPixelPtr = _bmp->pixelRow( yRange(0) );
+   return complete;
+}
 
-   Rayf ray;
-   ray.origin( cam->position() );
+//------------------------------------------------------------------------------
+//! Returns the queue distributing the tiles, or NULL to render from the
+//! calling thread.
+TaskQueue*
+PlasmaRayTracer::queue()
+{
+   if( _threads == 0 )  return Plasma::dispatchQueue();
+
+   if( _threads == 1 )  return NULL;
+
+   if( _queue == NULL || _queue->numAllocatedThreads() != _threads )
+   {
+      delete _queue;
+      _queue = new TaskQueue( _threads );
+   }
+   return _queue;
+}
 
-   bool camInFront = _clipPlane.inFront( cam->position() );
+//------------------------------------------------------------------------------
+//! Renders all of the tiles at the specified grid spacing (see renderRect()).
+//! Tiles not yet started after 'deadline' seconds are skipped.
+//! Returns true if all of the tiles got rendered.
+bool
+PlasmaRayTracer::renderTiles( const Frame& frame, int stride, bool refine, double deadline )
+{
+   TileLoop loop( *this, frame, stride, refine, deadline );
+   TaskQueue* q = queue();
+   if( q && loop.numTiles() > 1 )
+   {
+      q->parallelFor( 0, loop.numTiles(), 1, loop );
+   }
+   else
+   {
+      loop.render( 0, loop.numTiles() );
+   }
+   return loop.complete();
+}
 
-   for( screenCoord.y = yRange(0); screenCoord.y < screenLimit.y; ++screenCoord.y )
+//------------------------------------------------------------------------------
+//! Renders the pixels of the rectangle [begin, end) lying on a grid of the
+//! specified spacing (starting at begin), and fills the stride x stride block
+//! following each of them with its color.
+//! When refining, pixels on the grid of twice the spacing are skipped, since
+//! the previous pass already rendered them.
+void
+PlasmaRayTracer::renderRect(
+   const Frame& frame,
+   const Vec2i& begin,
+   const Vec2i& end,
+   int          stride,
+   bool         refine
+) const
+{
+   const int mask = 2*stride - 1;
+   uchar color[4];
+   for( int y = begin.y; y < end.y; y += stride )
    {
-      for( screenCoord.x = 0.0; screenCoord.x < screenLimit.x; ++screenCoord.x )
+      const bool evenRow = ((y - begin.y) & mask) == 0;
+      for( int x = begin.x; x < end.x; x += stride )
       {
-#if 0
-         if( (screenCoord.x < 773.0f || 774.0f < screenCoord.x) ||
-             (screenCoord.y < 492.0f || 492.0f < screenCoord.y) )
+         if( refine && evenRow && ((x - begin.x) & mask) == 0 )  continue;
+
+         if( stride == 1 )
          {
-            dstPixelPtr += 4;
+            renderPixel( frame, Vec2d( x, y ), _bmp->pixel( Vec2i( x, y ) ) );
             continue;
          }
-#endif
-
-         finalColor = Vec4f::zero();
 
-         for( sampleOffset.y = halfSample.y; sampleOffset.y < 1.0; sampleOffset.y += 2.0*halfSample.y )
+         renderPixel( frame, Vec2d( x, y ), color );
+         const int bw = CGM::min( stride, end.x - x );
+         const int bh = CGM::min( stride, end.y - y );
+         for( int by = 0; by < bh; ++by )
          {
-            for( sampleOffset.x = halfSample.x; sampleOffset.x < 1.0; sampleOffset.x += 2.0*halfSample.x )
+            uchar* dst = _bmp->pixel( Vec2i( x, y + by ) );
+            for( int bx = 0; bx < bw; ++bx, dst += 4 )
             {
-               sampleCoord = screenCoord + sampleOffset;
-               //StdErr << "Sample Coord: " << sampleCoord << " offset=" << sampleOffset << nl;
-               //getchar();
+               dst[0] = color[0];
+               dst[1] = color[1];
+               dst[2] = color[2];
+               dst[3] = color[3];
+            }
+         }
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Computes the RGBA8 color of the pixel at screenCoord, and stores it in dst.
+void
+PlasmaRayTracer::renderPixel( const Frame& frame, const Vec2d& screenCoord, uchar* dst ) const
+{
+   Vec2d sampleCoord;
+   Vec2d sampleOffset;
+   Vec4f color;
+   Vec4f finalColor = Vec4f::zero();
+
+   Rayf ray;
+   ray.origin( frame._camera->position() );
+
+   for( sampleOffset.y = frame._halfSample.y; sampleOffset.y < 1.0; sampleOffset.y += 2.0*frame._halfSample.y )
+   {
+      for( sampleOffset.x = frame._halfSample.x; sampleOffset.x < 1.0; sampleOffset.x += 2.0*frame._halfSample.x )
+      {
+         sampleCoord = screenCoord + sampleOffset;
+         //StdErr << "Sample Coord: " << sampleCoord << " offset=" << sampleOffset << nl;
+         //getchar();
 
-               ray.direction( cam->direction( sampleCoord ) );
+         ray.direction( frame._camera->direction( sampleCoord ) );
 
-               Intersector::Hit hit;
+         Intersector::Hit hit;
 
-               bool doTrace = true;
+         bool doTrace = true;
 #if 1
-               // Clipping plane.
-               if( Intersector::trace( _clipPlane, ray, hit._t ) )
-               {
-                  if( !camInFront )
-                  {
-                     hit._tMin = CGM::max( 0.0f, hit._t);
-                     hit._t = CGConstf::infinity();
-                  }
-                  else
-                  {
-                     // hit._t already contains the max allowed value.
-                  }
-               }
-               else
-               {
-                  if( !camInFront )
-                  {
-                     doTrace = false;
-                  }
-               }
+         // Clipping plane.
+         if( Intersector::trace( _clipPlane, ray, hit._t ) )
+         {
+            if( !frame._camInFront )
+            {
+               hit._tMin = CGM::max( 0.0f, hit._t);
+               hit._t = CGConstf::infinity();
+            }
+            else
+            {
+               // hit._t already contains the max allowed value.
+            }
+         }
+         else
+         {
+            if( !frame._camInFront )
+            {
+               doTrace = false;
+            }
+         }
 #endif
 
-               if( doTrace && Intersector::traceBlocks( world, ray, hit ) )
+         if( doTrace && Intersector::traceBlocks( frame._world, ray, hit ) )
+         {
+            //StdErr << "Hitting material #" << hit._materialID << " at " << hit._uv << nl;
+            const RCP<Material>& mat = hit._entity->material( hit._materialID );
+            if( mat.isValid() )
+            {
+               MaterialMap::ConstIterator it = _materialMap.find( mat.ptr() );
+               if( it != _materialMap.end() )
                {
-                  //StdErr << "Hitting material #" << hit._materialID << " at " << hit._uv << nl;
-                  const RCP<Material>& mat = hit._entity->material( hit._materialID );
-                  if( mat.isValid() )
-                  {
-                     MaterialMap::ConstIterator it = _materialMap.find( mat.ptr() );
-                     if( it != _materialMap.end() )
-                     {
-                        const MaterialData& matData = _materialMap[mat.ptr()];
-                        Vec2f texCoord = Vec2f(hit._uv.y, hit._uv.x) * 0.125; // The 1/8 factor and flip is the same as demo.glsl
+                  const MaterialData& matData = (*it).second;
+                  Vec2f texCoord = Vec2f(hit._uv.y, hit._uv.x) * 0.125; // The 1/8 factor and flip is the same as demo.glsl
 #if 0
-                        //StdErr << nl;
-                        //StdErr << "tc=" << texCoord;
-                        // Throw a new ray on the top-right of the screen pixel.
-                        //ray.direction( cam->direction(screenCoord + Vec2d(1.0, 1.0)) );
-                        ray.direction( cam->direction(screenCoord + Vec2d(0.35355, 0.35355)) ); // Radial distance of 0.5.
-                        hit._entity->blocks()->retrace( ray, hit );
-                        Vec2f texCoord2 = Vec2f(hit._uv.y, hit._uv.x) * 0.125; // The 1/8 factor and flip is the same as demo.glsl
-                        //StdErr << " ";
-                        //StdErr << " tc2=" << texCoord2;
-                        //StdErr << " d=" << (texCoord2 - texCoord).length();
-                        //StdErr << nl;
-                        float lod = (float)matData._levels.size(); // Corresponds to log2( maxDim )
-                        lod += 0.5f * CGM::log2( (texCoord2 - texCoord).sqrLength() ); // log2( len ) = log2( (len^2)^1/2 ) = 0.5 * log2( len^2 )
-                        lod += lodBias;
-                        //StdErr << "lod=" << lod << nl;
-                        //StdErr << "baseMap=" << matData._levels[0]->dimension() << nl;
-                        color = trilinearFilter( matData._levels, lod, texCoord );
-                        //StdErr << "color = " << color << nl;
-                        //const uint numLevels = (uint)matData._levels.size();
-                        //for( uint i = 0; i < numLevels; ++i )
-                        //{
-                        //   StdErr << "Material " << hit._materialID << " level " << i << " " << matData._levels[i]->dimension() << nl;
-                        //   matData._levels[i]->saveFile( String().format("mat%d_mip%d", hit._materialID, i ) );
-                        //}
+                  //StdErr << nl;
+                  //StdErr << "tc=" << texCoord;
+                  // Throw a new ray on the top-right of the screen pixel.
+                  //ray.direction( frame._camera->direction(screenCoord + Vec2d(1.0, 1.0)) );
+                  ray.direction( frame._camera->direction(screenCoord + Vec2d(0.35355, 0.35355)) ); // Radial distance of 0.5.
+                  hit._entity->blocks()->retrace( ray, hit );
+                  Vec2f texCoord2 = Vec2f(hit._uv.y, hit._uv.x) * 0.125; // The 1/8 factor and flip is the same as demo.glsl
+                  //StdErr << " ";
+                  //StdErr << " tc2=" << texCoord2;
+                  //StdErr << " d=" << (texCoord2 - texCoord).length();
+                  //StdErr << nl;
+                  float lod = (float)matData._levels.size(); // Corresponds to log2( maxDim )
+                  lod += 0.5f * CGM::log2( (texCoord2 - texCoord).sqrLength() ); // log2( len ) = log2( (len^2)^1/2 ) = 0.5 * log2( len^2 )
+                  lod += lodBias;
+                  //StdErr << "lod=" << lod << nl;
+                  //StdErr << "frame._baseMap=" << matData._levels[0]->dimension() << nl;
+                  color = trilinearFilter( matData._levels, lod, texCoord );
+                  //StdErr << "color = " << color << nl;
+                  //const uint numLevels = (uint)matData._levels.size();
+                  //for( uint i = 0; i < numLevels; ++i )
+                  //{
+                  //   StdErr << "Material " << hit._materialID << " level " << i << " " << matData._levels[i]->dimension() << nl;
+                  //   matData._levels[i]->saveFile( String().format("mat%d_mip%d", hit._materialID, i ) );
+                  //}
 #else
-                        uint mip = CGM::min( baseMap, (uint)matData._levels.size()-1 );
-                        color = bilinearFilter( *(matData._levels[mip]), texCoord );
-                        //color = bilinearFilter( *(matData._levels.back()), texCoord );
+                  uint mip = CGM::min( frame._baseMap, (uint)matData._levels.size()-1 );
+                  color = bilinearFilter( *(matData._levels[mip]), texCoord );
+                  //color = bilinearFilter( *(matData._levels.back()), texCoord );
 #endif
 
-                        float v = lightDir.dot( hit._normal );
-                        v = v * 1.5f;
-
-                        Intersector::Hit hitl;
-                        Rayf rayl( hit._pos + hit._normal*0.1f, lightDir );
+                  float v = frame._lightDir.dot( hit._normal );
+                  v = v * 1.5f;
 
-                        if( Intersector::traceBlocks( world, rayl, hitl ) )
-                        {
-                           v = 0.5f;
-                        }
+                  Intersector::Hit hitl;
+                  Rayf rayl( hit._pos + hit._normal*0.1f, frame._lightDir );
 
-                        v = CGM::clamp( v, 0.5f, 2.0f );
-
-                        color *= matData._color * v;
-                        color.w = 1.0f;
-                     }
-                     else
-                     {
-                        StdErr << "Unregistered material id=" << hit._materialID << nl;
-                        color = Vec4f( hit._uv, 0.0f, 1.0f );
-                     }
-                  }
-                  else
+                  if( Intersector::traceBlocks( frame._world, rayl, hitl ) )
                   {
-                     color = Vec4f( hit._uv, 0.0f, 1.0f );
+                     v = 0.5f;
                   }
+
+                  v = CGM::clamp( v, 0.5f, 2.0f );
+
+                  color *= matData._color * v;
+                  color.w = 1.0f;
                }
                else
                {
-                  color = world->backgroundColor();
+                  StdErr << "Unregistered material id=" << hit._materialID << nl;
+                  color = Vec4f( hit._uv, 0.0f, 1.0f );
                }
+            }
+            else
+            {
+               color = Vec4f( hit._uv, 0.0f, 1.0f );
+            }
+         }
+         else
+         {
+            color = frame._world->backgroundColor();
+         }
 
-               finalColor += color;
-            } // sampleOffset.x
-         } // sampleOffset.y
+         finalColor += color;
+      } // sampleOffset.x
+   } // sampleOffset.y
 
-         finalColor *= (float)sampleScale;
-         finalColor.clamp( 0.0f, 1.0f );
 
-         // Force red.
-         //finalColor = Vec4f( 1.0f, 0.0f, 0.0f, 1.0f );
+   finalColor *= frame._sampleScale;
+   finalColor.clamp( 0.0f, 1.0f );
 
-         *dstPixelPtr++ = (uchar)(finalColor.x * 255.0f);
-         *dstPixelPtr++ = (uchar)(finalColor.y * 255.0f);
-         *dstPixelPtr++ = (uchar)(finalColor.z * 255.0f);
-         *dstPixelPtr++ = (uchar)(finalColor.w * 255.0f);
-      }
-   }
+   dst[0] = (uchar)(finalColor.x * 255.0f);
+   dst[1] = (uchar)(finalColor.y * 255.0f);
+   dst[2] = (uchar)(finalColor.z * 255.0f);
+   dst[3] = (uchar)(finalColor.w * 255.0f);
 }
 
 //------------------------------------------------------------------------------
@@ -655,6 +776,9 @@ PlasmaRayTracer::performGet( VMState* vm )
       case ATTRIB_THREADS:
          VM::push( vm, _threads );
          return true;
+      case ATTRIB_TILE_SIZE:
+         VM::push( vm, tileSize() );
+         return true;
       default:
          break;
    }
@@ -693,6 +817,9 @@ PlasmaRayTracer::performSet( VMState* vm )
       case ATTRIB_THREADS:
          _threads = VM::toUInt( vm, -1 );
          return true;
+      case ATTRIB_TILE_SIZE:
+         tileSize( VM::toInt( vm, -1 ) );
+         return true;
       default:
          break;
    }
@@ -22,11 +22,17 @@
 
 NAMESPACE_BEGIN
 
+class TaskQueue;
+
 /*==============================================================================
   CLASS PlasmaRayTracer
 ==============================================================================*/
 //! This class renders blocks using ray-tracing.
 //! It is meant as a backup solution instead of a new block system.
+//! The image is split into small square tiles, which the worker threads grab
+//! dynamically (see TaskQueue::parallelFor()), so expensive parts of the image
+//! do not stall the others.  Every pixel is computed independently, so the
+//! tiled result is identical to rendering whole rows.
 class PlasmaRayTracer:
    public RCObject
 {
@@ -46,6 +52,7 @@ public:
 
    PLASMA_DLL_API void  render( const RCP<World>& world, const RCP<Camera>& cam );
    PLASMA_DLL_API void  render( const RCP<World>& world, const RCP<Camera>& cam, const Vec2i& yRange );
+   PLASMA_DLL_API bool  render( const RCP<World>& world, const RCP<Camera>& cam, double timeLimit );
 
    PLASMA_DLL_API void  prepareRender( const RCP<World>& );
 
@@ -65,6 +72,12 @@ public:
    inline void lodBias( float v ) { _lodBias = v; }
    inline float lodBias() const { return _lodBias; }
 
+   inline void tileSize( int v ) { _tileSize = CGM::max( v, 1 ); }
+   inline int tileSize() const { return _tileSize; }
+
+   inline void threads( uint v ) { _threads = v; }
+   inline uint threads() const { return _threads; }
+
    // VM
    PLASMA_DLL_API void init( VMState* );
    PLASMA_DLL_API virtual bool performGet( VMState* );
@@ -94,12 +107,30 @@ protected:
    };
    typedef Map< const Material*, MaterialData >   MaterialMap;
 
+   //! The values shared by all of the pixels of a frame.
+   struct Frame
+   {
+      Frame( const PlasmaRayTracer& prt, const RCP<World>& world, const RCP<Camera>& cam );
+
+      const RCP<World>&   _world;
+      const RCP<Camera>&  _camera;
+      Vec3f               _lightDir;
+      uint                _baseMap;
+      Vec2d               _halfSample;
+      float               _sampleScale;
+      bool                _camInFront;
+   };
+
+   class TileLoop;
+
    /*----- data members -----*/
 
    RCP<Bitmap>      _bmp;       //!< Our framebuffer (allows to save as PNG).
    RCP<GfxTexture>  _texture;   //!< A texture (allows to view the result).
    bool             _updateTex; //!< A flag indicating whether or not we want to keep the texture in sync.
-   uint             _threads;   //!< The number of threads to launch.
+   uint             _threads;   //!< The number of threads to use (0 means the shared Plasma queue).
+   TaskQueue*       _queue;     //!< A private queue, when a specific number of threads is requested.
+   int              _tileSize;  //!< The width and height of the tiles, in pixels.
    Planef           _clipPlane; //!< A clipping plane.
    Vec2i            _samplesPerPixel; //!< The number of samples per pixel.
    float            _lodBias;   //!< An lod bias.
@@ -110,6 +141,12 @@ protected:
 
    void  allocate( const Vec2i& dim );
 
+   TaskQueue*  queue();
+
+   bool  renderTiles( const Frame& frame, int stride, bool refine, double deadline );
+   void  renderRect( const Frame& frame, const Vec2i& begin, const Vec2i& end, int stride, bool refine ) const;
+   void  renderPixel( const Frame& frame, const Vec2d& screenCoord, uchar* dst ) const;
+
 private:
 }; //class PlasmaRayTracer
 
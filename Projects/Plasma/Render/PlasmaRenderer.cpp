@@ -40,6 +40,21 @@ RCP<Gfx::ColorState>   _noColor;
 Gfx::TextureState      _clampBilinear;
 Gfx::TextureState      _clampNearest;
 
+ConstString            _boneMatricesName( "boneMatrices" );
+
+//------------------------------------------------------------------------------
+//! Copies the bone matrices into the frame's constant ring, and returns a
+//! recycled constant list pointing to them.
+const RCP<Gfx::ConstantList>&
+boneList( const SkeletalEntity* skel )
+{
+   const Skeleton::MatrixContainer& trfs = skel->transforms();
+   Gfx::ConstantRing& ring = Core::gfx()->constantRing();
+   uint n = uint(trfs.size());
+   Gfx::ConstantRing::Slice slice = ring.store( trfs.data()->ptr(), n*16 );
+   return ring.arrayList( _boneMatricesName, Gfx::CONST_MAT4, n, slice );
+}
+
 
 UNNAMESPACE_END
 
@@ -875,11 +890,8 @@ PlasmaRenderer::renderWorldShadow( Gfx::Pass* pass )
       if( e->type() == Entity::SKELETAL )
       {
          // Retreive information for bone matrices.
-         SkeletalEntity* skel           = (SkeletalEntity*)e;
-         RCP<Gfx::ConstantBuffer> bones = skel->boneConstants();
-         RCP<Gfx::ConstantList> cl      = Gfx::ConstantList::create( bones );
-
-         pass->setConstants( cl );
+         SkeletalEntity* skel = (SkeletalEntity*)e;
+         pass->setConstants( boneList( skel ) );
          if( config != 1 )
          {
             config = 1;
@@ -928,11 +940,8 @@ PlasmaRenderer::renderWorldDepth( Gfx::Pass* pass )
       if( e->type() == Entity::SKELETAL )
       {
          // Retreive information for bone matrices.
-         SkeletalEntity* skel           = (SkeletalEntity*)e;
-         RCP<Gfx::ConstantBuffer> bones = skel->boneConstants();
-         RCP<Gfx::ConstantList> cl      = Gfx::ConstantList::create( bones );
-
-         pass->setConstants( cl );
+         SkeletalEntity* skel = (SkeletalEntity*)e;
+         pass->setConstants( boneList( skel ) );
          if( config != 1 )
          {
             config = 1;
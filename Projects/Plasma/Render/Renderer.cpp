@@ -27,7 +27,8 @@ NAMESPACE_BEGIN
 //!
 Renderer::Renderer() :
    _clearDepth( false ),
-   _size(0), _numPasses(0), _numRenderNodes(0), _numSamplerLists(0)
+   _size(0), _numPasses(0), _numRenderNodes(0), _numSamplerLists(0),
+   _numSubmitted(0), _numCulled(0), _viewSubmitted(0), _viewCulled(0)
 {
    // Default material set.
    _defMatSet = new MaterialSet();
@@ -70,6 +71,10 @@ Renderer::beginFrame()
    _numRenderNodes   = 0;
    _numSamplerLists  = 0;
    _numConstantLists = 0;
+   _numSubmitted     = 0;
+   _numCulled        = 0;
+   _viewSubmitted    = 0;
+   _viewCulled       = 0;
    performBeginFrame();
 }
 
@@ -103,18 +108,104 @@ Renderer::performEndFrame()
 }
 
 //------------------------------------------------------------------------------
-//!
+//! Classifies all of the entities of the world.
+//! When it follows a classification in a frustum (for the same view), it
+//! replaces it, in the statistics as well.
 void Renderer::classifyEntities( World* world )
+{
+   _numSubmitted -= _viewSubmitted;
+   _numCulled    -= _viewCulled;
+   _viewSubmitted = 0;
+   _viewCulled    = 0;
+
+   uint numEntities = world->numEntities();
+   _found.clear();
+   _found.reserve( numEntities );
+   for( uint i = 0; i < numEntities; ++i )
+   {
+      _found.pushBack( world->entity(i) );
+   }
+   _numSubmitted += numEntities;
+   classifyFound();
+}
+
+//------------------------------------------------------------------------------
+//! Classifies only the entities which can be seen in the frustum.
+void Renderer::classifyEntities( World* world, const Frustumf& frustum )
+{
+   _found.clear();
+   world->findEntities( frustum, _found );
+   _viewSubmitted = uint(_found.size());
+   _viewCulled    = world->numEntities() - _viewSubmitted;
+   _numSubmitted += _viewSubmitted;
+   _numCulled    += _viewCulled;
+   classifyFound();
+}
+
+//------------------------------------------------------------------------------
+//! Collects the patches of the shadow casters seen from a light.
+void Renderer::classifyCasters( World* world, const Frustumf& frustum )
+{
+   _casters.clear();
+   _found.clear();
+   world->findEntities( frustum, _found );
+   _numSubmitted += uint(_found.size());
+   _numCulled    += world->numEntities() - uint(_found.size());
+
+   for( auto cur = _found.begin(); cur != _found.end(); ++cur )
+   {
+      Entity* e           = *cur;
+      Geometry* geom      = e->geometry();
+      MaterialSet* matSet = e->materialSet();
+      const Mat4f* t      = &e->transform();
+
+      if( e->type() == Entity::PROXY )
+      {
+         ProxyEntity* pe = (ProxyEntity*)e;
+         e = pe->entity();
+         if( !e || !pe->visible() ) continue;
+         if( !geom ) geom = e->geometry();
+         if( !matSet ) matSet = e->materialSet();
+      }
+      else
+      if( e->type() == Entity::PARTICLE ) continue;
+
+      if( !geom || !e->visible() || e->ghost() || !e->castsShadows() ) continue;
+      if( !matSet ) matSet = _defMatSet.ptr();
+
+      int hasSkin = e->type() == Entity::SKELETAL ? HAS_SKIN : 0;
+
+      for( uint p = 0; p < geom->numPatches(); ++p )
+      {
+         Material* mat = geom->material( matSet, p );
+         switch( mat->type() )
+         {
+            case Material::BASE:
+               _casters.pushBack( Chunk( STANDARD | hasSkin, e, t, geom, mat, p ) );
+               break;
+            case Material::CUSTOM:
+               _casters.pushBack( Chunk( CUSTOM | hasSkin, e, t, geom, mat, p ) );
+               break;
+            default:
+               // Reflectors do not cast shadows.
+               break;
+         }
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//!
+void Renderer::classifyFound()
 {
    _reflections.clear();
    _visibles.clear();
    _ghosts.clear();
    _particles.clear();
 
-   uint numEntities = world->numEntities();
-   for( uint i = 0; i < numEntities; ++i )
+   for( auto cur = _found.begin(); cur != _found.end(); ++cur )
    {
-      Entity* e      = world->entity(i);
+      Entity* e      = *cur;
       Geometry* geom = e->geometry();
 
       if( e->type() != Entity::PROXY )
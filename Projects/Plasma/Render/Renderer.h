@@ -10,6 +10,7 @@
 
 #include <Gfx/Pass/RenderNode.h>
 
+#include <CGMath/Frustum.h>
 #include <CGMath/Vec2.h>
 
 #include <Base/Util/RCObject.h>
@@ -46,6 +47,9 @@ public:
 
    PLASMA_DLL_API virtual void render( const RCP<Gfx::RenderNode>&, World*, Viewport* );
 
+   // Statistics for the current frame (all of the passes).
+   inline uint submittedEntities() const { return _numSubmitted; }
+   inline uint culledEntities() const    { return _numCulled; }
 
    // Use only when the rendering is done in a current (not is own) buffer.
    bool clearDepth() const   { return _clearDepth; }
@@ -91,6 +95,9 @@ protected:
    virtual void performEndFrame();
 
    void classifyEntities( World* );
+   void classifyEntities( World*, const Frustumf& );
+   void classifyCasters( World*, const Frustumf& );
+   void classifyFound();
 
    Gfx::Pass* getPass();
    Gfx::RenderNode* getRenderNode();
@@ -109,11 +116,18 @@ protected:
    Vector< RCP<Gfx::SamplerList> >  _samplerLists;
    uint                             _numConstantLists;
    Vector< RCP<Gfx::ConstantList> > _constantLists;
+   uint                             _numSubmitted;
+   uint                             _numCulled;
+   uint                             _viewSubmitted; //!< The counts of the last classification in a frustum.
+   uint                             _viewCulled;
+
+   Vector< Entity* >                _found;
 
    Vector< Chunk >                  _reflections;
    Vector< Chunk >                  _ghosts;
    Vector< Chunk >                  _visibles;
    Vector< Chunk >                  _particles;
+   Vector< Chunk >                  _casters;
 
    RCP<MaterialSet>                _defMatSet;
 };
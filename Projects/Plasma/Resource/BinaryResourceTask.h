@@ -14,6 +14,7 @@
 #include <Base/IO/BinaryStream.h>
 #include <Base/IO/FileDevice.h>
 #include <Base/IO/GZippedFileDevice.h>
+#include <Base/IO/MMapDevice.h>
 #include <Base/Msg/Delegate.h>
 #include <Base/MT/Task.h>
 #include <Base/Util/RCP.h>
@@ -79,7 +80,13 @@ BinaryResourceTask<T>::BinaryResourceTask(
 template< typename T > void
 BinaryResourceTask<T>::execute()
 {
-   BinaryStream is = BinaryStream( new GZippedFileDevice( _path.cstr(), IODevice::MODE_READ ) );
+   // Block files are mapped (and never compressed).
+   RCP<IODevice> dev;
+   if( _path.getExt() == "blk" )
+      dev = new MMapDevice( FS::Entry( _path ), IODevice::MODE_READ );
+   else
+      dev = new GZippedFileDevice( _path.cstr(), IODevice::MODE_READ );
+   BinaryStream is( dev.ptr() );
    _loadDel( is, _resource.ptr() );
 }
 
@@ -578,6 +578,7 @@ void  initialize()
    addSupport( "mesh"  , GeomHandler(Lua::save) );
    addSupport( "bin"   , GeomHandler(Bin::save) );
    addSupport( "bin.gz", GeomHandler(Bin::saveCompressed) );
+   addSupport( "blk"   , GeomHandler(Bin::saveBlock) );
    addSupport( "obj"   , GeomHandler(Obj::save) );
 
    addSupport( "anim"  , AnimHandler(Lua::save) );
@@ -732,6 +733,7 @@ bool save( DFGraph& graph, const Path& path, const Table* params )
 {
    DFNode* out = graph.output();
    if( !out ) return false;
+   graph.evaluate( out );
 
    // What type of graph are we saving?
    switch( out->output()->type() )
@@ -2353,6 +2355,29 @@ bool Bin::saveCompressed( const Geometry& geom, const Path& path )
    return save( geom, fd.ptr() );
 }
 
+//------------------------------------------------------------------------------
+//! Saves in the block format, meant to be memory-mapped when loading.
+bool Bin::saveBlock( const Geometry& geom, const Path& path )
+{
+   RCP<MeshGeometry> mesh = nullptr;
+   switch( geom.type() )
+   {
+      case Geometry::MESH:
+         mesh = geom.mesh();
+         break;
+      case Geometry::METAGEOMETRY:
+         mesh = new MeshGeometry();
+         geom.metaGeometry()->createMesh( *mesh );
+         break;
+      default:
+         return false;
+   }
+   if( mesh.isNull() ) return false;
+
+   BinaryStream os( new FileDevice( path.cstr(), IODevice::MODE_WRITE|IODevice::MODE_NEWFILE ) );
+   return os.ok() && Serializer::dumpMeshBlock( *mesh, os );
+}
+
 //------------------------------------------------------------------------------
 //!
 bool Bin::save( const Geometry& geom, IODevice* dev )
@@ -94,6 +94,7 @@ namespace ResExporter
    {
       PLASMA_DLL_API bool  save( const Geometry& geom, const Path& path );
       PLASMA_DLL_API bool  saveCompressed( const Geometry& geom, const Path& path );
+      PLASMA_DLL_API bool  saveBlock( const Geometry& geom, const Path& path );
       PLASMA_DLL_API bool  save( const Geometry& geom, IODevice* dev );
    }
 
@@ -13,6 +13,7 @@
 #include <Plasma/Procedural/ProceduralMesh.h>
 #include <Plasma/Procedural/ProceduralWorld.h>
 #include <Plasma/DataFlow/ProceduralDataFlow.h>
+#include <Plasma/Geometry/MeshGeometry.h>
 #include <Plasma/Resource/BinaryResourceTask.h>
 #include <Plasma/Resource/ResExporter.h>
 #include <Plasma/Resource/Serializer.h>
@@ -46,6 +47,15 @@ UNNAMESPACE_BEGIN
 
 DBG_STREAM( os_rm, "ResManager" );
 
+//-----------------------------------------------------------------------------
+//! Size of a cached geometry, used for the cache's memory budget.
+size_t  geometryBytes( const Geometry& geom )
+{
+   const MeshGeometry* mesh = geom.mesh();
+   if( !mesh )  return 0;
+   return mesh->indicesSize()*sizeof(uint32_t) + mesh->verticesSize()*sizeof(float);
+}
+
 //-----------------------------------------------------------------------------
 //!
 String  getDir( const String& str )
@@ -90,11 +100,23 @@ saveGeometryVM( VMState* vm )
    return 1;
 }
 
+//------------------------------------------------------------------------------
+//! Converts a binary mesh (.mesh.bin or .mesh.bin.gz) into a .mesh.blk.
+int
+convertMeshVM( VMState* vm )
+{
+   Path src( VM::toCString( vm, 1 ) );
+   Path dst( VM::toCString( vm, 2 ) );
+   VM::push( vm, Serializer::convertToMeshBlock( src, dst ) );
+   return 1;
+}
+
 //------------------------------------------------------------------------------
 //!
 const VM::Reg res_funcs[] = {
    { "saveWorld" ,    saveWorldVM     },
    { "saveGeometry" , saveGeometryVM  },
+   { "convertMesh" ,  convertMeshVM   },
    { 0, 0 }
 };
 
@@ -121,7 +143,7 @@ ResManager::initializePlasma()
    _rc_anim      = new ResCache< SkeletalAnimation   >( "Animation"      );
    _rc_animGraph = new ResCache< AnimationGraph      >( "AnimationGraph" );
    _rc_brainProg = new ResCache< BrainProgram        >( "BrainProgram"   );
-   _rc_geom      = new ResCache< Geometry, DigestKey >( "Geometry"       );
+   _rc_geom      = new ResCache< Geometry, DigestKey >( "Geometry"      , 0.5, geometryBytes );
    _rc_graph     = new ResCache< DFGraph             >( "DataFlowGraph"  );
    _rc_skeleton  = new ResCache< Skeleton            >( "Skeleton"       );
    VMRegistry::add( initVM, VM_CAT_APP );
@@ -291,6 +313,27 @@ ResManager::getGeometry( const String& id, const Table& params, Task* caller, bo
    RCP< Resource<Geometry> > res( _rc_geom->get( key ) );
 
    // Create geometry if not.
+   // Try block MeshGeometry (memory-mapped).
+   if( res.isNull() )
+   {
+      const char* ext[] = { ".mesh.blk", 0 };
+      String path       = idToPath( id, ext );
+
+      if( !path.empty() )
+      {
+         res = _rc_geom->add( key );
+         BinaryGeometryTask* task = new BinaryGeometryTask(
+            res.ptr(),
+            &Serializer::loadMeshBlock,
+            path,
+            params
+         );
+         if( caller )
+            caller->spawn( task );
+         else
+            dispatchQueue()->post( task );
+      }
+   }
    // Try Binary MeshGeometry.
    if( res.isNull() )
    {
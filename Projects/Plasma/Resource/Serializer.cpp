@@ -16,6 +16,10 @@
 #include <Motion/Collision/CollisionGroup.h>
 #endif
 
+#include <Base/IO/GZippedFileDevice.h>
+#include <Base/IO/FileDevice.h>
+#include <Base/Util/CPU.h>
+
 /*==============================================================================
   UNNAMED NAMESPACE
 ==============================================================================*/
@@ -36,6 +40,138 @@ UNNAMESPACE_BEGIN
 //   CODE_WORLD_VIEWPORT,
 //};
 
+//------------------------------------------------------------------------------
+//! Mesh block format.
+//! All of the values use the byte order of the writer (given in the tag), and
+//! the index and vertex blocks start on 16B boundaries, so that they can be
+//! copied as is.
+//!   "PMB" endian(1=little,2=big)
+//!   uint8   version, primType, numAttr, reserved
+//!   uint32  numIndices, numVertices, indexOffset, vertexOffset, extraOffset
+//!   uint32  checksum (of the fields above, and of the attribute codes)
+//!   uint8   attribute codes[numAttr]
+//!   uint32  indices[numIndices]                     (at indexOffset)
+//!   float   vertices[numVertices*stride]            (at vertexOffset)
+//!   patches and collision shape, as in the stream format (at extraOffset)
+const uint8_t  _blockVersion    = 1;
+const uint32_t _blockHeaderSize = 32;
+const uint32_t _blockAlignment  = 16;
+
+//------------------------------------------------------------------------------
+//!
+inline uint8_t  nativeEndian()
+{
+   return (CPU_ENDIANNESS == CPU_ENDIAN_BIG) ? 2 : 1;
+}
+
+//------------------------------------------------------------------------------
+//!
+inline uint32_t  alignBlock( uint32_t offset )
+{
+   return (offset + _blockAlignment - 1) & ~(_blockAlignment - 1);
+}
+
+//------------------------------------------------------------------------------
+//! FNV-1a, fed with the values rather than their bytes so that it doesn't
+//! depend on the byte order.
+inline uint32_t  fnv1a( uint32_t h, uint32_t v )
+{
+   for( uint i = 0; i < 4; ++i, v >>= 8 )
+   {
+      h = (h ^ (v & 0xFF)) * 16777619u;
+   }
+   return h;
+}
+
+//------------------------------------------------------------------------------
+//!
+struct MeshBlockHeader
+{
+   uint8_t   _endian;
+   uint8_t   _version;
+   uint8_t   _primType;
+   uint8_t   _numAttr;
+   uint32_t  _numIndices;
+   uint32_t  _numVertices;
+   uint32_t  _indexOffset;
+   uint32_t  _vertexOffset;
+   uint32_t  _extraOffset;
+   uint8_t   _attr[256];
+
+   uint32_t  checksum() const
+   {
+      uint32_t h = 2166136261u;
+      h = fnv1a( h, (_version << 16) | (_primType << 8) | _numAttr );
+      h = fnv1a( h, _numIndices );
+      h = fnv1a( h, _numVertices );
+      h = fnv1a( h, _indexOffset );
+      h = fnv1a( h, _vertexOffset );
+      h = fnv1a( h, _extraOffset );
+      for( uint i = 0; i < _numAttr; ++i )  h = fnv1a( h, _attr[i] );
+      return h;
+   }
+};
+
+//------------------------------------------------------------------------------
+//! Writes zeros up to the specified offset.
+void  padTo( BinaryStream& os, uint32_t& pos, uint32_t offset )
+{
+   const char zeros[_blockAlignment] = { 0 };
+   os.write( zeros, offset - pos );
+   pos = offset;
+}
+
+//------------------------------------------------------------------------------
+//! Skips bytes up to the specified offset (streams can't always seek).
+bool  skipTo( BinaryStream& is, size_t& pos, size_t offset )
+{
+   char tmp[64];
+   while( pos < offset )
+   {
+      size_t n = CGM::min( offset - pos, sizeof(tmp) );
+      if( is.read( tmp, n ) != n )  return false;
+      pos += n;
+   }
+   return pos == offset;
+}
+
+//------------------------------------------------------------------------------
+//! Dumps the indices as T, narrowing them in chunks so that they can be
+//! written in bulk.
+template< typename T > void  dumpNarrowIndices( const uint32_t* src, uint32_t n, BinaryStream& os )
+{
+   T tmp[1024];
+   while( n != 0 )
+   {
+      uint32_t m = CGM::min( n, uint32_t(1024) );
+      for( uint32_t i = 0; i < m; ++i )
+      {
+         tmp[i] = (T)src[i];
+      }
+      os.write( tmp, m );
+      src += m;
+      n   -= m;
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Loads indices stored as T, reading them in bulk chunks before widening them.
+template< typename T > void  loadNarrowIndices( uint32_t* dst, uint32_t n, BinaryStream& is )
+{
+   T tmp[1024];
+   while( n != 0 )
+   {
+      uint32_t m = CGM::min( n, uint32_t(1024) );
+      is.read( tmp, m );
+      for( uint32_t i = 0; i < m; ++i )
+      {
+         dst[i] = tmp[i];
+      }
+      dst += m;
+      n   -= m;
+   }
+}
+
 
 UNNAMESPACE_END
 
@@ -162,27 +298,18 @@ bool  dumpMeshGeometry( const MeshGeometry& geom, BinaryStream& os )
    if( nIndices < (1<<8) )
    {
       // Dumping using uint8_t for every index.
-      for( uint i = 0; i < nIndices; ++i )
-      {
-         os << (uint8_t)indices[i];
-      }
+      dumpNarrowIndices<uint8_t>( indices, nIndices, os );
    }
    else
    if( nIndices < (1<<16) )
    {
       // Dumping using uint16_t for every index.
-      for( uint i = 0; i < nIndices; ++i )
-      {
-         os << (uint16_t)indices[i];
-      }
+      dumpNarrowIndices<uint16_t>( indices, nIndices, os );
    }
    else
    {
       // Dumping using uint32_t for every index.
-      for( uint i = 0; i < nIndices; ++i )
-      {
-         os << (uint32_t)indices[i];
-      }
+      os.write( indices, nIndices );
    }
 
    // 3. Dump vertex buffer (only one for now).
@@ -198,12 +325,7 @@ bool  dumpMeshGeometry( const MeshGeometry& geom, BinaryStream& os )
    // 3.2.2. Number of vertices (different from vSize).
    os << (uint32_t)geom.numVertices();
    // 3.2.3. Vertex floats.
-   const size_t vSize = geom.verticesSize();
-   const float* vData = geom.vertices();
-   for( uint i = 0; i < vSize; ++i )
-   {
-      os << (float)vData[i];
-   }
+   os.write( geom.vertices(), geom.verticesSize() );
 
    // 4. Dump the patches.
    ok &= dumpPatches( geom, os );
@@ -214,6 +336,54 @@ bool  dumpMeshGeometry( const MeshGeometry& geom, BinaryStream& os )
    return ok && os.ok();
 }
 
+//------------------------------------------------------------------------------
+//! Dumps a mesh in the block format (see MeshBlockHeader).
+bool  dumpMeshBlock( const MeshGeometry& geom, BinaryStream& os )
+{
+   if( geom.numAttributes() > 255 )  return false;
+
+   MeshBlockHeader h;
+   h._endian       = nativeEndian();
+   h._version      = _blockVersion;
+   h._primType     = (uint8_t)geom.primitiveType();
+   h._numAttr      = (uint8_t)geom.numAttributes();
+   h._numIndices   = geom.numIndices();
+   h._numVertices  = geom.numVertices();
+   h._indexOffset  = alignBlock( _blockHeaderSize + h._numAttr );
+   h._vertexOffset = alignBlock( h._indexOffset  + h._numIndices*sizeof(uint32_t) );
+   h._extraOffset  = alignBlock( h._vertexOffset + uint32_t(geom.verticesSize()*sizeof(float)) );
+   for( uint i = 0; i < h._numAttr; ++i )
+   {
+      h._attr[i] = (uint8_t)geom.attributeType( i );
+   }
+
+   // 1. Header (native order, since the values aren't swapped).
+   BinaryStream::Endian endian = os.endian();
+   os.endian( BinaryStream::ENDIAN_NATIVE );
+   os << 'P' << 'M' << 'B' << h._endian;
+   os << h._version << h._primType << h._numAttr << (uint8_t)0;
+   os << h._numIndices << h._numVertices << h._indexOffset << h._vertexOffset << h._extraOffset;
+   os << h.checksum();
+   os.write( h._attr, h._numAttr );
+   uint32_t pos = _blockHeaderSize + h._numAttr;
+
+   // 2. Index and vertex blocks.
+   padTo( os, pos, h._indexOffset );
+   os.write( geom.indices(), h._numIndices );
+   pos += h._numIndices*sizeof(uint32_t);
+   padTo( os, pos, h._vertexOffset );
+   os.write( geom.vertices(), geom.verticesSize() );
+   pos += uint32_t(geom.verticesSize()*sizeof(float));
+   padTo( os, pos, h._extraOffset );
+
+   // 3. Patches and collision shape.
+   bool ok = dumpPatches( geom, os );
+   ok &= dumpCollisionShape( geom, os );
+
+   os.endian( endian );
+   return ok && os.ok();
+}
+
 //------------------------------------------------------------------------------
 //! Dumps the patches of a geometry into a binary stream.
 bool  dumpPatches( const Geometry& geom, BinaryStream& os )
@@ -363,33 +533,20 @@ bool  loadMeshGeometry( BinaryStream& is, Resource<Geometry>* res )
    is >> nIndices;
    // 2.2. Load the indices (careful with the number of bits for each).
    geom->allocateIndices( nIndices );
-   uint32_t* indices = const_cast<uint32_t*>( geom->indices() );
+   uint32_t* indices = geom->indices();
    if( nIndices < (1<<8) )
    {
-      uint8_t idx;
-      for( uint i = 0; i < nIndices; ++i )
-      {
-         is >> idx;
-         indices[i] = idx;
-      }
+      loadNarrowIndices<uint8_t>( indices, nIndices, is );
    }
    else
    if( nIndices < (1<<16) )
    {
-      uint16_t idx;
-      for( uint i = 0; i < nIndices; ++i )
-      {
-         is >> idx;
-         indices[i] = idx;
-      }
+      loadNarrowIndices<uint16_t>( indices, nIndices, is );
    }
    else
    {
       // Storing in place (since it's 32b).
-      for( uint i = 0; i < nIndices; ++i )
-      {
-         is >> indices[i];
-      }
+      is.read( indices, nIndices );
    }
 
    // 3. Load vertex buffer (only one for now).
@@ -398,28 +555,22 @@ bool  loadMeshGeometry( BinaryStream& is, Resource<Geometry>* res )
    uint8_t nAttributes;
    is >> nAttributes;
    // 3.1.2. The attribute codes.
-   int* attrList = new int[nAttributes+1];
-   uint8_t attrType;
+   uint8_t attrTypes[256];
+   is.read( attrTypes, nAttributes );
+   int attrList[257];
    for( uint i = 0; i < nAttributes; ++i )
    {
-      is >> attrType;
-      attrList[i] = attrType;
+      attrList[i] = attrTypes[i];
    }
    attrList[nAttributes] = 0;
    geom->setAttributes( attrList );
-   delete [] attrList;
    // 3.2. Vertex data.
    // 3.2.2. Number of vertices.
    uint32_t nVerts;
    is >> nVerts;
    // 3.2.3. Vertex floats.
    geom->allocateVertices( nVerts );
-   float* vData = const_cast<float*>( geom->vertices() );
-   size_t vSize = geom->verticesSize();
-   for( uint i = 0; i < vSize; ++i )
-   {
-      is >> vData[i];
-   }
+   is.read( geom->vertices(), geom->verticesSize() );
 
    // 4. Load the patches.
    bool ok = loadPatches( is, *geom );
@@ -435,6 +586,80 @@ bool  loadMeshGeometry( BinaryStream& is, Resource<Geometry>* res )
    return ok && is.ok();
 }
 
+//------------------------------------------------------------------------------
+//! Loads a mesh in the block format.
+//! The index and vertex blocks are read with a single call each, which is a
+//! plain copy out of the mapping when reading from an MMapDevice.
+bool  loadMeshBlock( BinaryStream& is, Resource<Geometry>* res )
+{
+   // 1. Header.
+   char tag[4];
+   if( is.read( tag, 4 ) != 4 || tag[0] != 'P' || tag[1] != 'M' || tag[2] != 'B' )
+   {
+      StdErr << "ERROR - Serializer::loadMeshBlock() - Not a mesh block." << nl;
+      return false;
+   }
+   MeshBlockHeader h;
+   h._endian = (uint8_t)tag[3];
+   if( h._endian != 1 && h._endian != 2 )  return false;
+
+   BinaryStream::Endian endian = is.endian();
+   is.endian( h._endian == 1 ? BinaryStream::ENDIAN_LITTLE : BinaryStream::ENDIAN_BIG );
+
+   uint8_t  reserved;
+   uint32_t sum;
+   is >> h._version >> h._primType >> h._numAttr >> reserved;
+   is >> h._numIndices >> h._numVertices >> h._indexOffset >> h._vertexOffset >> h._extraOffset;
+   is >> sum;
+   is.read( h._attr, h._numAttr );
+   size_t pos = _blockHeaderSize + h._numAttr;
+   if( !is.ok() || h._version != _blockVersion || sum != h.checksum() ||
+       h._indexOffset < pos || h._vertexOffset < h._indexOffset + size_t(h._numIndices)*sizeof(uint32_t) )
+   {
+      StdErr << "ERROR - Serializer::loadMeshBlock() - Corrupted or unsupported header." << nl;
+      is.endian( endian );
+      return false;
+   }
+
+   RCP<MeshGeometry> geom( new MeshGeometry() );
+   geom->primitiveType( h._primType );
+   int attrList[257];
+   for( uint i = 0; i < h._numAttr; ++i )
+   {
+      attrList[i] = h._attr[i];
+   }
+   attrList[h._numAttr] = 0;
+   geom->setAttributes( attrList );
+   geom->allocateIndices( h._numIndices );
+   geom->allocateVertices( h._numVertices );
+   size_t iBytes = size_t(h._numIndices)*sizeof(uint32_t);
+   size_t vBytes = geom->verticesSize()*sizeof(float);
+   bool ok = h._extraOffset >= h._vertexOffset + vBytes;
+
+   // 2. Index and vertex blocks.
+   ok = ok && skipTo( is, pos, h._indexOffset );
+   ok = ok && is.read( geom->indices(), h._numIndices ) == h._numIndices;
+   pos += iBytes;
+   ok = ok && skipTo( is, pos, h._vertexOffset );
+   ok = ok && is.read( geom->vertices(), geom->verticesSize() ) == geom->verticesSize();
+   pos += vBytes;
+   ok = ok && skipTo( is, pos, h._extraOffset );
+
+   // 3. Patches and collision shape.
+   ok = ok && loadPatches( is, *geom );
+   geom->updateProperties();
+   ok = ok && loadCollisionShape( is, *geom );
+
+   is.endian( endian );
+   if( !ok )
+   {
+      StdErr << "ERROR - Serializer::loadMeshBlock() - Truncated data." << nl;
+      return false;
+   }
+   res->data( geom.ptr() );
+   return true;
+}
+
 //------------------------------------------------------------------------------
 //! Loads the patches from a binary stream into a MeshGeometry.
 bool  loadPatches( BinaryStream& is, MeshGeometry& geom )
@@ -574,6 +799,22 @@ RCP<CollisionShape>  loadCollisionShape( BinaryStream& is )
    return NULL;
 }
 
+//------------------------------------------------------------------------------
+//! Converts a mesh from the stream format (.mesh.bin or .mesh.bin.gz) into the
+//! block format.
+bool  convertToMeshBlock( const Path& src, const Path& dst )
+{
+   RCP< Resource<Geometry> > res = new Resource<Geometry>();
+   BinaryStream is( new GZippedFileDevice( src.cstr(), IODevice::MODE_READ ) );
+   if( !is.ok() || !loadMeshGeometry( is, res.ptr() ) )
+   {
+      StdErr << "ERROR - Serializer::convertToMeshBlock() - Could not read '" << src.string() << "'." << nl;
+      return false;
+   }
+   BinaryStream os( new FileDevice( dst, IODevice::MODE_WRITE|IODevice::MODE_NEWFILE ) );
+   return os.ok() && dumpMeshBlock( *res->data()->mesh(), os );
+}
+
 } //namespace Serializer
 
 NAMESPACE_END
@@ -10,6 +10,7 @@
 #include <Fusion/Resource/Resource.h>
 
 #include <Base/IO/BinaryStream.h>
+#include <Base/IO/Path.h>
 
 NAMESPACE_BEGIN
 
@@ -22,12 +23,16 @@ namespace Serializer
 
 PLASMA_DLL_API bool  dumpGeometry( const Geometry& geom, BinaryStream& os );
 PLASMA_DLL_API bool  dumpMeshGeometry( const MeshGeometry& geom, BinaryStream& os );
+PLASMA_DLL_API bool  dumpMeshBlock( const MeshGeometry& geom, BinaryStream& os );
 PLASMA_DLL_API bool  dumpPatches( const Geometry& geom, BinaryStream& os );
 PLASMA_DLL_API bool  dumpCollisionShape( const Geometry& geom, BinaryStream& os );
 PLASMA_DLL_API bool  dumpCollisionShape( const CollisionShape& geom, BinaryStream& os );
 
 PLASMA_DLL_API bool  loadGeometry( BinaryStream& is, Resource<Geometry>* res );
 PLASMA_DLL_API bool  loadMeshGeometry( BinaryStream& is, Resource<Geometry>* res );
+PLASMA_DLL_API bool  loadMeshBlock( BinaryStream& is, Resource<Geometry>* res );
+
+PLASMA_DLL_API bool  convertToMeshBlock( const Path& src, const Path& dst );
 
 PLASMA_DLL_API bool  loadPatches( BinaryStream& is, MeshGeometry& geom );
 PLASMA_DLL_API bool  loadCollisionShape( BinaryStream& is, Geometry& geom );
@@ -266,6 +266,7 @@ void DFScreen::graphUpdated( DFGraph* )
 
    // Evaluate the output node of the graph.
    DFNode* out = _graph->output();
+   _graph->evaluate( out );
 
    switch( out->type() )
    {
@@ -12,6 +12,7 @@
 
 #include <Fusion/VM/VMRegistry.h>
 
+#include <Base/ADT/Map.h>
 #include <Base/ADT/StringMap.h>
 #include <Base/Dbg/DebugStream.h>
 #include <Base/MT/TaskQueue.h>
@@ -25,6 +26,9 @@ UNNAMESPACE_BEGIN
 
 DBG_STREAM( os_brain, "Brain" );
 
+// The VM of every worker thread (in both the Plasma and ResManager queues).
+StorageSlot<VMState*>  _vmSlot;
+
 //------------------------------------------------------------------------------
 //!
 int postVM( VMState* vm )
@@ -137,6 +141,35 @@ int setAttributeVM( VMState* vm )
    return 0;
 }
 
+//------------------------------------------------------------------------------
+//!
+inline const BrainProgram* programOf( Entity* e )
+{
+   Brain* brain = e ? e->brain() : NULL;
+   return brain ? brain->program() : NULL;
+}
+
+//------------------------------------------------------------------------------
+//! Selects the entity of the batch being run (see _brainDriver).
+int selectVM( VMState* vm )
+{
+   BrainTaskContext* context = (BrainTaskContext*)VM::userData( vm );
+   context->select( VM::toUInt( vm, 1 ) - 1 );
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+//! Runs a brain program for every entity of a batch, so that the host makes a
+//! single call per group of entities sharing the program. The program still
+//! receives its entity and stimuli as chunk arguments.
+const char* _brainDriver =
+   "return function( f, select, entities, stimuli, first, n )\n"
+   "   for i = first, n do\n"
+   "      select( i )\n"
+   "      f( entities[i], stimuli[i] )\n"
+   "   end\n"
+   "end\n";
+
 //------------------------------------------------------------------------------
 //!
 const VM::Reg brainFuncs[] = {
@@ -201,7 +234,7 @@ void
 BrainProgramLoadTask::execute()
 {
    RCP<BrainProgram> prog = new BrainProgram();
-   VMState* vm = (VMState*)storage("brain.vm");
+   VMState* vm = storage( _vmSlot );
    VM::getByteCode( vm, _path.cstr(), prog->_byteCode );
    _progRes->data( prog.ptr() );
 }
@@ -231,7 +264,9 @@ Brain::initVMs()
       {
          VMState* vm = VM::open( VM_CAT_BRAIN | VM_CAT_MATH, true );
          VM::userData( vm, new BrainTaskContext() );
-         queue->setStorage( i, "brain.vm", vm );
+         // The driver stays at the bottom of the stack.
+         VM::doString( vm, _brainDriver );
+         queue->storage( i, _vmSlot ) = vm;
       }
    }
 
@@ -241,7 +276,7 @@ Brain::initVMs()
       for( uint i = 0; i < queue->numAllocatedThreads(); ++i )
       {
          VMState* vm = VM::open( VM_CAT_BRAIN | VM_CAT_MATH, true );
-         queue->setStorage( i, "brain.vm", vm );
+         queue->storage( i, _vmSlot ) = vm;
       }
    }
 }
@@ -256,7 +291,7 @@ Brain::termVMs()
       TaskQueue* queue = ResManager::dispatchQueue();
       for( uint i = 0; i < queue->numAllocatedThreads(); ++i )
       {
-         VMState*& vm = (VMState*&)queue->getStorage( i, "brain.vm" );
+         VMState*& vm = queue->storage( i, _vmSlot );
          VM::close( vm );
          vm = NULL;
       }
@@ -266,7 +301,7 @@ Brain::termVMs()
       TaskQueue* queue = Plasma::dispatchQueue();
       for( uint i = 0; i < queue->numAllocatedThreads(); ++i )
       {
-         VMState*& vm = (VMState*&)queue->getStorage( i, "brain.vm" );
+         VMState*& vm = queue->storage( i, _vmSlot );
          BrainTaskContext* context = (BrainTaskContext*)VM::userData( vm );
          delete context;
          VM::close( vm );
@@ -285,7 +320,7 @@ Brain::handlePostedCommands( World* world )
    uint n = queue->numAllocatedThreads();
    for( uint i = 0; i < n; ++i )
    {
-      VMState*& vm = (VMState*&)queue->getStorage( i, "brain.vm" );
+      VMState*& vm = queue->storage( i, _vmSlot );
       BrainTaskContext* context = (BrainTaskContext*)VM::userData( vm );
       world->handleCommands( context->commands() );
       context->commands().clear();
@@ -302,7 +337,7 @@ Brain::markEntitiesForAction( World* world )
    uint n = queue->numAllocatedThreads();
    for( uint i = 0; i < n; ++i )
    {
-      VMState*& vm              = (VMState*&)queue->getStorage( i, "brain.vm" );
+      VMState*& vm              = queue->storage( i, _vmSlot );
       BrainTaskContext* context = (BrainTaskContext*)VM::userData( vm );
       // Drain entities with actions before pĥysics.
       auto& before              = context->entitiesWithActionsBefore();
@@ -352,72 +387,178 @@ Brain::postBegin()
 
 
 /*==============================================================================
-  CLASS BrainTask
+  CLASS BrainLoop
 ==============================================================================*/
 
 //------------------------------------------------------------------------------
-//!
-BrainTask::BrainTask( Entity* e ):
-   _entity( e )
+//! Groups the entities sharing the same BrainProgram, the groups following the
+//! order in which their programs first appear and the entities keeping their
+//! relative order within a group, so that the execution order is reproducible.
+void
+BrainLoop::sort( Vector<Entity*>& entities )
 {
+   Map<const BrainProgram*, uint> ranks;
+   Vector<uint> rankOf( entities.size() );
+   Vector<uint> offsets;
+   for( uint i = 0; i < entities.size(); ++i )
+   {
+      const BrainProgram* prog = programOf( entities[i] );
+      auto it = ranks.find( prog );
+      if( it == ranks.end() )
+      {
+         rankOf[i]   = uint(offsets.size());
+         ranks[prog] = rankOf[i];
+         offsets.pushBack( 0 );
+      }
+      else
+      {
+         rankOf[i] = it->second;
+      }
+      ++offsets[rankOf[i]];
+   }
+   if( offsets.size() < 2 )  return;
+
+   // Counting sort.
+   uint first = 0;
+   for( uint r = 0; r < offsets.size(); ++r )
+   {
+      uint count = offsets[r];
+      offsets[r] = first;
+      first     += count;
+   }
+   Vector<Entity*> sorted( entities.size() );
+   for( uint i = 0; i < entities.size(); ++i )
+   {
+      sorted[offsets[rankOf[i]]++] = entities[i];
+   }
+   entities.swap( sorted );
 }
 
 //------------------------------------------------------------------------------
 //!
 void
-BrainTask::execute()
+BrainLoop::operator()( uint begin, uint end, WorkerTask& worker )
+{
+   VMState* vm = worker.storage( _vmSlot );
+   for( uint i = begin; i < end; )
+   {
+      // Run the consecutive entities sharing a program together.
+      const BrainProgram* prog = program( _entities[i] );
+      uint n = 1;
+      if( prog )
+      {
+         while( i+n < end && programOf( _entities[i+n] ) == prog )  ++n;
+         execute( prog, _entities + i, n, vm );
+      }
+      i += n;
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Returns the program of the entity's brain, or NULL (after reporting why) if
+//! it cannot be run.
+const BrainProgram*
+BrainLoop::program( Entity* e )
 {
-   if( _entity.isNull() )
+   if( e == NULL )
    {
-      StdErr << "ERROR - BrainTask::execute() called on a NULL entity." << nl;
-      return;
+      StdErr << "ERROR - BrainLoop::execute() called on a NULL entity." << nl;
+      return NULL;
    }
 
-   Brain* brain = _entity->brain();
+   Brain* brain = e->brain();
    if( brain == NULL )
    {
-      StdErr << "ERROR - BrainTask::execute() called on an entity (" << (void*)_entity.ptr() << ") without a brain." << nl;
-      return;
+      StdErr << "ERROR - BrainLoop::execute() called on an entity (" << (void*)e << ") without a brain." << nl;
+      return NULL;
    }
 
    const BrainProgram* prog = brain->program();
    if( !prog )
    {
-      StdErr << "ERROR - BrainTask::execute() no brain program." << nl;
-      return;
+      StdErr << "ERROR - BrainLoop::execute() no brain program." << nl;
+      return NULL;
    }
 
+   return prog;
+}
+
+//------------------------------------------------------------------------------
+//! Runs the brains of n entities sharing the same program: the byte code runs
+//! for all of them through a single call of the driver, then the delegate (if
+//! any) is called for each of them.
+void
+BrainLoop::execute( const BrainProgram* prog, Entity* const* entities, uint n, VMState* vm )
+{
    if( !prog->byteCode().empty() )
    {
       // Run program in a VM.
-      VMState* vm = (VMState*)storage( "brain.vm" );
-
-      // Set the entity in the context.
       BrainTaskContext* context = (BrainTaskContext*)VM::userData( vm );
-      context->entity( _entity.ptr() );
 
-      // Send parameters.
+      // Only load the byte code when the program changes, and keep the loaded
+      // chunk right above the driver for the next entities.
+      if( context->_program != prog )
+      {
+         VM::setTop( vm, 1 );
+         context->_program = NULL;
+         if( VM::loadByteCode( vm, prog->byteCode(), "Brain" ) != 0 )
+         {
+            StdErr << "ERROR - BrainLoop::execute() failed to load byte code: " << VM::toCString( vm, -1 ) << nl;
+            VM::setTop( vm, 1 );
+            return;
+         }
+         context->_program = prog;
+      }
+
+      // Send parameters, for every entity.
       // 1. The brain's entity.
-      VM::pushProxy( vm, _entity.ptr() );
       // 2. The brain's stimuli.
+      VM::newTable( vm ); // 3: entities.
+      VM::newTable( vm ); // 4: stimuli.
       StimulusQueue::Container stimuli;
-      brain->_stimuli.drain( stimuli );
-      VM::newTable( vm );
-      uint idx = 1;
-      for( auto cur = stimuli.begin(); cur != stimuli.end(); ++cur, ++idx )
+      for( uint i = 0; i < n; ++i )
       {
-         const RCP<Stimulus>& stimulus = (*cur);
-         stimulus->push( vm );
-         VM::seti( vm, -2, idx );
+         Entity* e = entities[i];
+         VM::pushProxy( vm, e );
+         VM::seti( vm, 3, i+1 );
+
+         e->brain()->_stimuli.drain( stimuli );
+         VM::newTable( vm );
+         uint idx = 1;
+         for( auto cur = stimuli.begin(); cur != stimuli.end(); ++cur, ++idx )
+         {
+            const RCP<Stimulus>& stimulus = (*cur);
+            stimulus->push( vm );
+            VM::seti( vm, -2, idx );
+         }
+         VM::seti( vm, 4, i+1 );
       }
 
-      // Execute brain bytecode.
-      VM::doByteCode( vm, prog->byteCode(), 2, 0, "Brain" );
+      // Execute brain bytecode; when a brain fails, resume after it.
+      context->_batch = entities;
+      for( uint first = 0; first < n; first = context->_cur + 1 )
+      {
+         context->_cur = first;
+         VM::pushValue( vm, 1 ); // Driver.
+         VM::pushValue( vm, 2 ); // Program.
+         VM::push( vm, selectVM );
+         VM::pushValue( vm, 3 );
+         VM::pushValue( vm, 4 );
+         VM::push( vm, first+1 );
+         VM::push( vm, n );
+         VM::ecall( vm, 6, 0 );
+         VM::setTop( vm, 4 ); // Discard a potential error message.
+      }
+      context->_batch = NULL;
+      VM::setTop( vm, 2 );
    }
 
    if( !prog->func().empty() )
    {
       // Call delegate (C++ program).
-      prog->func()( _entity.ptr() );
+      for( uint i = 0; i < n; ++i )
+      {
+         prog->func()( entities[i] );
+      }
    }
 }
@@ -29,6 +29,7 @@ NAMESPACE_BEGIN
 class Entity;
 //class Stimulus;
 class World;
+class WorkerTask;
 
 typedef Delegate1< Entity* >  BrainCallback;
 
@@ -168,7 +169,7 @@ public:
 
 protected:
 
-   friend class BrainTask;
+   friend class BrainLoop;
    friend class Entity;
    friend class World;
 
@@ -184,27 +185,40 @@ private:
 
 
 /*==============================================================================
-  CLASS BrainTask
+  CLASS BrainLoop
 ==============================================================================*/
-class BrainTask:
-   public Task
+//! Runs the brains of a range of entities (see TaskQueue::parallelFor()).
+//! The entities should be grouped by BrainProgram (see sort()): every worker
+//! VM only loads the byte code again when the program changes, and runs the
+//! consecutive entities sharing a program through a single call.
+class BrainLoop
 {
 public:
 
+   /*----- static methods -----*/
+
+   static void  sort( Vector<Entity*>& entities );
+
    /*----- methods -----*/
 
-   BrainTask( Entity* e );
+   inline BrainLoop( Entity* const* entities ): _entities( entities ) {}
 
-   virtual void execute();
+   void  operator()( uint begin, uint end, WorkerTask& worker );
 
 protected:
 
+   /*----- methods -----*/
+
+   static const BrainProgram*  program( Entity* e );
+
+   void  execute( const BrainProgram* prog, Entity* const* entities, uint n, VMState* vm );
+
    /*----- data members -----*/
 
-   RCP<Entity>  _entity;  //!< A pointer to the entity having the brain.
+   Entity* const*  _entities;  //!< The entities having a brain.
 
 private:
-}; //class BrainTask
+}; //class BrainLoop
 
 
 /*==============================================================================
@@ -224,6 +238,9 @@ public:
    inline       Entity*  entity()       { return _entity; }
    inline const Entity*  entity() const { return _entity; }
 
+   //! Makes the i-th entity of the batch being run the current one.
+   inline void  select( uint i ) { _cur = i; _entity = _batch[i]; }
+
    inline       CommandContainer&  commands()       { return _commands; }
    inline const CommandContainer&  commands() const { return _commands; }
 
@@ -238,16 +255,19 @@ public:
 
 protected:
 
-   friend class BrainTask;
+   friend class BrainLoop;
 
    inline void  entity( Entity* e ) { _entity = e; }
 
    /*----- data members -----*/
 
-   Entity*           _entity;
-   CommandContainer  _commands;
-   EntityContainer   _entitiesWithActionsBefore;
-   EntityContainer   _entitiesWithActionsAfter;
+   Entity*                 _entity;
+   CommandContainer        _commands;
+   EntityContainer         _entitiesWithActionsBefore;
+   EntityContainer         _entitiesWithActionsAfter;
+   RCP<const BrainProgram> _program;  //!< The program whose byte code is loaded right above the driver.
+   Entity* const*          _batch;    //!< The entities run by the current driver call.
+   uint                    _cur;      //!< The index of _entity in _batch.
 
 private:
 }; //class BrainTask
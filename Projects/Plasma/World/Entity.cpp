@@ -46,7 +46,8 @@ Entity::Entity( Type type )
      _type( type ),
      _state( VISIBILE | CASTS_SHADOWS ),
      _referential( Reff::identity() ),
-     _transform( Mat4f::identity() )
+     _transform( Mat4f::identity() ),
+     _boundsID( BVH::INVALID )
 {
 }
 
@@ -61,7 +62,7 @@ void Entity::referential( const Reff& ref )
 {
    _referential = ref;
    _transform   = _referential.localToGlobal();
-   _positionSubject.notify();
+   moved();
 }
 
 //------------------------------------------------------------------------------
@@ -70,7 +71,7 @@ void Entity::position( const Vec3f& pos )
 {
    _referential.position( pos );
    _transform = _referential.localToGlobal();
-   _positionSubject.notify();
+   moved();
 }
 
 //------------------------------------------------------------------------------
@@ -79,7 +80,7 @@ void Entity::orientation( const Quatf& orient )
 {
    _referential.orientation( orient );
    _transform = _referential.localToGlobal();
-   _positionSubject.notify();
+   moved();
 }
 
 //------------------------------------------------------------------------------
@@ -88,7 +89,7 @@ void Entity::scale( float s )
 {
    _referential.scale( s );
    _transform = _referential.localToGlobal();
-   _positionSubject.notify();
+   moved();
 }
 
 //------------------------------------------------------------------------------
@@ -97,7 +98,7 @@ void Entity::lookAt( const Vec3f& at, const Vec3f& up )
 {
    _referential = Reff::lookAt( position(), at, up );
    _transform   = _referential.localToGlobal();
-   _positionSubject.notify();
+   moved();
 }
 
 //------------------------------------------------------------------------------
@@ -106,7 +107,25 @@ void Entity::rotate( const Vec3f& pos, const Vec3f axis, float angle )
 {
    _referential.rotate( pos, axis, angle );
    _transform = _referential.localToGlobal();
+   moved();
+}
+
+//------------------------------------------------------------------------------
+//! The world refits the bounds of the moved entities lazily, on the next query.
+//! Entities get moved from the actions, which run concurrently, so the flag and
+//! the list are only updated under the world's lock.
+void Entity::moved()
+{
    _positionSubject.notify();
+   if( _world )
+   {
+      LockGuard g( _world->_movedLock );
+      if( !getState( BOUNDS_DIRTY ) )
+      {
+         setState( BOUNDS_DIRTY );
+         _world->_movedEntities.pushBack( this );
+      }
+   }
 }
 
 //------------------------------------------------------------------------------
@@ -138,6 +157,7 @@ void Entity::id( const ConstString& str )
 void Entity::geometry( Geometry* geom )
 {
    _geometry = geom;
+   moved();
 }
 
 //------------------------------------------------------------------------------
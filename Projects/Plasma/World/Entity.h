@@ -59,6 +59,10 @@ public:
    inline World* world() const;
    inline Subject& positionSubject();
 
+   // Notifies the observers and the world that the entity (or its bounds) moved.
+   // Must also be called after changing the entity's geometry in place.
+   PLASMA_DLL_API void moved();
+
    // Position, orientation and scaling.
    PLASMA_DLL_API virtual void referential( const Reff& ref );
    PLASMA_DLL_API virtual void position( const Vec3f& pos );
@@ -132,6 +136,7 @@ protected:
       GHOST                  = 0x04,
       RUNNING_ACTIONS_BEFORE = 0x08,
       RUNNING_ACTIONS_AFTER  = 0x10,
+      BOUNDS_DIRTY           = 0x20,
    };
 
    inline uint32_t state() const                     { return _state; }
@@ -162,6 +167,7 @@ protected:
    Reff             _referential;
    Mat4f            _transform;
    Subject          _positionSubject;
+   uint             _boundsID;   //!< The leaf in the world's BVH.
 };
 
 //------------------------------------------------------------------------------
@@ -322,7 +328,7 @@ Entity::update( const Reff& ref, const Mat4f& mat )
    _referential.orientation( ref.orientation() );
    _transform = Mat4f::scaling( _referential.scale() ) * mat;
 #endif
-   _positionSubject.notify();
+   moved();
 }
 
 NAMESPACE_END
@@ -80,7 +80,12 @@ ParticleEntity::init( uint32_t capacity )
 {
    if( _generator.isValid() && _animator.isValid() )
    {
-      _data.allocate( getRequirements(_generator.ptr(), _animator.ptr()), capacity );
+      bool soa = _generator->handlesSOA() && _animator->handlesSOA();
+      _data.allocate(
+         getRequirements(_generator.ptr(), _animator.ptr()),
+         capacity,
+         soa ? ParticleData::SOA : ParticleData::INTERLEAVED
+      );
       geometry( new ParticleGeometry(this) );
       if( brain() == nullptr )  brain( new Brain() );
       brain()->actions().pushBack( new ParticleAction() );
@@ -104,6 +104,7 @@ RigidEntity::geometry( Geometry* geom )
          _body->shape(0);
       }
    }
+   moved();
 }
 
 //------------------------------------------------------------------------------
@@ -98,6 +98,7 @@ SkeletalEntity::geometry( Geometry* geom )
    {
       _skeleton.skeleton( geom->skeleton() );
    }
+   moved();
 }
 
 //------------------------------------------------------------------------------
@@ -35,6 +35,7 @@
 #include <Base/MT/TaskQueue.h>
 #include <Base/MT/Thread.h>
 #include <Base/Util/Bits.h>
+#include <Base/Util/Timer.h>
 
 /*==============================================================================
   UNNAME NAMESPACE
@@ -48,6 +49,27 @@ const char* _world_str = "world";
 
 Vector<World*> _worlds;
 
+//------------------------------------------------------------------------------
+//! Computes the world bounds of the entity, if they can be derived from its
+//! geometry. Skeletal, particle and proxy entities are deformed or moved
+//! without notifying the world, and are never culled.
+bool entityBounds( const Entity* e, AABBoxf& box )
+{
+   if( e->type() != Entity::RIGID ) return false;
+
+   const Geometry* geom = e->geometry();
+   if( !geom || geom->boundingBox().isEmpty() ) return false;
+
+   const AABBoxf& local = geom->boundingBox();
+   const Mat4f& mat     = e->transform();
+   box = AABBoxf::empty();
+   for( int i = 0; i < 8; ++i )
+   {
+      box |= mat * local.corner(i);
+   }
+   return true;
+}
+
 //------------------------------------------------------------------------------
 //!
 bool runAnimators(
@@ -203,6 +225,9 @@ World::World()
      _gravity( 0, -9.80665f, 0 ),
      _bgColor( 0.5f, 0.5f, 0.5f, 1.0f ),
      _simulationSpeed( 1 ),
+     _brainReport( 0.0 ),
+     _brainRuns( 0 ),
+     _brainTime( 0.0 ),
      _state( 0x0 )
 {
    _attributes       = new Table();
@@ -308,6 +333,14 @@ void World::addEntity( Entity* entity )
       if( entity->brain()->hasActions() )  markForActionBefore( entity );  // After should still work.
    }
 
+   // Bounds registering (computed on the next query).
+   _unboundedEntities.pushBack( entity );
+   {
+      LockGuard g( _movedLock );
+      entity->setState( Entity::BOUNDS_DIRTY );
+      _movedEntities.pushBack( entity );
+   }
+
    entity->connect( this );
 }
 
@@ -342,6 +375,25 @@ void World::removeEntity( Entity* entity )
          }
       }
 
+      // Unregister bounds.
+      if( entity->_boundsID != BVH::INVALID )
+      {
+         _entityBVH.remove( entity->_boundsID );
+         entity->_boundsID = BVH::INVALID;
+      }
+      else
+      {
+         _unboundedEntities.removeSwap( entity );
+      }
+      {
+         LockGuard g( _movedLock );
+         if( entity->getState( Entity::BOUNDS_DIRTY ) )
+         {
+            _movedEntities.removeSwap( entity );
+            entity->unsetState( Entity::BOUNDS_DIRTY );
+         }
+      }
+
       // Removing entity.
       entity->disconnect();
       _entities.removeSwap( entity );
@@ -383,9 +435,15 @@ void World::removeAllEntities()
             unregisterReceptor( e, (*cur).ptr() );
          }
       }
+      // Unregister bounds.
+      e->_boundsID = BVH::INVALID;
+      e->unsetState( Entity::BOUNDS_DIRTY );
       // Disconnecting signal.
       e->disconnect();
    }
+   _entityBVH.clear();
+   _unboundedEntities.clear();
+   _movedEntities.clear();
    _entities.clear();
    _entityIDs.clear();
    _lights.clear();
@@ -415,6 +473,60 @@ AABBoxf World::boundingBox() const
    return box;
 }
 
+//------------------------------------------------------------------------------
+//! Refits the bounds of the entities which moved since the last update.
+//! Nothing is written when none did, so that concurrent queries are safe
+//! as long as the entities don't move.
+void World::updateEntityBounds()
+{
+   if( _movedEntities.empty() ) return;
+
+   for( auto cur = _movedEntities.begin(); cur != _movedEntities.end(); ++cur )
+   {
+      Entity* e = *cur;
+      e->unsetState( Entity::BOUNDS_DIRTY );
+
+      AABBoxf box;
+      bool bounded = entityBounds( e, box );
+      if( e->_boundsID != BVH::INVALID )
+      {
+         if( bounded )
+         {
+            _entityBVH.update( e->_boundsID, box );
+         }
+         else
+         {
+            _entityBVH.remove( e->_boundsID );
+            e->_boundsID = BVH::INVALID;
+            _unboundedEntities.pushBack( e );
+         }
+      }
+      else if( bounded )
+      {
+         _unboundedEntities.removeSwap( e );
+         e->_boundsID = _entityBVH.add( box, e );
+      }
+   }
+   _movedEntities.clear();
+}
+
+//------------------------------------------------------------------------------
+//! Appends the entities potentially visible in the frustum: those whose bounds
+//! overlap it, followed by all of the entities without bounds.
+void World::findEntities( const Frustumf& frustum, Vector<Entity*>& entities )
+{
+   updateEntityBounds();
+
+   _foundEntities.clear();
+   _entityBVH.find( frustum, _foundEntities );
+   entities.reserve( entities.size() + _foundEntities.size() + _unboundedEntities.size() );
+   for( auto cur = _foundEntities.begin(); cur != _foundEntities.end(); ++cur )
+   {
+      entities.pushBack( (Entity*)*cur );
+   }
+   entities.append( _unboundedEntities );
+}
+
 //------------------------------------------------------------------------------
 //!
 Entity* World::entity( const ConstString& id ) const
@@ -780,24 +892,41 @@ World::unregisterReceptor( Entity* e, Receptor* r )
 void
 World::runBrains( double /*step*/ )
 {
-   EntitySet::Container entities;
-   _entitiesToAnalyze.drain( entities );
+   EntitySet::Container& entities = _entitiesAnalyzed;
+   _entitiesToAnalyze.swap( entities );
    PROFILE_EVENT_C( EventProfiler::WORLD_BEGIN_BRAINS, entities.size() );
    if( !entities.empty() )
    {
-      TaskQueue* queue = Plasma::dispatchQueue();
-      // TODO: bundle brains by type to reduce the code of bytecode loading time
-      // compared to its execution time.
+      // Bundle brains by program, so that the byte code only gets loaded
+      // when it changes on a worker.
+      _brainEntities.clear();
       for( auto cur = entities.begin(); cur != entities.end(); ++cur )
       {
-         Entity* e       = (*cur).ptr();
-         BrainTask* task = new BrainTask( e );
-         queue->post( task );
+         _brainEntities.pushBack( (*cur).ptr() );
+      }
+      BrainLoop::sort( _brainEntities );
+
+      Timer timer;
+      BrainLoop loop( _brainEntities.data() );
+      Plasma::dispatchQueue()->parallelFor( 0, uint(_brainEntities.size()), 4, loop );
+      if( _brainReport > 0.0 )
+      {
+         _brainRuns += uint(_brainEntities.size());
+         _brainTime += timer.elapsed();
+         if( _brainTime >= _brainReport )
+         {
+            StdErr << "Brains: " << _brainRuns/_brainTime << " runs/s (" << _brainRuns << " runs in " << _brainTime << " s)." << nl;
+            _brainRuns = 0;
+            _brainTime = 0.0;
+         }
       }
-      queue->waitForAll();
 
       Brain::handlePostedCommands( this );
       Brain::markEntitiesForAction( this );
+
+      // Release the entities, but keep the memory for the next frame.
+      _brainEntities.clear();
+      entities.clear();
    }
 }
 
@@ -961,6 +1090,15 @@ World::submit( const Command& cmd )
    _commands.pushBack( cmd );
 }
 
+//-----------------------------------------------------------------------------
+//!
+void
+World::setPose( Skeleton::Instance& inst, const SkeletalPose* pose )
+{
+   LockGuard g( _posesLock );
+   _poses.add( inst, pose );
+}
+
 //-----------------------------------------------------------------------------
 //!
 void
@@ -979,16 +1117,17 @@ World::runActions( double t, double d, bool afterPhysics )
 #endif
    if( !entities.empty() )
    {
-      TaskQueue* queue = Plasma::dispatchQueue();
+      // Run the actions in chunks of entities.
+      ActionLoop loop( entities.data(), t, d, afterPhysics );
+      Plasma::dispatchQueue()->parallelFor( 0, entities.size(), 16, loop );
 
-      // Post one task for each entity that need to run actions.
-      for( auto cur = entities.begin(); cur != entities.end(); ++cur )
+      // Pose the skeletons set by the actions.
+      if( _poses.numInstances() != 0 )
       {
-         Entity* e = (*cur);
-         ActionTask* task = new ActionTask( e, t, d, afterPhysics );
-         queue->post( task );
+         _poses.queue( Plasma::dispatchQueue() );
+         _poses.execute();
+         _poses.clear();
       }
-      queue->waitForAll();
 
       // Clean up entities that no longer have actions.
       for( auto cur = entities.begin(); cur != entities.end(); ++cur )
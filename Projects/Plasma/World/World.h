@@ -6,6 +6,7 @@
 #define PLASMA_WORLD_H
 
 #include <Plasma/StdDefs.h>
+#include <Plasma/Animation/PoseBatch.h>
 
 #if MOTION_BULLET
 #include <MotionBullet/Attractor/BasicAttractors.h>
@@ -23,6 +24,7 @@
 #include <Fusion/Core/Animator.h>
 #include <Fusion/Core/Core.h>
 
+#include <CGMath/BVH.h>
 #include <CGMath/Vec3.h>
 
 #include <Base/ADT/HashTable.h>
@@ -71,6 +73,7 @@ public:
 
    inline void  add( const T& t );
    inline void  drain( Container& c );
+   inline void  swap( Container& c );
    inline void  clear() { LockGuard g( _lock ); _data.clear(); }
 
 protected:
@@ -102,6 +105,17 @@ SafeSet<T>::drain( Container& c )
    c.swap( _data );
 }
 
+//-----------------------------------------------------------------------------
+//! Similar to drain(), but keeps the memory of both containers around, which
+//! avoids reallocating them every time.
+template< typename T> void
+SafeSet<T>::swap( Container& c )
+{
+   c.clear();
+   LockGuard g( _lock );
+   c.swap( _data );
+}
+
 
 /*==============================================================================
   CLASS World
@@ -204,6 +218,12 @@ public:
 
    PLASMA_DLL_API AABBoxf boundingBox() const;
 
+   // Spatial queries.
+   PLASMA_DLL_API void updateEntityBounds();
+   PLASMA_DLL_API void findEntities( const Frustumf&, Vector<Entity*>& );
+   inline const BVH&  entityBVH() const                       { return _entityBVH; }
+   inline const Vector<Entity*>&  unboundedEntities() const   { return _unboundedEntities; }
+
    // Lights.
    inline uint numLights() const               { return uint(_lights.size()); }
    inline Light* light( uint i ) const         { return _lights[i]; }
@@ -254,6 +274,11 @@ public:
    inline double simulationSpeed() const         { return _simulationSpeed; }
    inline double time() const                    { return _world->time(); }
 
+   // Brains.
+   //! Prints the rate at which brains run every 'period' seconds of brain time (0 disables it).
+   inline void brainReport( double period )      { _brainReport = period; _brainRuns = 0; _brainTime = 0.0; }
+   inline double brainReport() const             { return _brainReport; }
+
    // Background.
    inline void backgroundColor( const Vec4f& c ) { _bgColor = c; }
    inline const Vec4f& backgroundColor() const   { return _bgColor; }
@@ -309,6 +334,9 @@ public:
 
    // Thread safe methods.
    PLASMA_DLL_API void  submit( const Command& cmd );
+   //! Poses a skeleton instance like Puppeteer::setPose(), once all of the actions have run
+   //! (the pose must live until then); the instances get posed side by side (see PoseBatch).
+   PLASMA_DLL_API void  setPose( Skeleton::Instance& inst, const SkeletalPose* pose );
    //PLASMA_DLL_API void  submit( const Vector< Command >& cmds );
 
 protected:
@@ -397,15 +425,26 @@ protected:
    GroupContainer            _groups;
    SelectionContainer        _selections;
    EntitySet                 _entitiesToAnalyze;
+   EntitySet::Container      _entitiesAnalyzed;
+   EntityPtrContainer        _brainEntities;
    EntityPtrContainer        _entitiesWithActionsBefore;
    EntityPtrContainer        _entitiesWithActionsAfter;
    EntityIDContainer         _entityIDs;
+
+   // Entity bounds.
+   BVH                       _entityBVH;
+   EntityPtrContainer        _unboundedEntities;
+   EntityPtrContainer        _movedEntities;
+   Lock                      _movedLock;      //!< Guards _movedEntities, since actions move entities concurrently.
+   Vector<void*>             _foundEntities;
    SndSourceContainer        _sndSources;
    SndListenerContainer      _sndListeners;
    SndEntitySourceMap        _sndBoundSources;
    SndEntityListenerMap      _sndBoundListeners;
    CommandContainer          _commands;
    ProbeContainer            _probes;
+   PoseBatch                 _poses;
+   Lock                      _posesLock;      //!< Guards _poses, since actions pose entities concurrently.
 
    // Receptors.
    ContactReceptorContainer       _contactReceptors;
@@ -421,6 +460,11 @@ protected:
    // Time.
    double                    _simulationSpeed;
 
+   // Brain rate report.
+   double                    _brainReport;  //!< The period of the report, in seconds (0 when disabled).
+   uint                      _brainRuns;    //!< The brains run since the last report.
+   double                    _brainTime;    //!< The time spent running them.
+
    uint  _state; //!< A series of bits packed together.
    //! silent     (1)  _state[ 0: 0]    //!< Set when world should not emit any sound.
 
@@ -4,12 +4,54 @@
 =============================================================================*/
 #include <Base/Dbg/UnitTest.h>
 
+#include <Plasma/Animation/PoseBatch.h>
+#include <Plasma/Animation/Puppeteer.h>
+#include <Plasma/Animation/SkeletalAnimation.h>
+#include <Plasma/Animation/SkeletalClip.h>
+#include <Plasma/DataFlow/DFGeomGenerator.h>
+#include <Plasma/DataFlow/DFGeomNodes.h>
+#include <Plasma/DataFlow/DFGeometry.h>
+#include <Plasma/DataFlow/DFGraph.h>
+#include <Plasma/Geometry/MeshGeometry.h>
+#include <Plasma/Geometry/MetaGeometry.h>
+#include <Plasma/Geometry/MetaSurface.h>
+#include <Plasma/Geometry/SurfaceGeometry.h>
+#include <Plasma/Intersector.h>
+#include <Plasma/Particle/BaseParticles.h>
+#include <Plasma/Particle/Smoke.h>
+#include <Plasma/Particle/Spark.h>
+#include <Plasma/Render/PlasmaBaker.h>
 #include <Plasma/Procedural/Tex.h>
+#include <Plasma/Resource/Serializer.h>
+#include <Plasma/World/RigidEntity.h>
+#include <Plasma/World/World.h>
+
+#include <Fusion/Core/Core.h>
+#include <Fusion/VM/VM.h>
+#include <Fusion/VM/VMMath.h>
+#include <Fusion/VM/VMRegistry.h>
+
+#include <Gfx/Mgr/Manager.h>
+#include <Gfx/Mgr/Null/NullContext.h>
+#include <Gfx/Mgr/Null/NullManager.h>
+#include <Gfx/Pass/Pass.h>
+
+#include <Base/IO/FileDevice.h>
+#include <Base/IO/FileSystem.h>
+#include <Base/IO/MMapDevice.h>
+#include <Base/MT/Atomic.h>
+#include <Base/MT/TaskQueue.h>
+#include <Base/Util/Timer.h>
 
 #include <CGMath/Vec3.h>
 #include <CGMath/CGMath.h>
+#include <CGMath/Frustum.h>
+#include <CGMath/Random.h>
 
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <new>
 
 USING_NAMESPACE
 
@@ -507,15 +549,1405 @@ void testTex( Test::Result& )
    dst->saveFile( "tex" );
 }
 
+/*==============================================================================
+   DATAFLOW EVALUATION
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//! Builds a union of transformed boxes, one column of 3-wide nodes per box.
+RCP<DFGraph> buildBoxUnion( uint numBoxes )
+{
+   RCP<DFGraph> graph = new DFGraph();
+   DFGraph::UpdateLock lock( graph.ptr() );
+   RCP<DFUnionNode> root = new DFUnionNode();
+   graph->addNode( root.ptr(), Vec2i(0, 0), 3*numBoxes );
+   for( uint i = 0; i < numBoxes; ++i )
+   {
+      RCP<DFTransformNode> xform = new DFTransformNode();
+      xform->position( Vec3f( float(i), 0.5f*float(i&1), 0.0f ) );
+      graph->addNode( xform.ptr(), Vec2i(3*i, 1), 3 );
+      RCP<DFBoxNode> box = new DFBoxNode();
+      box->halfSize( Vec3f( 0.75f, 0.5f+0.125f*float(i%3), 0.5f ) );
+      graph->addNode( box.ptr(), Vec2i(3*i, 2), 3 );
+   }
+   graph->output( root.ptr() );
+   return graph;
+}
+
+//------------------------------------------------------------------------------
+//!
+bool sameGeometry( const DFGeometry& a, const DFGeometry& b )
+{
+   if( a.numPatches() != b.numPatches() || a.numControlPoints() != b.numControlPoints() ) return false;
+   for( uint32_t i = 0; i < a.numControlPoints(); ++i )
+   {
+      if( a.controlPoint(i) != b.controlPoint(i) ) return false;
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+//!
+void testDFGraph( Test::Result& res )
+{
+   const uint numBoxes = 8;
+   TaskQueue queue( 4 );
+
+   // Serial evaluation, pulling from the output.
+   RCP<DFGraph> serial = buildBoxUnion( numBoxes );
+   Timer timer;
+   RCP<DFGeometry> ref = ((DFGeomOutput*)serial->output()->output())->getGeometry();
+   double serialTime = timer.elapsed();
+   TEST_ADD( res, ref.isValid() );
+   TEST_ADD( res, serial->cacheMisses() == 2*numBoxes+1 );
+
+   // Scheduled evaluation on the queue.
+   RCP<DFGraph> graph = buildBoxUnion( numBoxes );
+   timer.restart();
+   graph->evaluate( graph->output(), &queue );
+   double parallelTime = timer.elapsed();
+   TEST_ADD( res, graph->cacheMisses() == 2*numBoxes+1 );
+   graph->resetCacheStats();
+   RCP<DFGeometry> geom = ((DFGeomOutput*)graph->output()->output())->getGeometry();
+   TEST_ADD( res, graph->cacheHits() == 1 && graph->cacheMisses() == 0 );
+   TEST_ADD( res, geom.isValid() && sameGeometry( *ref, *geom ) );
+
+   // Editing a box only re-evaluates it and what is downstream of it.
+   DFNode* box = graph->getNode( Vec2i(0, 2) );
+   graph->invalidate( box );
+   TEST_ADD( res, box->output()->isDirty() );
+   TEST_ADD( res, graph->output()->output()->isDirty() );
+   TEST_ADD( res, !graph->getNode( Vec2i(3, 2) )->output()->isDirty() );
+   graph->resetCacheStats();
+   graph->evaluate( graph->output(), &queue );
+   TEST_ADD( res, graph->cacheMisses() == 3 );
+   geom = ((DFGeomOutput*)graph->output()->output())->getGeometry();
+   TEST_ADD( res, sameGeometry( *ref, *geom ) );
+
+   StdErr << "Serial: " << serialTime << "s, scheduled: " << parallelTime << "s" << nl;
+}
+
+/*==============================================================================
+   CULLING
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//! Records the patches of the entities in the pass, like the renderers do.
+void recordEntities( Gfx::Pass& pass, const Vector<Entity*>& entities )
+{
+   for( auto cur = entities.begin(); cur != entities.end(); ++cur )
+   {
+      Geometry* geom = (*cur)->geometry();
+      if( !geom ) continue;
+      pass.setWorldMatrixPtr( (*cur)->transform().ptr() );
+      for( uint p = 0; p < geom->numPatches(); ++p )
+      {
+         geom->renderPatch( pass, p );
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Measures the CPU time of a frame on a large world, walking every entity
+//! versus querying the world's BVH with the camera frustum. Rendering goes
+//! to a NullManager, so only the CPU side is timed.
+void testCulling( Test::Result& res )
+{
+   const int  side      = 100;
+   const uint numFrames = 50;
+
+   Core::gfx( Gfx::Manager::create( new Gfx::NullContext() ) );
+
+   RCP<DFGeometry>   box  = ((DFGeomOutput*)buildBoxUnion( 1 )->output()->output())->getGeometry();
+   RCP<MeshGeometry> mesh = box->createMesh();
+
+   RCP<World> world = new World();
+   for( int x = 0; x < side; ++x )
+   {
+      for( int z = 0; z < side; ++z )
+      {
+         RCP<RigidEntity> e = new RigidEntity( RigidBody::STATIC );
+         e->geometry( mesh.ptr() );
+         e->position( Vec3f( 4.0f*float(x), 0.0f, 4.0f*float(z) ) );
+         world->addEntity( e.ptr() );
+      }
+   }
+   uint numEntities = world->numEntities();
+
+   Frustumf frustum(
+      Reff( Vec3f( 0.5f*4.0f*float(side), 2.0f, 4.0f*float(side) ) ),
+      0.1f, 100.0f,
+      CGM::degToRad( 30.0f ), CGM::degToRad( 20.0f )
+   );
+
+   // Every entity overlapping the frustum is found.
+   Vector<Entity*> entities;
+   world->findEntities( frustum, entities );
+   uint numVisible = 0;
+   for( uint i = 0; i < numEntities; ++i )
+   {
+      Entity* e   = world->entity(i);
+      AABBoxf bb  = AABBoxf::empty();
+      for( int c = 0; c < 8; ++c ) bb |= e->transform() * mesh->boundingBox().corner(c);
+      if( frustum.intersect( bb ) == Frustumf::OUTSIDE ) continue;
+      ++numVisible;
+      TEST_ADD( res, entities.find( e ) != entities.end() );
+   }
+   TEST_ADD( res, numVisible > 0 && entities.size() < numEntities );
+
+   RCP<Gfx::Pass> pass = new Gfx::Pass();
+   double times[2];
+   size_t submitted[2];
+   for( uint cull = 0; cull < 2; ++cull )
+   {
+      submitted[cull] = 0;
+      Timer timer;
+      for( uint f = 0; f < numFrames; ++f )
+      {
+         // A few entities move every frame.
+         for( uint i = f; i < numEntities; i += 97 )
+         {
+            Entity* e = world->entity(i);
+            e->position( e->position() + Vec3f( 0.0f, (f&1) ? -0.25f : 0.25f, 0.0f ) );
+         }
+
+         entities.clear();
+         if( cull )
+         {
+            world->findEntities( frustum, entities );
+         }
+         else
+         {
+            for( uint i = 0; i < numEntities; ++i ) entities.pushBack( world->entity(i) );
+         }
+         submitted[cull] += entities.size();
+
+         pass->clear();
+         recordEntities( *pass, entities );
+         Core::gfx()->render( *pass );
+      }
+      times[cull] = timer.elapsed() / double(numFrames);
+   }
+   TEST_ADD( res, submitted[1] < submitted[0] );
+
+   StdErr << numEntities << " entities, " << numVisible << " visible" << nl;
+   StdErr << "Full walk: " << times[0]*1000.0 << "ms/frame, "
+          << "culled: "    << times[1]*1000.0 << "ms/frame "
+          << "(" << submitted[1]/numFrames << " submitted)" << nl;
+
+   world->removeAllEntities();
+   Core::gfx( RCP<Gfx::Manager>() );
+}
+
+/*==============================================================================
+   VERTEX AO
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//! Creates a bumpy square of side*side quads.
+RCP<SurfaceGeometry> makeBumpySurface( uint side )
+{
+   RCP<SurfaceGeometry> surface = new SurfaceGeometry();
+   surface->reserveVertices( (side+1)*(side+1) );
+   for( uint z = 0; z <= side; ++z )
+   {
+      for( uint x = 0; x <= side; ++x )
+      {
+         float h = 1.5f * CGM::sin( 0.7f*float(x) ) * CGM::cos( 0.5f*float(z) );
+         surface->addVertex( Vec3f( float(x), h, float(z) ) );
+      }
+   }
+   RCP<SurfaceGeometry::Patch> patch = surface->addPatch();
+   for( uint z = 0; z < side; ++z )
+   {
+      for( uint x = 0; x < side; ++x )
+      {
+         uint v = z*(side+1) + x;
+         patch->addFace( v, v + side + 1, v + side + 2, v + 1 );
+      }
+   }
+   surface->computeDerivedData();
+   return surface;
+}
+
+//------------------------------------------------------------------------------
+//! Bakes the AO of a new bumpy surface, and returns its normals.
+double bakeVertexAO( TaskQueue* queue, uint numPasses, Vector<Vec3f>& normals )
+{
+   RCP<SurfaceGeometry> surface = makeBumpySurface( 64 );
+   RCP<VertexAOBaker> baker     = new VertexAOBaker( surface.ptr(), 264, numPasses );
+   baker->queue( queue );
+
+   Timer timer;
+   while( !baker->refine() ) {}
+   double time = timer.elapsed();
+
+   normals.clear();
+   for( uint i = 0; i < surface->numNormals(); ++i )  normals.pushBack( surface->normal(i) );
+   return time;
+}
+
+//------------------------------------------------------------------------------
+//! Compares the AO baked from the calling thread with the one baked on a
+//! queue, which must be identical, and with a progressive bake.
+void testVertexAO( Test::Result& res )
+{
+   TaskQueue queue( 4 );
+
+   Vector<Vec3f> serial, parallel, progressive;
+   double serialTime   = bakeVertexAO( NULL, 1, serial );
+   double parallelTime = bakeVertexAO( &queue, 1, parallel );
+   bakeVertexAO( &queue, 4, progressive );
+
+   TEST_ADD( res, serial.size() > 0 );
+   TEST_ADD( res, serial.size() == parallel.size() &&
+                  memcmp( serial.data(), parallel.data(), serial.dataSize() ) == 0 );
+
+   // The passes draw other rays, so the results only match roughly.
+   float diff     = 0.0f;
+   uint  occluded = 0;
+   for( uint i = 0; i < serial.size() && i < progressive.size(); ++i )
+   {
+      diff += CGM::abs( serial[i].length() - progressive[i].length() );
+      if( serial[i].length() < 0.7f )  ++occluded;
+   }
+   TEST_ADD( res, progressive.size() == serial.size() );
+   TEST_ADD( res, diff < 0.05f*float(serial.size()) );
+   TEST_ADD( res, occluded > 0 );
+
+   StdErr << serial.size() << " vertices, " << occluded << " occluded, "
+          << "serial: " << serialTime << "s, 4 threads: " << parallelTime << "s" << nl;
+}
+
+/*==============================================================================
+   WORLD TRACE
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//! Returns a random ray going from one side of a world of the specified size
+//! to the other.
+Rayf  randomRay( RNG_WELL& rng, float size )
+{
+   Vec3f org( float(rng())*size, 0.5f + float(rng())*3.0f, -2.0f );
+   Vec3f dst( float(rng())*size, float(rng())*2.0f, size + 2.0f );
+   if( rng() < 0.5 )
+   {
+      // Along x instead of z.
+      org = Vec3f( org.z, org.y, org.x );
+      dst = Vec3f( dst.z, dst.y, dst.x );
+   }
+   return Rayf( org, dst - org );
+}
+
+//------------------------------------------------------------------------------
+//! Traces rays in worlds of 100, 1k, and 10k entities, through the entity BVH
+//! and with the linear scan, which must find the same hits.
+void testWorldTrace( Test::Result& res )
+{
+   const int  sides[] = { 10, 32, 100 };
+   const uint numRays = 2000;
+
+   RCP<DFGeometry>   box  = ((DFGeomOutput*)buildBoxUnion( 1 )->output()->output())->getGeometry();
+   RCP<MeshGeometry> mesh = box->createMesh();
+
+   for( uint w = 0; w < 3; ++w )
+   {
+      const int side = sides[w];
+      const float size = 4.0f*float(side);
+
+      RCP<World> world = new World();
+      for( int x = 0; x < side; ++x )
+      {
+         for( int z = 0; z < side; ++z )
+         {
+            RCP<RigidEntity> e = new RigidEntity( RigidBody::STATIC );
+            e->geometry( mesh.ptr() );
+            e->position( Vec3f( 4.0f*float(x), 0.0f, 4.0f*float(z) ) );
+            world->addEntity( e.ptr() );
+         }
+      }
+      uint numEntities = world->numEntities();
+
+      RNG_WELL rng;
+      Vector<Rayf> rays( numRays );
+      for( uint i = 0; i < numRays; ++i )  rays[i] = randomRay( rng, size );
+
+      double times[2] = { 0.0, 0.0 };
+      uint   numHits  = 0;
+      for( uint pass = 0; pass < 2; ++pass )
+      {
+         // Move some of the entities between the passes, to check the refit.
+         if( pass == 1 )
+         {
+            for( uint i = 0; i < numEntities; i += 7 )
+            {
+               Entity* e = world->entity(i);
+               e->position( e->position() + Vec3f( 1.0f, 1.5f, -1.0f ) );
+            }
+         }
+
+         Vector<Intersector::Hit> hits( numRays );
+         Vector<Intersector::Hit> refs( numRays );
+         Vector<bool> occluded( numRays );
+         Timer timer;
+         for( uint i = 0; i < numRays; ++i )
+         {
+            Intersector::trace( world.ptr(), rays[i], hits[i] );
+         }
+         times[1] += timer.restart();
+         for( uint i = 0; i < numRays; ++i )
+         {
+            Intersector::traceAll( world.ptr(), rays[i], refs[i] );
+         }
+         times[0] += timer.elapsed();
+
+         for( uint i = 0; i < numRays; ++i )
+         {
+            occluded[i] = Intersector::trace( world.ptr(), rays[i] );
+         }
+
+         for( uint i = 0; i < numRays; ++i )
+         {
+            TEST_ADD( res, hits[i]._entity == refs[i]._entity );
+            TEST_ADD( res, hits[i]._t == refs[i]._t );
+            TEST_ADD( res, occluded[i] == (refs[i]._t <= 1.0f) );
+            if( refs[i]._entity )  ++numHits;
+         }
+      }
+      TEST_ADD( res, numHits > 0 );
+
+      StdErr << numEntities << " entities, " << numHits << " hits: "
+             << "linear: " << times[0]*1000.0 << "ms, "
+             << "bvh: "    << times[1]*1000.0 << "ms" << nl;
+
+      world->removeAllEntities();
+   }
+}
+
+/*==============================================================================
+   DRAW SORT
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//! Orders the draws replayed by a NullManager by their state.
+struct DrawLess
+{
+   bool operator()( const Gfx::NullManager::Draw& a, const Gfx::NullManager::Draw& b ) const
+   {
+      if( a._program   != b._program   ) return a._program   < b._program;
+      if( a._samplers  != b._samplers  ) return a._samplers  < b._samplers;
+      if( a._constants != b._constants ) return a._constants < b._constants;
+      if( a._world     != b._world     ) return a._world     < b._world;
+      return a._geometry < b._geometry;
+   }
+};
+
+//------------------------------------------------------------------------------
+//! Records draws cycling through a few programs, sampler and constant lists,
+//! then compares the binds a NullManager does with and without sortDraws().
+//! Both replays must issue the same draws (program, samplers, constants, world
+//! matrix and geometry), only in a different order.
+void testDrawSort( Test::Result& res )
+{
+   const uint numDraws  = 20000;
+   const uint numStates = 8;
+
+   Core::gfx( Gfx::Manager::create( new Gfx::NullContext() ) );
+   Gfx::NullManager* mgr = (Gfx::NullManager*)Core::gfx();
+
+   Vector< RCP<Gfx::Program> >      progs;
+   Vector< RCP<Gfx::SamplerList> >  samplers;
+   Vector< RCP<Gfx::ConstantList> > constants;
+   Vector< RCP<Gfx::Geometry> >     geoms;
+   for( uint i = 0; i < numStates; ++i )
+   {
+      progs.pushBack( Core::gfx()->createProgram() );
+      samplers.pushBack( new Gfx::SamplerList() );
+      constants.pushBack( new Gfx::ConstantList() );
+      geoms.pushBack( Core::gfx()->createGeometry( Gfx::PRIM_TRIANGLES ) );
+   }
+   Vector<Mat4f> trfs( numDraws );
+   for( uint i = 0; i < numDraws; ++i )
+   {
+      trfs[i] = Mat4f::translation( Vec3f( 0.0f, 0.0f, -float(i%100) ) );
+   }
+
+   Gfx::Manager::Stats stats[2];
+   double times[2];
+   Vector<Gfx::NullManager::Draw> draws[2];
+   RCP<Gfx::Pass> pass = new Gfx::Pass();
+   for( uint sort = 0; sort < 2; ++sort )
+   {
+      pass->clear();
+      for( uint i = 0; i < numDraws; ++i )
+      {
+         pass->setWorldMatrixPtr( trfs[i].ptr() );
+         pass->setProgram( progs[i%numStates] );
+         pass->setSamplers( samplers[(i/numStates)%numStates] );
+         pass->setConstants( constants[(i/3)%numStates] );
+         pass->execGeometry( geoms[(i*7)%numStates] );
+      }
+
+      Timer timer;
+      if( sort )
+      {
+         pass->sortMode( Gfx::SORT_STATE );
+         pass->sortDraws();
+      }
+      Core::gfx()->resetStats();
+      Core::gfx()->render( *pass );
+      times[sort] = timer.elapsed();
+      stats[sort] = Core::gfx()->stats();
+
+      // Replay the pass again to record its draws (untimed).
+      draws[sort].reserve( numDraws );
+      mgr->recordDraws( &draws[sort] );
+      Core::gfx()->render( *pass );
+      mgr->recordDraws( NULL );
+   }
+
+   TEST_ADD( res, stats[0]._draws == numDraws );
+   TEST_ADD( res, stats[1]._draws == numDraws );
+   TEST_ADD( res, stats[1]._programBinds == numStates );
+   TEST_ADD( res, stats[1]._samplerBinds < stats[0]._samplerBinds );
+
+   // Sorting must only reorder the draws: compare them as multisets.
+   TEST_ADD( res, draws[0].size() == numDraws );
+   TEST_ADD( res, draws[1].size() == numDraws );
+   if( draws[0].size() == draws[1].size() )
+   {
+      std::sort( draws[0].begin(), draws[0].end(), DrawLess() );
+      std::sort( draws[1].begin(), draws[1].end(), DrawLess() );
+      uint numSame = 0;
+      for( uint i = 0; i < draws[0].size(); ++i )
+      {
+         const Gfx::NullManager::Draw& a = draws[0][i];
+         const Gfx::NullManager::Draw& b = draws[1][i];
+         if( a._program  == b._program  && a._samplers == b._samplers && a._constants == b._constants &&
+             a._world    == b._world    && a._geometry == b._geometry )
+         {
+            ++numSame;
+         }
+      }
+      TEST_ADD( res, numSame == numDraws );
+   }
+
+   for( uint sort = 0; sort < 2; ++sort )
+   {
+      StdErr << (sort ? "Sorted:   " : "Unsorted: ")
+             << stats[sort]._programBinds  << " program, "
+             << stats[sort]._samplerBinds  << " sampler, "
+             << stats[sort]._geometryBinds << " geometry binds ("
+             << times[sort]*1000.0 << "ms)" << nl;
+   }
+
+   Core::gfx( RCP<Gfx::Manager>() );
+}
+
+/*==============================================================================
+   PASS ALLOCATIONS
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//!
+class CountingAllocator:
+   public MemoryArena::Allocator
+{
+public:
+   CountingAllocator(): _allocs(0) {}
+   virtual void* allocate( size_t size ) { ++_allocs; return malloc( size ); }
+   virtual void  deallocate( void* ptr ) { free( ptr ); }
+   uint  _allocs;
+};
+
+//------------------------------------------------------------------------------
+//! Records the same frame repeatedly, with copied matrices, ranges, scissors
+//! and positions, and counts the allocations the pass does for them.
+void testPassAllocations( Test::Result& res )
+{
+   const uint numDraws  = 5000;
+   const uint numFrames = 20;
+
+   Core::gfx( Gfx::Manager::create( new Gfx::NullContext() ) );
+
+   RCP<Gfx::Program>  prog = Core::gfx()->createProgram();
+   RCP<Gfx::Geometry> geom = Core::gfx()->createGeometry( Gfx::PRIM_TRIANGLES );
+   Mat4f trf   = Mat4f::identity();
+   Vec3f pos   = Vec3f( 1.0f, 2.0f, 3.0f );
+   uint  range[2] = { 0, 3 };
+
+   CountingAllocator counter;
+   RCP<Gfx::Pass> pass = new Gfx::Pass( &counter );
+   Vector<uint> allocs;
+   Timer timer;
+   for( uint f = 0; f < numFrames; ++f )
+   {
+      uint before = counter._allocs;
+      pass->clear();
+      pass->setCamPosition( pos.ptr() );
+      pass->setViewMatrix( trf.ptr() );
+      pass->setProgram( prog );
+      for( uint i = 0; i < numDraws; ++i )
+      {
+         trf(2,3) = float(i);
+         pass->setWorldMatrix( trf.ptr() );
+         pass->setScissor( 0, 0, int(i), int(i) );
+         pass->execRangeGeometry( geom, range );
+      }
+      Core::gfx()->render( *pass );
+      allocs.pushBack( counter._allocs - before );
+   }
+   double time = timer.elapsed() / double(numFrames);
+
+   // Only the first frames grow the arena.
+   TEST_ADD( res, allocs[0] > 0 );
+   uint steady = 0;
+   for( uint f = 2; f < numFrames; ++f ) steady += allocs[f];
+   TEST_ADD( res, steady == 0 );
+
+   StdErr << "Frame 0: " << allocs[0] << " allocations, frame 1: " << allocs[1]
+          << ", then " << steady << " (" << time*1000.0 << "ms/frame)" << nl;
+
+   Core::gfx( RCP<Gfx::Manager>() );
+}
+
+/*==============================================================================
+   CONSTANT RING
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//! Records the skinned draws of a frame the way the renderers used to, with a
+//! new constant list per entity and pass, and with the manager's constant ring,
+//! and counts the allocations the ring does in every frame.
+void testConstantRing( Test::Result& res )
+{
+   const uint numEntities = 500;
+   const uint numBones    = 40;
+   const uint numPasses   = 3; // Shadow, depth and color.
+   const uint numFrames   = 20;
+
+   Core::gfx( Gfx::Manager::create( new Gfx::NullContext() ) );
+   Gfx::ConstantRing& ring = Core::gfx()->constantRing();
+
+   RCP<Gfx::Program>  prog = Core::gfx()->createProgram();
+   RCP<Gfx::Geometry> geom = Core::gfx()->createGeometry( Gfx::PRIM_TRIANGLES );
+   ConstString name( "boneMatrices" );
+
+   // What every skeleton instance holds: its matrices, and a buffer pointing to them.
+   Vector< Vector<Mat4f> >            bones( numEntities );
+   Vector< RCP<Gfx::ConstantBuffer> > buffers( numEntities );
+   for( uint e = 0; e < numEntities; ++e )
+   {
+      bones[e].resize( numBones );
+      for( uint b = 0; b < numBones; ++b )
+      {
+         bones[e][b] = Mat4f::translation( float(e), float(b), 1.0f );
+      }
+      buffers[e] = Core::gfx()->createConstants( sizeof(float*) );
+      buffers[e]->addConstantArray( name, Gfx::CONST_MAT4, numBones, 0, Gfx::VERTEX_SHADER, bones[e].data() );
+   }
+
+   RCP<Gfx::Pass> pass = new Gfx::Pass();
+   pass->setProgram( prog );
+   uint   allocs[numFrames];
+   uint   recycled = 0;
+   double times[2];
+   for( uint useRing = 0; useRing < 2; ++useRing )
+   {
+      Timer timer;
+      for( uint f = 0; f < numFrames; ++f )
+      {
+         ring.resetStats();
+         Core::gfx()->beginFrame();
+         for( uint p = 0; p < numPasses; ++p )
+         {
+            pass->clear();
+            pass->setProgram( prog );
+            for( uint e = 0; e < numEntities; ++e )
+            {
+               bones[e][0](2,3) = float(f);
+               if( useRing )
+               {
+                  Gfx::ConstantRing::Slice slice = ring.store( bones[e].data()->ptr(), numBones*16 );
+                  pass->setConstants( ring.arrayList( name, Gfx::CONST_MAT4, numBones, slice ) );
+               }
+               else
+               {
+                  pass->setConstants( Gfx::ConstantList::create( buffers[e] ) );
+               }
+               pass->execGeometry( geom );
+            }
+            Core::gfx()->render( *pass );
+         }
+         if( useRing )
+         {
+            allocs[f] = ring.stats()._allocations;
+            recycled  = ring.stats()._recycledArrays;
+         }
+      }
+      times[useRing] = timer.elapsed() / double(numFrames);
+   }
+
+   // The ring stops allocating once it has grown to fit the frame, and then
+   // recycles every array.
+   uint steady = 0;
+   for( uint f = 2; f < numFrames; ++f )  steady += allocs[f];
+   TEST_ADD( res, allocs[0] > 0 );
+   TEST_ADD( res, steady == 0 );
+   TEST_ADD( res, recycled == numEntities*numPasses );
+   TEST_ADD( res, ring.used() >= numEntities*numPasses*numBones*16 );
+   TEST_ADD( res, ring.numSpills() == 0 );
+
+   // The slices hold copies of the matrices, and the constants point to them.
+   Core::gfx()->beginFrame();
+   Gfx::ConstantRing::Slice slice = ring.store( bones[7].data()->ptr(), numBones*16 );
+   const RCP<Gfx::ConstantBuffer>& buffer = ring.arrayBuffer( name, Gfx::CONST_MAT4, numBones, slice );
+   const void* value = nullptr;
+   buffer->getConstant( &buffer->constants()[0], &value );
+   TEST_ADD( res, *(const float* const*)value == slice._data );
+   TEST_ADD( res, memcmp( slice._data, bones[7].data(), numBones*sizeof(Mat4f) ) == 0 );
+   TEST_ADD( res, (slice._offset % 4) == 0 );
+
+   // A frame larger than the ring spills, and the ring grows to fit it next time.
+   Gfx::ConstantRing small( Core::gfx(), 64 );
+   for( uint f = 0; f < 3; ++f )
+   {
+      small.beginFrame();
+      for( uint e = 0; e < 10; ++e )
+      {
+         Gfx::ConstantRing::Slice s = small.store( bones[e].data()->ptr(), 16*3 + 2 );
+         TEST_ADD( res, memcmp( s._data, bones[e].data(), (16*3 + 2)*sizeof(float) ) == 0 );
+      }
+      TEST_ADD( res, small.used() == 10*52 );
+      TEST_ADD( res, (f == 0) == (small.numSpills() > 0) );
+   }
+   TEST_ADD( res, small.capacity() >= 10*52 );
+
+   StdErr << "New lists: " << times[0]*1000.0 << "ms/frame, ring: " << allocs[0] << " and " << allocs[1]
+          << " allocations then " << steady << " ("
+          << times[1]*1000.0 << "ms/frame, " << ring.capacity()*sizeof(float)/1024 << "KB)" << nl;
+
+   buffers.clear();
+   Core::gfx( RCP<Gfx::Manager>() );
+}
+
+//------------------------------------------------------------------------------
+//!
+bool sameMesh( const MeshGeometry& a, const MeshGeometry& b )
+{
+   if( a.primitiveType() != b.primitiveType() || a.numIndices() != b.numIndices() ||
+       a.numVertices() != b.numVertices() || a.numAttributes() != b.numAttributes() ||
+       a.numPatches() != b.numPatches() )
+   {
+      return false;
+   }
+   for( uint i = 0; i < a.numAttributes(); ++i )
+   {
+      if( a.attributeType( i ) != b.attributeType( i ) )  return false;
+   }
+   for( uint i = 0; i < a.numPatches(); ++i )
+   {
+      if( a.patchInfo( i ).rangeSize() != b.patchInfo( i ).rangeSize() )  return false;
+   }
+   return memcmp( a.indices(), b.indices(), a.indicesSize()*sizeof(uint32_t) ) == 0 &&
+          memcmp( a.vertices(), b.vertices(), a.verticesSize()*sizeof(float) ) == 0;
+}
+
+//------------------------------------------------------------------------------
+//! Round-trips a mesh through the block format, and compares the load times
+//! with the stream format.
+void testMeshBlock( Test::Result& res )
+{
+   const uint numVertices = 200000;
+   const int  attribs[]   = { MeshGeometry::POSITION, MeshGeometry::NORMAL, MeshGeometry::MAPPING, 0 };
+
+   RCP<MeshGeometry> mesh = new MeshGeometry( MeshGeometry::TRIANGLES, attribs, numVertices*3, numVertices );
+   float* v = mesh->vertices();
+   for( size_t i = 0; i < mesh->verticesSize(); ++i )  v[i] = float(i % 977) * 0.25f;
+   uint32_t* idx = mesh->indices();
+   for( uint i = 0; i < mesh->numIndices(); ++i )  idx[i] = (i * 7919) % numVertices;
+   mesh->addPatch( 0, numVertices*3/2, 0 );
+   mesh->addPatch( numVertices*3/2, numVertices*3/2, 1 );
+
+   Path bin( "meshblock_test.mesh.bin" );
+   Path blk( "meshblock_test.mesh.blk" );
+   {
+      BinaryStream os( new FileDevice( bin, IODevice::MODE_WRITE|IODevice::MODE_NEWFILE ) );
+      TEST_ADD( res, Serializer::dumpMeshGeometry( *mesh, os ) );
+   }
+   TEST_ADD( res, Serializer::convertToMeshBlock( bin, blk ) );
+
+   RCP< Resource<Geometry> > a = new Resource<Geometry>();
+   RCP< Resource<Geometry> > b = new Resource<Geometry>();
+   Timer timer;
+   {
+      BinaryStream is( new FileDevice( bin, IODevice::MODE_READ ) );
+      TEST_ADD( res, Serializer::loadMeshGeometry( is, a.ptr() ) );
+   }
+   double tStream = timer.restart();
+   {
+      BinaryStream is( new MMapDevice( FS::Entry( blk ), IODevice::MODE_READ ) );
+      TEST_ADD( res, Serializer::loadMeshBlock( is, b.ptr() ) );
+   }
+   double tBlock = timer.elapsed();
+   TEST_ADD( res, a->data() && sameMesh( *mesh, *a->data()->mesh() ) );
+   TEST_ADD( res, b->data() && sameMesh( *mesh, *b->data()->mesh() ) );
+
+   StdErr << "Loading " << numVertices << " vertices: stream " << tStream*1000.0
+          << "ms, block " << tBlock*1000.0 << "ms" << nl;
+
+   // A damaged header is refused.
+   {
+      RCP<FileDevice> fd = new FileDevice( blk, IODevice::MODE_READ_WRITE );
+      fd->seek( 8 );
+      fd->write( "\xFF", 1 );
+   }
+   {
+      RCP< Resource<Geometry> > c = new Resource<Geometry>();
+      BinaryStream is( new MMapDevice( FS::Entry( blk ), IODevice::MODE_READ ) );
+      TEST_ADD( res, !Serializer::loadMeshBlock( is, c.ptr() ) );
+   }
+
+   FS::remove( bin );
+   FS::remove( blk );
+}
+
+/*==============================================================================
+   META SURFACE
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//! Compiles the function returned by a chunk into a MetaFunction.
+void compileFunction( const char* src, float param, MetaFunction* func, bool batched = false )
+{
+   VMState* vm = VM::open( VM_CAT_MATH, true );
+   VM::doString( vm, src );
+   VM::getByteCode( vm, func->code() );
+   VM::close( vm );
+   func->parameters().set( size_t(0), param );
+   func->batched( batched );
+}
+
+//------------------------------------------------------------------------------
+//!
+enum
+{
+   NO_FUNCTIONS,
+   POINT_FUNCTIONS,  //!< Functions of a point, called by the host for every point.
+   DRIVEN_FUNCTIONS, //!< Functions of a point, called a patch at a time.
+   ARRAY_FUNCTIONS   //!< Functions of arrays of points (see MetaFunction::batched()).
+};
+
+//------------------------------------------------------------------------------
+//! Builds a row of blocks of varying heights, subdivided on the queue, and
+//! optionally mapped and displaced (all of the functions computing the same
+//! values).
+RCP<MetaGeometry> buildBlockRow( uint numBlocks, TaskQueue* queue, int functions = NO_FUNCTIONS )
+{
+   RCP<MetaGeometry> geom = new MetaGeometry();
+   geom->queue( queue );
+   geom->batchFunctions( functions != POINT_FUNCTIONS );
+
+   MetaBuilder builder( geom.ptr() );
+   builder.setGeometricError( 0.01f );
+   MetaBlocks* blocks = builder.createBlocks();
+   builder.set( blocks, Mat4f::identity() );
+   if( functions == ARRAY_FUNCTIONS )
+   {
+      MetaFunction* mapping      = builder.createFunction();
+      MetaFunction* displacement = builder.createFunction();
+      compileFunction(
+         "return function( IN, s )\n"
+         "   local out = {}\n"
+         "   for i = 1, IN.count do out[i] = IN.uv[i]*s end\n"
+         "   return out\n"
+         "end",
+         2.0f, mapping, true
+      );
+      compileFunction(
+         "return function( IN, h )\n"
+         "   local out, pos, n, uv = {}, IN.pos, IN.n, IN.uv\n"
+         "   for i = 1, IN.count do out[i] = pos[i] + n[i]*(h*uv[i].x*(1-uv[i].y)) end\n"
+         "   return out\n"
+         "end",
+         0.1f, displacement, true
+      );
+      builder.set( blocks, mapping, displacement );
+   }
+   else if( functions != NO_FUNCTIONS )
+   {
+      MetaFunction* mapping      = builder.createFunction();
+      MetaFunction* displacement = builder.createFunction();
+      compileFunction(
+         "return function( IN, s ) return IN.uv*s end",
+         2.0f, mapping
+      );
+      compileFunction(
+         "return function( IN, h ) return IN.pos + IN.n*(h*IN.uv.x*(1-IN.uv.y)) end",
+         0.1f, displacement
+      );
+      builder.set( blocks, mapping, displacement );
+   }
+   for( uint i = 0; i < numBlocks; ++i )
+   {
+      float x0 = float(i)*2.0f;
+      float x1 = x0 + 2.0f;
+      float h0 = 2.0f + 0.5f*CGM::sin( float(i) );
+      float h1 = 2.0f + 0.5f*CGM::sin( float(i+1) );
+      Vec3f pos[8] = {
+         Vec3f( x0, 0.0f, 0.0f ), Vec3f( x1, 0.0f, 0.0f ),
+         Vec3f( x0, h0,   0.0f ), Vec3f( x1, h1,   0.0f ),
+         Vec3f( x0, 0.0f, 2.0f ), Vec3f( x1, 0.0f, 2.0f ),
+         Vec3f( x0, h0,   2.0f ), Vec3f( x1, h1,   2.0f )
+      };
+      MetaBlock* block = builder.createBlock();
+      builder.add( blocks, block );
+      builder.set( block, i%3, 0, 0, 0 );
+      builder.set( block, pos );
+   }
+   builder.execute();
+   return geom;
+}
+
+//------------------------------------------------------------------------------
+//! Checks that subdividing and triangulating on a queue gives the same mesh
+//! as doing it serially.
+void testMetaSurface( Test::Result& res )
+{
+   const uint numBlocks = 64;
+   TaskQueue queue( 4 );
+
+   Timer timer;
+   RCP<MetaGeometry> ref     = buildBlockRow( numBlocks, nullptr );
+   RCP<MeshGeometry> refMesh = new MeshGeometry();
+   Vector<uint> refInfos;
+   ref->createMesh( *refMesh, &refInfos );
+   double serialTime = timer.restart();
+
+   RCP<MetaGeometry> geom = buildBlockRow( numBlocks, &queue );
+   RCP<MeshGeometry> mesh = new MeshGeometry();
+   Vector<uint> infos;
+   geom->createMesh( *mesh, &infos );
+   double parallelTime = timer.elapsed();
+
+   TEST_ADD( res, refMesh->numIndices() > 0 );
+   TEST_ADD( res, sameMesh( *refMesh, *mesh ) );
+   TEST_ADD( res, refInfos.size() == infos.size() &&
+                  memcmp( refInfos.data(), infos.data(), infos.dataSize() ) == 0 );
+
+   StdErr << mesh->numVertices() << " vertices, serial: " << serialTime*1000.0
+          << "ms, queue: " << parallelTime*1000.0 << "ms" << nl;
+}
+
+//------------------------------------------------------------------------------
+//! Checks that evaluating the mapping and displacement functions a patch at a
+//! time, either through the driver or as functions of arrays, gives the same
+//! mesh as calling them for every point.
+void testMetaFunctions( Test::Result& res )
+{
+   const uint numBlocks = 16;
+
+   // The functions use vectors, which only get registered with Core otherwise.
+   VMMath::initialize();
+
+   RCP<MeshGeometry> meshes[3];
+   Vector<uint>      infos[3];
+   double            times[3];
+   for( uint i = 0; i < 3; ++i )
+   {
+      Timer timer;
+      RCP<MetaGeometry> geom = buildBlockRow( numBlocks, nullptr, POINT_FUNCTIONS+i );
+      meshes[i] = new MeshGeometry();
+      geom->createMesh( *meshes[i], &infos[i] );
+      times[i] = timer.elapsed();
+   }
+
+   // The functions must have done something.
+   RCP<MetaGeometry> plain     = buildBlockRow( numBlocks, nullptr );
+   RCP<MeshGeometry> plainMesh = new MeshGeometry();
+   plain->createMesh( *plainMesh );
+
+   TEST_ADD( res, meshes[0]->numIndices() > 0 );
+   TEST_ADD( res, !sameMesh( *plainMesh, *meshes[0] ) );
+   for( uint i = 1; i < 3; ++i )
+   {
+      TEST_ADD( res, sameMesh( *meshes[0], *meshes[i] ) );
+      TEST_ADD( res, infos[0].size() == infos[i].size() &&
+                     memcmp( infos[0].data(), infos[i].data(), infos[i].dataSize() ) == 0 );
+   }
+
+   StdErr << meshes[0]->numVertices() << " vertices, per point: " << times[0]*1000.0
+          << "ms, driven: " << times[1]*1000.0 << "ms, arrays: " << times[2]*1000.0 << "ms" << nl;
+}
+
+//------------------------------------------------------------------------------
+//! Creates one of the particle systems, with rates high enough to fill 64k particles.
+void makeParticleSystem( uint kind, RCP<ParticleGenerator>& gen, RCP<ParticleAnimator>& ani )
+{
+   switch( kind )
+   {
+      case 0:
+      {
+         LineGenerator* line = new LineGenerator();
+         line->rate( 200000.0f );
+         gen = line;
+         ani = new LineAnimator();
+      }  break;
+      case 1:
+      {
+         SmokeGenerator* smoke = new SmokeGenerator();
+         smoke->rate( 30000.0f, 1000.0f );
+         gen = smoke;
+         ani = new SmokeAnimator();
+      }  break;
+      default:
+      {
+         SparkGenerator* spark = new SparkGenerator();
+         spark->rate( 20000.0f, 1000.0f );
+         gen = spark;
+         ani = new SparkAnimator();
+      }  break;
+   }
+}
+
+//------------------------------------------------------------------------------
+//! Simulates a particle system in the specified layout, and returns the time
+//! spent in the animator, the number of particles it updated, and the final
+//! vertex stream.
+double simulateParticles(
+   uint                 kind,
+   ParticleData::Layout layout,
+   uint                 numFrames,
+   uint64_t&            numUpdated,
+   Vector<float>&       vertices
+)
+{
+   RCP<ParticleGenerator> gen;
+   RCP<ParticleAnimator>  ani;
+   makeParticleSystem( kind, gen, ani );
+
+   RCP<ParticleEntity> e = new ParticleEntity();
+   e->data().allocate( gen->generates() | ani->animates(), 1 << 16, layout );
+
+   ParticleRNG rng;
+   Timer timer;
+   double time = 0.0;
+   numUpdated  = 0;
+   for( uint f = 0; f < numFrames; ++f )
+   {
+      gen->generate( 1.0f/60.0f, *e, rng );
+      numUpdated += e->data().size();
+      timer.restart();
+      ani->animate( 1.0f/60.0f, *e, rng );
+      time += timer.elapsed();
+   }
+
+   vertices.resize( e->data().size() * e->data().vertexStride() );
+   e->data().pack( vertices.data() );
+   return time;
+}
+
+//------------------------------------------------------------------------------
+//!
+void testParticles( Test::Result& res )
+{
+   const char* names[] = { "line", "smoke", "spark" };
+   for( uint kind = 0; kind < 3; ++kind )
+   {
+      uint64_t refUpdated, soaUpdated;
+      Vector<float> refVertices, soaVertices;
+      double refTime = simulateParticles( kind, ParticleData::INTERLEAVED, 300, refUpdated, refVertices );
+      double soaTime = simulateParticles( kind, ParticleData::SOA, 300, soaUpdated, soaVertices );
+
+      // Both layouts draw the same random numbers, and remove the same particles.
+      TEST_ADD( res, refVertices.size() > 0 );
+      TEST_ADD( res, refUpdated == soaUpdated );
+      TEST_ADD( res, refVertices.size() == soaVertices.size() &&
+                     memcmp( refVertices.data(), soaVertices.data(), soaVertices.dataSize() ) == 0 );
+
+      StdErr << names[kind] << ": " << refUpdated << " updates, interleaved: "
+             << double(refUpdated)/(refTime*1000.0) << " particles/ms, soa: "
+             << double(soaUpdated)/(soaTime*1000.0) << " particles/ms" << nl;
+   }
+}
+
+/*==============================================================================
+   SKELETAL CLIP
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//! A cyclic animation where a third of the bones don't move, a third swing
+//! slowly, and the rest swing and twist faster, while the root walks forward
+//! (and grows by the specified amount halfway through).
+RCP<SkeletalAnimation> makeSwingAnimation( uint numBones, uint numPoses, float offset = 0.0f, float growth = 0.0f )
+{
+   RCP<SkeletalAnimation> anim = new SkeletalAnimation();
+   anim->reservePoses( numPoses );
+   for( uint p = 0; p < numPoses; ++p )
+   {
+      float a = CGConstf::pi2() * float(p) / float(numPoses-1);
+      Reff  ref( Quatf::eulerY( 0.1f*CGM::sin( a ) ), Vec3f( 0.0f, 1.0f + 0.05f*CGM::sin( 2.0f*a ), 0.05f*float(p) ),
+                 1.0f + growth*CGM::sin( 0.5f*a ) );
+      SkeletalPose* pose = anim->addPose( ref );
+      pose->reserveBones( numBones );
+      for( uint b = 0; b < numBones; ++b )
+      {
+         float phase = 0.37f*float(b) + offset;
+         switch( b % 3 )
+         {
+            case 0 : pose->addBone( Quatf::eulerX( 0.2f + 0.01f*float(b) ) ); break;
+            case 1 : pose->addBone( Quatf::eulerX( 0.6f*CGM::sin( a + phase ) ) ); break;
+            default: pose->addBone( Quatf::eulerZYX( Vec3f( 0.8f*CGM::sin( 2.0f*a + phase ), 0.3f*CGM::cos( 3.0f*a ), 0.2f ) ) ); break;
+         }
+      }
+   }
+   anim->cyclic( true );
+   return anim;
+}
+
+//------------------------------------------------------------------------------
+//! Returns the angle between two rotations (precise for tiny angles).
+float angle( const Quatf& a, const Quatf& b )
+{
+   Quatf d = (a.dot( b ) < 0.0f) ? a + b : a - b;
+   return 4.0f*CGM::asin( CGM::min( 1.0f, 0.5f*d.norm() ) );
+}
+
+//------------------------------------------------------------------------------
+//! Returns the largest angle between the bones (and root orientation) of two poses.
+float maxAngle( const SkeletalPose& a, const SkeletalPose& b )
+{
+   float worst = angle( a.orientation(), b.orientation() );
+   for( uint i = 0; i < a.numBones(); ++i )
+   {
+      worst = CGM::max( worst, angle( a.bones()[i], b.bones()[i] ) );
+   }
+   return worst;
+}
+
+//------------------------------------------------------------------------------
+//! Compresses an animation, checks the error bound on every frame and between
+//! them, and compares the memory and sampling cost of 100 characters with
+//! interpolating the poses bone by bone.
+void testSkeletalClip( Test::Result& res )
+{
+   const uint  numBones      = 60;
+   const uint  numPoses      = 241;
+   const uint  numCharacters = 100;
+   const uint  numSteps      = 200;
+   const float maxError      = 0.002f;
+
+   RCP<SkeletalAnimation> anim = makeSwingAnimation( numBones, numPoses );
+   RCP<SkeletalClip>      clip = SkeletalClip::create( *anim, maxError, 0.001f );
+   TEST_ADD( res, clip->numBones() == numBones );
+   TEST_ADD( res, clip->numFrames() == numPoses );
+   TEST_ADD( res, clip->numKeys() < (numBones+1)*numPoses );
+
+   // Every frame is within the bounds.
+   RCP<SkeletalPose> pose = new SkeletalPose( Reff::identity(), numBones );
+   float worst = 0.0f;
+   float worstPos = 0.0f;
+   for( uint p = 0; p+1 < numPoses; ++p )
+   {
+      clip->sample( float(p)/anim->rate(), *pose );
+      worst    = CGM::max( worst, maxAngle( *pose, *anim->pose(p) ) );
+      worstPos = CGM::max( worstPos, (pose->position() - anim->pose(p)->position()).length() );
+   }
+   TEST_ADD( res, worst <= maxError*1.01f );
+   TEST_ADD( res, worstPos <= 0.001f*1.01f );
+
+   // In between, it stays close to interpolating the frames.
+   RCP<SkeletalPose> ref = new SkeletalPose( Reff::identity(), numBones );
+   float worstBetween = 0.0f;
+   for( uint i = 0; i < 1000; ++i )
+   {
+      float time = anim->duration() * 2.0f * float(i) / 1000.0f;
+      SkeletalPose* p0;
+      SkeletalPose* p1;
+      float t;
+      anim->getPoses( time, p0, p1, t );
+      ref->referential( p0->referential().nlerp( p1->referential(), t ) );
+      for( uint b = 0; b < numBones; ++b )  ref->bones()[b] = p0->bones()[b].nlerp( p1->bones()[b], t );
+      clip->sample( time, *pose );
+      worstBetween = CGM::max( worstBetween, maxAngle( *pose, *ref ) );
+   }
+   TEST_ADD( res, worstBetween <= 2.0f*maxError );
+
+   // Blending in the same pass matches blending the sampled poses.
+   RCP<SkeletalPose> other = new SkeletalPose( Reff::identity(), numBones );
+   clip->sample( 1.0f, *pose );
+   clip->sample( 2.5f, *other );
+   for( uint b = 0; b < numBones; ++b )  ref->bones()[b] = pose->bones()[b].nlerp( other->bones()[b], 0.3f );
+   ref->referential( pose->referential().nlerp( other->referential(), 0.3f ) );
+   clip->blend( 2.5f, 0.3f, *pose );
+   TEST_ADD( res, maxAngle( *pose, *ref ) < 1e-3f );
+
+   // A root scale which varies (e.g. a character growing) follows the frames.
+   RCP<SkeletalAnimation> growing = makeSwingAnimation( numBones, numPoses, 0.0f, 0.5f );
+   RCP<SkeletalClip> growingClip = SkeletalClip::create( *growing, maxError, 0.001f );
+   float worstScale = 0.0f;
+   for( uint p = 0; p+1 < numPoses; ++p )
+   {
+      growingClip->sample( float(p)/growing->rate(), *pose );
+      worstScale = CGM::max( worstScale, CGM::abs( pose->referential().scale() - growing->pose(p)->referential().scale() ) );
+   }
+   TEST_ADD( res, worstScale <= 2e-4f );
+
+   // Memory.
+   size_t poseBytes = anim->numPoses() * (sizeof(RCP<SkeletalPose>) + sizeof(SkeletalPose) + numBones*sizeof(Quatf));
+   TEST_ADD( res, clip->sizeInBytes()*4 < poseBytes );
+
+   // Sampling 100 characters at different times, all playing the same
+   // animation, then each playing its own.
+   Vector< RCP<SkeletalAnimation> > anims( numCharacters );
+   Vector< RCP<SkeletalClip> >      clips( numCharacters );
+   Vector< RCP<SkeletalPose> >      poses( numCharacters );
+   for( uint c = 0; c < numCharacters; ++c )
+   {
+      anims[c] = makeSwingAnimation( numBones, numPoses, 0.1f*float(c) );
+      clips[c] = SkeletalClip::create( *anims[c], maxError, 0.001f );
+      poses[c] = new SkeletalPose( Reff::identity(), numBones );
+   }
+   double times[2][2];
+   for( uint distinct = 0; distinct < 2; ++distinct )
+   {
+      for( uint useClip = 0; useClip < 2; ++useClip )
+      {
+         Timer timer;
+         for( uint s = 0; s < numSteps; ++s )
+         {
+            for( uint c = 0; c < numCharacters; ++c )
+            {
+               float time = 0.013f*float(c) + float(s)/60.0f;
+               SkeletalPose* dst = poses[c].ptr();
+               if( useClip )
+               {
+                  (distinct ? clips[c] : clip)->sample( time, *dst );
+               }
+               else
+               {
+                  SkeletalPose* p0;
+                  SkeletalPose* p1;
+                  float t;
+                  (distinct ? anims[c] : anim)->getPoses( time, p0, p1, t );
+                  dst->referential( p0->referential().nlerp( p1->referential(), t ) );
+                  for( uint b = 0; b < numBones; ++b )  dst->bones()[b] = p0->bones()[b].nlerp( p1->bones()[b], t );
+               }
+            }
+         }
+         times[distinct][useClip] = timer.elapsed() / double(numSteps);
+      }
+   }
+
+   StdErr << numBones << " bones, " << numPoses << " poses: " << clip->numKeys() << " keys, "
+          << clip->sizeInBytes() << " bytes vs " << poseBytes << " bytes, error: " << worst
+          << " (" << worstBetween << " between frames)" << nl;
+   StdErr << numCharacters << " characters, same animation: poses " << times[0][0]*1000.0
+          << "ms, clip " << times[0][1]*1000.0 << "ms; own animations: poses "
+          << times[1][0]*1000.0 << "ms, clip " << times[1][1]*1000.0 << "ms" << nl;
+}
+
+/*==============================================================================
+   POSE BATCH
+==============================================================================*/
+
+//------------------------------------------------------------------------------
+//! A skeleton where every fifth bone starts a new chain off the first one.
+RCP<Skeleton> makeChainSkeleton( uint numBones )
+{
+   RCP<Skeleton> skel = new Skeleton();
+   skel->reserveBones( numBones );
+   for( uint b = 0; b < numBones; ++b )
+   {
+      int  parent = (b == 0) ? Skeleton::ROOT : ((b % 5 == 1) ? 0 : int(b-1));
+      Reff ref( Quatf::eulerY( 0.1f*float(b) ), Vec3f( 0.0f, 0.2f, 0.05f*float(b % 3) ), 1.0f );
+      skel->addBone( String().format( "b%d", b ).cstr(), ref, parent, Vec3f( 0.0f, 0.2f, 0.0f ) );
+   }
+   skel->computeDerivedData();
+   return skel;
+}
+
+//------------------------------------------------------------------------------
+//! Returns the largest difference between the bone matrices of two instances.
+float maxDifference( const Skeleton::Instance& a, const Skeleton::Instance& b )
+{
+   float worst = 0.0f;
+   for( uint i = 0; i < a.transforms().size(); ++i )
+   {
+      const float* ea = a.transforms()[i].ptr();
+      const float* eb = b.transforms()[i].ptr();
+      for( uint e = 0; e < 16; ++e )  worst = CGM::max( worst, CGM::abs( ea[e] - eb[e] ) );
+   }
+   return worst;
+}
+
+//------------------------------------------------------------------------------
+//! Poses 1000 characters (two skeletons, a third of them blending two clips)
+//! with a PoseBatch, compares them with sampling the clips and calling
+//! Puppeteer::setPose() one character at a time, and compares the timings.
+void testPoseBatch( Test::Result& res )
+{
+   const uint numBones      = 60;
+   const uint numPoses      = 241;
+   const uint numCharacters = 1000;
+   const uint numSteps      = 20;
+
+   Core::gfx( Gfx::Manager::create( new Gfx::NullContext() ) );
+
+   RCP<Skeleton> skels[2] = { makeChainSkeleton( numBones ), makeChainSkeleton( numBones/2 ) };
+   Vector< RCP<SkeletalClip> > clips[2];
+   for( uint s = 0; s < 2; ++s )
+   {
+      for( uint c = 0; c < 3; ++c )
+      {
+         // The last one grows, so that the root scale changes over time.
+         float growth = (c == 2) ? 0.3f : 0.0f;
+         clips[s].pushBack( SkeletalClip::create( *makeSwingAnimation( skels[s]->numBones(), numPoses, 0.7f*float(c), growth ) ) );
+      }
+   }
+   RCP<SkeletalPose> poses[2] = { new SkeletalPose( Reff::identity(), numBones ), new SkeletalPose( Reff::identity(), numBones/2 ) };
+
+   Vector<Skeleton::Instance> batched( numCharacters );
+   Vector<Skeleton::Instance> serial( numCharacters );
+   for( uint c = 0; c < numCharacters; ++c )
+   {
+      Skeleton* skel = skels[(c % 7 == 0) ? 1 : 0].ptr();
+      batched[c].skeleton( skel );
+      serial[c].skeleton( skel );
+   }
+
+   TaskQueue queue( 4 );
+   PoseBatch batch;
+   double times[3] = { 0.0, 0.0, 0.0 };
+   float  worst    = 0.0f;
+   for( uint step = 0; step < numSteps; ++step )
+   {
+      batch.clear();
+      for( uint c = 0; c < numCharacters; ++c )
+      {
+         uint  s    = (c % 7 == 0) ? 1 : 0;
+         float time = 0.013f*float(c) + float(step)/60.0f;
+         const Vector< RCP<SkeletalClip> >& cl = clips[s];
+         if( c % 3 == 0 )
+         {
+            batch.add( batched[c], cl[c % 2].ptr(), time, cl[2].ptr(), 0.5f*time, 0.3f );
+         }
+         else
+         {
+            batch.add( batched[c], cl[c % 3].ptr(), time );
+         }
+      }
+
+      Timer timer;
+      for( uint c = 0; c < numCharacters; ++c )
+      {
+         uint  s    = (c % 7 == 0) ? 1 : 0;
+         float time = 0.013f*float(c) + float(step)/60.0f;
+         const Vector< RCP<SkeletalClip> >& cl = clips[s];
+         if( c % 3 == 0 )
+         {
+            cl[c % 2]->sample( time, *poses[s] );
+            cl[2]->blend( 0.5f*time, 0.3f, *poses[s] );
+         }
+         else
+         {
+            cl[c % 3]->sample( time, *poses[s] );
+         }
+         Puppeteer::setPose( serial[c], poses[s].ptr() );
+      }
+      times[0] += timer.elapsed();
+
+      batch.queue( NULL );
+      timer.restart();
+      batch.execute();
+      times[1] += timer.elapsed();
+
+      batch.queue( &queue );
+      timer.restart();
+      batch.execute();
+      times[2] += timer.elapsed();
+
+      for( uint c = 0; c < numCharacters; ++c )
+      {
+         worst = CGM::max( worst, maxDifference( batched[c], serial[c] ) );
+      }
+   }
+   TEST_ADD( res, batch.numInstances() == numCharacters );
+   TEST_ADD( res, batch.numGroups() < numCharacters/3 );
+   TEST_ADD( res, worst < 1e-4f );
+
+   // Everything the serial path sets.
+   bool same = true;
+   for( uint c = 0; c < numCharacters; ++c )
+   {
+      same &= batched[c].offset().position().equal( serial[c].offset().position(), 1e-5f );
+      for( uint b = 0; b < batched[c].skeleton()->numBones(); ++b )
+      {
+         same &= batched[c].globalPosition( b ).equal( serial[c].globalPosition( b ), 1e-4f );
+         same &= CGM::abs( batched[c].localOrientation( b ).dot( serial[c].localOrientation( b ) ) ) > 0.99999f;
+      }
+   }
+   TEST_ADD( res, same );
+
+   // Sampled poses, as the actions hand them over (see World::setPose()), mixed
+   // with clips on the same skeletons.
+   Vector< RCP<SkeletalPose> > sampled( numCharacters );
+   batch.clear();
+   for( uint c = 0; c < numCharacters; ++c )
+   {
+      uint  s    = (c % 7 == 0) ? 1 : 0;
+      float time = 0.021f*float(c);
+      sampled[c] = new SkeletalPose( Reff::identity(), skels[s]->numBones() );
+      clips[s][c % 3]->sample( time, *sampled[c] );
+      Puppeteer::setPose( serial[c], sampled[c].ptr() );
+      if( c % 2 == 0 )
+      {
+         batch.add( batched[c], sampled[c].ptr() );
+      }
+      else
+      {
+         batch.add( batched[c], clips[s][c % 3].ptr(), time );
+      }
+   }
+   batch.execute();
+   float worstPosed = 0.0f;
+   for( uint c = 0; c < numCharacters; ++c )
+   {
+      worstPosed = CGM::max( worstPosed, maxDifference( batched[c], serial[c] ) );
+      worstPosed = CGM::max( worstPosed, (batched[c].offset().position() - serial[c].offset().position()).length() );
+   }
+   TEST_ADD( res, worstPosed < 1e-4f );
+
+   StdErr << numCharacters << " characters, " << numBones << " bones: serial " << times[0]/numSteps*1000.0
+          << "ms, batch " << times[1]/numSteps*1000.0 << "ms, batch on queue " << times[2]/numSteps*1000.0 << "ms" << nl;
+
+   batched.clear();
+   serial.clear();
+   Core::gfx( RCP<Gfx::Manager>() );
+}
+
 //------------------------------------------------------------------------------
 //!
 void initTests()
 {
    Test::Collection& spc = Test::special();
    spc.add( new Test::Function( "collision"   , "Collision"   , testCollision    ) );
+   spc.add( new Test::Function( "constantring", "ConstantRing", testConstantRing ) );
+   spc.add( new Test::Function( "culling"     , "Culling"     , testCulling      ) );
+   spc.add( new Test::Function( "dfgraph"     , "DFGraph"     , testDFGraph      ) );
+   spc.add( new Test::Function( "drawsort"    , "DrawSort"    , testDrawSort     ) );
    spc.add( new Test::Function( "intersection", "Intersection", testIntersection ) );
+   spc.add( new Test::Function( "meshblock"   , "MeshBlock"   , testMeshBlock    ) );
+   spc.add( new Test::Function( "metafuncs"   , "MetaFuncs"   , testMetaFunctions ) );
+   spc.add( new Test::Function( "metasurface" , "MetaSurface" , testMetaSurface  ) );
+   spc.add( new Test::Function( "particles"   , "Particles"   , testParticles    ) );
+   spc.add( new Test::Function( "passalloc"   , "PassAlloc"   , testPassAllocations ) );
+   spc.add( new Test::Function( "posebatch"   , "PoseBatch"   , testPoseBatch    ) );
    spc.add( new Test::Function( "rounding"    , "Rounding"    , testRounding     ) );
+   spc.add( new Test::Function( "skelclip"    , "SkelClip"    , testSkeletalClip ) );
    spc.add( new Test::Function( "tex"         , "Tex"         , testTex          ) );
+   spc.add( new Test::Function( "vertexao"    , "VertexAO"    , testVertexAO     ) );
+   spc.add( new Test::Function( "worldtrace"  , "WorldTrace"  , testWorldTrace   ) );
 }
 
 //------------------------------------------------------------------------------